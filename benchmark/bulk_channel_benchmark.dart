@@ -0,0 +1,154 @@
+// Compares BulkChannel with the standard method codec for moving bulk
+// payloads between the Windows runner and Dart, in both directions.
+//
+//   flutter run -d windows --profile -t benchmark/bulk_channel_benchmark.dart
+//
+// Prints one line per direction, transport and payload size (MB/s and
+// per-call latency percentiles), then a JSON summary, and exits. Payload
+// contents are written once per buffer on the producing side in both
+// transports; the consumer reads one byte per page.
+
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:a1_tools/core/services/bulk_channel.dart';
+import 'package:flutter/material.dart';
+import 'package:flutter/services.dart';
+
+const _channel = MethodChannel('com.a1chimney.a1tools/bulk_benchmark');
+
+const _sizes = <int>[
+  4 * 1024,
+  256 * 1024,
+  1024 * 1024,
+  1280 * 720 * 4, // One 720p BGRA frame
+  8 * 1024 * 1024,
+];
+
+// Per case: stop after this much data or this many calls, whichever first
+const _targetBytes = 256 * 1024 * 1024;
+const _maxCalls = 500;
+const _minCalls = 20;
+const _warmupCalls = 5;
+
+int _touch(Uint8List data) {
+  var sink = 0;
+  for (var i = 0; i < data.length; i += 4096) {
+    sink ^= data[i];
+  }
+  return sink;
+}
+
+class _Result {
+  _Result(this.name, this.size, this.latenciesUs, this.totalUs);
+
+  final String name;
+  final int size;
+  final List<int> latenciesUs;
+  final int totalUs;
+
+  double get mbPerSecond =>
+      size * latenciesUs.length / (1024 * 1024) / (totalUs / 1e6);
+
+  int percentile(double p) {
+    final sorted = [...latenciesUs]..sort();
+    return sorted[((sorted.length - 1) * p).round()];
+  }
+
+  Map<String, Object> toJson() => {
+        'case': name,
+        'bytes': size,
+        'calls': latenciesUs.length,
+        'mb_per_s': double.parse(mbPerSecond.toStringAsFixed(1)),
+        'p50_us': percentile(0.5),
+        'p99_us': percentile(0.99),
+      };
+
+  @override
+  String toString() =>
+      '${name.padRight(22)} ${(size ~/ 1024).toString().padLeft(6)} KB  '
+      '${mbPerSecond.toStringAsFixed(1).padLeft(8)} MB/s  '
+      'p50 ${percentile(0.5).toString().padLeft(6)} us  '
+      'p99 ${percentile(0.99).toString().padLeft(6)} us';
+}
+
+Future<_Result> _measure(
+    String name, int size, Future<void> Function() call) async {
+  for (var i = 0; i < _warmupCalls; i++) {
+    await call();
+  }
+  final calls = (_targetBytes ~/ size).clamp(_minCalls, _maxCalls);
+  final latencies = <int>[];
+  final total = Stopwatch()..start();
+  for (var i = 0; i < calls; i++) {
+    final watch = Stopwatch()..start();
+    await call();
+    latencies.add(watch.elapsedMicroseconds);
+  }
+  return _Result(name, size, latencies, total.elapsedMicroseconds);
+}
+
+Future<List<_Result>> _run() async {
+  final bulk = BulkChannel.instance;
+  if (!bulk.isSupported) {
+    throw UnsupportedError('BulkChannel needs the Windows runner');
+  }
+
+  Completer<BulkBuffer>? pending;
+  bulk.setHandler(BulkChannel.benchmarkKind, (buffer) {
+    final completer = pending;
+    pending = null;
+    if (completer == null) {
+      buffer.release();
+    } else {
+      completer.complete(buffer);
+    }
+  });
+
+  final results = <_Result>[];
+  for (final size in _sizes) {
+    results.add(await _measure('native->dart codec', size, () async {
+      final data = await _channel.invokeMethod<Uint8List>('produceEncoded', size);
+      _touch(data!);
+    }));
+
+    results.add(await _measure('native->dart bulk', size, () async {
+      final completer = pending = Completer<BulkBuffer>();
+      await _channel.invokeMethod<bool>('produceBulk', size);
+      final buffer = await completer.future;
+      _touch(buffer.payload);
+      buffer.release();
+    }));
+
+    final encoded = Uint8List(size);
+    results.add(await _measure('dart->native codec', size, () async {
+      encoded.fillRange(0, size, 0xA1);
+      await _channel.invokeMethod<void>('consumeEncoded', encoded);
+    }));
+
+    results.add(await _measure('dart->native bulk', size, () async {
+      final buffer = bulk.acquire(size)!;
+      buffer.payload.fillRange(0, size, 0xA1);
+      bulk.submit(buffer, BulkChannel.benchmarkKind);
+    }));
+  }
+  bulk.setHandler(BulkChannel.benchmarkKind, null);
+  return results;
+}
+
+Future<void> main() async {
+  WidgetsFlutterBinding.ensureInitialized();
+  runApp(const Directionality(
+    textDirection: TextDirection.ltr,
+    child: Center(child: Text('Running bulk channel benchmark...')),
+  ));
+
+  final results = await _run();
+  for (final result in results) {
+    stdout.writeln(result);
+  }
+  stdout.writeln(jsonEncode([for (final result in results) result.toJson()]));
+  exit(0);
+}
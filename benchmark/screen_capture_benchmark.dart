@@ -0,0 +1,169 @@
+// Compares the runner's native capture-and-encode path with the Dart path
+// it replaces (BMP from GDI over FFI, decoded and re-encoded as JPEG by the
+// image package on an isolate).
+//
+//   flutter run -d windows --profile -t benchmark/screen_capture_benchmark.dart
+//   flutter run -d linux --profile -t benchmark/screen_capture_benchmark.dart
+//
+// Prints one line per case (ms per frame, percentiles, mean JPEG bytes per
+// frame and ms scaled to a 1920x1080 frame), then a JSON summary, and exits.
+// All cases encode at quality 75. The synthetic frames are the same on both
+// paths, so "dart encode" and "native synthetic" compare the encoders on
+// equal input; the screen cases depend on what is on screen.
+//
+// "native tiles synthetic" is a TILES stream update (captureTiles) on the
+// same source as "native synthetic", a FRAME update: only the window that
+// scrolls changes between frames, so it shows what tiling saves per update
+// in bytes sent and capture+encode time.
+
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:a1_tools/core/services/native_screen_capture.dart';
+import 'package:a1_tools/features/monitoring/remote_monitoring_service.dart';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/material.dart';
+import 'package:image/image.dart' as img;
+
+const _quality = 75;
+const _frames = 60;
+const _warmupFrames = 3;
+const _width = 1920;
+const _height = 1080;
+
+class _Result {
+  _Result(this.name, this.width, this.height, this.latenciesUs, this.bytes);
+
+  final String name;
+  final int width;
+  final int height;
+  final List<int> latenciesUs;
+  final int bytes; // Mean JPEG bytes per frame (tile indices included)
+
+  double get meanMs =>
+      latenciesUs.reduce((a, b) => a + b) / latenciesUs.length / 1000;
+
+  // Mean time for a 1920x1080 frame, assuming cost scales with pixels
+  double get ms1080p => meanMs * (_width * _height) / (width * height);
+
+  int percentile(double p) {
+    final sorted = [...latenciesUs]..sort();
+    return sorted[((sorted.length - 1) * p).round()];
+  }
+
+  Map<String, Object> toJson() => {
+        'case': name,
+        'width': width,
+        'height': height,
+        'frames': latenciesUs.length,
+        'mean_ms': double.parse(meanMs.toStringAsFixed(2)),
+        'ms_per_1080p_frame': double.parse(ms1080p.toStringAsFixed(2)),
+        'p50_us': percentile(0.5),
+        'p99_us': percentile(0.99),
+        'jpeg_bytes': bytes,
+      };
+
+  @override
+  String toString() =>
+      '${name.padRight(22)} ${'${width}x$height'.padLeft(10)}  '
+      '${meanMs.toStringAsFixed(2).padLeft(7)} ms  '
+      '(${ms1080p.toStringAsFixed(2)} ms/1080p)  '
+      'p50 ${percentile(0.5).toString().padLeft(7)} us  '
+      'p99 ${percentile(0.99).toString().padLeft(7)} us  '
+      '${(bytes / 1024).toStringAsFixed(1).padLeft(7)} KB';
+}
+
+// The old path's encode step, as run by compute()
+Uint8List? _encodeBmp(Uint8List bmp) {
+  final image = img.decodeBmp(bmp);
+  return image == null
+      ? null
+      : Uint8List.fromList(img.encodeJpg(image, quality: _quality));
+}
+
+// [frame] returns the bytes one update puts on the wire, null on failure
+Future<_Result> _measure(String name, int width, int height,
+    Future<int?> Function() frame) async {
+  for (var i = 0; i < _warmupFrames; i++) {
+    await frame();
+  }
+  final latencies = <int>[];
+  var bytes = 0;
+  for (var i = 0; i < _frames; i++) {
+    final watch = Stopwatch()..start();
+    final size = await frame();
+    latencies.add(watch.elapsedMicroseconds);
+    if (size == null) throw StateError('$name: no frame');
+    bytes += size;
+  }
+  return _Result(name, width, height, latencies, bytes ~/ _frames);
+}
+
+Future<List<_Result>> _run() async {
+  final native = NativeScreenCapture.instance;
+  if (!native.isSupported) {
+    throw UnsupportedError('Native capture needs the Windows or Linux runner');
+  }
+
+  final results = <_Result>[];
+  results.add(await _measure('native synthetic', _width, _height, () async {
+    final frame = await native.capture(quality: _quality, synthetic: true);
+    return frame?.jpeg.length;
+  }));
+
+  // The warmup takes the first update, which sends every tile
+  results.add(
+      await _measure('native tiles synthetic', _width, _height, () async {
+    final update =
+        await native.captureTiles(quality: _quality, synthetic: true);
+    return update == null
+        ? null
+        : update.tiles.length + (update.atlas?.length ?? 0);
+  }));
+
+  // A near-lossless synthetic frame as the BMP the old path would get
+  final reference = await native.capture(quality: 100, synthetic: true);
+  final bmp = Uint8List.fromList(img.encodeBmp(img.decodeJpg(reference!.jpeg)!));
+  results.add(await _measure('dart encode', _width, _height,
+      () async => (await compute(_encodeBmp, bmp))?.length));
+
+  final screen = await native.capture(quality: _quality);
+  if (screen != null) {
+    results.add(await _measure(
+        'native screen', screen.width, screen.height, () async {
+      final frame = await native.capture(quality: _quality);
+      return frame?.jpeg.length;
+    }));
+  }
+
+  if (Platform.isWindows) {
+    final (width, height) = WindowsScreenCapture.getScreenSize();
+    results.add(await _measure('dart capture+encode', width, height, () async {
+      final bmp = WindowsScreenCapture.captureScreen();
+      return bmp == null ? null : (await compute(_encodeBmp, bmp))?.length;
+    }));
+  }
+  return results;
+}
+
+Future<void> main() async {
+  WidgetsFlutterBinding.ensureInitialized();
+  runApp(const Directionality(
+    textDirection: TextDirection.ltr,
+    child: Center(child: Text('Running screen capture benchmark...')),
+  ));
+
+  final results = await _run();
+  for (final result in results) {
+    stdout.writeln(result);
+  }
+  // The synthetic FRAME and TILES cases come first
+  final frames = results[0];
+  final tiles = results[1];
+  stdout.writeln('TILES vs FRAME per update: '
+      '${(100 * tiles.bytes / frames.bytes).toStringAsFixed(1)}% bytes, '
+      '${(100 * tiles.meanMs / frames.meanMs).toStringAsFixed(1)}% ms');
+  stdout.writeln(jsonEncode([for (final result in results) result.toJson()]));
+  exit(0);
+}
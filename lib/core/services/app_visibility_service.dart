@@ -0,0 +1,36 @@
+import 'package:flutter/foundation.dart';
+import 'package:flutter/widgets.dart';
+
+/// Whether anyone can currently see the app window.
+///
+/// Follows the engine lifecycle, which the desktop runners drive from
+/// minimize, occlusion and show/hide (windows/runner/window_visibility.h,
+/// linux/runner/window_visibility.h). Frames, animations and tickers stop on
+/// their own while hidden; periodic UI refreshes check [isVisible] so they
+/// stop too, and listen to [visible] to catch up when the window returns.
+class AppVisibilityService {
+  AppVisibilityService._();
+  static final AppVisibilityService instance = AppVisibilityService._();
+
+  final ValueNotifier<bool> _visible = ValueNotifier<bool>(true);
+  AppLifecycleListener? _listener;
+
+  ValueListenable<bool> get visible {
+    _ensureListening();
+    return _visible;
+  }
+
+  bool get isVisible => visible.value;
+
+  void _ensureListening() {
+    if (_listener != null) return;
+    _listener = AppLifecycleListener(
+      onStateChange: (state) => _visible.value = _isVisibleState(state),
+    );
+    final state = WidgetsBinding.instance.lifecycleState;
+    if (state != null) _visible.value = _isVisibleState(state);
+  }
+
+  static bool _isVisibleState(AppLifecycleState state) =>
+      state == AppLifecycleState.resumed || state == AppLifecycleState.inactive;
+}
@@ -0,0 +1,175 @@
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+typedef _AcquireNative = Int64 Function(Uint64, Pointer<Pointer<Uint8>>);
+typedef _AcquireDart = int Function(int, Pointer<Pointer<Uint8>>);
+typedef _MapNative = Int32 Function(
+    Int64, Pointer<Pointer<Uint8>>, Pointer<Uint64>);
+typedef _MapDart = int Function(int, Pointer<Pointer<Uint8>>, Pointer<Uint64>);
+typedef _ReleaseNative = Void Function(Int64);
+typedef _ReleaseDart = void Function(int);
+typedef _SubmitNative = Int32 Function(Int64, Uint16, Uint64);
+typedef _SubmitDart = int Function(int, int, int);
+typedef _SetListeningNative = Void Function(Int32);
+typedef _SetListeningDart = void Function(int);
+
+/// Bulk data (frames, images, metric blocks) between Dart and the runner
+/// without a method codec.
+///
+/// Buffers live in native memory owned by the runner
+/// (windows/runner/bulk_channel.h) and are seen here as external typed data:
+/// no copy and no `EncodableValue` boxing. Every [BulkBuffer] must be
+/// [BulkBuffer.release]d (or submitted) once it is no longer used. There is
+/// no finalizer: the typed data views outlive the wrapper, so releasing when
+/// it is collected could free memory a view still points at.
+///
+/// Only the Windows runner implements it; [isSupported] is false elsewhere.
+class BulkChannel {
+  BulkChannel._() {
+    if (!Platform.isWindows) return;
+    try {
+      final lib = DynamicLibrary.executable();
+      final acquire = lib.lookupFunction<_AcquireNative, _AcquireDart>(
+          'a1_bulk_acquire',
+          isLeaf: true);
+      _map = lib.lookupFunction<_MapNative, _MapDart>('a1_bulk_map',
+          isLeaf: true);
+      _release = lib.lookupFunction<_ReleaseNative, _ReleaseDart>(
+          'a1_bulk_release',
+          isLeaf: true);
+      // Not a leaf call: native consumers may take their time
+      _submit =
+          lib.lookupFunction<_SubmitNative, _SubmitDart>('a1_bulk_submit');
+      _setListening = lib.lookupFunction<_SetListeningNative, _SetListeningDart>(
+          'a1_bulk_set_listening',
+          isLeaf: true);
+      _outBase = calloc<Pointer<Uint8>>();
+      _outSize = calloc<Uint64>();
+      _channel.setMessageHandler(_onAnnounced);
+      // Last, so a missing export leaves the channel unsupported
+      _acquire = acquire;
+    } catch (e) {
+      debugPrint('[BulkChannel] Runner exports unavailable: $e');
+    }
+  }
+
+  static final BulkChannel instance = BulkChannel._();
+
+  /// [BulkBuffer.kind] used by benchmark/bulk_channel_benchmark.dart.
+  static const int benchmarkKind = 0xFFFF;
+
+  /// Announcements of native buffers: one raw little-endian int64 handle.
+  static const _channel = BasicMessageChannel<ByteData>(
+    'com.a1chimney.a1tools/bulk',
+    BinaryCodec(),
+  );
+
+  _AcquireDart? _acquire;
+  late final _MapDart _map;
+  late final _ReleaseDart _release;
+  late final _SubmitDart _submit;
+  late final _SetListeningDart _setListening;
+  // Out-parameters of the native calls, reused; Dart calls are serial
+  late final Pointer<Pointer<Uint8>> _outBase;
+  late final Pointer<Uint64> _outSize;
+
+  final Map<int, void Function(BulkBuffer)> _handlers = {};
+
+  bool get isSupported => _acquire != null;
+
+  /// Routes native buffers of [kind] to [handler], which owns (and must
+  /// release) each buffer it gets. Null removes the handler. The runner only
+  /// publishes while some handler is set.
+  void setHandler(int kind, void Function(BulkBuffer buffer)? handler) {
+    if (!isSupported) return;
+    if (handler == null) {
+      _handlers.remove(kind);
+    } else {
+      _handlers[kind] = handler;
+    }
+    _setListening(_handlers.isEmpty ? 0 : 1);
+  }
+
+  /// A native buffer with room for [size] payload bytes for Dart to fill and
+  /// [submit]; null when unsupported or over the runner's memory limit.
+  BulkBuffer? acquire(int size) {
+    final acquire = _acquire;
+    if (acquire == null) return null;
+    final handle = acquire(size, _outBase);
+    if (handle == 0) return null;
+    final payload = _outBase.value;
+    return BulkBuffer._(this, handle, payload - BulkBuffer.headerSize, size);
+  }
+
+  /// Hands [buffer] to the runner's consumer for [kind] and releases it.
+  /// [payloadSize] defaults to the size it was acquired with.
+  bool submit(BulkBuffer buffer, int kind, {int? payloadSize}) {
+    if (buffer._released) return false;
+    buffer._released = true;
+    return _submit(buffer.handle, kind, payloadSize ?? buffer.payload.length) != 0;
+  }
+
+  Future<ByteData?> _onAnnounced(ByteData? message) async {
+    if (message == null || message.lengthInBytes < 8) return null;
+    final handle = message.getInt64(0, Endian.little);
+    // Map adds our reference; then drop the one the publisher handed over
+    final mapped = _map(handle, _outBase, _outSize) != 0;
+    _release(handle);
+    if (!mapped) return null;
+
+    final buffer = BulkBuffer._(this, handle, _outBase.value, null);
+    final handler = _handlers[buffer.kind];
+    if (handler == null) {
+      buffer.release();
+    } else {
+      handler(buffer);
+    }
+    return null;
+  }
+}
+
+/// One native buffer: a fixed 64-byte header followed by the payload.
+/// The typed data views point straight into native memory and are invalid
+/// after [release]. A buffer that is never released stays allocated and
+/// counts against the runner's memory limit.
+class BulkBuffer {
+  BulkBuffer._(this._owner, this.handle, Pointer<Uint8> base, int? payloadSize)
+      : _header = ByteData.sublistView(base.asTypedList(headerSize)) {
+    payload = (base + headerSize)
+        .asTypedList(payloadSize ?? _header.getUint64(24, Endian.little));
+  }
+
+  /// Size of the header; must match sizeof(BulkHeader) in the runner.
+  static const int headerSize = 64;
+
+  final BulkChannel _owner;
+  final ByteData _header;
+  bool _released = false;
+
+  final int handle;
+  late final Uint8List payload;
+
+  int get kind => _header.getUint16(6, Endian.little);
+  int get sequence => _header.getUint32(8, Endian.little);
+  int get flags => _header.getUint32(12, Endian.little);
+
+  /// Runner QueryPerformanceCounter time of publish, in microseconds.
+  int get timestampUs => _header.getUint64(16, Endian.little);
+
+  int get width => _header.getUint32(32, Endian.little);
+  int get height => _header.getUint32(36, Endian.little);
+  int get stride => _header.getUint32(40, Endian.little);
+  int get format => _header.getUint32(44, Endian.little);
+
+  /// Returns the buffer to the runner. Safe to call more than once.
+  void release() {
+    if (_released) return;
+    _released = true;
+    _owner._release(handle);
+  }
+}
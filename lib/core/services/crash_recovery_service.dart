@@ -20,6 +20,7 @@ class CrashRecoveryService {
   static const String _prefsKeyRestartCount = 'crash_restart_count';
   static const String _prefsKeyFirstRestartTime = 'crash_first_restart_time';
   static const String _prefsKeyLastCrashTime = 'crash_last_crash_time';
+  static const String _serviceRestartStateFile = 'service_restart_state.json';
 
   // State
   int _restartCount = 0;
@@ -209,6 +210,14 @@ class CrashRecoveryService {
       return;
     }
 
+    // The service helper (Layer 2) has classified this build as crash-looping
+    final serviceState = await readServiceRestartState();
+    if (serviceState != null && serviceState.isCrashLooping) {
+      debugPrint('[CrashRecovery] Service helper circuit is ${serviceState.state} - '
+          'not restarting');
+      return;
+    }
+
     // Increment counter before restart
     await _incrementRestartCounter();
 
@@ -307,6 +316,27 @@ class CrashRecoveryService {
     }
   }
 
+  /// Read the crash-loop circuit breaker state persisted by the service
+  /// helper (service_helper/restart_history.cpp). Returns null when the
+  /// helper has not written one yet or it cannot be parsed.
+  Future<ServiceRestartState?> readServiceRestartState() async {
+    try {
+      final appDataDir = await getApplicationSupportDirectory();
+      final stateFile = File(
+          '${appDataDir.path}${Platform.pathSeparator}$_serviceRestartStateFile');
+
+      if (!await stateFile.exists()) {
+        return null;
+      }
+
+      final json = jsonDecode(await stateFile.readAsString()) as Map<String, dynamic>;
+      return ServiceRestartState.fromJson(json);
+    } catch (e) {
+      debugPrint('[CrashRecovery] Failed to read service restart state: $e');
+      return null;
+    }
+  }
+
   /// Clean up restart lock on successful start
   Future<void> cleanupOnStart() async {
     await _removeRestartLock();
@@ -378,3 +408,88 @@ class CrashRecoveryService {
     return logs;
   }
 }
+
+/// Circuit breaker state of the service helper's restart loop
+///
+/// The helper stops relaunching the app after repeated exits shortly after
+/// launch and retries with an exponential backoff. All times are written as
+/// milliseconds since the Unix epoch.
+class ServiceRestartState {
+  /// 'closed' (launching normally), 'open' (launches suspended) or
+  /// 'half_open' (one trial launch in progress)
+  final String state;
+
+  /// Consecutive times the circuit opened
+  final int trips;
+
+  /// Early exits since the last healthy run
+  final int earlyExits;
+
+  /// Early exits in a row that open the circuit, and what counts as early
+  final int crashLoopExits;
+  final Duration crashLoopWindow;
+
+  /// Current backoff and when the next trial launch is allowed
+  final Duration backoff;
+  final DateTime? nextAttempt;
+
+  /// The helper's most recent launches, oldest first
+  final List<ServiceLaunchRecord> launches;
+
+  const ServiceRestartState({
+    required this.state,
+    required this.trips,
+    required this.earlyExits,
+    required this.crashLoopExits,
+    required this.crashLoopWindow,
+    required this.backoff,
+    required this.nextAttempt,
+    required this.launches,
+  });
+
+  /// True while the helper considers the app to be in a crash loop
+  bool get isCrashLooping => state != 'closed';
+
+  factory ServiceRestartState.fromJson(Map<String, dynamic> json) {
+    final nextAttemptMs = (json['next_attempt_ms'] as num?)?.toInt() ?? 0;
+    return ServiceRestartState(
+      state: json['state'] as String? ?? 'closed',
+      trips: (json['trips'] as num?)?.toInt() ?? 0,
+      earlyExits: (json['early_exits'] as num?)?.toInt() ?? 0,
+      crashLoopExits: (json['crash_loop_exits'] as num?)?.toInt() ?? 0,
+      crashLoopWindow: Duration(milliseconds: (json['crash_loop_window_ms'] as num?)?.toInt() ?? 0),
+      backoff: Duration(milliseconds: (json['backoff_ms'] as num?)?.toInt() ?? 0),
+      nextAttempt: nextAttemptMs > 0 ? DateTime.fromMillisecondsSinceEpoch(nextAttemptMs) : null,
+      launches: (json['launches'] as List<dynamic>? ?? const [])
+          .map((e) => ServiceLaunchRecord.fromJson(e as Map<String, dynamic>))
+          .toList(),
+    );
+  }
+}
+
+/// One app launch by the service helper
+class ServiceLaunchRecord {
+  final DateTime launchedAt;
+
+  /// Null while running or if the exit was not observed
+  final DateTime? exitedAt;
+  final int exitCode;
+
+  const ServiceLaunchRecord({
+    required this.launchedAt,
+    required this.exitedAt,
+    required this.exitCode,
+  });
+
+  /// How long the instance ran, null if it has not exited
+  Duration? get uptime => exitedAt?.difference(launchedAt);
+
+  factory ServiceLaunchRecord.fromJson(Map<String, dynamic> json) {
+    final exitMs = (json['exit_ms'] as num?)?.toInt() ?? 0;
+    return ServiceLaunchRecord(
+      launchedAt: DateTime.fromMillisecondsSinceEpoch((json['launch_ms'] as num?)?.toInt() ?? 0),
+      exitedAt: exitMs > 0 ? DateTime.fromMillisecondsSinceEpoch(exitMs) : null,
+      exitCode: (json['exit_code'] as num?)?.toInt() ?? 0,
+    );
+  }
+}
@@ -4,7 +4,9 @@
 // Provides a unified interface for error reporting across the app.
 
 import 'dart:async';
+import 'dart:io';
 import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
 import 'package:sentry_flutter/sentry_flutter.dart';
 
 /// Breadcrumb categories for tracking user actions
@@ -30,6 +32,16 @@ class CrashReportingService {
 
   bool _isInitialized = false;
 
+  /// Platform-thread stall watchdog in the runner
+  /// (windows/runner/stall_monitor.h, linux/runner/stall_monitor.h)
+  static const _stallMonitorChannel =
+      MethodChannel('com.a1chimney.a1tools/stall_monitor');
+
+  /// Innermost frames that identify a stall for grouping
+  static const _stallFingerprintFrames = 3;
+
+  Timer? _stallUploadTimer;
+
   /// Current username for context (can be accessed for debugging)
   String? currentUsername;
 
@@ -94,6 +106,7 @@ class CrashReportingService {
     );
 
     instance._isInitialized = true;
+    instance.startRunnerStallUploads();
     debugPrint('[CrashReporting] Initialized with environment: $environment');
   }
 
@@ -309,6 +322,67 @@ class CrashReportingService {
     debugPrint('[CrashReporting] Message captured: $message');
   }
 
+  /// Periodically upload the message-loop stalls the runner recorded.
+  /// Started by [initialize]; the runner keeps the latest 32 in between.
+  void startRunnerStallUploads({Duration interval = const Duration(minutes: 1)}) {
+    if (!Platform.isWindows && !Platform.isLinux) return;
+    _stallUploadTimer?.cancel();
+    _stallUploadTimer = Timer.periodic(interval, (_) => uploadRunnerStalls());
+  }
+
+  /// Stop periodic stall uploads
+  void stopRunnerStallUploads() {
+    _stallUploadTimer?.cancel();
+    _stallUploadTimer = null;
+  }
+
+  /// Take the stalls recorded by the runner and send one event per stall,
+  /// grouped by where the platform thread was stuck. Returns the number
+  /// sent.
+  Future<int> uploadRunnerStalls() async {
+    if (!_isInitialized) return 0;
+
+    final Map<dynamic, dynamic>? result;
+    try {
+      result = await _stallMonitorChannel.invokeMapMethod<dynamic, dynamic>('takeStalls');
+    } catch (e) {
+      debugPrint('[CrashReporting] Failed to read runner stalls: $e');
+      return 0;
+    }
+    final stalls = ((result?['stalls'] as List?) ?? const [])
+        .map((e) => RunnerStall.fromMap(e as Map<dynamic, dynamic>))
+        .toList();
+    final dropped = (result?['dropped'] as num?)?.toInt() ?? 0;
+
+    for (final stall in stalls) {
+      await Sentry.captureEvent(
+        SentryEvent(
+          timestamp: stall.startedAt.toUtc(),
+          message: SentryMessage(
+              'Platform thread stalled for ${stall.duration.inMilliseconds} ms'),
+          level: SentryLevel.warning,
+          fingerprint: [
+            'runner-stall',
+            ...stall.frames.take(_stallFingerprintFrames),
+          ],
+          tags: {'stall_source': 'runner'},
+        ),
+        withScope: (scope) {
+          scope.setContexts('runner_stall', {
+            ...stall.toJson(),
+            if (dropped > 0) 'dropped_before_upload': dropped,
+          });
+        },
+      );
+    }
+
+    if (stalls.isNotEmpty || dropped > 0) {
+      debugPrint('[CrashReporting] Uploaded ${stalls.length} runner stalls '
+          '($dropped dropped)');
+    }
+    return stalls.length;
+  }
+
   /// Start a transaction for performance monitoring
   ISentrySpan startTransaction({
     required String name,
@@ -340,6 +414,7 @@ class CrashReportingService {
 
   /// Flush pending events (call before app termination)
   Future<void> flush() async {
+    stopRunnerStallUploads();
     if (_isInitialized) {
       await Sentry.close();
       debugPrint('[CrashReporting] Flushed and closed');
@@ -347,6 +422,45 @@ class CrashReportingService {
   }
 }
 
+/// A period in which the runner's platform thread did not get to its
+/// message loop, with its stack sampled while it was stuck
+class RunnerStall {
+  /// When the stall was first noticed (within 100 ms of its start)
+  final DateTime startedAt;
+  final Duration duration;
+
+  /// Windows message being dispatched when sampled, 0 if none or on Linux
+  final int message;
+
+  /// Innermost first, "module+0xoffset"; symbolize with the release's PDBs
+  /// or debug symbols
+  final List<String> frames;
+
+  const RunnerStall({
+    required this.startedAt,
+    required this.duration,
+    required this.message,
+    required this.frames,
+  });
+
+  factory RunnerStall.fromMap(Map<dynamic, dynamic> map) {
+    return RunnerStall(
+      startedAt: DateTime.fromMillisecondsSinceEpoch(
+          (map['startedMs'] as num?)?.toInt() ?? 0),
+      duration: Duration(milliseconds: (map['durationMs'] as num?)?.toInt() ?? 0),
+      message: (map['message'] as num?)?.toInt() ?? 0,
+      frames: ((map['frames'] as List?) ?? const []).cast<String>(),
+    );
+  }
+
+  Map<String, dynamic> toJson() => {
+        'started_at': startedAt.toUtc().toIso8601String(),
+        'duration_ms': duration.inMilliseconds,
+        if (message != 0) 'message': '0x${message.toRadixString(16)}',
+        'frames': frames,
+      };
+}
+
 /// Extension for easy error reporting
 extension CrashReportingExtension on Object {
   /// Report this exception to crash reporting
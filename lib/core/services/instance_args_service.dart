@@ -0,0 +1,46 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// Command lines of later launches of the app.
+///
+/// A second launch on Windows or Linux hands its arguments to the running
+/// instance over local IPC and exits (windows/runner/instance_channel.h,
+/// linux/runner/instance_channel.h); they arrive here instead of starting a
+/// second engine.
+class InstanceArgsService {
+  InstanceArgsService._();
+  static final InstanceArgsService instance = InstanceArgsService._();
+
+  static const _channel = EventChannel('com.a1chimney.a1tools/instance_args');
+
+  /// Flags passed by launchers that start the app in the background; a
+  /// launch carrying one of these should not pop the window up.
+  static const backgroundLaunchFlags = {
+    '--auto-start',
+    '--crash-restart',
+    '--service-restart',
+  };
+
+  Stream<List<String>>? _stream;
+
+  /// One event per forwarded launch. Launches that happen before the first
+  /// listener are queued by the runner and delivered on listen.
+  Stream<List<String>> get forwardedArgs {
+    if (!Platform.isWindows && !Platform.isLinux) {
+      return const Stream.empty();
+    }
+    return _stream ??= _channel
+        .receiveBroadcastStream()
+        .map((event) => List<String>.from(event as List))
+        .handleError((Object e) {
+      debugPrint('[InstanceArgs] Channel error: $e');
+    });
+  }
+
+  /// Whether [args] came from a background launcher rather than the user
+  static bool isBackgroundLaunch(List<String> args) =>
+      args.any(backgroundLaunchFlags.contains);
+}
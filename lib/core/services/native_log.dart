@@ -0,0 +1,180 @@
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+import 'package:flutter/foundation.dart';
+
+typedef _InternNative = Uint32 Function(Pointer<Utf8>);
+typedef _InternDart = int Function(Pointer<Utf8>);
+typedef _WriteNative = Void Function(
+    Uint8, Uint32, Uint32, Pointer<Uint8>, Uint32);
+typedef _WriteDart = void Function(int, int, int, Pointer<Uint8>, int);
+
+/// Matches `LogLevel` in windows/runner/native_log.h.
+enum NativeLogLevel { trace, debug, info, warning, error }
+
+/// Structured log shared with the runner and its plugins.
+///
+/// Entries are a format with `{}` placeholders plus the raw argument values;
+/// formats and subsystem names are interned once, so logging an entry costs
+/// an encode into a reused native buffer and one leaf call that queues it on
+/// the runner's per-thread ring (windows/runner/native_log.h). Nothing is
+/// formatted until the log is decoded with scripts/decode_native_log.py.
+///
+/// Formats must be constants: every distinct one is interned for the life
+/// of the process. Put variable parts in the arguments.
+///
+/// Only the Windows runner implements it; elsewhere, and in debug builds,
+/// entries are also formatted and printed with [debugPrint].
+class NativeLog {
+  NativeLog._() {
+    if (!Platform.isWindows) return;
+    try {
+      final lib = DynamicLibrary.executable();
+      _intern = lib.lookupFunction<_InternNative, _InternDart>('a1_log_intern',
+          isLeaf: true);
+      final write = lib.lookupFunction<_WriteNative, _WriteDart>(
+          'a1_log_write',
+          isLeaf: true);
+      _args = calloc<Uint8>(_maxArgsSize);
+      _argsBytes = _args.asTypedList(_maxArgsSize);
+      _argsData = ByteData.sublistView(_argsBytes);
+      _textFormat = _idOf('{}');
+      // Last, so a missing export leaves the log unsupported
+      _write = write;
+    } catch (e) {
+      debugPrint('[NativeLog] Runner exports unavailable: $e');
+    }
+  }
+
+  static final NativeLog instance = NativeLog._();
+
+  // NativeLog::kMaxRecordSize less the record header
+  static const int _maxArgsSize = 4096 - 24;
+  // Beyond this many, formats are logged as text under a generic one
+  static const int _maxInterned = 2048;
+
+  // LogRecordHeader::Arg
+  static const int _argInt = 1;
+  static const int _argDouble = 3;
+  static const int _argText = 4;
+
+  late final _InternDart _intern;
+  _WriteDart? _write;
+  // Argument encoding buffer, reused; Dart calls are serial
+  late final Pointer<Uint8> _args;
+  late final Uint8List _argsBytes;
+  late final ByteData _argsData;
+  final Map<String, int> _ids = {};
+  // Stands in for formats past _maxInterned, with the text as argument
+  late final int _textFormat;
+
+  bool get isSupported => _write != null;
+
+  /// A logger for one subsystem (e.g. "monitoring").
+  NativeLogger logger(String subsystem) => NativeLogger._(this, subsystem);
+
+  /// Logs [format], with each `{}` standing for the next of [args]. Ints and
+  /// doubles are stored as values, anything else as its `toString()`.
+  void write(NativeLogLevel level, String subsystem, String format,
+      [List<Object?> args = const []]) {
+    final write = _write;
+    if (write == null || kDebugMode) {
+      debugPrint('[$subsystem] ${NativeLog.format(format, args)}');
+    }
+    if (write == null) return;
+
+    final subsystemId = _idOf(subsystem);
+    var formatId = _idOf(format);
+    if (formatId == 0) {
+      formatId = _textFormat;
+      args = [NativeLog.format(format, args)];
+    }
+    write(level.index, subsystemId, formatId, _args, _encode(args));
+  }
+
+  /// [format] with each `{}` replaced by the next of [args], as the decoder
+  /// prints it.
+  static String format(String format, List<Object?> args) {
+    if (args.isEmpty) return format;
+    final out = StringBuffer();
+    var start = 0;
+    for (final arg in args) {
+      final index = format.indexOf('{}', start);
+      if (index < 0) break;
+      out
+        ..write(format.substring(start, index))
+        ..write(arg);
+      start = index + 2;
+    }
+    out.write(format.substring(start));
+    return out.toString();
+  }
+
+  // 0 once the table is full
+  int _idOf(String text) {
+    final id = _ids[text];
+    if (id != null) return id;
+    if (_ids.length >= _maxInterned) return 0;
+    final native = text.toNativeUtf8(allocator: calloc);
+    try {
+      return _ids[text] = _intern(native);
+    } finally {
+      calloc.free(native);
+    }
+  }
+
+  // Returns the encoded size; arguments that do not fit are left out.
+  int _encode(List<Object?> args) {
+    var size = 0;
+    for (final arg in args) {
+      if (arg is int) {
+        if (size + 9 > _maxArgsSize) break;
+        _argsData.setUint8(size, _argInt);
+        _argsData.setInt64(size + 1, arg, Endian.little);
+        size += 9;
+      } else if (arg is double) {
+        if (size + 9 > _maxArgsSize) break;
+        _argsData.setUint8(size, _argDouble);
+        _argsData.setFloat64(size + 1, arg, Endian.little);
+        size += 9;
+      } else {
+        if (size + 3 > _maxArgsSize) break;
+        var bytes = utf8.encode(arg.toString());
+        if (bytes.length > _maxArgsSize - size - 3) {
+          bytes = bytes.sublist(0, _maxArgsSize - size - 3);
+        }
+        _argsData.setUint8(size, _argText);
+        _argsData.setUint16(size + 1, bytes.length, Endian.little);
+        _argsBytes.setRange(size + 3, size + 3 + bytes.length, bytes);
+        size += 3 + bytes.length;
+      }
+    }
+    return size;
+  }
+}
+
+/// [NativeLog] entries under one subsystem.
+class NativeLogger {
+  const NativeLogger._(this._log, this.subsystem);
+
+  final NativeLog _log;
+  final String subsystem;
+
+  void trace(String format, [List<Object?> args = const []]) =>
+      _log.write(NativeLogLevel.trace, subsystem, format, args);
+
+  void debug(String format, [List<Object?> args = const []]) =>
+      _log.write(NativeLogLevel.debug, subsystem, format, args);
+
+  void info(String format, [List<Object?> args = const []]) =>
+      _log.write(NativeLogLevel.info, subsystem, format, args);
+
+  void warning(String format, [List<Object?> args = const []]) =>
+      _log.write(NativeLogLevel.warning, subsystem, format, args);
+
+  void error(String format, [List<Object?> args = const []]) =>
+      _log.write(NativeLogLevel.error, subsystem, format, args);
+}
@@ -0,0 +1,178 @@
+import 'dart:io';
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// Screen capture and JPEG encoding done by the runner
+/// (windows/runner/screen_capture.h, linux/runner/screen_capture.h).
+///
+/// The runner grabs the screen into a reused 32-bit buffer and encodes it on
+/// a native worker, so only the JPEG crosses the channel; nothing is decoded
+/// or re-encoded in Dart. Captures run one at a time; while one is in
+/// progress further calls queue in the runner.
+///
+/// [captureTiles] sends only the parts of the screen that changed since its
+/// previous call, for streaming.
+class NativeScreenCapture {
+  NativeScreenCapture._();
+  static final NativeScreenCapture instance = NativeScreenCapture._();
+
+  static const _channel = MethodChannel('com.a1chimney.a1tools/screen_capture');
+
+  // Set when the runner has no such channel (an older build)
+  bool _missing = false;
+
+  bool get isSupported =>
+      !_missing && (Platform.isWindows || Platform.isLinux);
+
+  /// Captures the primary screen, or with [synthetic] a generated frame of
+  /// [width] x [height] (default 1920x1080) for benchmarks, shrinks it by
+  /// [scale] (0.25-1) and encodes it at [quality] (1-100). Returns null if
+  /// the capture failed.
+  Future<CapturedFrame?> capture({
+    int quality = 75,
+    double scale = 1.0,
+    bool synthetic = false,
+    int? width,
+    int? height,
+  }) async {
+    final result = await _invoke('capture', {
+      'quality': quality,
+      'scale': scale,
+      'source': synthetic ? 'synthetic' : 'screen',
+      if (width != null) 'width': width,
+      if (height != null) 'height': height,
+    });
+    return result == null ? null : CapturedFrame.fromMap(result);
+  }
+
+  /// Captures like [capture], but cuts the scaled frame into [tileSize]
+  /// squares (a multiple of 16 from 32 to 256) and encodes only those that
+  /// changed since the previous call, all of them after a resolution or
+  /// scale change or a failed call. With [full] the whole frame is encoded
+  /// as well.
+  ///
+  /// The runner keeps one set of tile hashes, so this must have a single
+  /// caller (ScreenStreamServer) that delivers every result it gets.
+  Future<CapturedTiles?> captureTiles({
+    int quality = 75,
+    double scale = 1.0,
+    int tileSize = 64,
+    bool full = false,
+    bool synthetic = false,
+    int? width,
+    int? height,
+  }) async {
+    final result = await _invoke('captureTiles', {
+      'quality': quality,
+      'scale': scale,
+      'tileSize': tileSize,
+      'full': full,
+      'source': synthetic ? 'synthetic' : 'screen',
+      if (width != null) 'width': width,
+      if (height != null) 'height': height,
+    });
+    return result == null ? null : CapturedTiles.fromMap(result);
+  }
+
+  Future<Map<String, dynamic>?> _invoke(
+      String method, Map<String, Object> args) async {
+    if (!isSupported) return null;
+    try {
+      return await _channel.invokeMapMethod<String, dynamic>(method, args);
+    } on MissingPluginException {
+      _missing = true;
+      debugPrint('[ScreenCapture] Runner has no native capture');
+      return null;
+    } on PlatformException catch (e) {
+      debugPrint('[ScreenCapture] Capture failed: ${e.code} ${e.message}');
+      return null;
+    }
+  }
+}
+
+/// One JPEG-encoded frame from [NativeScreenCapture]
+class CapturedFrame {
+  final int width;
+  final int height;
+  final Uint8List jpeg;
+
+  /// Time spent grabbing the pixels
+  final Duration captureTime;
+
+  /// Time spent shrinking them, zero at scale 1
+  final Duration scaleTime;
+
+  /// Time spent encoding them
+  final Duration encodeTime;
+
+  const CapturedFrame({
+    required this.width,
+    required this.height,
+    required this.jpeg,
+    required this.captureTime,
+    required this.scaleTime,
+    required this.encodeTime,
+  });
+
+  factory CapturedFrame.fromMap(Map<String, dynamic> map) => CapturedFrame(
+        width: map['width'] as int,
+        height: map['height'] as int,
+        jpeg: map['jpeg'] as Uint8List,
+        captureTime: Duration(microseconds: map['captureUs'] as int),
+        scaleTime: Duration(microseconds: map['scaleUs'] as int),
+        encodeTime: Duration(microseconds: map['encodeUs'] as int),
+      );
+}
+
+/// The tiles of a frame that changed since the previous
+/// [NativeScreenCapture.captureTiles]
+class CapturedTiles {
+  final int width;
+  final int height;
+  final int tileSize;
+
+  /// Row-major indices of the changed tiles in the frame's tile grid, as
+  /// little-endian uint16s in atlas order (the TILES wire format)
+  final Uint8List tiles;
+
+  /// JPEG of the changed tiles packed left to right, top to bottom, 16 to a
+  /// row; null when nothing changed. Edge tiles are padded to full size.
+  final Uint8List? atlas;
+
+  /// The whole frame, when asked for
+  final Uint8List? frame;
+
+  final Duration captureTime;
+  final Duration scaleTime;
+  final Duration hashTime;
+  final Duration encodeTime;
+
+  const CapturedTiles({
+    required this.width,
+    required this.height,
+    required this.tileSize,
+    required this.tiles,
+    required this.atlas,
+    required this.frame,
+    required this.captureTime,
+    required this.scaleTime,
+    required this.hashTime,
+    required this.encodeTime,
+  });
+
+  int get tileCount => tiles.length ~/ 2;
+
+  factory CapturedTiles.fromMap(Map<String, dynamic> map) => CapturedTiles(
+        width: map['width'] as int,
+        height: map['height'] as int,
+        tileSize: map['tileSize'] as int,
+        tiles: map['tiles'] as Uint8List,
+        atlas: map['atlas'] as Uint8List?,
+        frame: map['jpeg'] as Uint8List?,
+        captureTime: Duration(microseconds: map['captureUs'] as int),
+        scaleTime: Duration(microseconds: map['scaleUs'] as int),
+        hashTime: Duration(microseconds: map['hashUs'] as int),
+        encodeTime: Duration(microseconds: map['encodeUs'] as int),
+      );
+}
@@ -0,0 +1,171 @@
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter/foundation.dart';
+import 'package:path_provider/path_provider.dart';
+
+/// Reader for the service helper's latency histograms
+/// (service_helper/supervisor_stats.h). The helper rewrites the file in place
+/// after every sample; a read that races a write is detected by comparing the
+/// header and trailer sequence numbers and simply retried.
+class ServiceHelperStats {
+  static ServiceHelperStats? _instance;
+  static ServiceHelperStats get instance => _instance ??= ServiceHelperStats._();
+
+  ServiceHelperStats._();
+
+  static const String _statsFile = 'service_helper_stats.bin';
+  static const int _magic = 0x54533141; // "A1ST"
+  static const int _version = 1;
+  static const int _headerSize = 40; // Fixed fields before the bucket bounds
+  static const int _maxReadAttempts = 3;
+
+  /// Metric names in the helper's StatsMetric order
+  static const List<String> metricNames = [
+    'check_duration',
+    'snapshot_duration',
+    'detect_exit',
+    'first_frame',
+    'downtime',
+  ];
+
+  /// Read the current snapshot, null if there is no (valid) stats file
+  Future<ServiceHelperStatsSnapshot?> read() async {
+    try {
+      final appDataDir = await getApplicationSupportDirectory();
+      final file = File('${appDataDir.path}${Platform.pathSeparator}$_statsFile');
+      if (!await file.exists()) {
+        return null;
+      }
+
+      for (var attempt = 0; attempt < _maxReadAttempts; attempt++) {
+        final snapshot = parse(await file.readAsBytes());
+        if (snapshot != null) {
+          return snapshot;
+        }
+        await Future.delayed(const Duration(milliseconds: 20));
+      }
+    } catch (e) {
+      debugPrint('[ServiceHelperStats] Failed to read stats: $e');
+    }
+    return null;
+  }
+
+  /// Decode a stats file image, null if it is not valid or was torn
+  static ServiceHelperStatsSnapshot? parse(Uint8List bytes) {
+    if (bytes.length < _headerSize) {
+      return null;
+    }
+    final data = ByteData.sublistView(bytes);
+    if (data.getUint32(0, Endian.little) != _magic ||
+        data.getUint16(4, Endian.little) != _version) {
+      return null;
+    }
+    final metricCount = data.getUint16(6, Endian.little);
+    final bucketCount = data.getUint32(8, Endian.little);
+    final histogramSize = 8 * (3 + bucketCount);
+    final size = _headerSize + 8 * bucketCount + histogramSize * metricCount + 8;
+    if (bytes.length < size) {
+      return null;
+    }
+
+    final sequence = data.getUint64(16, Endian.little);
+    if (data.getUint64(size - 8, Endian.little) != sequence) {
+      return null; // Torn read
+    }
+
+    final bounds = List<int>.generate(
+        bucketCount, (i) => data.getUint64(_headerSize + 8 * i, Endian.little));
+    final histograms = <String, ServiceHelperHistogram>{};
+    var offset = _headerSize + 8 * bucketCount;
+    for (var m = 0; m < metricCount; m++) {
+      final name = m < metricNames.length ? metricNames[m] : 'metric_$m';
+      histograms[name] = ServiceHelperHistogram(
+        count: data.getUint64(offset, Endian.little),
+        sumMs: data.getUint64(offset + 8, Endian.little),
+        maxMs: data.getUint64(offset + 16, Endian.little),
+        bucketUpperMs: bounds,
+        buckets: List<int>.generate(
+            bucketCount, (i) => data.getUint64(offset + 24 + 8 * i, Endian.little)),
+      );
+      offset += histogramSize;
+    }
+
+    return ServiceHelperStatsSnapshot(
+      sequence: sequence,
+      createdAt: DateTime.fromMillisecondsSinceEpoch(data.getInt64(24, Endian.little)),
+      updatedAt: DateTime.fromMillisecondsSinceEpoch(data.getInt64(32, Endian.little)),
+      histograms: histograms,
+    );
+  }
+}
+
+/// All histograms from one read of the stats file
+class ServiceHelperStatsSnapshot {
+  /// Bumped by the helper on every write
+  final int sequence;
+  final DateTime createdAt;
+  final DateTime updatedAt;
+  final Map<String, ServiceHelperHistogram> histograms;
+
+  const ServiceHelperStatsSnapshot({
+    required this.sequence,
+    required this.createdAt,
+    required this.updatedAt,
+    required this.histograms,
+  });
+
+  Map<String, dynamic> toJson() => {
+        'sequence': sequence,
+        'created_ms': createdAt.millisecondsSinceEpoch,
+        'updated_ms': updatedAt.millisecondsSinceEpoch,
+        'histograms': histograms.map((name, h) => MapEntry(name, h.toJson())),
+      };
+}
+
+/// One fixed-bucket latency histogram; bucket i counts samples up to
+/// bucketUpperMs[i], the last bucket is the overflow bucket
+class ServiceHelperHistogram {
+  final int count;
+  final int sumMs;
+  final int maxMs;
+  final List<int> bucketUpperMs;
+  final List<int> buckets;
+
+  const ServiceHelperHistogram({
+    required this.count,
+    required this.sumMs,
+    required this.maxMs,
+    required this.bucketUpperMs,
+    required this.buckets,
+  });
+
+  double get meanMs => count == 0 ? 0 : sumMs / count;
+
+  /// Upper bound of the bucket holding the given percentile (0-100), capped
+  /// at the largest sample seen
+  int percentileMs(double percentile) {
+    if (count == 0) return 0;
+    final target = (count * percentile / 100).ceil().clamp(1, count);
+    var seen = 0;
+    for (var i = 0; i < buckets.length; i++) {
+      seen += buckets[i];
+      if (seen >= target) {
+        // The overflow bound reads back as a negative Dart int
+        final bound = bucketUpperMs[i];
+        return bound < 0 || bound > maxMs ? maxMs : bound;
+      }
+    }
+    return maxMs;
+  }
+
+  Map<String, dynamic> toJson() => {
+        'count': count,
+        'sum_ms': sumMs,
+        'max_ms': maxMs,
+        'p50_ms': percentileMs(50),
+        'p90_ms': percentileMs(90),
+        'p99_ms': percentileMs(99),
+        'buckets': buckets,
+      };
+}
@@ -0,0 +1,104 @@
+import 'dart:io';
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// Dart side of the runner's cold-start phase tracer
+/// (windows/runner/startup_trace.h, linux/runner/startup_trace.h).
+///
+/// The runner records its own phases from process start to the first frame;
+/// Dart adds phases of its startup to the same timeline so one Chrome trace
+/// (chrome://tracing, ui.perfetto.dev) shows the whole launch.
+class StartupTraceService {
+  StartupTraceService._();
+  static final StartupTraceService instance = StartupTraceService._();
+
+  static const _channel = MethodChannel('com.a1chimney.a1tools/startup_trace');
+
+  bool get _isSupported => Platform.isWindows || Platform.isLinux;
+
+  /// Begin a phase; pair with [end] using the same name
+  void begin(String name) => _record(name, 'B');
+
+  /// End a phase started with [begin]
+  void end(String name) => _record(name, 'E');
+
+  /// Record a point in time
+  void instant(String name) => _record(name, 'i');
+
+  /// Time [action] as one phase
+  Future<T> trace<T>(String name, Future<T> Function() action) async {
+    begin(name);
+    try {
+      return await action();
+    } finally {
+      end(name);
+    }
+  }
+
+  /// Events recorded so far, in recording order
+  Future<List<StartupTraceEvent>> getEvents() async {
+    if (!_isSupported) return const [];
+    try {
+      final events = await _channel.invokeListMethod<Map<dynamic, dynamic>>('getEvents');
+      return (events ?? const [])
+          .map((e) => StartupTraceEvent.fromMap(e))
+          .toList();
+    } catch (e) {
+      debugPrint('[StartupTrace] Failed to read events: $e');
+      return const [];
+    }
+  }
+
+  /// Write the trace as Chrome trace JSON; returns the file path, null on
+  /// failure. Without [path] the runner picks A1_TOOLS_STARTUP_TRACE or the
+  /// temp directory.
+  Future<String?> dump([String? path]) async {
+    if (!_isSupported) return null;
+    try {
+      return await _channel.invokeMethod<String>('dump', path);
+    } catch (e) {
+      debugPrint('[StartupTrace] Failed to dump trace: $e');
+      return null;
+    }
+  }
+
+  // Fire and forget: the timestamp is taken when the runner receives the
+  // message, which is close enough for phases in the tens of milliseconds.
+  void _record(String name, String phase) {
+    if (!_isSupported) return;
+    _channel.invokeMethod('record', {'name': name, 'ph': phase}).catchError((e) {
+      debugPrint('[StartupTrace] Failed to record $name: $e');
+    });
+  }
+}
+
+/// One recorded startup phase event
+class StartupTraceEvent {
+  final String name;
+
+  /// 'B' (begin), 'E' (end) or 'i' (instant)
+  final String phase;
+
+  /// Microseconds since the process started
+  final int timestampUs;
+  final int threadId;
+
+  const StartupTraceEvent({
+    required this.name,
+    required this.phase,
+    required this.timestampUs,
+    required this.threadId,
+  });
+
+  Duration get sinceProcessStart => Duration(microseconds: timestampUs);
+
+  factory StartupTraceEvent.fromMap(Map<dynamic, dynamic> map) {
+    return StartupTraceEvent(
+      name: map['name'] as String? ?? '',
+      phase: map['ph'] as String? ?? 'i',
+      timestampUs: (map['ts_us'] as num?)?.toInt() ?? 0,
+      threadId: (map['tid'] as num?)?.toInt() ?? 0,
+    );
+  }
+}
@@ -5,6 +5,7 @@ import 'package:package_info_plus/package_info_plus.dart';
 
 import '../../config/api_config.dart';
 import '../../core/services/api_client.dart';
+import '../../core/services/service_helper_stats.dart';
 
 /// Heartbeat manager that tracks online/away/offline status
 /// Sends heartbeat to office_map.php every 20 seconds
@@ -21,6 +22,7 @@ class HeartbeatManager with WidgetsBindingObserver {
   // Send to office_map.php which updates a1tools_users table
   static String get _heartbeatUrl => ApiConfig.officeMap;
   static const Duration _heartbeatInterval = Duration(seconds: 20);
+  static const Duration _serviceStatsInterval = Duration(minutes: 10);
   final ApiClient _api = ApiClient.instance;
 
   Timer? _timer;
@@ -30,6 +32,8 @@ class HeartbeatManager with WidgetsBindingObserver {
   bool _isRunning = false;
   bool _initialized = false;
   bool _versionBlockNotified = false; // Only notify once per session
+  int _lastServiceStatsSequence = -1;
+  DateTime? _lastServiceStatsSent;
 
   HeartbeatManager({
     required this.getUsername,
@@ -125,23 +129,48 @@ class HeartbeatManager with WidgetsBindingObserver {
     }
   }
 
+  /// Service helper stats to piggyback on this heartbeat: only when they
+  /// changed, and at most every [_serviceStatsInterval]
+  Future<ServiceHelperStatsSnapshot?> _pendingServiceStats() async {
+    final lastSent = _lastServiceStatsSent;
+    if (lastSent != null && DateTime.now().difference(lastSent) < _serviceStatsInterval) {
+      return null;
+    }
+    final stats = await ServiceHelperStats.instance.read();
+    if (stats == null || stats.sequence == _lastServiceStatsSequence) {
+      return null;
+    }
+    return stats;
+  }
+
   /// Send heartbeat to server
   Future<void> _sendHeartbeat() async {
     final username = getUsername();
     if (username.isEmpty) return;
 
     try {
+      final body = <String, dynamic>{
+        'action': 'heartbeat',
+        'username': username,
+        'status': _currentStatus,
+        'app_version': _appVersion,
+      };
+      final serviceStats = await _pendingServiceStats();
+      if (serviceStats != null) {
+        body['service_stats'] = serviceStats.toJson();
+      }
+
       final response = await _api.post(
         _heartbeatUrl,
-        body: {
-          'action': 'heartbeat',
-          'username': username,
-          'status': _currentStatus,
-          'app_version': _appVersion,
-        },
+        body: body,
         timeout: const Duration(seconds: 10),
       );
 
+      if (response.success && serviceStats != null) {
+        _lastServiceStatsSequence = serviceStats.sequence;
+        _lastServiceStatsSent = DateTime.now();
+      }
+
       if (response.success) {
         final data = response.rawJson;
         debugPrint('[HeartbeatManager] Sent: $_currentStatus (v$_appVersion)');
@@ -15,11 +15,16 @@ import 'dart:convert';
 import 'dart:io';
 import 'package:flutter/foundation.dart';
 
+import 'frame_fan_out.dart';
+
 /// Video-only streaming server for A1 Tools remote monitoring
 /// Audio capture has been disabled due to performance issues (spawned PowerShell every 200ms)
 /// 
 /// For audio monitoring, consider using external tools or a persistent FFmpeg process
 /// in a future update.
+///
+/// Frames go out through [FrameFanOut]: a viewer that cannot keep up gets
+/// the newest frame when its socket drains and skips the ones in between.
 class AVStreamServer {
   static const int defaultPort = 5902;
   static const String authPassword = 'a1stream';
@@ -44,6 +49,13 @@ class AVStreamServer {
   // Rate limiting - skip capture if previous one hasn't finished
   bool _captureInProgress = false;
   int _skippedFrames = 0;
+
+  late final FrameFanOut _fanOut = FrameFanOut(
+    onError: (client, e) {
+      _log('Error sending to client: $e');
+      _removeClient(client);
+    },
+  );
   
   AVStreamServer({
     this.onCaptureScreen,
@@ -54,6 +66,9 @@ class AVStreamServer {
   
   bool get isRunning => _isRunning;
   int get clientCount => _clients.length;
+
+  /// Frames not sent to slow viewers
+  int get droppedFrames => _fanOut.droppedPackets;
   
   // Audio is disabled in this version
   bool get audioEnabled => false;
@@ -101,13 +116,7 @@ class AVStreamServer {
     _idleTimer = null;
     _captureInProgress = false;
     
-    for (final client in _clients.toList()) {
-      try {
-        await client.close();
-      } catch (e) {
-  debugPrint('[AvStreamService] Error: $e');
-}
-    }
+    await _fanOut.closeAll();
     _clients.clear();
     
     await _server?.close();
@@ -144,6 +153,7 @@ class AVStreamServer {
                 _cancelIdleTimer();
                 // Audio is always disabled in this version
                 client.write('OK AUDIO=0\n');
+                _fanOut.add(client);
                 _log('Client $clientAddress authenticated (audio disabled)');
                 onClientCountChanged?.call(_clients.length);
                 _ensureStreamingStarted();
@@ -201,10 +211,12 @@ class AVStreamServer {
       _log('No clients, streaming paused');
       _startIdleTimer();
     }
-    
-    try { client.close(); } catch (e) {
-  debugPrint('[AvStreamService] Error: $e');
-}
+
+    final dropped = _fanOut.droppedFor(client);
+    if (dropped > 0) {
+      _log('Client fell behind $dropped times; those frames were dropped');
+    }
+    _fanOut.close(client);
   }
   
   void _startIdleTimer() {
@@ -260,17 +272,7 @@ class AVStreamServer {
         return;
       }
       
-      final header = 'FRAME ${imageData.length}\n';
-      final headerBytes = utf8.encode(header);
-      
-      for (final client in _clients.toList()) {
-        try {
-          client.add(headerBytes);
-          client.add(imageData);
-        } catch (e) {
-          _removeClient(client);
-        }
-      }
+      _fanOut.send(_clients.toList(), StreamPacket('FRAME ${imageData.length}\n', [imageData]));
     } catch (e) {
       _log('Video capture error: $e');
     } finally {
@@ -0,0 +1,194 @@
+import 'dart:collection';
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:flutter/foundation.dart';
+
+/// One message of a stream (a header line and its binary payloads), built
+/// once per capture and shared by every viewer queue it is put on; the
+/// buffers are only referenced, never copied, and are freed once the last
+/// queue lets go of them.
+class StreamPacket {
+  final List<Uint8List> chunks;
+
+  /// Applies on top of the packet before it (TILES), so it cannot be shown
+  /// if that one was dropped
+  final bool delta;
+
+  StreamPacket(String header, List<Uint8List> payloads, {this.delta = false})
+      : chunks = [utf8.encode(header), ...payloads];
+
+  int get length => chunks.fold(0, (total, chunk) => total + chunk.length);
+}
+
+/// Sends each packet of a stream to many viewers without letting a slow one
+/// hold up or bloat the others.
+///
+/// Every viewer has its own queue of at most [maxQueued] packets behind the
+/// one being written. A packet is written only once the socket has taken
+/// the previous one (its flush completed, i.e. the OS accepted every byte),
+/// so nothing piles up in socket buffers; when the queue is full the oldest
+/// packet is dropped and counted, and the newest always wins. Deltas that
+/// would follow a dropped packet are dropped as well, and [onResync] asks
+/// for a whole frame for that viewer.
+///
+/// Viewers may acknowledge each packet once read (see [ack]); the last
+/// [maxUnacked] packets written to each are remembered for that.
+///
+/// Once a socket is added, everything written to it must go through [send]:
+/// a socket cannot be written while a flush is pending.
+class FrameFanOut {
+  final int maxQueued;
+  static const int maxUnacked = 64;
+
+  /// A viewer lost deltas and needs a whole frame before the next ones
+  final void Function(Socket client)? onResync;
+
+  /// Writing to a viewer failed; it has been dropped from the fan-out
+  final void Function(Socket client, Object error)? onError;
+
+  final Map<Socket, _ClientQueue> _queues = {};
+  final Stopwatch _clock = Stopwatch()..start();
+  int _droppedPackets = 0;
+
+  FrameFanOut({this.maxQueued = 1, this.onResync, this.onError});
+
+  /// Packets dropped for all viewers so far
+  int get droppedPackets => _droppedPackets;
+
+  /// Packets dropped for [client] so far
+  int droppedFor(Socket client) => _queues[client]?.dropped ?? 0;
+
+  /// Bytes written to [client] so far
+  int sentFor(Socket client) => _queues[client]?.sent ?? 0;
+
+  /// How long ago the oldest packet [client] has not acknowledged was
+  /// written, null when it is up to date
+  Duration? unackedAge(Socket client) {
+    final queue = _queues[client];
+    if (queue == null || queue.unacked.isEmpty) return null;
+    return Duration(
+        microseconds: _clock.elapsedMicroseconds - queue.unacked.first.$2);
+  }
+
+  /// Bytes waiting in every queue, including packets being written
+  int get queuedBytes => _queues.values.fold(0, (total, queue) => total + queue.bytes);
+
+  void add(Socket client) {
+    _queues.putIfAbsent(client, () => _ClientQueue(client));
+  }
+
+  /// Queues [packet] for each of [clients] that was added
+  void send(Iterable<Socket> clients, StreamPacket packet) {
+    for (final client in clients) {
+      final queue = _queues[client];
+      if (queue == null) continue;
+      _enqueue(queue, packet);
+      _pump(queue);
+    }
+  }
+
+  /// [client] has read the oldest packet written to it that it had not
+  /// acknowledged. Returns its size and how long ago it was written, or null
+  /// if there is none.
+  ({int bytes, Duration delivery})? ack(Socket client) {
+    final queue = _queues[client];
+    if (queue == null || queue.unacked.isEmpty) return null;
+    final (bytes, writtenUs) = queue.unacked.removeFirst();
+    return (
+      bytes: bytes,
+      delivery: Duration(microseconds: _clock.elapsedMicroseconds - writtenUs),
+    );
+  }
+
+  /// Removes [client] and closes it, discarding whatever it had queued
+  Future<void> close(Socket client) async {
+    final queue = _queues.remove(client);
+    queue?.pending.clear();
+    if (queue != null && queue.writing) {
+      // close() throws while a flush is pending
+      client.destroy();
+      return;
+    }
+    try {
+      await client.close();
+    } catch (e) {
+      debugPrint('[FrameFanOut] Error closing client: $e');
+      client.destroy();
+    }
+  }
+
+  /// Closes every viewer
+  Future<void> closeAll() async {
+    await Future.wait(_queues.keys.toList().map(close));
+  }
+
+  void _enqueue(_ClientQueue queue, StreamPacket packet) {
+    if (queue.pending.length < maxQueued) {
+      queue.pending.add(packet);
+      return;
+    }
+    queue.pending.removeFirst();
+    _drop(queue);
+    // Deltas up to the next whole frame built on the dropped packet
+    while (queue.pending.isNotEmpty && queue.pending.first.delta) {
+      queue.pending.removeFirst();
+      _drop(queue);
+    }
+    if (queue.pending.isEmpty && packet.delta) {
+      _drop(queue);
+      onResync?.call(queue.socket);
+      return;
+    }
+    queue.pending.add(packet);
+  }
+
+  void _drop(_ClientQueue queue) {
+    queue.dropped++;
+    _droppedPackets++;
+  }
+
+  Future<void> _pump(_ClientQueue queue) async {
+    if (queue.writing) return;
+    queue.writing = true;
+    try {
+      while (queue.pending.isNotEmpty) {
+        final packet = queue.pending.removeFirst();
+        queue.inFlight = packet.length;
+        for (final chunk in packet.chunks) {
+          queue.socket.add(chunk);
+        }
+        queue.sent += packet.length;
+        queue.unacked.addLast((packet.length, _clock.elapsedMicroseconds));
+        if (queue.unacked.length > maxUnacked) queue.unacked.removeFirst();
+        // Completes as the socket drains; the next packet is whatever is
+        // newest by then
+        await queue.socket.flush();
+        queue.inFlight = 0;
+      }
+    } catch (e) {
+      if (_queues.remove(queue.socket) != null) {
+        queue.pending.clear();
+        onError?.call(queue.socket, e);
+      }
+    } finally {
+      queue.writing = false;
+      queue.inFlight = 0;
+    }
+  }
+}
+
+class _ClientQueue {
+  final Socket socket;
+  final ListQueue<StreamPacket> pending = ListQueue();
+  bool writing = false;
+  int inFlight = 0;
+  int dropped = 0;
+  int sent = 0;
+  // Size and write time of the packets not acknowledged yet, oldest first
+  final ListQueue<(int, int)> unacked = ListQueue();
+
+  _ClientQueue(this.socket);
+
+  int get bytes => pending.fold(inFlight, (total, packet) => total + packet.length);
+}
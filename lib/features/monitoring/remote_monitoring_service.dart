@@ -18,6 +18,8 @@ import 'package:path_provider/path_provider.dart';
 import 'package:image/image.dart' as img;
 
 import '../../config/api_config.dart';
+import '../../core/services/native_log.dart';
+import '../../core/services/native_screen_capture.dart';
 import '../../core/services/version_check_service.dart';
 import '../../core/services/websocket_client.dart';
 import '../admin/privacy_exclusions_service.dart';
@@ -584,11 +586,11 @@ class RemoteMonitoringService {
     _screenshotIntervalMinutes = screenshotIntervalMinutes;
     
     _log('=== INITIALIZATION ===');
-    _log('Computer: $computerName');
-    _log('Username: $username');
-    _log('Screenshot interval: $screenshotIntervalMinutes minutes');
-    _log('Platform: ${Platform.operatingSystem}');
-    _log('Is Windows: ${Platform.isWindows}');
+    _log('Computer: {}', [computerName]);
+    _log('Username: {}', [username]);
+    _log('Screenshot interval: {} minutes', [screenshotIntervalMinutes]);
+    _log('Platform: {}', [Platform.operatingSystem]);
+    _log('Is Windows: {}', [Platform.isWindows]);
   }
   
   /// Start all monitoring services
@@ -598,7 +600,7 @@ class RemoteMonitoringService {
       return;
     }
     if (_computerName == null || _username == null) {
-      _log('ERROR: Cannot start - not initialized (computerName=$_computerName, username=$_username)');
+      _log('ERROR: Cannot start - not initialized (computerName={}, username={})', [_computerName, _username]);
       return;
     }
 
@@ -618,7 +620,7 @@ class RemoteMonitoringService {
     _startHeartbeat();
 
     // Start periodic screenshots
-    _log('Starting screenshot timer (every $_screenshotIntervalMinutes minutes)...');
+    _log('Starting screenshot timer (every {} minutes)...', [_screenshotIntervalMinutes]);
     _startScreenshotTimer();
 
     // Start command polling (every 500ms for responsiveness)
@@ -628,7 +630,7 @@ class RemoteMonitoringService {
     // Take initial screenshot
     _log('Taking initial screenshot...');
     final success = await _captureAndUploadScreenshot();
-    _log('Initial screenshot result: ${success ? "SUCCESS" : "FAILED"}');
+    _log('Initial screenshot result: {}', [success ? "SUCCESS" : "FAILED"]);
 
     _log('=== SERVICES STARTED ===');
   }
@@ -662,7 +664,7 @@ class RemoteMonitoringService {
     try {
       await PrivacyInjectionService.removeAllExclusions();
     } catch (e) {
-      _log('Warning: Failed to remove privacy exclusions: $e');
+      _log('Warning: Failed to remove privacy exclusions: {}', [e]);
     }
 
     _log('Remote monitoring services stopped');
@@ -698,9 +700,16 @@ class RemoteMonitoringService {
   // PRIVATE METHODS
   // ===========================================================================
   
-  void _log(String message) {
-    debugPrint('[RemoteMonitoring] $message');
-    onLog?.call(message);
+  /// Logs [format] with each `{}` standing for the next of [args] (see
+  /// [NativeLog.write]); [onLog] gets the formatted text.
+  void _log(String format, [List<Object?> args = const []]) {
+    final level = format.startsWith('ERROR') || format.startsWith('Error')
+        ? NativeLogLevel.error
+        : format.startsWith('Warning')
+            ? NativeLogLevel.warning
+            : NativeLogLevel.info;
+    NativeLog.instance.write(level, 'RemoteMonitoring', format, args);
+    onLog?.call(NativeLog.format(format, args));
   }
 
   /// Apply privacy exclusions from the server
@@ -718,12 +727,12 @@ class RemoteMonitoringService {
         return;
       }
 
-      _log('Applying ${exclusions.length} privacy exclusions: $exclusions');
+      _log('Applying {} privacy exclusions: {}', [exclusions.length, exclusions]);
 
       // Use updateExclusions to handle adding/removing properly
       await PrivacyInjectionService.updateExclusions(exclusions);
     } catch (e) {
-      _log('Error applying privacy exclusions: $e');
+      _log('Error applying privacy exclusions: {}', [e]);
     }
   }
 
@@ -753,16 +762,16 @@ class RemoteMonitoringService {
     try {
       _log('Sending heartbeat...');
       final screenSize = Platform.isWindows ? WindowsScreenCapture.getScreenSize() : (0, 0);
-      _log('Screen size: ${screenSize.$1}x${screenSize.$2}');
+      _log('Screen size: {}x{}', [screenSize.$1, screenSize.$2]);
 
       final localIp = await _getLocalIp();
-      _log('Local IP: $localIp');
+      _log('Local IP: {}', [localIp]);
 
       // Get app version from VersionCheckService (dynamically from pubspec.yaml)
       final appVersion = VersionCheckService.instance.currentVersion;
 
       final url = '$_baseUrl?action=heartbeat';
-      _log('Heartbeat URL: $url');
+      _log('Heartbeat URL: {}', [url]);
 
       final response = await http.post(
         Uri.parse(url),
@@ -777,16 +786,16 @@ class RemoteMonitoringService {
         },
       ).timeout(const Duration(seconds: 10));
       
-      _log('Heartbeat response: ${response.statusCode}');
-      _log('Heartbeat body: ${response.body}');
+      _log('Heartbeat response: {}', [response.statusCode]);
+      _log('Heartbeat body: {}', [response.body]);
       
       if (response.statusCode == 200) {
         final data = jsonDecode(response.body);
         
         if (data['success'] == true) {
-          _log('Heartbeat SUCCESS - stream_requested: ${data['stream_requested']}');
+          _log('Heartbeat SUCCESS - stream_requested: {}', [data['stream_requested']]);
         } else {
-          _log('Heartbeat FAILED: ${data['error']}');
+          _log('Heartbeat FAILED: {}', [data['error']]);
         }
         
         // Check if streaming is requested
@@ -805,11 +814,11 @@ class RemoteMonitoringService {
           _stopAudioStreaming();
         }
       } else {
-        _log('Heartbeat HTTP error: ${response.statusCode}');
+        _log('Heartbeat HTTP error: {}', [response.statusCode]);
       }
     } catch (e, stack) {
-      _log('Heartbeat exception: $e');
-      _log('Stack: $stack');
+      _log('Heartbeat exception: {}', [e]);
+      _log('Stack: {}', [stack]);
     }
   }
   
@@ -854,47 +863,27 @@ class RemoteMonitoringService {
       // Privacy exclusions are applied continuously at startup and refreshed every 2 minutes
       // Windows with WDA_EXCLUDEFROMCAPTURE will automatically appear black in screenshots
 
-      _log('Step 1: Capturing screen via FFI...');
-
-      // Capture screen
-      Uint8List? bmpData;
-      try {
-        bmpData = WindowsScreenCapture.captureScreen();
-      } catch (e, stack) {
-        _log('FFI capture exception: $e');
-        _log('Stack: $stack');
-        return false;
-      }
-
-      if (bmpData == null) {
-        _log('ERROR: FFI capture returned null');
-        return false;
-      }
-
-      _log('Step 2: BMP captured, size: ${bmpData.length} bytes');
-
-      // Convert to JPEG for smaller file size
-      _log('Step 3: Converting BMP to JPEG...');
+      _log('Step 1: Capturing screen...');
       Uint8List? jpgData;
       try {
-        jpgData = await _convertBmpToJpg(bmpData);
+        jpgData = await _captureJpeg();
       } catch (e, stack) {
-        _log('JPEG conversion exception: $e');
-        _log('Stack: $stack');
+        _log('Capture exception: {}', [e]);
+        _log('Stack: {}', [stack]);
         return false;
       }
 
       if (jpgData == null) {
-        _log('ERROR: JPEG conversion returned null');
+        _log('ERROR: Screen capture failed');
         return false;
       }
 
-      _log('Step 4: JPEG ready, size: ${jpgData.length} bytes');
+      _log('Step 2: JPEG ready, size: {} bytes', [jpgData.length]);
 
       // Upload to server
-      _log('Step 5: Uploading to server...');
+      _log('Step 3: Uploading to server...');
       final url = '$_baseUrl?action=upload_screenshot';
-      _log('Upload URL: $url');
+      _log('Upload URL: {}', [url]);
 
       final request = http.MultipartRequest('POST', Uri.parse(url));
       request.fields['computer_name'] = _computerName!;
@@ -905,8 +894,8 @@ class RemoteMonitoringService {
       final response = await request.send().timeout(const Duration(seconds: 30));
       final responseBody = await response.stream.bytesToString();
 
-      _log('Upload response status: ${response.statusCode}');
-      _log('Upload response body: $responseBody');
+      _log('Upload response status: {}', [response.statusCode]);
+      _log('Upload response body: {}', [responseBody]);
 
       if (response.statusCode == 200) {
         final data = jsonDecode(responseBody);
@@ -914,25 +903,44 @@ class RemoteMonitoringService {
           _log('=== SCREENSHOT SUCCESS ===');
           return true;
         } else {
-          _log('ERROR: Server returned success=false: ${data['error']}');
+          _log('ERROR: Server returned success=false: {}', [data['error']]);
         }
       } else {
-        _log('ERROR: HTTP ${response.statusCode}');
+        _log('ERROR: HTTP {}', [response.statusCode]);
       }
 
       return false;
     } catch (e, stack) {
-      _log('Screenshot exception: $e');
-      _log('Stack: $stack');
+      _log('Screenshot exception: {}', [e]);
+      _log('Stack: {}', [stack]);
       onError?.call('Screenshot failed: $e');
       return false;
     }
   }
   
+  /// Capture the screen as JPEG. The runner captures and encodes natively
+  /// when it can; otherwise the screen is grabbed as BMP over FFI and
+  /// encoded in Dart on a background isolate.
+  Future<Uint8List?> _captureJpeg({int quality = 75}) async {
+    final native = NativeScreenCapture.instance;
+    if (native.isSupported) {
+      final frame = await native.capture(quality: quality);
+      if (frame != null) return frame.jpeg;
+      _log('Warning: Native capture failed, falling back to FFI capture');
+    }
+
+    final bmpData = WindowsScreenCapture.captureScreen();
+    if (bmpData == null) {
+      _log('ERROR: FFI capture returned null');
+      return null;
+    }
+    return _convertBmpToJpg(bmpData, quality: quality);
+  }
+
   /// Convert BMP to JPEG using the image package (pure Dart, no external processes)
   /// This is significantly faster than spawning PowerShell for each conversion
   Future<Uint8List?> _convertBmpToJpg(Uint8List bmpData, {int quality = 75}) async {
-    _log('Converting BMP (${bmpData.length} bytes) to JPEG using image package...');
+    _log('Converting BMP ({} bytes) to JPEG using image package...', [bmpData.length]);
 
     try {
       // Use compute to run the CPU-intensive conversion on a background isolate
@@ -942,15 +950,15 @@ class RemoteMonitoringService {
       ));
 
       if (result != null) {
-        _log('JPEG conversion complete: ${result.length} bytes');
+        _log('JPEG conversion complete: {} bytes', [result.length]);
       } else {
         _log('JPEG conversion returned null');
       }
 
       return result;
     } catch (e, stack) {
-      _log('BMP to JPG exception: $e');
-      _log('Stack: $stack');
+      _log('BMP to JPG exception: {}', [e]);
+      _log('Stack: {}', [stack]);
 
       // Fallback to PowerShell if the image package fails
       _log('Falling back to PowerShell conversion...');
@@ -990,7 +998,7 @@ class RemoteMonitoringService {
       }
       return null;
     } catch (e) {
-      _log('PowerShell fallback failed: $e');
+      _log('PowerShell fallback failed: {}', [e]);
       return null;
     } finally {
       await _cleanupTempFile(bmpPath);
@@ -1049,11 +1057,11 @@ class RemoteMonitoringService {
             _handleWebSocketCommand(data);
           }
         } catch (e) {
-          _log('Error parsing WebSocket command: $e');
+          _log('Error parsing WebSocket command: {}', [e]);
         }
       },
       onError: (error) {
-        _log('WebSocket command error: $error');
+        _log('WebSocket command error: {}', [error]);
         // Fall back to polling on WebSocket errors
         _startCommandPollingFallback();
       },
@@ -1082,7 +1090,7 @@ class RemoteMonitoringService {
     final commandType = data['type'] ?? data['command_type'];
     if (commandType == null) return;
 
-    _log('Received WebSocket command: $commandType');
+    _log('Received WebSocket command: {}', [commandType]);
 
     // Convert WebSocket format to expected command format
     final cmd = {
@@ -1130,7 +1138,7 @@ class RemoteMonitoringService {
     final commandType = cmd['command_type'] as String;
     final commandData = cmd['command_data'] as Map<String, dynamic>? ?? {};
     
-    _log('Executing command: $commandType');
+    _log('Executing command: {}', [commandType]);
     
     try {
       switch (commandType) {
@@ -1229,7 +1237,7 @@ class RemoteMonitoringService {
       // Acknowledge command
       await _acknowledgeCommand(commandId);
     } catch (e) {
-      _log('Command execution failed: $e');
+      _log('Command execution failed: {}', [e]);
     }
   }
   
@@ -1253,10 +1261,10 @@ class RemoteMonitoringService {
     _isStreaming = true;
     onStreamingChanged?.call(true);
     _log('=== STARTING LIVE STREAM ===');
-    _log('FPS: $_streamFps, Quality: $_streamQuality');
+    _log('FPS: {}, Quality: {}', [_streamFps, _streamQuality]);
     
     final intervalMs = (1000 / _streamFps).round();
-    _log('Frame interval: ${intervalMs}ms');
+    _log('Frame interval: {}ms', [intervalMs]);
     _streamTimer = Timer.periodic(Duration(milliseconds: intervalMs), (_) => _captureAndStreamFrame());
   }
   
@@ -1277,15 +1285,9 @@ class RemoteMonitoringService {
       // Privacy exclusions are applied continuously at startup
       // Windows with WDA_EXCLUDEFROMCAPTURE will automatically appear black
 
-      final bmpData = WindowsScreenCapture.captureScreen();
-      if (bmpData == null) {
-        _log('Stream frame: capture failed');
-        return;
-      }
-
-      final jpgData = await _convertBmpToJpg(bmpData, quality: _streamQuality);
+      final jpgData = await _captureJpeg(quality: _streamQuality);
       if (jpgData == null) {
-        _log('Stream frame: conversion failed');
+        _log('Stream frame: capture failed');
         return;
       }
 
@@ -1296,10 +1298,10 @@ class RemoteMonitoringService {
 
       final response = await request.send().timeout(const Duration(seconds: 5));
       if (response.statusCode != 200) {
-        _log('Stream frame upload failed: ${response.statusCode}');
+        _log('Stream frame upload failed: {}', [response.statusCode]);
       }
     } catch (e) {
-      _log('Stream frame error: $e');
+      _log('Stream frame error: {}', [e]);
     }
   }
 
@@ -1358,7 +1360,7 @@ class RemoteMonitoringService {
 
       // Check if bundled ffmpeg exists
       if (!await File(ffmpegPath).exists()) {
-        _log('FFmpeg not found at: $ffmpegPath');
+        _log('FFmpeg not found at: {}', [ffmpegPath]);
         return;
       }
 
@@ -1410,7 +1412,7 @@ exit 1
       ]).timeout(const Duration(seconds: 8));
 
       if (result.exitCode != 0) {
-        _log('Audio capture failed: ${result.stderr}');
+        _log('Audio capture failed: {}', [result.stderr]);
         return;
       }
 
@@ -1427,7 +1429,7 @@ exit 1
         return;
       }
 
-      _log('Audio captured: ${audioData.length} bytes');
+      _log('Audio captured: {} bytes', [audioData.length]);
 
       // Upload audio chunk
       final request = http.MultipartRequest('POST', Uri.parse('$_baseUrl?action=audio_frame'));
@@ -1438,7 +1440,7 @@ exit 1
       if (response.statusCode == 200) {
         _log('Audio chunk uploaded successfully');
       } else {
-        _log('Audio upload failed: ${response.statusCode}');
+        _log('Audio upload failed: {}', [response.statusCode]);
       }
 
       // Cleanup
@@ -1448,7 +1450,7 @@ exit 1
   debugPrint('[RemoteMonitoringService] Error: $e');
 }
     } catch (e) {
-      _log('Audio capture error: $e');
+      _log('Audio capture error: {}', [e]);
     }
   }
 }
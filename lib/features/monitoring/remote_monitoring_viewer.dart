@@ -19,6 +19,7 @@ import 'package:intl/intl.dart';
 import 'package:path_provider/path_provider.dart';
 import '../../app_theme.dart';
 import '../../config/api_config.dart';
+import '../../core/services/app_visibility_service.dart';
 
 class RemoteMonitoringViewer extends StatefulWidget {
   final String computerName;
@@ -104,15 +105,26 @@ class _RemoteMonitoringViewerState extends State<RemoteMonitoringViewer> with Si
     _loadScreenshots();
     _loadComputerStatus();
     
-    // Auto-refresh screenshots every 30 seconds
+    // Auto-refresh screenshots every 30 seconds while the window is visible
     _screenshotRefreshTimer = Timer.periodic(
       const Duration(seconds: 30),
-      (_) => _loadScreenshots(),
+      (_) {
+        if (AppVisibilityService.instance.isVisible) _loadScreenshots();
+      },
     );
+    AppVisibilityService.instance.visible.addListener(_onVisibilityChanged);
+  }
+
+  void _onVisibilityChanged() {
+    // Catch up on what was skipped while minimized or covered
+    if (AppVisibilityService.instance.isVisible && mounted) {
+      _loadScreenshots();
+    }
   }
   
   @override
   void dispose() {
+    AppVisibilityService.instance.visible.removeListener(_onVisibilityChanged);
     _tabController.dispose();
     _screenshotRefreshTimer?.cancel();
     _streamPollTimer?.cancel();
@@ -540,7 +552,8 @@ class _RemoteMonitoringViewerState extends State<RemoteMonitoringViewer> with Si
   }
   
   Future<void> _pollStreamFrame() async {
-    if (!_isStreaming) return;
+    // Nothing to show frames to while the window is minimized or covered
+    if (!_isStreaming || !AppVisibilityService.instance.isVisible) return;
 
     try {
       final url = '${ApiConfig.remoteMonitoring}?action=get_stream&computer=${Uri.encodeComponent(widget.computerName)}&since=$_lastFrameTimestamp';
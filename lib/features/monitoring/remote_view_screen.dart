@@ -10,6 +10,7 @@ import 'package:http/http.dart' as http;
 import 'package:intl/intl.dart';
 import '../../config/api_config.dart';
 import '../../app_theme.dart';
+import '../../core/services/app_visibility_service.dart';
 
 class RemoteViewScreen extends StatefulWidget {
   final String computerName;
@@ -70,9 +71,9 @@ class _RemoteViewScreenState extends State<RemoteViewScreen> {
     super.initState();
     _loadScreenshotList();
     
-    // Auto-refresh every 30 seconds
+    // Auto-refresh every 30 seconds while the window is visible
     _refreshTimer = Timer.periodic(const Duration(seconds: 30), (_) {
-      _loadScreenshotList();
+      if (AppVisibilityService.instance.isVisible) _loadScreenshotList();
     });
   }
 
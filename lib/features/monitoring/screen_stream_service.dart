@@ -7,14 +7,45 @@
 // - Reduced default FPS from 10 to 2 FPS
 // - Added rate limiting to prevent capture backlog
 // - Max FPS clamped to 4 to prevent system overload
+// - TILES mode: only changed tiles are sent, which allows up to 15 FPS
 
 import 'dart:async';
 import 'dart:convert';
 import 'dart:io';
 import 'package:flutter/foundation.dart';
 
+import '../../core/services/native_screen_capture.dart';
+import 'frame_fan_out.dart';
+import 'stream_rate_controller.dart';
+
 /// Screen streaming server for A1 Tools remote monitoring
 /// Runs on target PCs and streams screen captures to connected viewers
+///
+/// Protocol (text lines, binary payloads):
+/// - Viewer: `AUTH <password>`, answered `OK` or `FAIL`; then `SET_FPS <n>`,
+///   `SET_QUALITY <n>`, `SET_SCALE <x>`, `SET_MODE TILES`, `SET_RATE AUTO`
+///   and an `ACK` after reading each FRAME or TILES.
+/// - Server: `FRAME <size>` and a whole-frame JPEG.
+/// - In TILES mode (when [onCaptureTiles] is set) a viewer gets one FRAME to
+///   start from and afterwards only what changed:
+///   `TILES <width> <height> <tileSize> <count> <atlasSize>`, then <count>
+///   little-endian uint16 tile indices (row-major in the frame's tile grid)
+///   and a JPEG atlas holding those tiles in order, left to right and top to
+///   bottom. Frame and tiles are at the SET_SCALE size; after a scale change
+///   every tile is resent at the new size. A FRAME may follow at any time
+///   and replaces the picture. Older servers ignore SET_MODE and keep
+///   sending FRAMEs.
+///
+/// Each capture is encoded once and fanned out to every viewer through its
+/// own short queue ([FrameFanOut]): a viewer that cannot keep up skips
+/// frames (and gets a FRAME again if it missed tiles) without slowing the
+/// others or growing socket buffers.
+///
+/// FPS, quality and scale are picked by a [StreamRateController] from the
+/// ACKs and capture timings, never above what viewers asked for with
+/// SET_FPS, SET_QUALITY and SET_SCALE; `SET_RATE AUTO` lifts those limits
+/// to the controller's bounds. Quality and scale reach [onCaptureTiles];
+/// an [onCaptureScreen] callback can read them from [quality] and [scale].
 class ScreenStreamServer {
   static const int defaultPort = 5901;
   static const String authPassword = 'a1stream';
@@ -28,29 +59,73 @@ class ScreenStreamServer {
   
   // Callback to capture screen (provided by app)
   final Future<Uint8List?> Function()? onCaptureScreen;
+  // Tiled capture for TILES mode, normally NativeScreenCapture.captureTiles
+  final Future<CapturedTiles?> Function({
+    required int quality,
+    required double scale,
+    required bool full,
+  })? onCaptureTiles;
   final void Function(String message)? onLog;
   final void Function(int clientCount)? onClientCountChanged;
   final void Function()? onIdleStop;
+  // Called once per rate controller period while streaming
+  final void Function(StreamRateStats stats)? onRateStats;
   
   // Settings - REDUCED from 100ms (10 FPS) to 500ms (2 FPS)
   int _captureIntervalMs = 500; // 2 FPS default
-  static const int _minIntervalMs = 250; // Max 4 FPS
-  int _quality = 50;
-  double _scale = 0.5;
+  int _requestedFps = 2;
+  // Whole frames are encoded every tick while any viewer takes FRAMEs;
+  // tiles only cost what changed
+  static const int _maxFrameFps = 4;
+  static const int _maxTileFps = 15;
+  // Picks FPS, quality and scale, up to what viewers asked for
+  final StreamRateController _rate = StreamRateController(
+    fps: 2,
+    quality: 50,
+    scale: 0.5,
+  );
   
   // Rate limiting - prevent capture backlog
   bool _captureInProgress = false;
   int _skippedFrames = 0;
+
+  // Viewers in TILES mode, and those of them still waiting for a FRAME to
+  // apply tiles to
+  final Set<Socket> _tileClients = {};
+  final Set<Socket> _needsKeyframe = {};
+
+  // Tile updates are small and losing one costs a whole frame, so viewers
+  // may fall a few behind before anything is dropped
+  late final FrameFanOut _fanOut = FrameFanOut(
+    maxQueued: 3,
+    onResync: (client) => _needsKeyframe.add(client),
+    onError: (client, e) {
+      _log('Error sending to client: $e');
+      _removeClient(client);
+    },
+  );
   
   ScreenStreamServer({
     this.onCaptureScreen,
+    this.onCaptureTiles,
     this.onLog,
     this.onClientCountChanged,
     this.onIdleStop,
+    this.onRateStats,
   });
   
   bool get isRunning => _isRunning;
   int get clientCount => _clients.length;
+
+  /// JPEG quality and scale the rate controller currently wants
+  int get quality => _rate.quality;
+  double get scale => _rate.scale;
+
+  /// The rate controller's last measurements and decision
+  StreamRateStats? get rateStats => _rate.stats;
+
+  /// Frames and tile updates not sent to slow viewers
+  int get droppedFrames => _fanOut.droppedPackets;
   
   /// Start the streaming server
   Future<bool> start({int port = defaultPort}) async {
@@ -91,14 +166,10 @@ class ScreenStreamServer {
     _idleTimer = null;
     _captureInProgress = false;
 
-    for (final client in _clients.toList()) {
-      try {
-        await client.close();
-      } catch (e) {
-        if (kDebugMode) debugPrint('[ScreenStreamService] Error closing client: $e');
-      }
-    }
+    await _fanOut.closeAll();
     _clients.clear();
+    _tileClients.clear();
+    _needsKeyframe.clear();
 
     try {
       await _server?.close();
@@ -144,8 +215,10 @@ class ScreenStreamServer {
                 _clients.add(client);
                 _cancelIdleTimer();
                 client.write('OK\n');
+                _fanOut.add(client);
                 _log('Client $clientAddress authenticated');
                 onClientCountChanged?.call(_clients.length);
+                _applyFrameRate();
                 _ensureStreamingStarted();
               } else {
                 client.write('FAIL\n');
@@ -175,33 +248,62 @@ class ScreenStreamServer {
   /// Handle commands from authenticated clients
   void _handleCommand(Socket client, String command) {
     if (command.startsWith('SET_FPS ')) {
-      final fps = int.tryParse(command.substring(8)) ?? 2;
-      // Clamp FPS to prevent overload - max 4 FPS
-      final clampedFps = fps.clamp(1, 4);
-      _captureIntervalMs = (1000 / clampedFps).round().clamp(_minIntervalMs, 2000);
-      _log('FPS set to $clampedFps (interval: ${_captureIntervalMs}ms)');
-      
-      // Restart timer with new interval
-      if (_captureTimer != null) {
-        _captureTimer?.cancel();
-        _captureTimer = Timer.periodic(
-          Duration(milliseconds: _captureIntervalMs),
-          (_) => _captureAndSend(),
-        );
-      }
+      _requestedFps = int.tryParse(command.substring(8)) ?? 2;
+      _applyFrameRate();
+    } else if (command == 'SET_MODE TILES') {
+      if (onCaptureTiles == null) return;
+      _tileClients.add(client);
+      _needsKeyframe.add(client);
+      _log('Client switched to TILES mode');
+      _applyFrameRate();
     } else if (command.startsWith('SET_QUALITY ')) {
-      _quality = (int.tryParse(command.substring(12)) ?? 50).clamp(10, 90);
-      _log('Quality set to $_quality');
+      final quality = (int.tryParse(command.substring(12)) ?? 50).clamp(10, 90);
+      _rate.setCeilings(quality: quality);
+      _log('Quality limited to $quality');
     } else if (command.startsWith('SET_SCALE ')) {
-      _scale = (double.tryParse(command.substring(10)) ?? 0.5).clamp(0.25, 1.0);
-      _log('Scale set to $_scale');
+      final scale = (double.tryParse(command.substring(10)) ?? 0.5).clamp(0.25, 1.0);
+      _rate.setCeilings(scale: scale);
+      _log('Scale limited to $scale');
+    } else if (command == 'SET_RATE AUTO') {
+      _requestedFps = _maxTileFps;
+      _rate.setAutomatic();
+      _log('Rate set to automatic');
+      _applyFrameRate();
+    } else if (command == 'ACK') {
+      final ack = _fanOut.ack(client);
+      if (ack != null) _rate.onAck(client, ack.bytes, ack.delivery);
     }
   }
   
+  /// Clamp the requested FPS to prevent overload: max 4 FPS while any
+  /// viewer takes whole frames, 15 when all of them take tiles
+  void _applyFrameRate() {
+    final allTiles = _clients.isNotEmpty && _clients.every(_tileClients.contains);
+    _rate.setCeilings(fps: _requestedFps.clamp(1, allTiles ? _maxTileFps : _maxFrameFps));
+    final fps = _rate.fps;
+    final intervalMs = (1000 / fps).round();
+    if (intervalMs == _captureIntervalMs) return;
+    _captureIntervalMs = intervalMs;
+    _log('FPS set to $fps (interval: ${_captureIntervalMs}ms)');
+
+    // Restart timer with new interval
+    if (_captureTimer != null) {
+      _captureTimer?.cancel();
+      _captureTimer = Timer.periodic(
+        Duration(milliseconds: _captureIntervalMs),
+        (_) => _captureAndSend(),
+      );
+    }
+  }
+
   /// Remove a client from the list
   void _removeClient(Socket client) {
-    _clients.remove(client);
+    if (!_clients.remove(client)) return;
+    _tileClients.remove(client);
+    _needsKeyframe.remove(client);
+    _rate.removeClient(client);
     onClientCountChanged?.call(_clients.length);
+    _applyFrameRate();
     
     if (_clients.isEmpty) {
       _captureTimer?.cancel();
@@ -210,12 +312,12 @@ class ScreenStreamServer {
       _log('No clients connected, streaming paused');
       _startIdleTimer();
     }
-    
-    try {
-      client.close();
-    } catch (e) {
-  debugPrint('[ScreenStreamService] Error: $e');
-}
+
+    final dropped = _fanOut.droppedFor(client);
+    if (dropped > 0) {
+      _log('Client fell behind $dropped times; those frames were dropped');
+    }
+    _fanOut.close(client);
   }
   
   void _startIdleTimer() {
@@ -254,7 +356,9 @@ class ScreenStreamServer {
   
   /// Capture screen and send to all clients
   Future<void> _captureAndSend() async {
-    if (_clients.isEmpty || onCaptureScreen == null) return;
+    if (_clients.isEmpty) return;
+    final tiles = onCaptureTiles != null && _tileClients.isNotEmpty;
+    if (!tiles && onCaptureScreen == null) return;
     
     // Rate limiting - skip if previous capture hasn't finished
     if (_captureInProgress) {
@@ -266,34 +370,72 @@ class ScreenStreamServer {
     }
     
     _captureInProgress = true;
+    final captureTime = Stopwatch()..start();
     
     try {
+      if (tiles) {
+        await _captureAndSendTiles();
+        return;
+      }
       final imageData = await onCaptureScreen!();
       if (imageData == null || imageData.isEmpty) {
         return;
       }
-      
-      // Protocol: FRAME <size>\n<binary data>
-      final header = 'FRAME ${imageData.length}\n';
-      final headerBytes = utf8.encode(header);
-      
-      // Send to all connected clients
-      for (final client in _clients.toList()) {
-        try {
-          client.add(headerBytes);
-          client.add(imageData);
-        } catch (e) {
-          _log('Error sending to client: $e');
-          _removeClient(client);
-        }
-      }
+      _fanOut.send(_clients.toList(), StreamPacket('FRAME ${imageData.length}\n', [imageData]));
     } catch (e) {
       _log('Capture error: $e');
     } finally {
       _captureInProgress = false;
+      _rate.onCapture(captureTime.elapsed);
+      _updateRate();
     }
   }
+
+  /// Let the rate controller adjust the settings once per period
+  void _updateRate() {
+    if (_clients.isEmpty) return;
+    final stats = _rate.update(_fanOut, skippedFrames: _skippedFrames);
+    if (stats == null) return;
+    onRateStats?.call(stats);
+    if (stats.reason != 'steady') _log('Rate: $stats');
+    _applyFrameRate();
+  }
   
+  /// One tiled capture serves everyone: viewers in sync get the changed
+  /// tiles, the rest (FRAME viewers and new TILES viewers) the whole frame.
+  Future<void> _captureAndSendTiles() async {
+    // Viewers that connect or switch mode meanwhile wait for the next tick
+    final synced = _tileClients.where((c) => !_needsKeyframe.contains(c)).toList();
+    final needFrame = _clients.where((c) => !synced.contains(c)).toList();
+
+    final update = await onCaptureTiles!(
+        quality: _rate.quality, scale: _rate.scale, full: needFrame.isNotEmpty);
+    if (update == null) {
+      // The runner may have moved on without us; start over from a FRAME
+      _needsKeyframe.addAll(_tileClients);
+      return;
+    }
+
+    final frame = update.frame;
+    if (frame != null) {
+      _fanOut.send(needFrame, StreamPacket('FRAME ${frame.length}\n', [frame]));
+      // The tiles of the next capture apply to this frame
+      _needsKeyframe.removeAll(needFrame);
+    }
+    final atlas = update.atlas;
+    if (atlas != null && update.tileCount > 0) {
+      _fanOut.send(
+        synced,
+        StreamPacket(
+          'TILES ${update.width} ${update.height} ${update.tileSize} '
+          '${update.tileCount} ${atlas.length}\n',
+          [update.tiles, atlas],
+          delta: true,
+        ),
+      );
+    }
+  }
+
   void _log(String message) {
     debugPrint('[ScreenStreamServer] $message');
     onLog?.call(message);
@@ -308,12 +450,19 @@ class ScreenStreamClient {
   bool _authenticated = false;
   
   final void Function(Uint8List frameData)? onFrame;
+  // When set, asks the server for TILES mode; tiles apply to the last frame
+  final void Function(ScreenTiles tiles)? onTiles;
   final void Function(String status)? onStatusChanged;
   final void Function(String error)? onError;
+  // Lets the server pick FPS, quality and scale for the link (SET_RATE
+  // AUTO); setFps, setQuality and setScale then cap its choice
+  final bool automaticRate;
   
   List<int> _buffer = [];
   int _expectedFrameSize = 0;
   bool _waitingForFrameData = false;
+  // Header fields of the TILES message being received, null for a FRAME
+  List<int>? _tilesHeader;
   
   // Stats
   int _framesReceived = 0;
@@ -322,8 +471,10 @@ class ScreenStreamClient {
   
   ScreenStreamClient({
     this.onFrame,
+    this.onTiles,
     this.onStatusChanged,
     this.onError,
+    this.automaticRate = true,
   });
   
   bool get isConnected => _isConnected && _authenticated;
@@ -373,6 +524,8 @@ class ScreenStreamClient {
     _isConnected = false;
     _authenticated = false;
     _buffer.clear();
+    _waitingForFrameData = false;
+    _tilesHeader = null;
 
     try {
       await _socket?.close();
@@ -406,6 +559,8 @@ class ScreenStreamClient {
         
         if (response == 'OK') {
           _authenticated = true;
+          if (onTiles != null) _socket?.write('SET_MODE TILES\n');
+          if (automaticRate) _socket?.write('SET_RATE AUTO\n');
           onStatusChanged?.call('Streaming...');
         } else {
           onError?.call('Authentication failed');
@@ -424,6 +579,14 @@ class ScreenStreamClient {
           if (_expectedFrameSize > 0) {
             _waitingForFrameData = true;
           }
+        } else if (header.startsWith('TILES ')) {
+          // TILES <width> <height> <tileSize> <count> <atlasSize>
+          final fields = header.substring(6).split(' ').map(int.tryParse).toList();
+          if (fields.length == 5 && fields.every((f) => f != null && f > 0)) {
+            _tilesHeader = fields.cast<int>();
+            _expectedFrameSize = _tilesHeader![3] * 2 + _tilesHeader![4];
+            _waitingForFrameData = true;
+          }
         }
       } else {
         if (_buffer.length >= _expectedFrameSize) {
@@ -431,6 +594,10 @@ class ScreenStreamClient {
           _buffer = _buffer.sublist(_expectedFrameSize);
           _waitingForFrameData = false;
           _expectedFrameSize = 0;
+          final tilesHeader = _tilesHeader;
+          _tilesHeader = null;
+          // Read off the wire; the server times its link by these
+          _socket?.write('ACK\n');
           
           // Update stats
           _framesReceived++;
@@ -444,7 +611,11 @@ class ScreenStreamClient {
           _lastFrameTime = now;
           
           // Deliver frame
-          onFrame?.call(frameData);
+          if (tilesHeader == null) {
+            onFrame?.call(frameData);
+          } else {
+            onTiles?.call(ScreenTiles._fromMessage(tilesHeader, frameData));
+          }
         } else {
           break;
         }
@@ -452,7 +623,7 @@ class ScreenStreamClient {
     }
   }
   
-  /// Request FPS change (server will clamp to max 4 FPS)
+  /// Request FPS change (server will clamp to max 4 FPS, 15 in TILES mode)
   void setFps(int fps) {
     if (_authenticated && _socket != null) {
       _socket!.write('SET_FPS $fps\n');
@@ -473,3 +644,35 @@ class ScreenStreamClient {
     }
   }
 }
+
+/// A TILES update from [ScreenStreamServer]: the [indices] of the changed
+/// tiles of the frame (row-major, [tileSize] squares, partial at the right
+/// and bottom edges) and a JPEG [atlas] holding them in that order, left to
+/// right and top to bottom, `atlas width ~/ tileSize` to a row.
+class ScreenTiles {
+  final int width;
+  final int height;
+  final int tileSize;
+  final List<int> indices;
+  final Uint8List atlas;
+
+  const ScreenTiles({
+    required this.width,
+    required this.height,
+    required this.tileSize,
+    required this.indices,
+    required this.atlas,
+  });
+
+  factory ScreenTiles._fromMessage(List<int> header, Uint8List payload) {
+    final count = header[3];
+    final data = ByteData.sublistView(payload);
+    return ScreenTiles(
+      width: header[0],
+      height: header[1],
+      tileSize: header[2],
+      indices: [for (var i = 0; i < count; i++) data.getUint16(i * 2, Endian.little)],
+      atlas: Uint8List.sublistView(payload, count * 2),
+    );
+  }
+}
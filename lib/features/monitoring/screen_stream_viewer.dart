@@ -1,5 +1,6 @@
 import 'package:flutter/material.dart';
 import 'dart:typed_data';
+import 'dart:ui' as ui;
 import 'screen_stream_service.dart';
 
 /// Full-screen viewer for remote screen streaming
@@ -21,7 +22,10 @@ class ScreenStreamViewer extends StatefulWidget {
 
 class _ScreenStreamViewerState extends State<ScreenStreamViewer> {
   late ScreenStreamClient _client;
-  Uint8List? _currentFrame;
+  // The picture so far: the last FRAME with the TILES since drawn over it
+  ui.Image? _currentFrame;
+  // Updates decode asynchronously but must apply in arrival order
+  Future<void> _applying = Future.value();
   String _status = 'Initializing...';
   String? _error;
   bool _isFullscreen = false;
@@ -31,14 +35,8 @@ class _ScreenStreamViewerState extends State<ScreenStreamViewer> {
   void initState() {
     super.initState();
     _client = ScreenStreamClient(
-      onFrame: (frameData) {
-        if (mounted) {
-          setState(() {
-            _currentFrame = frameData;
-            _error = null;
-          });
-        }
-      },
+      onFrame: (frameData) => _enqueue(() => _applyFrame(frameData)),
+      onTiles: (tiles) => _enqueue(() => _applyTiles(tiles)),
       onStatusChanged: (status) {
         if (mounted) {
           setState(() => _status = status);
@@ -70,8 +68,76 @@ class _ScreenStreamViewerState extends State<ScreenStreamViewer> {
   @override
   void dispose() {
     _client.disconnect();
+    _currentFrame?.dispose();
+    _currentFrame = null;
     super.dispose();
   }
+
+  void _enqueue(Future<void> Function() update) {
+    _applying = _applying.then((_) => update()).catchError((Object e) {
+      debugPrint('[ScreenStreamViewer] Bad update: $e');
+    });
+  }
+
+  Future<ui.Image> _decode(Uint8List jpeg) async {
+    final codec = await ui.instantiateImageCodec(jpeg);
+    try {
+      return (await codec.getNextFrame()).image;
+    } finally {
+      codec.dispose();
+    }
+  }
+
+  Future<void> _applyFrame(Uint8List jpeg) async {
+    final image = await _decode(jpeg);
+    _show(image);
+  }
+
+  /// Draws the changed tiles from the atlas over the current picture
+  Future<void> _applyTiles(ScreenTiles tiles) async {
+    final atlas = await _decode(tiles.atlas);
+    final base = _currentFrame;
+    final size = tiles.tileSize;
+    final atlasColumns = atlas.width ~/ size;
+    final gridColumns = (tiles.width + size - 1) ~/ size;
+
+    final recorder = ui.PictureRecorder();
+    final canvas = Canvas(recorder);
+    if (base != null && base.width == tiles.width && base.height == tiles.height) {
+      canvas.drawImage(base, Offset.zero, Paint());
+    }
+    final paint = Paint()..filterQuality = FilterQuality.none;
+    for (var i = 0; i < tiles.indices.length; i++) {
+      final index = tiles.indices[i];
+      final x = (index % gridColumns) * size;
+      final y = (index ~/ gridColumns) * size;
+      // Edge tiles are padded in the atlas; draw only the part on screen
+      final width = (tiles.width - x).clamp(0, size).toDouble();
+      final height = (tiles.height - y).clamp(0, size).toDouble();
+      final source = Offset(((i % atlasColumns) * size).toDouble(),
+          ((i ~/ atlasColumns) * size).toDouble());
+      canvas.drawImageRect(atlas, source & Size(width, height),
+          Offset(x.toDouble(), y.toDouble()) & Size(width, height), paint);
+    }
+    final picture = recorder.endRecording();
+    final image = picture.toImageSync(tiles.width, tiles.height);
+    picture.dispose();
+    atlas.dispose();
+    _show(image);
+  }
+
+  void _show(ui.Image image) {
+    if (!mounted) {
+      image.dispose();
+      return;
+    }
+    final previous = _currentFrame;
+    setState(() {
+      _currentFrame = image;
+      _error = null;
+    });
+    previous?.dispose();
+  }
   
   void _changeFps(int fps) {
     setState(() => _fps = fps);
@@ -135,10 +201,9 @@ class _ScreenStreamViewerState extends State<ScreenStreamViewer> {
               child: _error != null
                   ? _buildErrorWidget()
                   : _currentFrame != null
-                      ? Image.memory(
-                          _currentFrame!,
+                      ? RawImage(
+                          image: _currentFrame,
                           fit: BoxFit.contain,
-                          gaplessPlayback: true,
                           filterQuality: FilterQuality.medium,
                         )
                       : _buildConnectingWidget(),
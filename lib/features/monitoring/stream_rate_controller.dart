@@ -0,0 +1,383 @@
+import 'dart:collection';
+import 'dart:io';
+import 'dart:math' as math;
+
+import 'frame_fan_out.dart';
+
+/// The range [StreamRateController] works in. Viewers' SET_FPS, SET_QUALITY
+/// and SET_SCALE lower the top of it; the controller never goes above what
+/// was asked for.
+class StreamRateBounds {
+  final int minFps;
+  final int maxFps;
+  final int minQuality;
+  final int maxQuality;
+  final double minScale;
+  final double maxScale;
+
+  const StreamRateBounds({
+    this.minFps = 1,
+    this.maxFps = 15,
+    this.minQuality = 10,
+    this.maxQuality = 90,
+    this.minScale = 0.25,
+    this.maxScale = 1.0,
+  });
+}
+
+/// One [StreamRateController] period: what it measured and what it chose
+class StreamRateStats {
+  final int fps;
+  final int quality;
+  final double scale;
+
+  /// Why the settings moved: `network`, `encoder`, `probe` or `steady`
+  final String reason;
+
+  /// Bytes the slowest acknowledging viewer confirmed per second, null
+  /// when no viewer acknowledges
+  final int? ackedBytesPerSecond;
+
+  /// Its average time from write to ACK, and the lowest seen lately (the
+  /// round trip with empty queues)
+  final Duration? deliveryTime;
+  final Duration? baseDeliveryTime;
+
+  /// Average time a capture took, encoding included
+  final Duration captureTime;
+
+  final int skippedFrames;
+  final int droppedPackets;
+
+  const StreamRateStats({
+    required this.fps,
+    required this.quality,
+    required this.scale,
+    required this.reason,
+    required this.ackedBytesPerSecond,
+    required this.deliveryTime,
+    required this.baseDeliveryTime,
+    required this.captureTime,
+    required this.skippedFrames,
+    required this.droppedPackets,
+  });
+
+  Map<String, dynamic> toJson() => {
+        'fps': fps,
+        'quality': quality,
+        'scale': scale,
+        'reason': reason,
+        'ackedBytesPerSecond': ackedBytesPerSecond,
+        'deliveryMs': deliveryTime?.inMilliseconds,
+        'baseDeliveryMs': baseDeliveryTime?.inMilliseconds,
+        'captureMs': captureTime.inMilliseconds,
+        'skippedFrames': skippedFrames,
+        'droppedPackets': droppedPackets,
+      };
+
+  @override
+  String toString() => '$fps FPS, quality $quality, scale $scale ($reason'
+      '${ackedBytesPerSecond == null ? '' : ', ${ackedBytesPerSecond! ~/ 1024} KB/s'}'
+      '${deliveryTime == null ? '' : ', ${deliveryTime!.inMilliseconds} ms'})';
+}
+
+/// Picks FPS, JPEG quality and scale for a screen stream from how it is
+/// doing, so it stays smooth on a LAN and degrades gently over a VPN.
+///
+/// Once per [period] it looks at:
+/// - each viewer's ACKs (one per FRAME or TILES it has fully read): the
+///   bytes confirmed, and the time from handing a packet to the socket to
+///   its ACK, which grows past the link's round trip as queues build;
+/// - packets [FrameFanOut] dropped for viewers that fell behind;
+/// - how long captures take and how many ticks were skipped because the
+///   previous capture was still running.
+///
+/// A busy encoder lowers FPS, then scale. A congested link (drops, a
+/// stalled viewer, or delivery time at twice its base) steps down quality
+/// to 50, scale to 0.5, FPS, then quality and scale to their minimums,
+/// several steps at once when the ACKed rate is far below what is being
+/// sent. After three quiet periods it probes back up, one step per quiet
+/// period, in reverse order. Frames are encoded once for everyone, so the slowest
+/// acknowledging viewer sets the pace; viewers that never ACK only count
+/// through the encoder.
+class StreamRateController {
+  final StreamRateBounds bounds;
+  final Duration period;
+
+  int _fps;
+  int _quality;
+  double _scale;
+  int _fpsCeiling;
+  int _qualityCeiling;
+  double _scaleCeiling;
+
+  final Stopwatch _window = Stopwatch()..start();
+  final Map<Socket, _ClientWindow> _clients = {};
+  int _captures = 0;
+  int _captureUs = 0;
+  int _lastSkipped = 0;
+  int _lastDropped = 0;
+  // Quiet periods in a row, and how many are needed before probing up
+  int _quietPeriods = 0;
+  int _quietNeeded = _quietAfterCongestion;
+  StreamRateStats? _stats;
+
+  static const int _quietAfterCongestion = 3;
+  static const int _quietAfterProbe = 1;
+  static const int _maxStepsDown = 3;
+  // Bases for the delivery time are the lowest of this many periods
+  static const int _baseHistory = 10;
+  static const int _qualityStepDown = 10;
+  static const int _qualityStepUp = 5;
+  static const double _scaleStep = 0.125;
+
+  StreamRateController({
+    this.bounds = const StreamRateBounds(),
+    this.period = const Duration(seconds: 1),
+    required int fps,
+    required int quality,
+    required double scale,
+  })  : _fps = fps.clamp(bounds.minFps, bounds.maxFps),
+        _quality = quality.clamp(bounds.minQuality, bounds.maxQuality),
+        _scale = scale.clamp(bounds.minScale, bounds.maxScale),
+        _fpsCeiling = fps.clamp(bounds.minFps, bounds.maxFps),
+        _qualityCeiling = quality.clamp(bounds.minQuality, bounds.maxQuality),
+        _scaleCeiling = scale.clamp(bounds.minScale, bounds.maxScale);
+
+  int get fps => _fps;
+  int get quality => _quality;
+  double get scale => _scale;
+
+  /// The last period's measurements and decision, null before the first
+  StreamRateStats? get stats => _stats;
+
+  /// Sets the most that may be sent; current settings above it drop to it
+  /// at once, below it they climb back as the link allows
+  void setCeilings({int? fps, int? quality, double? scale}) {
+    if (fps != null) {
+      _fpsCeiling = fps.clamp(bounds.minFps, bounds.maxFps);
+      _fps = math.min(_fps, _fpsCeiling);
+    }
+    if (quality != null) {
+      _qualityCeiling = quality.clamp(bounds.minQuality, bounds.maxQuality);
+      _quality = math.min(_quality, _qualityCeiling);
+    }
+    if (scale != null) {
+      _scaleCeiling = scale.clamp(bounds.minScale, bounds.maxScale);
+      _scale = math.min(_scale, _scaleCeiling);
+    }
+  }
+
+  /// Lets every setting climb to the top of [bounds]
+  void setAutomatic() {
+    setCeilings(
+      fps: bounds.maxFps,
+      quality: bounds.maxQuality,
+      scale: bounds.maxScale,
+    );
+  }
+
+  /// A capture, encoding included, took [elapsed]
+  void onCapture(Duration elapsed) {
+    _captures++;
+    _captureUs += elapsed.inMicroseconds;
+  }
+
+  /// [client] acknowledged a packet of [bytes] written [delivery] ago
+  void onAck(Socket client, int bytes, Duration delivery) {
+    final window = _clients.putIfAbsent(client, _ClientWindow.new);
+    window.acks++;
+    window.ackedBytes += bytes;
+    window.deliveryUs += delivery.inMicroseconds;
+  }
+
+  void removeClient(Socket client) {
+    _clients.remove(client);
+  }
+
+  /// Ends the period if it is over and adjusts the settings. Returns the
+  /// period's stats, or null if it is not over yet.
+  StreamRateStats? update(FrameFanOut fanOut, {required int skippedFrames}) {
+    final elapsedUs = _window.elapsedMicroseconds;
+    if (elapsedUs < period.inMicroseconds) return null;
+    _window.reset();
+
+    final skipped = skippedFrames - _lastSkipped;
+    _lastSkipped = skippedFrames;
+    final dropped = fanOut.droppedPackets - _lastDropped;
+    _lastDropped = fanOut.droppedPackets;
+    final captureUs = _captures == 0 ? 0 : _captureUs ~/ _captures;
+    _captures = 0;
+    _captureUs = 0;
+    final encoderBusy = skipped > 0 || captureUs > 700000 ~/ _fps;
+
+    // The viewer worst off sets the pace
+    _ClientWindow? slowest;
+    var congested = false;
+    var sentRatio = 1.0;
+    for (final entry in _clients.entries) {
+      final client = entry.key;
+      final window = entry.value;
+      final drops = fanOut.droppedFor(client) - window.dropsSeen;
+      window.dropsSeen = fanOut.droppedFor(client);
+      final sent = fanOut.sentFor(client) - window.sentSeen;
+      window.sentSeen = fanOut.sentFor(client);
+      window.endPeriod();
+
+      final base = window.baseUs;
+      // Nothing confirmed for a whole period past the usual delivery time
+      final waiting = fanOut.unackedAge(client);
+      final stalled = waiting != null &&
+          waiting.inMicroseconds > period.inMicroseconds + (base ?? 0);
+      final queued = window.acks > 0 &&
+          base != null &&
+          window.averageUs > base * 2 &&
+          window.averageUs - base > 80000;
+      if (drops > 0 || stalled || queued) {
+        congested = true;
+        // Sent over confirmed, both per period; how far over the link we are
+        final ratio = window.ackedBytes == 0 ? 4.0 : sent / (window.ackedBytes * 0.8);
+        sentRatio = math.max(sentRatio, ratio);
+      }
+      if (slowest == null || window.ackedBytes < slowest.ackedBytes) {
+        slowest = window;
+      }
+      window.resetCounts();
+    }
+
+    String reason = 'steady';
+    if (encoderBusy) {
+      _stepDownEncoder();
+      reason = 'encoder';
+    } else if (congested) {
+      // Each step saves 15-40%; take as many as the overshoot calls for
+      var estimate = sentRatio;
+      for (var step = 0; step < _maxStepsDown; step++) {
+        final saved = _stepDownNetwork();
+        if (saved == null) break;
+        estimate *= saved;
+        if (estimate <= 1) break;
+      }
+      reason = 'network';
+    }
+    if (encoderBusy || congested) {
+      _quietPeriods = 0;
+      _quietNeeded = _quietAfterCongestion;
+    } else if (++_quietPeriods >= _quietNeeded) {
+      if (_stepUp()) reason = 'probe';
+      _quietPeriods = 0;
+      _quietNeeded = _quietAfterProbe;
+    }
+
+    final seconds = elapsedUs / Duration.microsecondsPerSecond;
+    _stats = StreamRateStats(
+      fps: _fps,
+      quality: _quality,
+      scale: _scale,
+      reason: reason,
+      ackedBytesPerSecond: slowest == null ? null : (slowest.lastAckedBytes / seconds).round(),
+      deliveryTime: slowest?.lastAverageUs == null ? null : Duration(microseconds: slowest!.lastAverageUs!),
+      baseDeliveryTime: slowest?.baseUs == null ? null : Duration(microseconds: slowest!.baseUs!),
+      captureTime: Duration(microseconds: captureUs),
+      skippedFrames: skipped,
+      droppedPackets: dropped,
+    );
+    return _stats;
+  }
+
+  int get _softQuality => 50.clamp(bounds.minQuality, _qualityCeiling);
+  double get _softScale => 0.5.clamp(bounds.minScale, _scaleCeiling);
+
+  void _stepDownEncoder() {
+    if (_fps > bounds.minFps) {
+      _fps = math.max(bounds.minFps, (_fps * 3) ~/ 4);
+    } else if (_scale > bounds.minScale) {
+      _scale = _scaleDown(bounds.minScale);
+    }
+  }
+
+  /// One step down, cheapest for the picture first. Returns the share of
+  /// the bytes it is expected to keep, or null at the bottom.
+  double? _stepDownNetwork() {
+    if (_quality > _softQuality) {
+      _quality = math.max(_softQuality, _quality - _qualityStepDown);
+      return 0.85;
+    }
+    if (_scale > _softScale) {
+      final old = _scale;
+      _scale = _scaleDown(_softScale);
+      return (_scale * _scale) / (old * old);
+    }
+    if (_fps > bounds.minFps) {
+      final old = _fps;
+      _fps = math.max(bounds.minFps, (_fps * 3) ~/ 4);
+      return _fps / old;
+    }
+    if (_quality > bounds.minQuality) {
+      _quality = math.max(bounds.minQuality, _quality - _qualityStepDown);
+      return 0.85;
+    }
+    if (_scale > bounds.minScale) {
+      final old = _scale;
+      _scale = _scaleDown(bounds.minScale);
+      return (_scale * _scale) / (old * old);
+    }
+    return null;
+  }
+
+  /// One step back up, in the reverse order. Returns false at the ceiling.
+  bool _stepUp() {
+    if (_scale < _softScale) {
+      _scale = _scaleUp(_softScale);
+    } else if (_quality < _softQuality) {
+      _quality = math.min(_softQuality, _quality + _qualityStepUp);
+    } else if (_fps < _fpsCeiling) {
+      _fps = math.min(_fpsCeiling, _fps + math.max(1, _fps ~/ 2));
+    } else if (_scale < _scaleCeiling) {
+      _scale = _scaleUp(_scaleCeiling);
+    } else if (_quality < _qualityCeiling) {
+      _quality = math.min(_qualityCeiling, _quality + _qualityStepUp);
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  // Scales move in eighths, so 1/2 and 1/4 land on the fast box filter
+  double _scaleDown(double floor) =>
+      math.max(floor, ((_scale / _scaleStep).ceil() - 1) * _scaleStep);
+  double _scaleUp(double ceiling) =>
+      math.min(ceiling, ((_scale / _scaleStep).floor() + 1) * _scaleStep);
+}
+
+class _ClientWindow {
+  int acks = 0;
+  int ackedBytes = 0;
+  int deliveryUs = 0;
+  int dropsSeen = 0;
+  int sentSeen = 0;
+  int lastAckedBytes = 0;
+  int? lastAverageUs;
+  final ListQueue<int> _minima = ListQueue();
+
+  int get averageUs => acks == 0 ? 0 : deliveryUs ~/ acks;
+
+  /// The lowest average delivery time of the recent periods
+  int? get baseUs => _minima.isEmpty ? null : _minima.reduce(math.min);
+
+  void endPeriod() {
+    lastAckedBytes = ackedBytes;
+    lastAverageUs = acks == 0 ? null : averageUs;
+    if (acks == 0) return;
+    _minima.addLast(averageUs);
+    if (_minima.length > StreamRateController._baseHistory) {
+      _minima.removeFirst();
+    }
+  }
+
+  void resetCounts() {
+    acks = 0;
+    ackedBytes = 0;
+    deliveryUs = 0;
+  }
+}
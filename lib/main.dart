@@ -12,6 +12,8 @@ import 'features/monitoring/capture_protection_service.dart';
 
 // Crash Recovery (Layer 1)
 import 'core/services/crash_recovery_service.dart';
+import 'core/services/instance_args_service.dart';
+import 'core/services/startup_trace_service.dart';
 
 // Desktop window + tray
 import 'package:window_manager/window_manager.dart';
@@ -43,6 +45,54 @@ import 'features/admin/report_lookup_screen.dart';
 import 'core/services/notification_service.dart';
 import 'config/api_config.dart';
 
+/// ---- Window visibility -----------------------------------------------------
+
+/// Command line of this launch, as passed by the runner.
+List<String> _launchArgs = const [];
+
+/// Started by auto-start or a restart. The runner then keeps the window
+/// hidden and collapsed until it is first shown, so only the engine and the
+/// background services run (windows/runner/flutter_window.h,
+/// linux/runner/my_application.cc).
+bool get _isBackgroundLaunch =>
+    InstanceArgsService.isBackgroundLaunch(_launchArgs);
+
+/// Window options held back until a background launch is first shown.
+WindowOptions? _pendingWindowOptions;
+
+/// Set once the window has been shown by this launch.
+bool _windowShown = false;
+
+/// Shows and focuses the main window, applying held-back options first.
+Future<void> _showMainWindow() async {
+  final options = _pendingWindowOptions;
+  _pendingWindowOptions = null;
+  _windowShown = true;
+  if (options == null) {
+    await windowManager.show();
+    await windowManager.focus();
+    return;
+  }
+  await windowManager.waitUntilReadyToShow(options, () async {
+    await windowManager.show();
+    await windowManager.focus();
+  });
+}
+
+/// Screens shown instead of the main app (fatal error, blocked) must not
+/// stay hidden behind a background launch.
+Future<void> _revealBackgroundWindow() async {
+  if (!_isBackgroundLaunch || !(Platform.isWindows || Platform.isLinux)) {
+    return;
+  }
+  try {
+    await windowManager.ensureInitialized();
+    await _showMainWindow();
+  } catch (e) {
+    if (kDebugMode) debugPrint('[Main] Could not show window: $e');
+  }
+}
+
 /// ---- System tray globals (desktop only) ------------------------------------
 
 final SystemTray _systemTray = SystemTray();
@@ -62,8 +112,7 @@ Future<void> _initSystemTray() async {
   _systemTray.registerSystemTrayEventHandler((eventName) async {
     if (eventName == kSystemTrayEventClick) {
       // Left click - show and focus window
-      await windowManager.show();
-      await windowManager.focus();
+      await _showMainWindow();
     }
     // Right click does nothing (no menu)
   });
@@ -71,6 +120,17 @@ Future<void> _initSystemTray() async {
   windowManager.addListener(_TrayWindowListener());
 }
 
+/// A second launch by the user (desktop shortcut, start menu) is forwarded
+/// here by the runner instead of starting another instance: bring the
+/// window back from the tray. Background relaunches stay in the tray.
+void _listenForForwardedLaunches() {
+  InstanceArgsService.instance.forwardedArgs.listen((args) async {
+    if (kDebugMode) debugPrint('[Instance] Forwarded launch: $args');
+    if (InstanceArgsService.isBackgroundLaunch(args)) return;
+    await _showMainWindow();
+  });
+}
+
 class _TrayWindowListener extends WindowListener {
   @override
   Future<bool> onWindowClose() async {
@@ -289,13 +349,19 @@ Future<void> _launchMainApp() async {
       titleBarStyle: TitleBarStyle.normal,
     );
 
-    await windowManager.waitUntilReadyToShow(windowOptions, () async {
-      await windowManager.show();
-      await windowManager.focus();
-    });
+    if (_isBackgroundLaunch && !_windowShown) {
+      // Stay in the tray; the options are applied when the window is opened
+      _pendingWindowOptions = windowOptions;
+    } else {
+      await windowManager.waitUntilReadyToShow(windowOptions, () async {
+        await windowManager.show();
+        await windowManager.focus();
+      });
+    }
 
     await windowManager.setPreventClose(true);
     await _initSystemTray();
+    _listenForForwardedLaunches();
   }
 
   // Start VM monitoring in the background (for users who log in on VM later)
@@ -367,7 +433,9 @@ Future<VersionCheckResult> _checkMinimumVersion() async {
 /// Track restart source for telemetry
 String? _restartSource;
 
-Future<void> main() async {
+Future<void> main(List<String> args) async {
+  _launchArgs = args;
+
   // Parse command line args for restart tracking
   _restartSource = _parseRestartSource();
   if (_restartSource != null && kDebugMode) {
@@ -383,6 +451,7 @@ Future<void> main() async {
   if (!CrashRecoveryService.instance.shouldRestart()) {
     if (kDebugMode) debugPrint('[Main] Too many restarts detected - showing error screen');
     WidgetsFlutterBinding.ensureInitialized();
+    await _revealBackgroundWindow();
     runApp(_buildFatalErrorApp());
     return;
   }
@@ -390,6 +459,7 @@ Future<void> main() async {
   // Wrap everything in runZonedGuarded to catch async errors
   runZonedGuarded(() async {
     WidgetsFlutterBinding.ensureInitialized();
+    StartupTraceService.instance.instant('dart_main');
 
     // Set up Flutter error handler for framework errors
     FlutterError.onError = (FlutterErrorDetails details) {
@@ -430,6 +500,7 @@ Future<void> main() async {
     final isVm = await _checkForVirtualMachine();
     if (isVm) {
       _isShowingBlockedScreen = true;
+      await _revealBackgroundWindow();
       // Show blocked screen with real-time monitoring
       // When unblocked, launch the main app
       runApp(VmBlockedScreen(
@@ -453,6 +524,7 @@ Future<void> main() async {
     final versionResult = await _checkMinimumVersion();
     if (versionResult.blocked) {
       _isShowingBlockedScreen = true;
+      await _revealBackgroundWindow();
       runApp(MaterialApp(
         debugShowCheckedModeBanner: false,
         theme: AppTheme.lightTheme,
@@ -477,7 +549,7 @@ Future<void> main() async {
     }
 
     // Not blocked - launch the main app normally
-    await _launchMainApp();
+    await StartupTraceService.instance.trace('launch_main_app', _launchMainApp);
 
     // Mark successful start (resets restart counter)
     await CrashRecoveryService.instance.markSuccessfulStart();
@@ -503,7 +575,10 @@ String? _parseRestartSource() {
   try {
     // Check for restart flags in command line args
     // These would be passed by the crash recovery service or watchdog
-    final args = Platform.environment['FLUTTER_TOOL_ARGS'] ?? '';
+    final args = [
+      ..._launchArgs,
+      Platform.environment['FLUTTER_TOOL_ARGS'] ?? '',
+    ].join(' ');
 
     // Check common restart indicators
     if (args.contains('--crash-restart')) {
@@ -0,0 +1,137 @@
+#include "app_heartbeat.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+static const guint kHeartbeatIntervalSeconds = 1;
+
+// Heartbeat ticks between frame probes.
+static const guint kFrameProbeEveryTicks = 15;
+
+static AppHeartbeat* heartbeat = nullptr;
+
+// Weak reference to the view probed for frames, null until the first frame.
+static GtkWidget* probe_view = nullptr;
+static gboolean window_visible = FALSE;
+static guint ticks_since_probe = 0;
+
+static int64_t now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void cancel_frame_probe() {
+  heartbeat->frame_probe_ms.store(0, std::memory_order_relaxed);
+  ticks_since_probe = 0;
+}
+
+static void probe_frame() {
+  if (probe_view == nullptr) {
+    return;
+  }
+  if (!window_visible) {
+    cancel_frame_probe();
+    return;
+  }
+  if (++ticks_since_probe < kFrameProbeEveryTicks) {
+    return;
+  }
+  ticks_since_probe = 0;
+
+  // Keep the original request time if a probe is already outstanding.
+  int64_t expected = 0;
+  heartbeat->frame_probe_ms.compare_exchange_strong(expected, now_ms(),
+                                                    std::memory_order_relaxed);
+  gtk_widget_queue_draw(probe_view);
+}
+
+static void after_paint_cb(GdkFrameClock* frame_clock, gpointer user_data) {
+  if (heartbeat->frame_probe_ms.load(std::memory_order_relaxed) != 0) {
+    app_heartbeat_touch_frame();
+  }
+}
+
+static gboolean heartbeat_tick_cb(gpointer user_data) {
+  heartbeat->loop_tick_ms.store(now_ms(), std::memory_order_relaxed);
+  heartbeat->loop_count.fetch_add(1, std::memory_order_relaxed);
+  probe_frame();
+  return G_SOURCE_CONTINUE;
+}
+
+gboolean app_heartbeat_open() {
+  if (heartbeat != nullptr) {
+    return TRUE;
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "%s%u", APP_HEARTBEAT_SHM_PREFIX,
+           static_cast<unsigned>(getuid()));
+
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return FALSE;
+  }
+  if (ftruncate(fd, sizeof(AppHeartbeat)) != 0) {
+    close(fd);
+    return FALSE;
+  }
+  void* view = mmap(nullptr, sizeof(AppHeartbeat), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED) {
+    return FALSE;
+  }
+
+  heartbeat = static_cast<AppHeartbeat*>(view);
+  // The segment outlives us; invalidate it while re-initializing so the
+  // helper never pairs our pid with a previous instance's ticks.
+  heartbeat->magic = 0;
+  std::atomic_thread_fence(std::memory_order_release);
+  heartbeat->pid = static_cast<uint32_t>(getpid());
+  heartbeat->loop_tick_ms.store(now_ms());
+  heartbeat->frame_tick_ms.store(0);
+  heartbeat->frame_probe_ms.store(0);
+  heartbeat->loop_count.store(0);
+  heartbeat->version = APP_HEARTBEAT_VERSION;
+  std::atomic_thread_fence(std::memory_order_release);
+  heartbeat->magic = APP_HEARTBEAT_MAGIC;
+
+  g_timeout_add_seconds(kHeartbeatIntervalSeconds, heartbeat_tick_cb, nullptr);
+  return TRUE;
+}
+
+void app_heartbeat_touch_frame() {
+  if (heartbeat == nullptr) {
+    return;
+  }
+  heartbeat->frame_tick_ms.store(now_ms(), std::memory_order_relaxed);
+  heartbeat->frame_probe_ms.store(0, std::memory_order_relaxed);
+}
+
+void app_heartbeat_probe_frames(GtkWidget* view) {
+  if (heartbeat == nullptr || probe_view != nullptr) {
+    return;
+  }
+  // The toplevel's clock, shared by every widget in the window.
+  GdkFrameClock* frame_clock = gtk_widget_get_frame_clock(view);
+  if (frame_clock == nullptr) {
+    return;
+  }
+  g_signal_connect_object(frame_clock, "after-paint",
+                          G_CALLBACK(after_paint_cb), view,
+                          static_cast<GConnectFlags>(0));
+  probe_view = view;
+  g_object_add_weak_pointer(G_OBJECT(view),
+                            reinterpret_cast<gpointer*>(&probe_view));
+}
+
+void app_heartbeat_set_visible(gboolean visible) {
+  window_visible = visible;
+  if (heartbeat != nullptr && !visible) {
+    cancel_frame_probe();
+  }
+}
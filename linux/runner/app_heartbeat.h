@@ -0,0 +1,70 @@
+#ifndef FLUTTER_APP_HEARTBEAT_H_
+#define FLUTTER_APP_HEARTBEAT_H_
+
+#include <gtk/gtk.h>
+#include <stdint.h>
+
+#include <atomic>
+
+// Prefix of the POSIX shared-memory object the service helper reads to
+// detect a hung app; the user id is appended. Must match
+// HEARTBEAT_SHM_PREFIX in service_helper/heartbeat_monitor.h.
+#define APP_HEARTBEAT_SHM_PREFIX "/a1_tools_heartbeat_"
+
+// Layout of the heartbeat segment, shared with the service helper. Bump the
+// version on any change.
+typedef struct {
+  uint32_t magic;    // APP_HEARTBEAT_MAGIC once initialized
+  uint32_t version;  // APP_HEARTBEAT_VERSION
+  uint32_t pid;
+  uint32_t reserved;
+  // All times are CLOCK_MONOTONIC milliseconds.
+  std::atomic<int64_t> loop_tick_ms;    // Last GTK main loop heartbeat
+  std::atomic<int64_t> frame_tick_ms;   // Last frame produced by the engine
+  std::atomic<int64_t> frame_probe_ms;  // Pending frame probe, 0 when none
+  std::atomic<uint64_t> loop_count;
+} AppHeartbeat;
+
+#define APP_HEARTBEAT_MAGIC 0x42483141u  // "A1HB"
+#define APP_HEARTBEAT_VERSION 1u
+
+/**
+ * app_heartbeat_open:
+ *
+ * Creates the shared-memory segment and starts a 1 s GLib timeout on the
+ * default main context that publishes loop ticks, so a stuck GTK main loop
+ * stops the ticks.
+ *
+ * Returns: %TRUE if the segment is available.
+ */
+gboolean app_heartbeat_open();
+
+/**
+ * app_heartbeat_touch_frame:
+ *
+ * Records that the engine produced a frame; completes a pending probe.
+ */
+void app_heartbeat_touch_frame();
+
+/**
+ * app_heartbeat_probe_frames:
+ * @view: the Flutter view, realized.
+ *
+ * Every 15 loop ticks while the window is visible, marks a frame probe and
+ * queues a redraw of @view; the probe completes when the toplevel's
+ * #GdkFrameClock next finishes painting ("after-paint"). A stuck paint
+ * leaves the probe pending and the service helper sees it age past its
+ * frame stall threshold. Call once the first frame is in.
+ */
+void app_heartbeat_probe_frames(GtkWidget* view);
+
+/**
+ * app_heartbeat_set_visible:
+ * @visible: whether the user can see the window.
+ *
+ * A window nobody can see legitimately paints nothing, so probes stop (and
+ * a pending one is cleared) while it is hidden.
+ */
+void app_heartbeat_set_visible(gboolean visible);
+
+#endif  // FLUTTER_APP_HEARTBEAT_H_
@@ -0,0 +1,193 @@
+#include "instance_channel.h"
+
+#include <glib-unix.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const uint32_t kMessageMagic = 0x41493141;  // "A1IA"
+static const size_t kMaxMessageBytes = 64 * 1024;
+static const int kClientTimeoutMs = 2000;  // Second launch waiting on the primary
+static const int kServerIoTimeoutMs = 1000;  // Primary waiting on a client
+
+static int listen_fd = -1;
+static guint listen_source = 0;
+static InstanceArgsCallback args_callback = nullptr;
+static gpointer args_user_data = nullptr;
+
+static socklen_t socket_address(struct sockaddr_un* address) {
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  // Leading NUL: abstract namespace, nothing on disk to clean up
+  int length = snprintf(address->sun_path + 1, sizeof(address->sun_path) - 1,
+                        "a1_tools_instance_%u", static_cast<unsigned>(getuid()));
+  return static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + 1 +
+                                length);
+}
+
+static void set_timeout(int fd, int timeout_ms) {
+  struct timeval timeout;
+  timeout.tv_sec = timeout_ms / 1000;
+  timeout.tv_usec = (timeout_ms % 1000) * 1000;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+static gboolean peer_is_same_user(int fd) {
+  struct ucred credentials;
+  socklen_t length = sizeof(credentials);
+  return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0 &&
+         credentials.uid == getuid();
+}
+
+static gboolean write_all(int fd, const void* data, size_t size) {
+  const char* cursor = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t n = send(fd, cursor, size, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return FALSE;
+    }
+    cursor += n;
+    size -= static_cast<size_t>(n);
+  }
+  return TRUE;
+}
+
+static gboolean read_all(int fd, void* data, size_t size) {
+  char* cursor = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t n = recv(fd, cursor, size, 0);
+    if (n <= 0) {
+      return FALSE;
+    }
+    cursor += n;
+    size -= static_cast<size_t>(n);
+  }
+  return TRUE;
+}
+
+gboolean instance_channel_forward(gchar** args) {
+  GByteArray* message = g_byte_array_new();
+  uint32_t count = args != nullptr ? g_strv_length(args) : 0;
+  g_byte_array_append(message, reinterpret_cast<const guint8*>(&kMessageMagic),
+                      sizeof(kMessageMagic));
+  g_byte_array_append(message, reinterpret_cast<const guint8*>(&count),
+                      sizeof(count));
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t length = static_cast<uint32_t>(strlen(args[i]));
+    g_byte_array_append(message, reinterpret_cast<const guint8*>(&length),
+                        sizeof(length));
+    g_byte_array_append(message, reinterpret_cast<const guint8*>(args[i]),
+                        length);
+  }
+
+  gboolean ok = FALSE;
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  struct sockaddr_un address;
+  socklen_t address_length = socket_address(&address);
+  if (fd >= 0 && message->len <= kMaxMessageBytes &&
+      connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+              address_length) == 0 &&
+      peer_is_same_user(fd)) {
+    set_timeout(fd, kClientTimeoutMs);
+    char ack = 0;
+    ok = write_all(fd, message->data, message->len) &&
+         read_all(fd, &ack, 1) && ack == 1;
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+  g_byte_array_unref(message);
+  return ok;
+}
+
+// Reads one forwarded command line; nullptr on any protocol error.
+static gchar** read_args(int fd) {
+  uint32_t header[2];
+  if (!read_all(fd, header, sizeof(header)) || header[0] != kMessageMagic) {
+    return nullptr;
+  }
+  size_t total = sizeof(header);
+  GPtrArray* args = g_ptr_array_new_with_free_func(g_free);
+  for (uint32_t i = 0; i < header[1]; i++) {
+    uint32_t length = 0;
+    total += sizeof(length);
+    if (total > kMaxMessageBytes || !read_all(fd, &length, sizeof(length)) ||
+        (total += length) > kMaxMessageBytes) {
+      g_ptr_array_unref(args);
+      return nullptr;
+    }
+    gchar* arg = static_cast<gchar*>(g_malloc(length + 1));
+    if (!read_all(fd, arg, length)) {
+      g_free(arg);
+      g_ptr_array_unref(args);
+      return nullptr;
+    }
+    arg[length] = '\0';
+    g_ptr_array_add(args, arg);
+  }
+  g_ptr_array_add(args, nullptr);
+  return reinterpret_cast<gchar**>(g_ptr_array_free(args, FALSE));
+}
+
+static gboolean accept_cb(gint fd, GIOCondition condition, gpointer user_data) {
+  int client = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+  if (client < 0) {
+    return G_SOURCE_CONTINUE;
+  }
+  if (peer_is_same_user(client)) {
+    // A same-user client writes right away; the timeout only bounds a
+    // misbehaving one
+    set_timeout(client, kServerIoTimeoutMs);
+    gchar** args = read_args(client);
+    if (args != nullptr) {
+      const char ack = 1;
+      write_all(client, &ack, 1);
+      args_callback(args, args_user_data);
+    }
+  }
+  close(client);
+  return G_SOURCE_CONTINUE;
+}
+
+gboolean instance_channel_listen(InstanceArgsCallback callback,
+                                 gpointer user_data) {
+  if (listen_fd >= 0) {
+    return TRUE;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (fd < 0) {
+    return FALSE;
+  }
+  struct sockaddr_un address;
+  socklen_t address_length = socket_address(&address);
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), address_length) != 0 ||
+      listen(fd, 8) != 0) {
+    close(fd);
+    return FALSE;
+  }
+
+  listen_fd = fd;
+  args_callback = callback;
+  args_user_data = user_data;
+  listen_source = g_unix_fd_add(listen_fd, G_IO_IN, accept_cb, nullptr);
+  return TRUE;
+}
+
+void instance_channel_close() {
+  if (listen_source != 0) {
+    g_source_remove(listen_source);
+    listen_source = 0;
+  }
+  if (listen_fd >= 0) {
+    close(listen_fd);
+    listen_fd = -1;
+  }
+  args_callback = nullptr;
+  args_user_data = nullptr;
+}
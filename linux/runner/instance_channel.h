@@ -0,0 +1,54 @@
+#ifndef FLUTTER_INSTANCE_CHANNEL_H_
+#define FLUTTER_INSTANCE_CHANNEL_H_
+
+#include <glib.h>
+
+// Single-instance IPC over an abstract Unix socket
+// ("\0a1_tools_instance_<uid>"). The primary instance listens on it; a second
+// launch sends its command line and exits before starting an engine. Both
+// ends check the peer's uid, since abstract sockets have no file
+// permissions.
+//
+// Wire format (native byte order, little-endian on all our targets): uint32
+// magic, uint32 argument count, then per argument a uint32 byte length and
+// the bytes. The primary answers with one byte (1). Same layout as
+// windows/runner/instance_channel.h.
+
+/**
+ * InstanceArgsCallback:
+ * @args: (transfer full): the forwarded arguments, free with g_strfreev().
+ * @user_data: data passed to instance_channel_listen().
+ */
+typedef void (*InstanceArgsCallback)(gchar** args, gpointer user_data);
+
+/**
+ * instance_channel_forward:
+ * @args: %NULL-terminated arguments to send.
+ *
+ * Sends @args to a running primary instance.
+ *
+ * Returns: %TRUE if the primary acknowledged them.
+ */
+gboolean instance_channel_forward(gchar** args);
+
+/**
+ * instance_channel_listen:
+ * @callback: called on the default main context for every forwarded
+ * command line.
+ * @user_data: passed to @callback.
+ *
+ * Becomes the primary instance.
+ *
+ * Returns: %FALSE if another instance already listens.
+ */
+gboolean instance_channel_listen(InstanceArgsCallback callback,
+                                 gpointer user_data);
+
+/**
+ * instance_channel_close:
+ *
+ * Stops listening.
+ */
+void instance_channel_close();
+
+#endif  // FLUTTER_INSTANCE_CHANNEL_H_
@@ -1,6 +1,11 @@
 #include "my_application.h"
+#include "prefetch.h"
+#include "startup_trace.h"
 
 int main(int argc, char** argv) {
+  startup_trace_instant("main");
+  // First, so the reads overlap everything else on a cold start
+  prefetch_start();
   g_autoptr(MyApplication) app = my_application_new();
   return g_application_run(G_APPLICATION(app), argc, argv);
 }
@@ -1,28 +1,183 @@
 #include "my_application.h"
 
 #include <flutter_linux/flutter_linux.h>
+#include <glib-unix.h>
 #ifdef GDK_WINDOWING_X11
 #include <gdk/gdkx.h>
 #endif
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "app_heartbeat.h"
 #include "flutter/generated_plugin_registrant.h"
+#include "instance_channel.h"
+#include "screen_capture.h"
+#include "stall_monitor.h"
+#include "startup_trace.h"
+#include "window_visibility.h"
+
+// Environment variable carrying the eventfd a supervising service helper
+// waits on for the first frame. Must match READY_FD_ENV_VAR in
+// service_helper/readiness_signal.h.
+#define READY_FD_ENV_VAR "A1_TOOLS_READY_FD"
+
+// Window size once shown, in logical pixels.
+static const gint kWindowWidth = 1280;
+static const gint kWindowHeight = 720;
+
+// Flags passed by launchers that start the app in the background. Must match
+// InstanceArgsService.backgroundLaunchFlags in Dart.
+static const gchar* const kBackgroundLaunchFlags[] = {
+    "--auto-start", "--crash-restart", "--service-restart"};
 
 struct _MyApplication {
   GtkApplication parent_instance;
   char** dart_entrypoint_arguments;
+  // Launched by auto-start or a restart: run from the tray without showing
+  // the window, which stays collapsed until it is first shown.
+  gboolean background_launch;
+  // Command lines forwarded by later launches, delivered to Dart over
+  // com.a1chimney.a1tools/instance_args once it listens.
+  FlEventChannel* instance_args_channel;
+  gboolean instance_args_listening;
+  GPtrArray* pending_instance_args;
 };
 
 G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 
+// Tells a relaunching service helper that the app is usable.
+static void signal_first_frame() {
+  const gchar* fd_string = g_getenv(READY_FD_ENV_VAR);
+  if (fd_string == nullptr) {
+    return;
+  }
+  int fd = atoi(fd_string);
+  if (fd > 2) {
+    uint64_t value = 1;
+    if (write(fd, &value, sizeof(value)) != sizeof(value)) {
+      g_warning("Failed to signal first frame to the service helper");
+    }
+    close(fd);
+  }
+  // Don't leak the descriptor number into processes we spawn.
+  g_unsetenv(READY_FD_ENV_VAR);
+}
+
 // Called when first Flutter frame received.
 static void first_frame_cb(MyApplication* self, FlView *view)
 {
-  gtk_widget_show(gtk_widget_get_toplevel(GTK_WIDGET(view)));
+  startup_trace_instant("first_frame");
+  GtkWidget* window = gtk_widget_get_toplevel(GTK_WIDGET(view));
+  // A background launch stays hidden until the user opens it from the tray
+  if (!self->background_launch) {
+    gtk_widget_show(window);
+  }
+  // Stop frames while nobody can see the window
+  window_visibility_track(
+      GTK_WINDOW(window),
+      fl_engine_get_binary_messenger(fl_view_get_engine(view)));
+  app_heartbeat_touch_frame();
+  app_heartbeat_probe_frames(GTK_WIDGET(view));
+  signal_first_frame();
+
+  // A startup benchmark run is over once the trace is written.
+  gboolean exit_after = FALSE;
+  if (startup_trace_dump_requested(&exit_after) && exit_after) {
+    g_application_quit(G_APPLICATION(self));
+  }
+}
+
+// First show of a background-launched window: grow it to its normal size
+// if nothing else sized it while hidden. Runs before the window is mapped,
+// whoever shows it (tray handler via window_manager, a forwarded launch).
+static void expand_from_background_cb(GtkWidget* widget, gpointer user_data) {
+  g_signal_handlers_disconnect_by_func(
+      widget, reinterpret_cast<gpointer>(expand_from_background_cb), user_data);
+  // Dart applies its own window options before showing from the tray
+  gint width = 0, height = 0;
+  gtk_window_get_size(GTK_WINDOW(widget), &width, &height);
+  if (width >= kWindowWidth / 4 || height >= kWindowHeight / 4) {
+    return;
+  }
+  gtk_window_resize(GTK_WINDOW(widget), kWindowWidth, kWindowHeight);
+  gtk_window_set_position(GTK_WINDOW(widget), GTK_WIN_POS_CENTER);
+}
+
+static gboolean is_background_launch(gchar** args) {
+  for (gchar** arg = args; arg != nullptr && *arg != nullptr; arg++) {
+    for (const gchar* flag : kBackgroundLaunchFlags) {
+      if (g_strcmp0(*arg, flag) == 0) {
+        return TRUE;
+      }
+    }
+  }
+  return FALSE;
+}
+
+// SIGTERM from the service helper (e.g. restarting an instance that leaked
+// past its resource budget) quits through the main loop instead of killing
+// the process mid-frame.
+static gboolean terminate_cb(gpointer user_data) {
+  g_application_quit(G_APPLICATION(user_data));
+  return G_SOURCE_REMOVE;
+}
+
+// Sends queued forwarded command lines to Dart if it is listening.
+static void deliver_forwarded_args(MyApplication* self) {
+  if (!self->instance_args_listening || self->instance_args_channel == nullptr) {
+    return;
+  }
+  for (guint i = 0; i < self->pending_instance_args->len; i++) {
+    gchar** args = static_cast<gchar**>(g_ptr_array_index(self->pending_instance_args, i));
+    g_autoptr(FlValue) list = fl_value_new_list();
+    for (gchar** arg = args; *arg != nullptr; arg++) {
+      fl_value_append_take(list, fl_value_new_string(*arg));
+    }
+    g_autoptr(GError) error = nullptr;
+    if (!fl_event_channel_send(self->instance_args_channel, list, nullptr, &error)) {
+      g_warning("Failed to forward instance arguments: %s", error->message);
+    }
+  }
+  g_ptr_array_set_size(self->pending_instance_args, 0);
+}
+
+// A later launch handed us its command line.
+static void forwarded_args_cb(gchar** args, gpointer user_data) {
+  MyApplication* self = MY_APPLICATION(user_data);
+  g_ptr_array_add(self->pending_instance_args, args);
+  deliver_forwarded_args(self);
+}
+
+static FlMethodErrorResponse* instance_args_listen_cb(FlEventChannel* channel,
+                                                      FlValue* args,
+                                                      gpointer user_data) {
+  MyApplication* self = MY_APPLICATION(user_data);
+  self->instance_args_listening = TRUE;
+  // Launches that arrived before Dart listened
+  deliver_forwarded_args(self);
+  return nullptr;
+}
+
+static FlMethodErrorResponse* instance_args_cancel_cb(FlEventChannel* channel,
+                                                      FlValue* args,
+                                                      gpointer user_data) {
+  MY_APPLICATION(user_data)->instance_args_listening = FALSE;
+  return nullptr;
 }
 
 // Implements GApplication::activate.
 static void my_application_activate(GApplication* application) {
   MyApplication* self = MY_APPLICATION(application);
+  startup_trace_begin("my_application_activate");
+
+  // Shared-memory heartbeat read by the service helper's hang detector.
+  app_heartbeat_open();
+  // Watchdog for this thread's main loop
+  stall_monitor_start();
+  g_unix_signal_add(SIGTERM, terminate_cb, application);
+
   GtkWindow* window =
       GTK_WINDOW(gtk_application_window_new(GTK_APPLICATION(application)));
 
@@ -53,12 +208,21 @@ static void my_application_activate(GApplication* application) {
     gtk_window_set_title(window, "company_hub");
   }
 
-  gtk_window_set_default_size(window, 1280, 720);
+  if (self->background_launch) {
+    // Minimal surface for the hidden first frame
+    gtk_window_set_default_size(window, 1, 1);
+    g_signal_connect(window, "show", G_CALLBACK(expand_from_background_cb),
+                     nullptr);
+  } else {
+    gtk_window_set_default_size(window, kWindowWidth, kWindowHeight);
+  }
 
   g_autoptr(FlDartProject) project = fl_dart_project_new();
   fl_dart_project_set_dart_entrypoint_arguments(project, self->dart_entrypoint_arguments);
 
+  startup_trace_begin("fl_view_new");
   FlView* view = fl_view_new(project);
+  startup_trace_end("fl_view_new");
   GdkRGBA background_color;
   // Background defaults to black, override it here if necessary, e.g. #00000000 for transparent.
   gdk_rgba_parse(&background_color, "#000000");
@@ -71,9 +235,26 @@ static void my_application_activate(GApplication* application) {
   g_signal_connect_swapped(view, "first-frame", G_CALLBACK(first_frame_cb), self);
   gtk_widget_realize(GTK_WIDGET(view));
 
+  startup_trace_begin("fl_register_plugins");
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
+  startup_trace_end("fl_register_plugins");
+
+  startup_trace_begin("channel_setup");
+  FlBinaryMessenger* messenger =
+      fl_engine_get_binary_messenger(fl_view_get_engine(view));
+  startup_trace_register_channel(messenger);
+  stall_monitor_register_channel(messenger);
+  screen_capture_register_channel(messenger);
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  self->instance_args_channel = fl_event_channel_new(
+      messenger, "com.a1chimney.a1tools/instance_args", FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(self->instance_args_channel,
+                                       instance_args_listen_cb,
+                                       instance_args_cancel_cb, self, nullptr);
+  startup_trace_end("channel_setup");
 
   gtk_widget_grab_focus(GTK_WIDGET(view));
+  startup_trace_end("my_application_activate");
 }
 
 // Implements GApplication::local_command_line.
@@ -81,6 +262,16 @@ static gboolean my_application_local_command_line(GApplication* application, gch
   MyApplication* self = MY_APPLICATION(application);
   // Strip out the first argument as it is the binary name.
   self->dart_entrypoint_arguments = g_strdupv(*arguments + 1);
+  self->background_launch = is_background_launch(self->dart_entrypoint_arguments);
+
+  // A running instance takes over our arguments; no second engine is
+  // started. If two launches race for the socket, the loser forwards.
+  if (instance_channel_forward(self->dart_entrypoint_arguments) ||
+      (!instance_channel_listen(forwarded_args_cb, self) &&
+       instance_channel_forward(self->dart_entrypoint_arguments))) {
+    *exit_status = 0;
+    return TRUE;
+  }
 
   g_autoptr(GError) error = nullptr;
   if (!g_application_register(application, nullptr, &error)) {
@@ -109,6 +300,8 @@ static void my_application_shutdown(GApplication* application) {
   //MyApplication* self = MY_APPLICATION(object);
 
   // Perform any actions required at application shutdown.
+  stall_monitor_stop();
+  screen_capture_shutdown();
 
   G_APPLICATION_CLASS(my_application_parent_class)->shutdown(application);
 }
@@ -116,6 +309,9 @@ static void my_application_shutdown(GApplication* application) {
 // Implements GObject::dispose.
 static void my_application_dispose(GObject* object) {
   MyApplication* self = MY_APPLICATION(object);
+  instance_channel_close();
+  g_clear_object(&self->instance_args_channel);
+  g_clear_pointer(&self->pending_instance_args, g_ptr_array_unref);
   g_clear_pointer(&self->dart_entrypoint_arguments, g_strfreev);
   G_OBJECT_CLASS(my_application_parent_class)->dispose(object);
 }
@@ -128,7 +324,10 @@ static void my_application_class_init(MyApplicationClass* klass) {
   G_OBJECT_CLASS(klass)->dispose = my_application_dispose;
 }
 
-static void my_application_init(MyApplication* self) {}
+static void my_application_init(MyApplication* self) {
+  self->pending_instance_args =
+      g_ptr_array_new_with_free_func(reinterpret_cast<GDestroyNotify>(g_strfreev));
+}
 
 MyApplication* my_application_new() {
   // Set the program name to the application ID, which helps various systems
@@ -137,6 +336,8 @@ MyApplication* my_application_new() {
   // the application to be recognized beyond its binary name.
   g_set_prgname(APPLICATION_ID);
 
+  // Uniqueness is handled by instance_channel.h rather than GApplication's
+  // D-Bus registration, which costs a bus round trip on every launch.
   return MY_APPLICATION(g_object_new(my_application_get_type(),
                                      "application-id", APPLICATION_ID,
                                      "flags", G_APPLICATION_NON_UNIQUE,
@@ -0,0 +1,677 @@
+#include "pixel_kernels.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+// The SIMD versions are compiled for their instruction set with target
+// attributes and only called after the CPU check in pixel_kernels_get, so
+// the rest of the runner keeps the baseline flags. Helpers the SIMD code
+// calls must carry the same attribute; GCC will not inline across targets.
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXEL_KERNELS_X86 1
+#include <immintrin.h>
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// JFIF BT.601 full range in 1/16384ths: each row sums to 16384 for Y and to
+// 0 for Cb and Cr, so greys stay grey.
+static const int kYB = 1868, kYG = 9617, kYR = 4899;
+static const int kCbB = 8192, kCbG = -5427, kCbR = -2765;
+static const int kCrB = -1332, kCrG = -6860, kCrR = 8192;
+static const int kYRound = 1 << 13;
+// Chroma is computed from the sum of four pixels, so it shifts by two bits
+// more; this is 128 plus rounding at that scale
+static const int kChromaOffset = (128 << 16) + (1 << 15);
+
+// Fixed-point sample positions for bilinear scaling: source pixel index and
+// weight of the next pixel, in 1/128ths, for each target pixel centre.
+static void bilinear_positions(int src_size, int dst_size, int* index,
+                               int* weight) {
+  for (int i = 0; i < dst_size; i++) {
+    int64_t position =
+        (static_cast<int64_t>(2 * i + 1) * src_size * 128) / (2 * dst_size) -
+        64;
+    position = std::max<int64_t>(position, 0);
+    index[i] = static_cast<int>(position >> 7);
+    weight[i] = static_cast<int>(position & 127);
+    if (index[i] >= src_size - 1) {
+      index[i] = src_size - 1;
+      weight[i] = 0;
+    }
+  }
+}
+
+static inline uint8_t lerp(int a, int b, int weight) {
+  return static_cast<uint8_t>(a + (((b - a) * weight + 64) >> 7));
+}
+
+static inline void box_pixel(const uint8_t* src, int src_stride, int factor,
+                             int shift, uint8_t* dst) {
+  for (int c = 0; c < 4; c++) {
+    int sum = 0;
+    for (int y = 0; y < factor; y++) {
+      for (int x = 0; x < factor; x++) {
+        sum += src[src_stride * y + x * 4 + c];
+      }
+    }
+    dst[c] = static_cast<uint8_t>((sum + (1 << (shift - 1))) >> shift);
+  }
+}
+
+static inline uint8_t luma(const uint8_t* pixel) {
+  return static_cast<uint8_t>(
+      (pixel[0] * kYB + pixel[1] * kYG + pixel[2] * kYR + kYRound) >> 14);
+}
+
+// Cb and Cr of the 2 x 2 block at |x| of rows |row0| and |row1|; |x1| is
+// the block's right column, |x| itself at an odd right edge.
+static inline void chroma(const uint8_t* row0, const uint8_t* row1, int x,
+                          int x1, uint8_t* cb, uint8_t* cr) {
+  int sum[3];
+  for (int c = 0; c < 3; c++) {
+    sum[c] = row0[x * 4 + c] + row0[x1 * 4 + c] + row1[x * 4 + c] +
+             row1[x1 * 4 + c];
+  }
+  int b = sum[0], g = sum[1], r = sum[2];
+  *cb = static_cast<uint8_t>(
+      std::min((b * kCbB + g * kCbG + r * kCbR + kChromaOffset) >> 16, 255));
+  *cr = static_cast<uint8_t>(
+      std::min((b * kCrB + g * kCrG + r * kCrR + kChromaOffset) >> 16, 255));
+}
+
+// The parts of each kernel the SIMD versions leave to scalar code: columns
+// from |x| (in target pixels) to the end of the row.
+
+static void box_row_tail(const uint8_t* src, int src_stride, int factor,
+                         uint8_t* dst, int x, int width) {
+  int shift = factor == 2 ? 2 : 4;
+  for (; x < width; x++) {
+    box_pixel(src + x * factor * 4, src_stride, factor, shift, dst + x * 4);
+  }
+}
+
+static void lerp_row_tail(const uint8_t* row0, const uint8_t* row1,
+                          int weight, uint8_t* dst, int x, int bytes) {
+  for (; x < bytes; x++) {
+    dst[x] = lerp(row0[x], row1[x], weight);
+  }
+}
+
+static void bilinear_row_tail(const uint8_t* row, const int* index,
+                              const int* weight, uint8_t* dst, int x,
+                              int width) {
+  for (; x < width; x++) {
+    const uint8_t* a = row + index[x] * 4;
+    const uint8_t* b = a + (weight[x] != 0 ? 4 : 0);
+    for (int c = 0; c < 4; c++) {
+      dst[x * 4 + c] = lerp(a[c], b[c], weight[x]);
+    }
+  }
+}
+
+static void luma_row_tail(const uint8_t* row, uint8_t* y, int x, int width) {
+  for (; x < width; x++) {
+    y[x] = luma(row + x * 4);
+  }
+}
+
+static void chroma_row_tail(const uint8_t* row0, const uint8_t* row1,
+                            uint8_t* cb, uint8_t* cr, int x, int width) {
+  for (; x < (width + 1) / 2; x++) {
+    chroma(row0, row1, 2 * x, std::min(2 * x + 1, width - 1), cb + x, cr + x);
+  }
+}
+
+// Shared drivers: |RowFunctions| supply the row kernels of one instruction
+// set, each returning how far it got for the scalar tail to finish.
+
+template <typename RowFunctions>
+static void downscale_box(const uint8_t* src, int src_stride, int src_width,
+                          int src_height, int factor, uint8_t* dst,
+                          int dst_stride) {
+  int width = src_width / factor;
+  int height = src_height / factor;
+  for (int y = 0; y < height; y++) {
+    const uint8_t* row = src + static_cast<size_t>(src_stride) * y * factor;
+    uint8_t* target = dst + static_cast<size_t>(dst_stride) * y;
+    int x = factor == 2 ? RowFunctions::Box2(row, src_stride, target, width)
+                        : RowFunctions::Box4(row, src_stride, target, width);
+    box_row_tail(row, src_stride, factor, target, x, width);
+  }
+}
+
+template <typename RowFunctions>
+static void downscale_bilinear(const uint8_t* src, int src_stride,
+                               int src_width, int src_height, uint8_t* dst,
+                               int dst_stride, int dst_width, int dst_height) {
+  std::vector<int> columns(dst_width * 2);
+  std::vector<int> rows(dst_height * 2);
+  bilinear_positions(src_width, dst_width, columns.data(),
+                     columns.data() + dst_width);
+  bilinear_positions(src_height, dst_height, rows.data(),
+                     rows.data() + dst_height);
+  // Each target row blends two source rows into |blended|, then samples it
+  std::vector<uint8_t> blended(static_cast<size_t>(src_width) * 4);
+  int bytes = src_width * 4;
+  for (int y = 0; y < dst_height; y++) {
+    const uint8_t* row0 = src + static_cast<size_t>(src_stride) * rows[y];
+    int weight = rows[dst_height + y];
+    const uint8_t* row = row0;
+    if (weight != 0) {
+      const uint8_t* row1 = row0 + src_stride;
+      int x = RowFunctions::Lerp(row0, row1, weight, blended.data(), bytes);
+      lerp_row_tail(row0, row1, weight, blended.data(), x, bytes);
+      row = blended.data();
+    }
+    uint8_t* target = dst + static_cast<size_t>(dst_stride) * y;
+    int x = RowFunctions::Bilinear(row, columns.data(),
+                                   columns.data() + dst_width, target,
+                                   dst_width);
+    bilinear_row_tail(row, columns.data(), columns.data() + dst_width, target,
+                      x, dst_width);
+  }
+}
+
+template <typename RowFunctions>
+static void bgrx_to_ycbcr420(const uint8_t* src, int src_stride, int width,
+                             int height, uint8_t* y, int y_stride, uint8_t* cb,
+                             uint8_t* cr, int chroma_stride) {
+  for (int row = 0; row < height; row += 2) {
+    const uint8_t* row0 = src + static_cast<size_t>(src_stride) * row;
+    // An odd last row pairs with itself
+    const uint8_t* row1 = row + 1 < height ? row0 + src_stride : row0;
+    for (int i = 0; i < 2 && row + i < height; i++) {
+      const uint8_t* source = i == 0 ? row0 : row1;
+      uint8_t* target = y + static_cast<size_t>(y_stride) * (row + i);
+      int x = RowFunctions::Luma(source, target, width);
+      luma_row_tail(source, target, x, width);
+    }
+    size_t offset = static_cast<size_t>(chroma_stride) * (row / 2);
+    int x = RowFunctions::Chroma(row0, row1, cb + offset, cr + offset, width);
+    chroma_row_tail(row0, row1, cb + offset, cr + offset, x, width);
+  }
+}
+
+struct ScalarRows {
+  static int Box2(const uint8_t*, int, uint8_t*, int) { return 0; }
+  static int Box4(const uint8_t*, int, uint8_t*, int) { return 0; }
+  static int Lerp(const uint8_t*, const uint8_t*, int, uint8_t*, int) {
+    return 0;
+  }
+  static int Bilinear(const uint8_t*, const int*, const int*, uint8_t*, int) {
+    return 0;
+  }
+  static int Luma(const uint8_t*, uint8_t*, int) { return 0; }
+  static int Chroma(const uint8_t*, const uint8_t*, uint8_t*, uint8_t*, int) {
+    return 0;
+  }
+};
+
+#if defined(PIXEL_KERNELS_X86)
+
+// SSE4.1: four target pixels at a time, 16-bit sums two pixels to a
+// register.
+
+// [p0 p1] [p2 p3] (16-bit BGRX) -> [p0+p1 p2+p3]
+TARGET_SSE41 static inline __m128i pair_sums_sse41(__m128i a, __m128i b) {
+  return _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+}
+
+TARGET_SSE41 static inline __m128i load_pixels2_sse41(const uint8_t* p) {
+  return _mm_cvtepu8_epi16(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+}
+
+template <int kFactor>
+TARGET_SSE41 static int box_row_sse41(const uint8_t* src, int src_stride,
+                                      uint8_t* dst, int width) {
+  const int kShift = kFactor == 2 ? 2 : 4;
+  const __m128i round = _mm_set1_epi16(1 << (kShift - 1));
+  int x = 0;
+  for (; x + 4 <= width; x += 4) {
+    // 4 * kFactor source pixels per row, summed down the block
+    __m128i sums[2 * kFactor];
+    const uint8_t* block = src + x * kFactor * 4;
+    for (int i = 0; i < 2 * kFactor; i++) {
+      sums[i] = load_pixels2_sse41(block + i * 8);
+    }
+    for (int y = 1; y < kFactor; y++) {
+      const uint8_t* row = block + static_cast<size_t>(src_stride) * y;
+      for (int i = 0; i < 2 * kFactor; i++) {
+        sums[i] = _mm_add_epi16(sums[i], load_pixels2_sse41(row + i * 8));
+      }
+    }
+    // Then across it, halving the pixels each round
+    for (int n = 2 * kFactor; n > 2; n /= 2) {
+      for (int i = 0; i < n / 2; i++) {
+        sums[i] = pair_sums_sse41(sums[2 * i], sums[2 * i + 1]);
+      }
+    }
+    __m128i low = _mm_srli_epi16(_mm_add_epi16(sums[0], round), kShift);
+    __m128i high = _mm_srli_epi16(_mm_add_epi16(sums[1], round), kShift);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4),
+                     _mm_packus_epi16(low, high));
+  }
+  return x;
+}
+
+TARGET_SSE41 static int lerp_row_sse41(const uint8_t* row0,
+                                       const uint8_t* row1, int weight,
+                                       uint8_t* dst, int bytes) {
+  const __m128i factor = _mm_set1_epi16(static_cast<int16_t>(weight));
+  const __m128i round = _mm_set1_epi16(64);
+  int x = 0;
+  for (; x + 16 <= bytes; x += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x));
+    __m128i zero = _mm_setzero_si128();
+    __m128i result[2];
+    for (int i = 0; i < 2; i++) {
+      __m128i a16 = i == 0 ? _mm_unpacklo_epi8(a, zero)
+                           : _mm_unpackhi_epi8(a, zero);
+      __m128i b16 = i == 0 ? _mm_unpacklo_epi8(b, zero)
+                           : _mm_unpackhi_epi8(b, zero);
+      __m128i delta = _mm_mullo_epi16(_mm_sub_epi16(b16, a16), factor);
+      result[i] = _mm_add_epi16(
+          a16, _mm_srai_epi16(_mm_add_epi16(delta, round), 7));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                     _mm_packus_epi16(result[0], result[1]));
+  }
+  return x;
+}
+
+TARGET_SSE41 static int bilinear_row_sse41(const uint8_t* row,
+                                           const int* index,
+                                           const int* weight, uint8_t* dst,
+                                           int width) {
+  const __m128i round = _mm_set1_epi16(64);
+  int x = 0;
+  // The last pixel's neighbour may be past the row; leave it to the tail
+  for (; x + 4 < width; x += 4) {
+    uint32_t a[4], b[4];
+    for (int i = 0; i < 4; i++) {
+      memcpy(&a[i], row + index[x + i] * 4, 4);
+      memcpy(&b[i], row + index[x + i] * 4 + 4, 4);
+    }
+    __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+    // Each pixel's weight in its four channels
+    __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weight + x));
+    w = _mm_packus_epi32(w, w);
+    __m128i w_low = _mm_unpacklo_epi16(w, w);
+    __m128i result[2];
+    for (int i = 0; i < 2; i++) {
+      __m128i factor = i == 0 ? _mm_unpacklo_epi32(w_low, w_low)
+                              : _mm_unpackhi_epi32(w_low, w_low);
+      __m128i a16 = i == 0 ? _mm_cvtepu8_epi16(pa)
+                           : _mm_cvtepu8_epi16(_mm_srli_si128(pa, 8));
+      __m128i b16 = i == 0 ? _mm_cvtepu8_epi16(pb)
+                           : _mm_cvtepu8_epi16(_mm_srli_si128(pb, 8));
+      __m128i delta = _mm_mullo_epi16(_mm_sub_epi16(b16, a16), factor);
+      result[i] = _mm_add_epi16(
+          a16, _mm_srai_epi16(_mm_add_epi16(delta, round), 7));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4),
+                     _mm_packus_epi16(result[0], result[1]));
+  }
+  return x;
+}
+
+// Y of four pixels as 32-bit lanes
+TARGET_SSE41 static inline __m128i luma4_sse41(__m128i pixels,
+                                               __m128i coefficients) {
+  __m128i low = _mm_madd_epi16(_mm_cvtepu8_epi16(pixels), coefficients);
+  __m128i high = _mm_madd_epi16(
+      _mm_unpackhi_epi8(pixels, _mm_setzero_si128()), coefficients);
+  return _mm_srli_epi32(_mm_add_epi32(_mm_hadd_epi32(low, high),
+                                      _mm_set1_epi32(kYRound)),
+                        14);
+}
+
+TARGET_SSE41 static int luma_row_sse41(const uint8_t* row, uint8_t* y,
+                                       int width) {
+  const __m128i coefficients =
+      _mm_setr_epi16(kYB, kYG, kYR, 0, kYB, kYG, kYR, 0);
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const __m128i* source = reinterpret_cast<const __m128i*>(row + x * 4);
+    __m128i low = luma4_sse41(_mm_loadu_si128(source), coefficients);
+    __m128i high = luma4_sse41(_mm_loadu_si128(source + 1), coefficients);
+    __m128i words = _mm_packus_epi32(low, high);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(y + x),
+                     _mm_packus_epi16(words, words));
+  }
+  return x;
+}
+
+// 2 x 2 sums of four source pixels of two rows: [c0 c1] (16-bit BGRX)
+TARGET_SSE41 static inline __m128i chroma_sums_sse41(__m128i top,
+                                                     __m128i bottom) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i low = _mm_add_epi16(_mm_cvtepu8_epi16(top), _mm_cvtepu8_epi16(bottom));
+  __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero),
+                               _mm_unpackhi_epi8(bottom, zero));
+  return pair_sums_sse41(low, high);
+}
+
+TARGET_SSE41 static int chroma_row_sse41(const uint8_t* row0,
+                                         const uint8_t* row1, uint8_t* cb,
+                                         uint8_t* cr, int width) {
+  const __m128i cb_coefficients =
+      _mm_setr_epi16(kCbB, kCbG, kCbR, 0, kCbB, kCbG, kCbR, 0);
+  const __m128i cr_coefficients =
+      _mm_setr_epi16(kCrB, kCrG, kCrR, 0, kCrB, kCrG, kCrR, 0);
+  const __m128i offset = _mm_set1_epi32(kChromaOffset);
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const __m128i* top = reinterpret_cast<const __m128i*>(row0 + x * 4);
+    const __m128i* bottom = reinterpret_cast<const __m128i*>(row1 + x * 4);
+    __m128i sums01 = chroma_sums_sse41(_mm_loadu_si128(top),
+                                       _mm_loadu_si128(bottom));
+    __m128i sums23 = chroma_sums_sse41(_mm_loadu_si128(top + 1),
+                                       _mm_loadu_si128(bottom + 1));
+    __m128i blue = _mm_hadd_epi32(_mm_madd_epi16(sums01, cb_coefficients),
+                                  _mm_madd_epi16(sums23, cb_coefficients));
+    __m128i red = _mm_hadd_epi32(_mm_madd_epi16(sums01, cr_coefficients),
+                                 _mm_madd_epi16(sums23, cr_coefficients));
+    blue = _mm_srai_epi32(_mm_add_epi32(blue, offset), 16);
+    red = _mm_srai_epi32(_mm_add_epi32(red, offset), 16);
+    // [cb0-3 cr0-3] as bytes, saturating 256 to 255
+    __m128i words = _mm_packus_epi32(blue, red);
+    __m128i bytes = _mm_packus_epi16(words, words);
+    uint32_t values[2] = {static_cast<uint32_t>(_mm_cvtsi128_si32(bytes)),
+                          static_cast<uint32_t>(_mm_extract_epi32(bytes, 1))};
+    memcpy(cb + x / 2, &values[0], 4);
+    memcpy(cr + x / 2, &values[1], 4);
+  }
+  return x / 2;
+}
+
+struct Sse41Rows {
+  static int Box2(const uint8_t* src, int stride, uint8_t* dst, int width) {
+    return box_row_sse41<2>(src, stride, dst, width);
+  }
+  static int Box4(const uint8_t* src, int stride, uint8_t* dst, int width) {
+    return box_row_sse41<4>(src, stride, dst, width);
+  }
+  static int Lerp(const uint8_t* row0, const uint8_t* row1, int weight,
+                  uint8_t* dst, int bytes) {
+    return lerp_row_sse41(row0, row1, weight, dst, bytes);
+  }
+  static int Bilinear(const uint8_t* row, const int* index, const int* weight,
+                      uint8_t* dst, int width) {
+    return bilinear_row_sse41(row, index, weight, dst, width);
+  }
+  static int Luma(const uint8_t* row, uint8_t* y, int width) {
+    return luma_row_sse41(row, y, width);
+  }
+  static int Chroma(const uint8_t* row0, const uint8_t* row1, uint8_t* cb,
+                    uint8_t* cr, int width) {
+    return chroma_row_sse41(row0, row1, cb, cr, width);
+  }
+};
+
+// AVX2: eight target pixels at a time. Most AVX2 instructions work on each
+// 128-bit half separately, so results come out interleaved by half and are
+// put back in order with a cross-lane permute.
+
+// [p0 p1 | p2 p3] [p4 p5 | p6 p7] (16-bit BGRX) -> [s0 s1 | s2 s3] where
+// sN = p2N + p2N+1
+TARGET_AVX2 static inline __m256i pair_sums_avx2(__m256i a, __m256i b) {
+  __m256i sums = _mm256_add_epi16(_mm256_unpacklo_epi64(a, b),
+                                  _mm256_unpackhi_epi64(a, b));
+  return _mm256_permute4x64_epi64(sums, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+TARGET_AVX2 static inline __m256i load_pixels4_avx2(const uint8_t* p) {
+  return _mm256_cvtepu8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+template <int kFactor>
+TARGET_AVX2 static int box_row_avx2(const uint8_t* src, int src_stride,
+                                    uint8_t* dst, int width) {
+  const int kShift = kFactor == 2 ? 2 : 4;
+  const __m256i round = _mm256_set1_epi16(1 << (kShift - 1));
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i sums[2 * kFactor];
+    const uint8_t* block = src + x * kFactor * 4;
+    for (int i = 0; i < 2 * kFactor; i++) {
+      sums[i] = load_pixels4_avx2(block + i * 16);
+    }
+    for (int y = 1; y < kFactor; y++) {
+      const uint8_t* row = block + static_cast<size_t>(src_stride) * y;
+      for (int i = 0; i < 2 * kFactor; i++) {
+        sums[i] = _mm256_add_epi16(sums[i], load_pixels4_avx2(row + i * 16));
+      }
+    }
+    for (int n = 2 * kFactor; n > 2; n /= 2) {
+      for (int i = 0; i < n / 2; i++) {
+        sums[i] = pair_sums_avx2(sums[2 * i], sums[2 * i + 1]);
+      }
+    }
+    __m256i low = _mm256_srli_epi16(_mm256_add_epi16(sums[0], round), kShift);
+    __m256i high = _mm256_srli_epi16(_mm256_add_epi16(sums[1], round), kShift);
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high),
+                                              _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), packed);
+  }
+  return x;
+}
+
+TARGET_AVX2 static int lerp_row_avx2(const uint8_t* row0, const uint8_t* row1,
+                                     int weight, uint8_t* dst, int bytes) {
+  const __m256i factor = _mm256_set1_epi16(static_cast<int16_t>(weight));
+  const __m256i round = _mm256_set1_epi16(64);
+  int x = 0;
+  for (; x + 16 <= bytes; x += 16) {
+    __m256i a = load_pixels4_avx2(row0 + x);
+    __m256i b = load_pixels4_avx2(row1 + x);
+    __m256i delta = _mm256_mullo_epi16(_mm256_sub_epi16(b, a), factor);
+    __m256i result = _mm256_add_epi16(
+        a, _mm256_srai_epi16(_mm256_add_epi16(delta, round), 7));
+    __m256i packed = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(result, result), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                     _mm256_castsi256_si128(packed));
+  }
+  return x;
+}
+
+TARGET_AVX2 static int bilinear_row_avx2(const uint8_t* row, const int* index,
+                                         const int* weight, uint8_t* dst,
+                                         int width) {
+  const __m256i round = _mm256_set1_epi16(64);
+  const int* pixels = reinterpret_cast<const int*>(row);
+  int x = 0;
+  for (; x + 8 < width; x += 8) {
+    __m256i columns =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index + x));
+    __m256i pa = _mm256_i32gather_epi32(pixels, columns, 4);
+    __m256i pb = _mm256_i32gather_epi32(
+        pixels, _mm256_add_epi32(columns, _mm256_set1_epi32(1)), 4);
+    __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weight + x));
+    // Each weight into the four 16-bit channels of its pixel, halves as
+    // unpacking the pixels below lays them out
+    w = _mm256_or_si256(w, _mm256_slli_epi32(w, 16));
+    __m256i result[2];
+    for (int i = 0; i < 2; i++) {
+      __m256i factor = i == 0 ? _mm256_unpacklo_epi32(w, w)
+                              : _mm256_unpackhi_epi32(w, w);
+      __m256i zero = _mm256_setzero_si256();
+      __m256i a16 = i == 0 ? _mm256_unpacklo_epi8(pa, zero)
+                           : _mm256_unpackhi_epi8(pa, zero);
+      __m256i b16 = i == 0 ? _mm256_unpacklo_epi8(pb, zero)
+                           : _mm256_unpackhi_epi8(pb, zero);
+      __m256i delta = _mm256_mullo_epi16(_mm256_sub_epi16(b16, a16), factor);
+      result[i] = _mm256_add_epi16(
+          a16, _mm256_srai_epi16(_mm256_add_epi16(delta, round), 7));
+    }
+    // Unpacking and packing within halves cancel out
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4),
+                        _mm256_packus_epi16(result[0], result[1]));
+  }
+  return x;
+}
+
+// Y of eight pixels as 32-bit lanes, in order
+TARGET_AVX2 static inline __m256i luma8_avx2(__m256i pixels,
+                                             __m256i coefficients) {
+  __m256i zero = _mm256_setzero_si256();
+  __m256i low =
+      _mm256_madd_epi16(_mm256_unpacklo_epi8(pixels, zero), coefficients);
+  __m256i high =
+      _mm256_madd_epi16(_mm256_unpackhi_epi8(pixels, zero), coefficients);
+  return _mm256_srli_epi32(_mm256_add_epi32(_mm256_hadd_epi32(low, high),
+                                            _mm256_set1_epi32(kYRound)),
+                           14);
+}
+
+TARGET_AVX2 static int luma_row_avx2(const uint8_t* row, uint8_t* y,
+                                     int width) {
+  const __m256i coefficients = _mm256_setr_epi16(
+      kYB, kYG, kYR, 0, kYB, kYG, kYR, 0, kYB, kYG, kYR, 0, kYB, kYG, kYR, 0);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const __m256i* source = reinterpret_cast<const __m256i*>(row + x * 4);
+    __m256i low = luma8_avx2(_mm256_loadu_si256(source), coefficients);
+    __m256i high = luma8_avx2(_mm256_loadu_si256(source + 1), coefficients);
+    __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high),
+                                             _MM_SHUFFLE(3, 1, 2, 0));
+    __m256i bytes = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(words, words), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y + x),
+                     _mm256_castsi256_si128(bytes));
+  }
+  return x;
+}
+
+// 2 x 2 sums of eight source pixels of two rows: [c0 c1 | c2 c3]
+TARGET_AVX2 static inline __m256i chroma_sums_avx2(__m256i top,
+                                                   __m256i bottom) {
+  __m256i zero = _mm256_setzero_si256();
+  __m256i low = _mm256_add_epi16(_mm256_unpacklo_epi8(top, zero),
+                                 _mm256_unpacklo_epi8(bottom, zero));
+  __m256i high = _mm256_add_epi16(_mm256_unpackhi_epi8(top, zero),
+                                  _mm256_unpackhi_epi8(bottom, zero));
+  // [p0 p1 | p4 p5] and [p2 p3 | p6 p7]: pairs line up without a permute
+  return _mm256_add_epi16(_mm256_unpacklo_epi64(low, high),
+                          _mm256_unpackhi_epi64(low, high));
+}
+
+TARGET_AVX2 static int chroma_row_avx2(const uint8_t* row0,
+                                       const uint8_t* row1, uint8_t* cb,
+                                       uint8_t* cr, int width) {
+  const __m256i cb_coefficients =
+      _mm256_setr_epi16(kCbB, kCbG, kCbR, 0, kCbB, kCbG, kCbR, 0, kCbB, kCbG,
+                        kCbR, 0, kCbB, kCbG, kCbR, 0);
+  const __m256i cr_coefficients =
+      _mm256_setr_epi16(kCrB, kCrG, kCrR, 0, kCrB, kCrG, kCrR, 0, kCrB, kCrG,
+                        kCrR, 0, kCrB, kCrG, kCrR, 0);
+  const __m256i offset = _mm256_set1_epi32(kChromaOffset);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const __m256i* top = reinterpret_cast<const __m256i*>(row0 + x * 4);
+    const __m256i* bottom = reinterpret_cast<const __m256i*>(row1 + x * 4);
+    __m256i sums0 = chroma_sums_avx2(_mm256_loadu_si256(top),
+                                     _mm256_loadu_si256(bottom));
+    __m256i sums1 = chroma_sums_avx2(_mm256_loadu_si256(top + 1),
+                                     _mm256_loadu_si256(bottom + 1));
+    // [0 1 4 5 | 2 3 6 7] after the horizontal add, so reorder
+    __m256i blue = _mm256_permute4x64_epi64(
+        _mm256_hadd_epi32(_mm256_madd_epi16(sums0, cb_coefficients),
+                          _mm256_madd_epi16(sums1, cb_coefficients)),
+        _MM_SHUFFLE(3, 1, 2, 0));
+    __m256i red = _mm256_permute4x64_epi64(
+        _mm256_hadd_epi32(_mm256_madd_epi16(sums0, cr_coefficients),
+                          _mm256_madd_epi16(sums1, cr_coefficients)),
+        _MM_SHUFFLE(3, 1, 2, 0));
+    blue = _mm256_srai_epi32(_mm256_add_epi32(blue, offset), 16);
+    red = _mm256_srai_epi32(_mm256_add_epi32(red, offset), 16);
+    // Dwords [cb0-3 cr0-3 .. .. | cb4-7 cr4-7 .. ..] as bytes, saturating
+    // 256 to 255, then [cb0-7 cr0-7]
+    __m256i words = _mm256_packus_epi32(blue, red);
+    __m256i bytes = _mm256_permutevar8x32_epi32(
+        _mm256_packus_epi16(words, words),
+        _mm256_setr_epi32(0, 4, 1, 5, 0, 4, 1, 5));
+    __m128i values = _mm256_castsi256_si128(bytes);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(cb + x / 2), values);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(cr + x / 2),
+                     _mm_srli_si128(values, 8));
+  }
+  return x / 2;
+}
+
+struct Avx2Rows {
+  static int Box2(const uint8_t* src, int stride, uint8_t* dst, int width) {
+    return box_row_avx2<2>(src, stride, dst, width);
+  }
+  static int Box4(const uint8_t* src, int stride, uint8_t* dst, int width) {
+    return box_row_avx2<4>(src, stride, dst, width);
+  }
+  static int Lerp(const uint8_t* row0, const uint8_t* row1, int weight,
+                  uint8_t* dst, int bytes) {
+    return lerp_row_avx2(row0, row1, weight, dst, bytes);
+  }
+  static int Bilinear(const uint8_t* row, const int* index, const int* weight,
+                      uint8_t* dst, int width) {
+    return bilinear_row_avx2(row, index, weight, dst, width);
+  }
+  static int Luma(const uint8_t* row, uint8_t* y, int width) {
+    return luma_row_avx2(row, y, width);
+  }
+  static int Chroma(const uint8_t* row0, const uint8_t* row1, uint8_t* cb,
+                    uint8_t* cr, int width) {
+    return chroma_row_avx2(row0, row1, cb, cr, width);
+  }
+};
+
+#endif  // PIXEL_KERNELS_X86
+
+template <typename RowFunctions>
+static PixelKernels make_kernels(const char* name) {
+  PixelKernels kernels;
+  kernels.name = name;
+  kernels.downscale_box = downscale_box<RowFunctions>;
+  kernels.downscale_bilinear = downscale_bilinear<RowFunctions>;
+  kernels.bgrx_to_ycbcr420 = bgrx_to_ycbcr420<RowFunctions>;
+  return kernels;
+}
+
+const PixelKernels* pixel_kernels_get_level(PixelKernelsLevel level) {
+  static const PixelKernels scalar = make_kernels<ScalarRows>("scalar");
+#if defined(PIXEL_KERNELS_X86)
+  static const PixelKernels sse41 = make_kernels<Sse41Rows>("sse4.1");
+  static const PixelKernels avx2 = make_kernels<Avx2Rows>("avx2");
+  __builtin_cpu_init();
+  switch (level) {
+    case PIXEL_KERNELS_AVX2:
+      // Also checks that the OS saves the AVX registers
+      return __builtin_cpu_supports("avx2") ? &avx2 : nullptr;
+    case PIXEL_KERNELS_SSE41:
+      return __builtin_cpu_supports("sse4.1") ? &sse41 : nullptr;
+    case PIXEL_KERNELS_SCALAR:
+      return &scalar;
+  }
+  return nullptr;
+#else
+  return level == PIXEL_KERNELS_SCALAR ? &scalar : nullptr;
+#endif
+}
+
+const PixelKernels* pixel_kernels_get() {
+  static const PixelKernels* best = [] {
+    const PixelKernels* kernels = pixel_kernels_get_level(PIXEL_KERNELS_AVX2);
+    if (kernels == nullptr) {
+      kernels = pixel_kernels_get_level(PIXEL_KERNELS_SSE41);
+    }
+    return kernels != nullptr ? kernels
+                              : pixel_kernels_get_level(PIXEL_KERNELS_SCALAR);
+  }();
+  return best;
+}
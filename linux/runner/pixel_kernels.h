@@ -0,0 +1,62 @@
+#ifndef FLUTTER_PIXEL_KERNELS_H_
+#define FLUTTER_PIXEL_KERNELS_H_
+
+#include <stdint.h>
+
+/**
+ * PixelKernels:
+ * @name: "avx2", "sse4.1" or "scalar".
+ * @downscale_box: averages each @factor x @factor block (@factor 2 or 4) of
+ *   a 32-bit BGRX image into one pixel of @dst, which is
+ *   @src_width / @factor x @src_height / @factor; leftover columns and rows
+ *   are dropped.
+ * @downscale_bilinear: resamples a 32-bit BGRX image to @dst_width x
+ *   @dst_height (at most the source size) by bilinear interpolation between
+ *   pixel centres, weights in 1/128ths.
+ * @bgrx_to_ycbcr420: converts a 32-bit BGRX image to JFIF YCbCr planes: a
+ *   @width x @height Y plane and Cb and Cr planes of half the width and
+ *   height, rounded up, each the average of a 2 x 2 block (the last column
+ *   and row repeat when the size is odd). The fourth byte is ignored.
+ *
+ * The screen scaling and colour conversion behind the screen capture
+ * channel (screen_capture.h). Every implementation gives bit-identical
+ * results. Strides are in bytes.
+ */
+typedef struct {
+  const char* name;
+  void (*downscale_box)(const uint8_t* src, int src_stride, int src_width,
+                        int src_height, int factor, uint8_t* dst,
+                        int dst_stride);
+  void (*downscale_bilinear)(const uint8_t* src, int src_stride, int src_width,
+                             int src_height, uint8_t* dst, int dst_stride,
+                             int dst_width, int dst_height);
+  void (*bgrx_to_ycbcr420)(const uint8_t* src, int src_stride, int width,
+                           int height, uint8_t* y, int y_stride, uint8_t* cb,
+                           uint8_t* cr, int chroma_stride);
+} PixelKernels;
+
+typedef enum {
+  PIXEL_KERNELS_SCALAR,
+  PIXEL_KERNELS_SSE41,
+  PIXEL_KERNELS_AVX2,
+} PixelKernelsLevel;
+
+/**
+ * pixel_kernels_get:
+ *
+ * Returns: the fastest kernels this CPU runs, chosen on first use.
+ */
+const PixelKernels* pixel_kernels_get();
+
+/**
+ * pixel_kernels_get_level:
+ * @level: the instruction set to use.
+ *
+ * For benchmarks and comparisons.
+ *
+ * Returns: the kernels for @level, or %nullptr if this CPU or build cannot
+ * run them.
+ */
+const PixelKernels* pixel_kernels_get_level(PixelKernelsLevel level);
+
+#endif  // FLUTTER_PIXEL_KERNELS_H_
@@ -0,0 +1,141 @@
+// Throughput of the screen capture scaling and colour conversion kernels
+// (pixel_kernels.h) on each instruction set this CPU supports. Not part of
+// the app; after a `flutter build linux`:
+//
+//   cmake --build build/linux/x64/release --target pixel_kernels_benchmark
+//   build/linux/x64/release/runner/pixel_kernels_benchmark
+//
+// Prints one line per kernel and instruction set (GB/s of source pixels,
+// ms per 1920x1080 frame, speedup over scalar), then a JSON summary. The
+// frame is desktop-like: flat areas, gradients and text-like detail.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "pixel_kernels.h"
+
+static const int kWidth = 1920;
+static const int kHeight = 1080;
+// Each case runs for at least this long, after one untimed pass
+static const double kMinSeconds = 0.5;
+
+struct Case {
+  const char* name;
+  // Runs the kernel once over the frame
+  void (*run)(const PixelKernels* kernels, const uint8_t* frame,
+              std::vector<uint8_t>* out);
+};
+
+static void run_box2(const PixelKernels* kernels, const uint8_t* frame,
+                     std::vector<uint8_t>* out) {
+  kernels->downscale_box(frame, kWidth * 4, kWidth, kHeight, 2, out->data(),
+                         kWidth / 2 * 4);
+}
+
+static void run_box4(const PixelKernels* kernels, const uint8_t* frame,
+                     std::vector<uint8_t>* out) {
+  kernels->downscale_box(frame, kWidth * 4, kWidth, kHeight, 4, out->data(),
+                         kWidth / 4 * 4);
+}
+
+// SET_SCALE 0.75, which the box filter cannot do
+static void run_bilinear(const PixelKernels* kernels, const uint8_t* frame,
+                         std::vector<uint8_t>* out) {
+  kernels->downscale_bilinear(frame, kWidth * 4, kWidth, kHeight, out->data(),
+                              kWidth * 3 / 4 * 4, kWidth * 3 / 4,
+                              kHeight * 3 / 4);
+}
+
+static void run_ycbcr(const PixelKernels* kernels, const uint8_t* frame,
+                      std::vector<uint8_t>* out) {
+  uint8_t* y = out->data();
+  uint8_t* cb = y + kWidth * kHeight;
+  uint8_t* cr = cb + kWidth / 2 * kHeight / 2;
+  kernels->bgrx_to_ycbcr420(frame, kWidth * 4, kWidth, kHeight, y, kWidth, cb,
+                            cr, kWidth / 2);
+}
+
+static const Case kCases[] = {
+    {"box 1/2", run_box2},
+    {"box 1/4", run_box4},
+    {"bilinear 3/4", run_bilinear},
+    {"bgrx->ycbcr420", run_ycbcr},
+};
+
+static std::vector<uint8_t> make_frame() {
+  std::vector<uint8_t> frame(static_cast<size_t>(kWidth) * kHeight * 4);
+  for (int y = 0; y < kHeight; y++) {
+    for (int x = 0; x < kWidth; x++) {
+      uint8_t* pixel = frame.data() + (static_cast<size_t>(y) * kWidth + x) * 4;
+      if ((x % 640) >= 40 && (y % 360) >= 40) {
+        uint32_t cell = static_cast<uint32_t>((x / 2) * 2654435761u) ^
+                        static_cast<uint32_t>((y / 2) * 40503u);
+        uint8_t value = (y % 16) < 9 && ((cell >> 13) % 3) == 0 ? 32 : 245;
+        memset(pixel, value, 3);
+      } else {
+        pixel[0] = static_cast<uint8_t>(x * 255 / kWidth);
+        pixel[1] = static_cast<uint8_t>(y * 255 / kHeight);
+        pixel[2] = 128;
+      }
+      pixel[3] = 255;
+    }
+  }
+  return frame;
+}
+
+// Seconds per run of |test| with |kernels|
+static double measure(const Case& test, const PixelKernels* kernels,
+                      const uint8_t* frame, std::vector<uint8_t>* out) {
+  typedef std::chrono::steady_clock Clock;
+  test.run(kernels, frame, out);
+  int runs = 0;
+  Clock::time_point started = Clock::now();
+  double elapsed = 0;
+  do {
+    test.run(kernels, frame, out);
+    runs++;
+    elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+  } while (elapsed < kMinSeconds);
+  return elapsed / runs;
+}
+
+int main() {
+  std::vector<uint8_t> frame = make_frame();
+  std::vector<uint8_t> out(frame.size());
+  const double frame_bytes = static_cast<double>(frame.size());
+  printf("best: %s\n", pixel_kernels_get()->name);
+
+  std::string json = "[";
+  for (const Case& test : kCases) {
+    double scalar_seconds = 0;
+    for (int level = PIXEL_KERNELS_SCALAR; level <= PIXEL_KERNELS_AVX2;
+         level++) {
+      const PixelKernels* kernels =
+          pixel_kernels_get_level(static_cast<PixelKernelsLevel>(level));
+      if (kernels == nullptr) {
+        continue;
+      }
+      double seconds = measure(test, kernels, frame.data(), &out);
+      if (level == PIXEL_KERNELS_SCALAR) {
+        scalar_seconds = seconds;
+      }
+      double gb_per_second = frame_bytes / seconds / 1e9;
+      printf("%-16s %-7s %7.2f GB/s  %6.3f ms/frame  %5.2fx\n", test.name,
+             kernels->name, gb_per_second, seconds * 1000,
+             scalar_seconds / seconds);
+      char entry[256];
+      snprintf(entry, sizeof(entry),
+               "%s{\"kernel\":\"%s\",\"isa\":\"%s\",\"gb_per_s\":%.3f,"
+               "\"ms_per_frame\":%.4f}",
+               json.size() > 1 ? "," : "", test.name, kernels->name,
+               gb_per_second, seconds * 1000);
+      json += entry;
+    }
+  }
+  printf("%s]\n", json.c_str());
+  return 0;
+}
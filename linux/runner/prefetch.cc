@@ -0,0 +1,105 @@
+#include "prefetch.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "startup_trace.h"
+
+// Assets beyond this are left to demand paging; the splash and the first
+// screens only touch a fraction of them.
+static const uint64_t kMaxAssetBytes = 64ull << 20;
+
+// Hints |path| into the page cache. Returns the bytes hinted.
+static uint64_t prefetch_file(const char* path) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return 0;
+  }
+  struct stat st;
+  uint64_t size = 0;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    size = static_cast<uint64_t>(st.st_size);
+    // readahead() queues the reads and returns once they are issued; it
+    // also sidesteps the per-file readahead window fadvise is limited to.
+    if (readahead(fd, 0, size) != 0) {
+      posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    }
+  }
+  close(fd);
+  return size;
+}
+
+static void prefetch_directory(const char* path, uint64_t* budget) {
+  DIR* dir = opendir(path);
+  if (dir == nullptr) {
+    return;
+  }
+  struct dirent* entry;
+  while (*budget > 0 && (entry = readdir(dir)) != nullptr) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 ||
+        // License text, only read by the about dialog
+        strcmp(entry->d_name, "NOTICES.Z") == 0) {
+      continue;
+    }
+    g_autofree gchar* child = g_build_filename(path, entry->d_name, nullptr);
+    if (entry->d_type == DT_DIR) {
+      prefetch_directory(child, budget);
+    } else {
+      uint64_t size = prefetch_file(child);
+      *budget = size < *budget ? *budget - size : 0;
+    }
+  }
+  closedir(dir);
+}
+
+static void prefetch_bundle(gchar* bundle_dir) {
+  startup_trace_begin("prefetch");
+
+  // In the order the engine needs them: the AOT snapshot when the Dart VM
+  // starts, ICU data right after, then the assets for the first frames
+  g_autofree gchar* libapp =
+      g_build_filename(bundle_dir, "lib", "libapp.so", nullptr);
+  startup_trace_begin("prefetch:libapp.so");
+  prefetch_file(libapp);
+  startup_trace_end("prefetch:libapp.so");
+
+  g_autofree gchar* icu =
+      g_build_filename(bundle_dir, "data", "icudtl.dat", nullptr);
+  startup_trace_begin("prefetch:icudtl.dat");
+  prefetch_file(icu);
+  startup_trace_end("prefetch:icudtl.dat");
+
+  g_autofree gchar* assets =
+      g_build_filename(bundle_dir, "data", "flutter_assets", nullptr);
+  uint64_t budget = kMaxAssetBytes;
+  startup_trace_begin("prefetch:flutter_assets");
+  prefetch_directory(assets, &budget);
+  startup_trace_end("prefetch:flutter_assets");
+
+  startup_trace_end("prefetch");
+  g_free(bundle_dir);
+}
+
+void prefetch_start() {
+  if (g_strcmp0(g_getenv(PREFETCH_ENV_VAR), "0") == 0) {
+    startup_trace_instant("prefetch:disabled");
+    return;
+  }
+  char exe[PATH_MAX];
+  ssize_t length = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+  if (length <= 0) {
+    return;
+  }
+  exe[length] = '\0';
+  // Detached: the thread only warms the cache and owns nothing the process
+  // needs at exit
+  std::thread(prefetch_bundle, g_path_get_dirname(exe)).detach();
+}
@@ -0,0 +1,23 @@
+#ifndef FLUTTER_PREFETCH_H_
+#define FLUTTER_PREFETCH_H_
+
+// Set to 0 to skip prefetching, e.g. for A/B runs of
+// scripts/startup_benchmark.py (--no-prefetch).
+#define PREFETCH_ENV_VAR "A1_TOOLS_PREFETCH"
+
+/**
+ * prefetch_start:
+ *
+ * Starts reading the files the engine needs at startup (lib/libapp.so,
+ * data/icudtl.dat, data/flutter_assets) into the page cache on a background
+ * thread, so a cold start overlaps that I/O with GTK and window setup
+ * instead of faulting it in page by page on the main thread. On a warm
+ * cache it costs a few syscalls.
+ *
+ * Recorded in the startup trace as "prefetch" on its own thread, with one
+ * "prefetch:<file>" phase per file and "prefetch:flutter_assets" for the
+ * asset directory.
+ */
+void prefetch_start();
+
+#endif  // FLUTTER_PREFETCH_H_
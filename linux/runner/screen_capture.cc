@@ -0,0 +1,849 @@
+#include "screen_capture.h"
+
+#include "pixel_kernels.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// jpeglib.h needs stdio.h first
+#include <jpeglib.h>
+
+#include <string>
+#include <vector>
+
+#define SCREEN_CAPTURE_CHANNEL "com.a1chimney.a1tools/screen_capture"
+
+static const int kDefaultQuality = 75;
+static const int kDefaultSyntheticWidth = 1920;
+static const int kDefaultSyntheticHeight = 1080;
+static const int kMaxSyntheticSize = 8192;
+// Smallest scale accepted, as ScreenStreamServer's SET_SCALE
+static const double kMinScale = 0.25;
+// Tiles are whole JPEG MCUs (16 x 16 with 4:2:0 chroma), so tiles side by
+// side in an atlas never share a block. At most 256 x 256 tiles, so indices
+// fit 16 bits.
+static const int kDefaultTileSize = 64;
+static const int kMinTileSize = 32;
+static const int kMaxTileSize = 256;
+// Changed tiles per atlas row
+static const int kAtlasColumns = 16;
+// Captures queued or running; more are refused rather than piling up on
+// the thread pool.
+static const gint kMaxPending = 4;
+
+typedef struct {
+  gboolean synthetic;
+  int width;  // Synthetic only
+  int height;
+  int quality;
+  double scale;  // 0.25-1
+  gboolean tiles;  // "captureTiles"
+  int tile_size;
+  gboolean full;  // Tiled: also encode the whole frame
+} CaptureRequest;
+
+typedef struct {
+  int width;
+  int height;
+  unsigned char* jpeg;  // malloc'd by libjpeg
+  unsigned long jpeg_size;
+  // Tiled: indices of the changed tiles as little-endian uint16s, and the
+  // atlas they are packed into (null when nothing changed)
+  std::vector<uint8_t> tile_indices;
+  unsigned char* atlas;  // malloc'd by libjpeg
+  unsigned long atlas_size;
+  gint64 capture_us;
+  gint64 scale_us;
+  gint64 hash_us;
+  gint64 encode_us;
+  // Set on failure
+  const char* error_code;
+  std::string error_message;
+} CaptureResult;
+
+// A grabbed frame: 32-bit BGRX rows, not owned.
+typedef struct {
+  const uint8_t* pixels;
+  int width;
+  int height;
+  int stride;
+} Frame;
+
+typedef struct {
+  struct jpeg_error_mgr manager;
+  jmp_buf jump;
+  char message[JMSG_LENGTH_MAX];
+} JpegError;
+
+static FlMethodChannel* channel = nullptr;
+static gint pending = 0;
+
+static GMutex capture_mutex;  // Guards everything below
+static gboolean shut_down = FALSE;
+static Display* display = nullptr;
+static gboolean use_shm = FALSE;
+static XImage* image = nullptr;
+static XShmSegmentInfo shm_info;
+static std::vector<uint8_t> synthetic_pixels;
+static guint64 synthetic_frame = 0;
+static std::vector<uint8_t> scaled_pixels;
+// Y, Cb and Cr planes of the frame being encoded
+static std::vector<uint8_t> ycbcr_planes;
+// Tile hashes of the previous tiled capture, row-major; empty when the next
+// one must send every tile, and the frame size they were taken at
+static std::vector<guint64> tile_hashes;
+static int tiled_width = 0;
+static int tiled_height = 0;
+static int tile_columns = 0;
+static int tile_rows = 0;
+static int tile_hashes_size = 0;
+static std::vector<uint8_t> atlas_pixels;
+
+static void release_image() {
+  if (image == nullptr) {
+    return;
+  }
+  if (use_shm) {
+    XShmDetach(display, &shm_info);
+    XDestroyImage(image);
+    shmdt(shm_info.shmaddr);
+  } else {
+    XDestroyImage(image);
+  }
+  image = nullptr;
+}
+
+// Only a local server can map our segment; asking a remote one to attach it
+// ends in an X error.
+static gboolean display_is_local(Display* x_display) {
+  const char* name = DisplayString(x_display);
+  return name != nullptr && (name[0] == ':' || strncmp(name, "unix:", 5) == 0);
+}
+
+static gboolean create_shm_image(Visual* visual, int depth, int width,
+                                 int height) {
+  image = XShmCreateImage(display, visual, depth, ZPixmap, nullptr, &shm_info,
+                          width, height);
+  if (image == nullptr) {
+    return FALSE;
+  }
+  shm_info.shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height,
+                          IPC_CREAT | 0600);
+  if (shm_info.shmid < 0) {
+    XDestroyImage(image);
+    image = nullptr;
+    return FALSE;
+  }
+  shm_info.shmaddr = image->data =
+      static_cast<char*>(shmat(shm_info.shmid, nullptr, 0));
+  shm_info.readOnly = False;
+  gboolean attached = shm_info.shmaddr != reinterpret_cast<char*>(-1) &&
+                      XShmAttach(display, &shm_info);
+  XSync(display, False);
+  // Freed once both sides detach, even if we crash
+  shmctl(shm_info.shmid, IPC_RMID, nullptr);
+  if (!attached) {
+    if (shm_info.shmaddr != reinterpret_cast<char*>(-1)) {
+      shmdt(shm_info.shmaddr);
+    }
+    image->data = nullptr;
+    XDestroyImage(image);
+    image = nullptr;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// Grabs the root window into |image|, reusing it while the size holds.
+static gboolean grab_screen(Frame* frame, CaptureResult* result) {
+  if (display == nullptr) {
+    // A connection of our own, used only under capture_mutex
+    display = XOpenDisplay(nullptr);
+    if (display == nullptr) {
+      result->error_code = "UNAVAILABLE";
+      result->error_message = "No X11 display";
+      return FALSE;
+    }
+    use_shm = XShmQueryExtension(display) && display_is_local(display);
+  }
+
+  Window root = DefaultRootWindow(display);
+  XWindowAttributes attributes;
+  if (!XGetWindowAttributes(display, root, &attributes)) {
+    result->error_code = "CAPTURE_FAILED";
+    result->error_message = "Could not query the root window";
+    return FALSE;
+  }
+  if (image != nullptr &&
+      (image->width != attributes.width || image->height != attributes.height)) {
+    release_image();
+  }
+
+  if (use_shm) {
+    if (image == nullptr &&
+        !create_shm_image(attributes.visual, attributes.depth,
+                          attributes.width, attributes.height)) {
+      g_warning("MIT-SHM unavailable, capturing with XGetImage");
+      use_shm = FALSE;
+    }
+  }
+  if (use_shm) {
+    if (!XShmGetImage(display, root, image, 0, 0, AllPlanes)) {
+      result->error_code = "CAPTURE_FAILED";
+      result->error_message = "XShmGetImage failed";
+      return FALSE;
+    }
+  } else {
+    release_image();
+    image = XGetImage(display, root, 0, 0, attributes.width, attributes.height,
+                      AllPlanes, ZPixmap);
+    if (image == nullptr) {
+      result->error_code = "CAPTURE_FAILED";
+      result->error_message = "XGetImage failed";
+      return FALSE;
+    }
+  }
+
+  if (image->bits_per_pixel != 32 || image->byte_order != LSBFirst ||
+      image->red_mask != 0xff0000 || image->green_mask != 0xff00 ||
+      image->blue_mask != 0xff) {
+    result->error_code = "CAPTURE_FAILED";
+    result->error_message = "Unsupported X11 pixel format";
+    return FALSE;
+  }
+  frame->pixels = reinterpret_cast<const uint8_t*>(image->data);
+  frame->width = image->width;
+  frame->height = image->height;
+  frame->stride = image->bytes_per_line;
+  return TRUE;
+}
+
+// Desktop-like content: a gradient background and, over most of it,
+// windows of text-like detail. The window under the centre scrolls by a
+// pixel per frame, so consecutive frames differ the way a screen with one
+// busy window does. Mirrors FillSyntheticFrame in
+// windows/runner/screen_capture.cpp.
+static void grab_synthetic(int width, int height, Frame* frame) {
+  size_t stride = static_cast<size_t>(width) * 4;
+  synthetic_pixels.resize(stride * height);
+  guint64 scroll = synthetic_frame++;
+  int active_column = (width / 2) / 640;
+  int active_row = (height / 2) / 360;
+  for (int y = 0; y < height; y++) {
+    uint8_t* row = synthetic_pixels.data() + stride * y;
+    // 16-pixel lines of 9-pixel glyphs, ragged right; [0] still, [1] scrolled
+    guint64 offset[2] = {0, y / 360 == active_row ? scroll : 0};
+    guint64 line[2];
+    gboolean glyph_row[2];
+    int line_length[2];
+    for (int i = 0; i < 2; i++) {
+      line[i] = (y + offset[i]) / 16;
+      glyph_row[i] = ((y + offset[i]) % 16) < 9;
+      line_length[i] = 200 + static_cast<int>((line[i] * 97) % 380);
+    }
+    for (int x = 0; x < width; x++) {
+      uint8_t* pixel = row + x * 4;
+      gboolean in_window = (x % 640) >= 40 && (y % 360) >= 40;
+      if (in_window) {
+        int i = x / 640 == active_column ? 1 : 0;
+        gboolean ink = FALSE;
+        if (glyph_row[i] && (x % 640) - 40 < line_length[i] &&
+            ((x + line[i] * 13) / 6) % 8 != 7) {
+          guint32 cell = static_cast<guint32>((x / 2) * 2654435761u) ^
+                         static_cast<guint32>(((y + offset[i]) / 2) * 40503u);
+          ink = ((cell >> 13) % 3) == 0;
+        }
+        uint8_t value = ink ? 32 : 245;
+        pixel[0] = value;
+        pixel[1] = value;
+        pixel[2] = value;
+      } else {
+        pixel[0] = static_cast<uint8_t>(x * 255 / width);
+        pixel[1] = static_cast<uint8_t>(y * 255 / height);
+        pixel[2] = 128;
+      }
+      pixel[3] = 255;
+    }
+  }
+  frame->pixels = synthetic_pixels.data();
+  frame->width = width;
+  frame->height = height;
+  frame->stride = static_cast<int>(stride);
+}
+
+// Shrinks |frame| by |scale| into |scaled_pixels|: by averaging whole
+// blocks when that is 1/2 or 1/4, by bilinear interpolation otherwise.
+static void scale_frame(const Frame* frame, double scale, Frame* scaled) {
+  const PixelKernels* kernels = pixel_kernels_get();
+  int factor = static_cast<int>(1 / scale + 0.5);
+  gboolean box = (factor == 2 || factor == 4) &&
+                 ABS(1 / scale - factor) < 0.01 &&
+                 frame->width >= factor && frame->height >= factor;
+  if (box) {
+    scaled->width = frame->width / factor;
+    scaled->height = frame->height / factor;
+  } else {
+    scaled->width = MAX(1, static_cast<int>(frame->width * scale + 0.5));
+    scaled->height = MAX(1, static_cast<int>(frame->height * scale + 0.5));
+  }
+  scaled->stride = scaled->width * 4;
+  scaled_pixels.resize(static_cast<size_t>(scaled->stride) * scaled->height);
+  if (box) {
+    kernels->downscale_box(frame->pixels, frame->stride, frame->width,
+                           frame->height, factor, scaled_pixels.data(),
+                           scaled->stride);
+  } else {
+    kernels->downscale_bilinear(frame->pixels, frame->stride, frame->width,
+                                frame->height, scaled_pixels.data(),
+                                scaled->stride, scaled->width, scaled->height);
+  }
+  scaled->pixels = scaled_pixels.data();
+}
+
+// Repeats the last column and row of a |width| x |height| plane out to
+// its |stride| x |padded_height| buffer.
+static void pad_plane(uint8_t* plane, int stride, int width, int height,
+                      int padded_height) {
+  for (int y = 0; y < height; y++) {
+    uint8_t* row = plane + static_cast<size_t>(stride) * y;
+    memset(row + width, row[width - 1], stride - width);
+  }
+  for (int y = height; y < padded_height; y++) {
+    memcpy(plane + static_cast<size_t>(stride) * y,
+           plane + static_cast<size_t>(stride) * (height - 1), stride);
+  }
+}
+
+static void jpeg_error_exit(j_common_ptr cinfo) {
+  JpegError* error = reinterpret_cast<JpegError*>(cinfo->err);
+  (*cinfo->err->format_message)(cinfo, error->message);
+  longjmp(error->jump, 1);
+}
+
+static inline guint64 rotate_left(guint64 value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+// Hashes |rows| rows of |row_bytes| bytes (a multiple of 4) for change
+// detection. Each 16-byte block is keyed, mixed with a 32 x 32 -> 64-bit
+// multiply and added to a rotated accumulator, four accumulators in flight;
+// accumulators are scrambled after every row so rows cannot trade places
+// unnoticed. SSE2 is part of x86-64; elsewhere a scalar version with the
+// same structure is used. Hashes are only compared within one process.
+// Keep in sync with HashTile in windows/runner/screen_capture.cpp.
+static guint64 hash_tile(const uint8_t* pixels, int stride, int row_bytes,
+                         int rows) {
+  static const guint64 kKeys[8] = {
+      0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull,
+      0x1f67b3b7a4a44072ull, 0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull,
+      0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull};
+  static const guint32 kPrime = 0x9e3779b1u;
+#if defined(__SSE2__)
+  __m128i acc[4];
+  __m128i keys[4];
+  for (int i = 0; i < 4; i++) {
+    keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kKeys + i * 2));
+    acc[i] = keys[i];
+  }
+  const __m128i prime = _mm_set1_epi32(static_cast<int>(kPrime));
+  auto mix = [](__m128i value, __m128i data, __m128i key) {
+    __m128i keyed = _mm_xor_si128(data, key);
+    __m128i product = _mm_mul_epu32(
+        keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+    value = _mm_or_si128(_mm_slli_epi64(value, 17), _mm_srli_epi64(value, 47));
+    return _mm_add_epi64(
+        value, _mm_add_epi64(product, _mm_shuffle_epi32(
+                                          data, _MM_SHUFFLE(1, 0, 3, 2))));
+  };
+  for (int y = 0; y < rows; y++) {
+    const uint8_t* row = pixels + static_cast<size_t>(stride) * y;
+    int x = 0;
+    for (; x + 64 <= row_bytes; x += 64) {
+      for (int i = 0; i < 4; i++) {
+        __m128i data =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + i * 16));
+        acc[i] = mix(acc[i], data, keys[i]);
+      }
+    }
+    for (; x + 16 <= row_bytes; x += 16) {
+      __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+      acc[0] = mix(acc[0], data, keys[0]);
+    }
+    if (x < row_bytes) {
+      uint8_t tail[16] = {};
+      memcpy(tail, row + x, row_bytes - x);
+      acc[1] = mix(acc[1],
+                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail)),
+                   keys[1]);
+    }
+    // acc = (acc ^ (acc >> 47) ^ key) * prime
+    for (int i = 0; i < 4; i++) {
+      __m128i value = _mm_xor_si128(
+          _mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47)), keys[i]);
+      __m128i low = _mm_mul_epu32(value, prime);
+      __m128i high = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+      acc[i] = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+    }
+  }
+  guint64 lanes[8];
+  for (int i = 0; i < 4; i++) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + i * 2), acc[i]);
+  }
+#else
+  guint64 lanes[8];
+  memcpy(lanes, kKeys, sizeof(lanes));
+  for (int y = 0; y < rows; y++) {
+    const uint8_t* row = pixels + static_cast<size_t>(stride) * y;
+    int lane = 0;
+    for (int x = 0; x < row_bytes; x += 8) {
+      guint64 data = 0;
+      memcpy(&data, row + x, MIN(8, row_bytes - x));
+      guint64 keyed = data ^ kKeys[lane];
+      lanes[lane] = rotate_left(lanes[lane], 17) +
+                    (keyed & 0xffffffffu) * (keyed >> 32) + data;
+      lane = (lane + 1) & 7;
+    }
+    for (int i = 0; i < 8; i++) {
+      lanes[i] = (lanes[i] ^ (lanes[i] >> 47) ^ kKeys[i]) * kPrime;
+    }
+  }
+#endif
+  guint64 hash = static_cast<guint64>(rows) << 32 | row_bytes;
+  for (int i = 0; i < 8; i++) {
+    hash = rotate_left(hash ^ lanes[i], 29) * 0x9e3779b97f4a7c15ull;
+  }
+  // MurmurHash3 finalizer
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ull;
+  return hash ^ (hash >> 33);
+}
+
+// Hashes every tile of |frame| and lists those that differ from the previous
+// tiled capture: all of them after a size change or a failed capture.
+static void diff_tiles(const Frame* frame, int tile_size,
+                       std::vector<uint16_t>* changed) {
+  int columns = (frame->width + tile_size - 1) / tile_size;
+  int rows = (frame->height + tile_size - 1) / tile_size;
+  gboolean reset = frame->width != tiled_width ||
+                   frame->height != tiled_height ||
+                   columns != tile_columns || rows != tile_rows ||
+                   tile_size != tile_hashes_size ||
+                   tile_hashes.size() != static_cast<size_t>(columns) * rows;
+  if (reset) {
+    tile_hashes.assign(static_cast<size_t>(columns) * rows, 0);
+    tiled_width = frame->width;
+    tiled_height = frame->height;
+    tile_columns = columns;
+    tile_rows = rows;
+    tile_hashes_size = tile_size;
+  }
+  changed->clear();
+  for (int row = 0; row < rows; row++) {
+    int y = row * tile_size;
+    int height = MIN(tile_size, frame->height - y);
+    for (int column = 0; column < columns; column++) {
+      int x = column * tile_size;
+      int width = MIN(tile_size, frame->width - x);
+      guint64 hash = hash_tile(
+          frame->pixels + static_cast<size_t>(frame->stride) * y + x * 4,
+          frame->stride, width * 4, height);
+      size_t index = static_cast<size_t>(row) * columns + column;
+      if (reset || hash != tile_hashes[index]) {
+        changed->push_back(static_cast<uint16_t>(index));
+      }
+      tile_hashes[index] = hash;
+    }
+  }
+}
+
+// Copies the |changed| tiles of |frame| into |atlas_pixels|, kAtlasColumns
+// to a row in the order listed. Partial tiles at the right and bottom edges
+// are padded by repeating their last column and row.
+static void pack_atlas(const Frame* frame, int tile_size,
+                       const std::vector<uint16_t>& changed, Frame* atlas) {
+  int count = static_cast<int>(changed.size());
+  int columns = MIN(count, kAtlasColumns);
+  int rows = (count + columns - 1) / columns;
+  size_t stride = static_cast<size_t>(columns) * tile_size * 4;
+  atlas_pixels.resize(stride * rows * tile_size);
+  for (int i = 0; i < count; i++) {
+    int source_x = (changed[i] % tile_columns) * tile_size;
+    int source_y = (changed[i] / tile_columns) * tile_size;
+    int width = MIN(tile_size, frame->width - source_x);
+    int height = MIN(tile_size, frame->height - source_y);
+    uint8_t* cell = atlas_pixels.data() + stride * (i / columns) * tile_size +
+                    static_cast<size_t>(i % columns) * tile_size * 4;
+    for (int y = 0; y < tile_size; y++) {
+      const uint8_t* source =
+          frame->pixels +
+          static_cast<size_t>(frame->stride) * (source_y + MIN(y, height - 1)) +
+          source_x * 4;
+      uint8_t* target = cell + stride * y;
+      memcpy(target, source, width * 4);
+      for (int x = width; x < tile_size; x++) {
+        memcpy(target + x * 4, source + (width - 1) * 4, 4);
+      }
+    }
+  }
+  // Blank the unused cells of the last row so they cost next to nothing
+  for (int i = count; i < columns * rows; i++) {
+    uint8_t* cell = atlas_pixels.data() + stride * (i / columns) * tile_size +
+                    static_cast<size_t>(i % columns) * tile_size * 4;
+    for (int y = 0; y < tile_size; y++) {
+      memset(cell + stride * y, 0, tile_size * 4);
+    }
+  }
+  atlas->pixels = atlas_pixels.data();
+  atlas->width = columns * tile_size;
+  atlas->height = rows * tile_size;
+  atlas->stride = static_cast<int>(stride);
+}
+
+// Encodes |frame| into |*jpeg|, malloc'd by libjpeg. The frame is
+// converted to YCbCr 4:2:0 by pixel_kernels and handed over as raw data, so
+// libjpeg only transforms and compresses it.
+static gboolean encode_jpeg(const Frame* frame, int quality,
+                            unsigned char** jpeg, unsigned long* jpeg_size,
+                            CaptureResult* result) {
+  // Raw data comes in whole MCUs: 16 x 16 luma, 8 x 8 of each chroma plane
+  int luma_width = (frame->width + 15) & ~15;
+  int luma_height = (frame->height + 15) & ~15;
+  int chroma_width = luma_width / 2;
+  int chroma_height = luma_height / 2;
+  size_t luma_size = static_cast<size_t>(luma_width) * luma_height;
+  size_t chroma_size = static_cast<size_t>(chroma_width) * chroma_height;
+  ycbcr_planes.resize(luma_size + chroma_size * 2);
+  uint8_t* planes[3] = {ycbcr_planes.data(), ycbcr_planes.data() + luma_size,
+                        ycbcr_planes.data() + luma_size + chroma_size};
+  pixel_kernels_get()->bgrx_to_ycbcr420(frame->pixels, frame->stride,
+                                        frame->width, frame->height, planes[0],
+                                        luma_width, planes[1], planes[2],
+                                        chroma_width);
+  pad_plane(planes[0], luma_width, frame->width, frame->height, luma_height);
+  for (int i = 1; i < 3; i++) {
+    pad_plane(planes[i], chroma_width, (frame->width + 1) / 2,
+              (frame->height + 1) / 2, chroma_height);
+  }
+
+  struct jpeg_compress_struct cinfo;
+  JpegError error;
+  cinfo.err = jpeg_std_error(&error.manager);
+  error.manager.error_exit = jpeg_error_exit;
+  if (setjmp(error.jump)) {
+    jpeg_destroy_compress(&cinfo);
+    free(*jpeg);
+    *jpeg = nullptr;
+    result->error_code = "ENCODE_FAILED";
+    result->error_message = error.message;
+    return FALSE;
+  }
+
+  jpeg_create_compress(&cinfo);
+  *jpeg = nullptr;
+  *jpeg_size = 0;
+  jpeg_mem_dest(&cinfo, jpeg, jpeg_size);
+  cinfo.image_width = frame->width;
+  cinfo.image_height = frame->height;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_YCbCr;
+  // Defaults to 2 x 2 luma sampling for YCbCr, matching the planes
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, quality, TRUE);
+  cinfo.raw_data_in = TRUE;
+  jpeg_start_compress(&cinfo, TRUE);
+  JSAMPROW rows[3][16];
+  JSAMPARRAY components[3] = {rows[0], rows[1], rows[2]};
+  while (cinfo.next_scanline < cinfo.image_height) {
+    for (int i = 0; i < 16; i++) {
+      rows[0][i] = planes[0] + static_cast<size_t>(luma_width) *
+                                   (cinfo.next_scanline + i);
+    }
+    for (int i = 0; i < 8; i++) {
+      size_t offset =
+          static_cast<size_t>(chroma_width) * (cinfo.next_scanline / 2 + i);
+      rows[1][i] = planes[1] + offset;
+      rows[2][i] = planes[2] + offset;
+    }
+    jpeg_write_raw_data(&cinfo, components, 16);
+  }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  return TRUE;
+}
+
+static void capture(const CaptureRequest* request, CaptureResult* result) {
+  g_mutex_lock(&capture_mutex);
+  if (shut_down) {
+    g_mutex_unlock(&capture_mutex);
+    result->error_code = "UNAVAILABLE";
+    result->error_message = "Shutting down";
+    return;
+  }
+  gint64 started = g_get_monotonic_time();
+  Frame frame;
+  gboolean grabbed = TRUE;
+  if (request->synthetic) {
+    grab_synthetic(request->width, request->height, &frame);
+  } else {
+    grabbed = grab_screen(&frame, result);
+  }
+  gint64 grabbed_at = g_get_monotonic_time();
+  if (grabbed && request->scale < 1) {
+    Frame scaled;
+    scale_frame(&frame, request->scale, &scaled);
+    frame = scaled;
+  }
+  gint64 scaled_at = g_get_monotonic_time();
+  gint64 hashed_at = scaled_at;
+  // The frame points into buffers guarded by capture_mutex
+  gboolean encoded = FALSE;
+  if (grabbed && request->tiles) {
+    std::vector<uint16_t> changed;
+    diff_tiles(&frame, request->tile_size, &changed);
+    hashed_at = g_get_monotonic_time();
+    encoded = TRUE;
+    if (!changed.empty()) {
+      Frame atlas;
+      pack_atlas(&frame, request->tile_size, changed, &atlas);
+      encoded = encode_jpeg(&atlas, request->quality, &result->atlas,
+                            &result->atlas_size, result);
+    }
+    if (encoded && request->full) {
+      encoded = encode_jpeg(&frame, request->quality, &result->jpeg,
+                            &result->jpeg_size, result);
+    }
+    if (encoded) {
+      result->tile_indices.reserve(changed.size() * 2);
+      for (uint16_t index : changed) {
+        result->tile_indices.push_back(index & 0xff);
+        result->tile_indices.push_back(index >> 8);
+      }
+    } else {
+      // The caller never sees these tiles; resend everything next time
+      tile_hashes.clear();
+    }
+  } else if (grabbed) {
+    encoded = encode_jpeg(&frame, request->quality, &result->jpeg,
+                          &result->jpeg_size, result);
+  }
+  if (encoded) {
+    result->width = frame.width;
+    result->height = frame.height;
+  }
+  g_mutex_unlock(&capture_mutex);
+  result->capture_us = grabbed_at - started;
+  result->scale_us = scaled_at - grabbed_at;
+  result->hash_us = hashed_at - scaled_at;
+  result->encode_us = g_get_monotonic_time() - hashed_at;
+}
+
+static void free_result(CaptureResult* result) {
+  free(result->jpeg);
+  free(result->atlas);
+  delete result;
+}
+
+static void capture_thread_cb(GTask* task, gpointer source_object,
+                              gpointer task_data, GCancellable* cancellable) {
+  CaptureResult* result = new CaptureResult();
+  capture(static_cast<CaptureRequest*>(task_data), result);
+  g_task_return_pointer(task, result, [](gpointer data) {
+    free_result(static_cast<CaptureResult*>(data));
+  });
+}
+
+static void capture_done_cb(GObject* source_object, GAsyncResult* async_result,
+                            gpointer user_data) {
+  g_autoptr(FlMethodCall) method_call = FL_METHOD_CALL(user_data);
+  g_atomic_int_add(&pending, -1);
+  CaptureResult* result = static_cast<CaptureResult*>(
+      g_task_propagate_pointer(G_TASK(async_result), nullptr));
+  CaptureRequest* request =
+      static_cast<CaptureRequest*>(g_task_get_task_data(G_TASK(async_result)));
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (result->error_code != nullptr) {
+    response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+        result->error_code, result->error_message.c_str(), nullptr));
+  } else {
+    // {width, height, jpeg, captureUs, scaleUs, encodeUs}, plus {tileSize, tiles,
+    // atlas, hashUs} for tiled captures; jpeg and atlas only when encoded
+    g_autoptr(FlValue) map = fl_value_new_map();
+    fl_value_set_string_take(map, "width", fl_value_new_int(result->width));
+    fl_value_set_string_take(map, "height", fl_value_new_int(result->height));
+    if (result->jpeg != nullptr) {
+      fl_value_set_string_take(
+          map, "jpeg",
+          fl_value_new_uint8_list(result->jpeg, result->jpeg_size));
+    }
+    if (request->tiles) {
+      fl_value_set_string_take(map, "tileSize",
+                               fl_value_new_int(request->tile_size));
+      fl_value_set_string_take(
+          map, "tiles",
+          fl_value_new_uint8_list(result->tile_indices.data(),
+                                  result->tile_indices.size()));
+      if (result->atlas != nullptr) {
+        fl_value_set_string_take(
+            map, "atlas",
+            fl_value_new_uint8_list(result->atlas, result->atlas_size));
+      }
+      fl_value_set_string_take(map, "hashUs",
+                               fl_value_new_int(result->hash_us));
+    }
+    fl_value_set_string_take(map, "captureUs",
+                             fl_value_new_int(result->capture_us));
+    fl_value_set_string_take(map, "scaleUs",
+                             fl_value_new_int(result->scale_us));
+    fl_value_set_string_take(map, "encodeUs",
+                             fl_value_new_int(result->encode_us));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(map));
+  }
+  free_result(result);
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send screen capture response: %s", error->message);
+  }
+}
+
+static int int_arg(FlValue* args, const char* key, int fallback) {
+  FlValue* value = fl_value_lookup_string(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_INT) {
+    return fallback;
+  }
+  return static_cast<int>(fl_value_get_int(value));
+}
+
+static double double_arg(FlValue* args, const char* key, double fallback) {
+  FlValue* value = fl_value_lookup_string(args, key);
+  if (value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_FLOAT) {
+    return fl_value_get_float(value);
+  }
+  return value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_INT
+             ? static_cast<double>(fl_value_get_int(value))
+             : fallback;
+}
+
+static gboolean bool_arg(FlValue* args, const char* key) {
+  FlValue* value = fl_value_lookup_string(args, key);
+  return value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_BOOL &&
+         fl_value_get_bool(value);
+}
+
+// Expected args: null or {quality: 1-100, scale: 0.25-1,
+// source: "screen" | "synthetic", width, height}, plus {tileSize, full} for "captureTiles"
+static FlMethodResponse* start_capture(FlMethodCall* method_call,
+                                       gboolean tiles) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  CaptureRequest* request = g_new0(CaptureRequest, 1);
+  request->quality = kDefaultQuality;
+  request->scale = 1;
+  request->width = kDefaultSyntheticWidth;
+  request->height = kDefaultSyntheticHeight;
+  request->tiles = tiles;
+  request->tile_size = kDefaultTileSize;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    request->quality = CLAMP(int_arg(args, "quality", kDefaultQuality), 1, 100);
+    request->scale = double_arg(args, "scale", 1);
+    FlValue* source = fl_value_lookup_string(args, "source");
+    request->synthetic = source != nullptr &&
+                         fl_value_get_type(source) == FL_VALUE_TYPE_STRING &&
+                         strcmp(fl_value_get_string(source), "synthetic") == 0;
+    request->width = int_arg(args, "width", kDefaultSyntheticWidth);
+    request->height = int_arg(args, "height", kDefaultSyntheticHeight);
+    request->tile_size = int_arg(args, "tileSize", kDefaultTileSize);
+    request->full = bool_arg(args, "full");
+  }
+  if (!(request->scale >= kMinScale && request->scale <= 1)) {
+    g_free(request);
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENT", "Scale must be in 0.25-1", nullptr));
+  }
+  if (request->tile_size < kMinTileSize || request->tile_size > kMaxTileSize ||
+      request->tile_size % 16 != 0) {
+    g_free(request);
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENT", "Tile size must be a multiple of 16 in 32-256",
+        nullptr));
+  }
+  if (request->width <= 0 || request->width > kMaxSyntheticSize ||
+      request->height <= 0 || request->height > kMaxSyntheticSize) {
+    g_free(request);
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENT", "Synthetic frame size out of range", nullptr));
+  }
+
+  if (g_atomic_int_add(&pending, 1) >= kMaxPending) {
+    g_atomic_int_add(&pending, -1);
+    g_free(request);
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "BUSY", "Too many captures pending", nullptr));
+  }
+  // Completes on this (the main) thread's context
+  GTask* task = g_task_new(nullptr, nullptr, capture_done_cb,
+                           g_object_ref(method_call));
+  g_task_set_task_data(task, request, g_free);
+  g_task_run_in_thread(task, capture_thread_cb);
+  g_object_unref(task);
+  return nullptr;
+}
+
+static void method_call_cb(FlMethodChannel* method_channel,
+                           FlMethodCall* method_call, gpointer user_data) {
+  g_autoptr(FlMethodResponse) response = nullptr;
+  const gchar* method = fl_method_call_get_name(method_call);
+  if (strcmp(method, "capture") == 0 || strcmp(method, "captureTiles") == 0) {
+    // Answered from capture_done_cb unless refused right away
+    response = start_capture(method_call, strcmp(method, "captureTiles") == 0);
+    if (response == nullptr) {
+      return;
+    }
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send screen capture response: %s", error->message);
+  }
+}
+
+void screen_capture_register_channel(FlBinaryMessenger* messenger) {
+  if (channel != nullptr) {
+    return;
+  }
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  channel = fl_method_channel_new(messenger, SCREEN_CAPTURE_CHANNEL,
+                                  FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel, method_call_cb, nullptr,
+                                            nullptr);
+}
+
+void screen_capture_shutdown() {
+  g_mutex_lock(&capture_mutex);
+  shut_down = TRUE;
+  if (display != nullptr) {
+    release_image();
+    XCloseDisplay(display);
+    display = nullptr;
+  }
+  std::vector<uint8_t>().swap(synthetic_pixels);
+  std::vector<uint8_t>().swap(scaled_pixels);
+  std::vector<uint8_t>().swap(ycbcr_planes);
+  std::vector<uint8_t>().swap(atlas_pixels);
+  std::vector<guint64>().swap(tile_hashes);
+  g_mutex_unlock(&capture_mutex);
+}
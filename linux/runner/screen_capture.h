@@ -0,0 +1,48 @@
+#ifndef FLUTTER_SCREEN_CAPTURE_H_
+#define FLUTTER_SCREEN_CAPTURE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * screen_capture_register_channel:
+ * @messenger: the engine's binary messenger.
+ *
+ * Registers the com.a1chimney.a1tools/screen_capture method channel, which
+ * captures and JPEG-encodes frames natively so Dart only receives the
+ * compressed bytes (lib/core/services/native_screen_capture.dart).
+ *
+ * "capture" takes an optional map {quality, scale, source, width, height}
+ * and returns {width, height, jpeg, captureUs, scaleUs, encodeUs}. Frames
+ * are grabbed into a reused BGRX buffer, shrunk by scale (0.25-1, default
+ * 1) and converted to YCbCr 4:2:0 by the SIMD kernels of pixel_kernels.h,
+ * and encoded with libjpeg-turbo on a GLib worker thread; captures run one
+ * at a time.
+ *
+ * "captureTiles" takes the same plus {tileSize (default 64), full} and
+ * sends only what changed since the previous "captureTiles" call: the
+ * scaled frame is cut into tileSize squares, each hashed, and the changed
+ * ones are packed into one atlas JPEG, 16 to a row. It returns {width,
+ * height, tileSize, tiles, atlas, hashUs, captureUs, scaleUs, encodeUs},
+ * where tiles holds the row-major tile indices as little-endian uint16s in
+ * atlas order and atlas is left out when nothing changed; with full, jpeg
+ * holds the whole frame as well. The tile state is shared, so there must
+ * be a single caller (ScreenStreamServer).
+ *
+ * Sources:
+ * - "screen" (default): the X11 root window, through MIT-SHM when the
+ *   display is local and XGetImage otherwise. Under Wayland only XWayland
+ *   windows are visible this way.
+ * - "synthetic": generated desktop-like content of the requested size that
+ *   changes every frame, for benchmarks and machines without a display.
+ */
+void screen_capture_register_channel(FlBinaryMessenger* messenger);
+
+/**
+ * screen_capture_shutdown:
+ *
+ * Releases the X11 connection and shared memory. Captures still queued
+ * fail.
+ */
+void screen_capture_shutdown();
+
+#endif  // FLUTTER_SCREEN_CAPTURE_H_
@@ -0,0 +1,315 @@
+#include "stall_monitor.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#define STALL_MONITOR_CHANNEL "com.a1chimney.a1tools/stall_monitor"
+
+// Only while the window is visible; probing stops while it is hidden.
+static const gint64 kProbeIntervalMs = 100;
+// Probes waiting at least this long are stalls.
+static const gint64 kStallThresholdMs = 250;
+// While a stall goes on, how often to check for the monitor being stopped.
+static const gint64 kStalledPollMs = 1000;
+// How long to wait for the main thread to run the sampling signal handler.
+static const gint64 kSampleTimeoutMs = 100;
+// Stalls kept until Dart takes them; older ones are dropped first.
+static const size_t kMaxStalls = 32;
+static const int kMaxFrames = 48;
+// sample_signal_cb and the signal trampoline that called it.
+static const int kSignalFrames = 2;
+
+typedef struct {
+  gint64 started_ms;   // Unix time the probe was posted
+  gint64 duration_ms;  // Until the probe was dispatched
+  // Innermost first, "module+0xoffset (symbol)"
+  std::vector<std::string> frames;
+} Stall;
+
+static GMutex mutex;  // Guards everything below
+static GCond wake;
+static gboolean stopping = FALSE;
+static gboolean visible = TRUE;
+static guint64 sequence = 0;
+static guint64 dispatched_sequence = 0;
+static gint64 dispatched_at = 0;
+static std::deque<Stall> stalls;
+static guint64 dropped = 0;
+
+static GThread* monitor = nullptr;
+static pthread_t main_thread;
+static int sample_signal = 0;
+static sem_t sample_done;
+// Written by the signal handler on the main thread, read by the monitor
+// after sample_done is posted
+static void* sample_pcs[kMaxFrames];
+static int sample_count = 0;
+
+static FlMethodChannel* channel = nullptr;
+
+static gint64 now_ms() {
+  return g_get_monotonic_time() / 1000;
+}
+
+static void sample_signal_cb(int signal) {
+  int saved_errno = errno;
+  sample_count = backtrace(sample_pcs, kMaxFrames);
+  sem_post(&sample_done);
+  errno = saved_errno;
+}
+
+// Picks a real-time signal nobody else handles and installs the sampler.
+static gboolean install_sample_signal() {
+  for (int signal = SIGRTMIN + 2; signal <= SIGRTMAX; signal++) {
+    struct sigaction current;
+    if (sigaction(signal, nullptr, &current) != 0 ||
+        current.sa_handler != SIG_DFL) {
+      continue;
+    }
+    struct sigaction action = {};
+    action.sa_handler = sample_signal_cb;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(signal, &action, nullptr) == 0) {
+      sample_signal = signal;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+// Interrupts the main thread to take its backtrace. Returns the number of
+// frames in sample_pcs, or 0 if it did not answer in time.
+static int capture_stack() {
+  if (sample_signal == 0) {
+    return 0;
+  }
+  // A late answer to an earlier request
+  while (sem_trywait(&sample_done) == 0) {
+  }
+  if (pthread_kill(main_thread, sample_signal) != 0) {
+    return 0;
+  }
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_nsec += kSampleTimeoutMs * 1000000;
+  deadline.tv_sec += deadline.tv_nsec / 1000000000;
+  deadline.tv_nsec %= 1000000000;
+  while (sem_timedwait(&sample_done, &deadline) != 0) {
+    if (errno != EINTR) {
+      return 0;
+    }
+  }
+  return sample_count;
+}
+
+static std::string describe_address(void* pc) {
+  char offset[32];
+  Dl_info info;
+  if (dladdr(pc, &info) != 0 && info.dli_fname != nullptr) {
+    const char* name = strrchr(info.dli_fname, '/');
+    snprintf(offset, sizeof(offset), "+0x%zx",
+             static_cast<size_t>(static_cast<char*>(pc) -
+                                 static_cast<char*>(info.dli_fbase)));
+    std::string frame =
+        std::string(name != nullptr ? name + 1 : info.dli_fname) + offset;
+    if (info.dli_sname != nullptr) {
+      frame += " (";
+      frame += info.dli_sname;
+      frame += ")";
+    }
+    return frame;
+  }
+  snprintf(offset, sizeof(offset), "%p", pc);
+  return offset;
+}
+
+static void record(gint64 started_ms, gint64 duration_ms, int frame_count) {
+  Stall stall;
+  stall.started_ms = started_ms;
+  stall.duration_ms = duration_ms;
+  for (int i = kSignalFrames; i < frame_count; i++) {
+    stall.frames.push_back(describe_address(sample_pcs[i]));
+  }
+
+  g_mutex_lock(&mutex);
+  if (stalls.size() >= kMaxStalls) {
+    stalls.pop_front();
+    dropped++;
+  }
+  stalls.push_back(std::move(stall));
+  g_mutex_unlock(&mutex);
+}
+
+static gboolean probe_cb(gpointer user_data) {
+  gint64 now = now_ms();
+  g_mutex_lock(&mutex);
+  dispatched_sequence = GPOINTER_TO_SIZE(user_data);
+  dispatched_at = now;
+  g_cond_broadcast(&wake);
+  g_mutex_unlock(&mutex);
+  return G_SOURCE_REMOVE;
+}
+
+static void post_probe(guint64 probe) {
+  // Default priority, so it queues behind the same work as engine tasks
+  // and input
+  GSource* source = g_idle_source_new();
+  g_source_set_priority(source, G_PRIORITY_DEFAULT);
+  g_source_set_callback(source, probe_cb, GSIZE_TO_POINTER(probe), nullptr);
+  g_source_set_name(source, "stall_monitor_probe");
+  g_source_attach(source, nullptr);
+  g_source_unref(source);
+}
+
+static gpointer monitor_loop(gpointer user_data) {
+  g_mutex_lock(&mutex);
+  while (!stopping) {
+    if (!visible) {
+      g_cond_wait(&wake, &mutex);
+      continue;
+    }
+    guint64 probe = ++sequence;
+    gint64 posted_at = now_ms();
+    gint64 started_ms = g_get_real_time() / 1000;
+    g_mutex_unlock(&mutex);
+    post_probe(probe);
+    g_mutex_lock(&mutex);
+
+    // Wait for the probe, sampling the stack once it is late
+    int frame_count = 0;
+    gboolean sampled = FALSE;
+    while (!stopping && dispatched_sequence != probe) {
+      gint64 waited = now_ms() - posted_at;
+      if (!sampled && waited >= kStallThresholdMs) {
+        sampled = TRUE;
+        g_mutex_unlock(&mutex);
+        frame_count = capture_stack();
+        g_mutex_lock(&mutex);
+        continue;
+      }
+      gint64 timeout_ms = sampled ? kStalledPollMs : kStallThresholdMs - waited;
+      g_cond_wait_until(&wake, &mutex,
+                        g_get_monotonic_time() + timeout_ms * 1000);
+    }
+    if (stopping) {
+      break;
+    }
+
+    gint64 duration_ms = dispatched_at - posted_at;
+    if (duration_ms >= kStallThresholdMs) {
+      g_mutex_unlock(&mutex);
+      record(started_ms, duration_ms, frame_count);
+      g_mutex_lock(&mutex);
+    }
+    gint64 next_probe = g_get_monotonic_time() + kProbeIntervalMs * 1000;
+    while (!stopping && g_cond_wait_until(&wake, &mutex, next_probe)) {
+    }
+  }
+  g_mutex_unlock(&mutex);
+  return nullptr;
+}
+
+void stall_monitor_start() {
+  if (monitor != nullptr) {
+    return;
+  }
+  main_thread = pthread_self();
+  sem_init(&sample_done, 0, 0);
+  if (install_sample_signal()) {
+    // backtrace() loads libgcc on first use, which is not safe in the
+    // signal handler
+    void* warm_up[1];
+    backtrace(warm_up, 1);
+  } else {
+    g_warning("No free signal for stall stack samples");
+  }
+  stopping = FALSE;
+  monitor = g_thread_new("stall_monitor", monitor_loop, nullptr);
+}
+
+void stall_monitor_stop() {
+  if (monitor == nullptr) {
+    return;
+  }
+  g_mutex_lock(&mutex);
+  stopping = TRUE;
+  g_cond_broadcast(&wake);
+  g_mutex_unlock(&mutex);
+  g_thread_join(monitor);
+  monitor = nullptr;
+}
+
+void stall_monitor_set_visible(gboolean is_visible) {
+  g_mutex_lock(&mutex);
+  visible = is_visible;
+  g_cond_broadcast(&wake);
+  g_mutex_unlock(&mutex);
+}
+
+// {dropped: n, stalls: [{startedMs, durationMs, frames}]}
+static FlMethodResponse* take_stalls() {
+  g_mutex_lock(&mutex);
+  std::deque<Stall> taken;
+  taken.swap(stalls);
+  guint64 taken_dropped = dropped;
+  dropped = 0;
+  g_mutex_unlock(&mutex);
+
+  g_autoptr(FlValue) list = fl_value_new_list();
+  for (const Stall& stall : taken) {
+    FlValue* frames = fl_value_new_list();
+    for (const std::string& frame : stall.frames) {
+      fl_value_append_take(frames, fl_value_new_string(frame.c_str()));
+    }
+    FlValue* map = fl_value_new_map();
+    fl_value_set_string_take(map, "startedMs",
+                             fl_value_new_int(stall.started_ms));
+    fl_value_set_string_take(map, "durationMs",
+                             fl_value_new_int(stall.duration_ms));
+    fl_value_set_string_take(map, "frames", frames);
+    fl_value_append_take(list, map);
+  }
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "dropped",
+                           fl_value_new_int(static_cast<int64_t>(taken_dropped)));
+  fl_value_set_string(result, "stalls", list);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static void method_call_cb(FlMethodChannel* method_channel,
+                           FlMethodCall* method_call, gpointer user_data) {
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(fl_method_call_get_name(method_call), "takeStalls") == 0) {
+    response = take_stalls();
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send stall monitor response: %s", error->message);
+  }
+}
+
+void stall_monitor_register_channel(FlBinaryMessenger* messenger) {
+  if (channel != nullptr) {
+    return;
+  }
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  channel = fl_method_channel_new(messenger, STALL_MONITOR_CHANNEL,
+                                  FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel, method_call_cb, nullptr,
+                                            nullptr);
+}
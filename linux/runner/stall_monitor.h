@@ -0,0 +1,48 @@
+#ifndef FLUTTER_STALL_MONITOR_H_
+#define FLUTTER_STALL_MONITOR_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * stall_monitor_start:
+ *
+ * Starts a watchdog for the GTK main loop, which must run on the calling
+ * thread. A monitor thread adds an idle probe to the default main context
+ * every 100 ms while the window is visible (none while it is hidden,
+ * iconified or fully obscured, so an idle app stays idle) and measures how
+ * long the loop takes to dispatch it. When a
+ * probe is still waiting after 250 ms, the main thread's stack is captured
+ * with backtrace() from a signal handler; once the probe finally runs the
+ * stall (duration and stack) goes into a ring buffer that Dart drains and
+ * uploads (lib/core/services/crash_reporting_service.dart).
+ *
+ * Times are CLOCK_MONOTONIC, so a suspended laptop is not a stall.
+ */
+void stall_monitor_start();
+
+/**
+ * stall_monitor_stop:
+ *
+ * Stops and joins the monitor thread.
+ */
+void stall_monitor_stop();
+
+/**
+ * stall_monitor_set_visible:
+ * @visible: whether the user can see the window.
+ *
+ * Pauses probing while the window is not visible and resumes it once it is
+ * again.
+ */
+void stall_monitor_set_visible(gboolean visible);
+
+/**
+ * stall_monitor_register_channel:
+ * @messenger: the engine's binary messenger.
+ *
+ * Registers the com.a1chimney.a1tools/stall_monitor method channel; its
+ * "takeStalls" call returns and clears the recorded stalls.
+ */
+void stall_monitor_register_channel(FlBinaryMessenger* messenger);
+
+#endif  // FLUTTER_STALL_MONITOR_H_
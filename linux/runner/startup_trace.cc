@@ -0,0 +1,256 @@
+#include "startup_trace.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+
+#define STARTUP_TRACE_CHANNEL "com.a1chimney.a1tools/startup_trace"
+
+static const size_t kMaxEvents = 128;
+static const size_t kMaxNameLength = 47;
+
+typedef struct {
+  char name[kMaxNameLength + 1];
+  char phase;
+  pid_t tid;
+  int64_t ts_us;
+  std::atomic<bool> ready;  // Set once the other fields are written
+} StartupTraceEvent;
+
+static StartupTraceEvent events[kMaxEvents];
+static std::atomic<size_t> event_count(0);
+
+static pthread_once_t origin_once = PTHREAD_ONCE_INIT;
+static int64_t process_start_us = 0;  // CLOCK_BOOTTIME at process start
+
+static FlMethodChannel* channel = nullptr;
+
+static int64_t boottime_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Process start time from /proc/self/stat (field 22, clock ticks since
+// boot, so only 10 ms resolution). Falls back to the first event.
+static void init_origin() {
+  process_start_us = boottime_us();
+
+  char stat[1024];
+  int fd = open("/proc/self/stat", O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  ssize_t n = read(fd, stat, sizeof(stat) - 1);
+  close(fd);
+  if (n <= 0) {
+    return;
+  }
+  stat[n] = '\0';
+
+  // The command name may contain spaces; fields are counted after it.
+  const char* field = strrchr(stat, ')');
+  if (field == nullptr) {
+    return;
+  }
+  for (int i = 0; i < 20 && field != nullptr; i++) {
+    field = strchr(field + 1, ' ');
+  }
+  long ticks_per_second = sysconf(_SC_CLK_TCK);
+  if (field == nullptr || ticks_per_second <= 0) {
+    return;
+  }
+  long long start_ticks = strtoll(field + 1, nullptr, 10);
+  int64_t start_us = start_ticks * 1000000 / ticks_per_second;
+  if (start_us > 0 && start_us <= process_start_us) {
+    process_start_us = start_us;
+  }
+}
+
+void startup_trace_record(const char* name, char phase) {
+  pthread_once(&origin_once, init_origin);
+  int64_t ts = boottime_us() - process_start_us;
+
+  size_t index = event_count.fetch_add(1, std::memory_order_relaxed);
+  if (index >= kMaxEvents) {
+    return;
+  }
+  StartupTraceEvent* event = &events[index];
+  g_strlcpy(event->name, name, sizeof(event->name));
+  event->phase = phase;
+  event->tid = static_cast<pid_t>(syscall(SYS_gettid));
+  event->ts_us = ts;
+  event->ready.store(true, std::memory_order_release);
+}
+
+static size_t recorded_events() {
+  size_t count = event_count.load(std::memory_order_acquire);
+  return count < kMaxEvents ? count : kMaxEvents;
+}
+
+static const StartupTraceEvent* event_at(size_t index) {
+  if (!events[index].ready.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  return &events[index];
+}
+
+static void append_json_string(std::string* out, const char* text) {
+  out->push_back('"');
+  for (const char* c = text; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      out->push_back('\\');
+      out->push_back(*c);
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      out->push_back(' ');
+    } else {
+      out->push_back(*c);
+    }
+  }
+  out->push_back('"');
+}
+
+gboolean startup_trace_dump(const char* path) {
+  std::string json = "{\"traceEvents\":[";
+  char buffer[96];
+  bool first = true;
+  for (size_t i = 0; i < recorded_events(); i++) {
+    const StartupTraceEvent* event = event_at(i);
+    if (event == nullptr) {
+      continue;
+    }
+    json += first ? "\n" : ",\n";
+    first = false;
+    json += "{\"name\":";
+    append_json_string(&json, event->name);
+    snprintf(buffer, sizeof(buffer),
+             ",\"cat\":\"startup\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":%d,"
+             "\"tid\":%d",
+             event->phase, static_cast<long long>(event->ts_us),
+             static_cast<int>(getpid()), static_cast<int>(event->tid));
+    json += buffer;
+    // Instant events are process-wide markers
+    json += event->phase == 'i' ? ",\"s\":\"p\"}" : "}";
+  }
+  json += "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"platform\":\"linux\"}}\n";
+
+  g_autoptr(GError) error = nullptr;
+  if (!g_file_set_contents(path, json.data(), json.size(), &error)) {
+    g_warning("Failed to write startup trace: %s", error->message);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+gboolean startup_trace_dump_requested(gboolean* exit_after) {
+  const gchar* path = g_getenv(STARTUP_TRACE_ENV_VAR);
+  if (exit_after != nullptr) {
+    *exit_after = g_strcmp0(g_getenv(STARTUP_TRACE_EXIT_ENV_VAR), "1") == 0;
+  }
+  if (path == nullptr || path[0] == '\0') {
+    return FALSE;
+  }
+  return startup_trace_dump(path);
+}
+
+static FlMethodResponse* get_events() {
+  g_autoptr(FlValue) list = fl_value_new_list();
+  for (size_t i = 0; i < recorded_events(); i++) {
+    const StartupTraceEvent* event = event_at(i);
+    if (event == nullptr) {
+      continue;
+    }
+    char phase[2] = {event->phase, '\0'};
+    FlValue* map = fl_value_new_map();
+    fl_value_set_string_take(map, "name", fl_value_new_string(event->name));
+    fl_value_set_string_take(map, "ph", fl_value_new_string(phase));
+    fl_value_set_string_take(map, "ts_us", fl_value_new_int(event->ts_us));
+    fl_value_set_string_take(map, "tid", fl_value_new_int(event->tid));
+    fl_value_append_take(list, map);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(list));
+}
+
+// Expected args: {"name": "dart_main", "ph": "B" | "E" | "i"}
+static FlMethodResponse* record(FlValue* args) {
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    FlValue* name = fl_value_lookup_string(args, "name");
+    FlValue* phase = fl_value_lookup_string(args, "ph");
+    if (name != nullptr && phase != nullptr &&
+        fl_value_get_type(name) == FL_VALUE_TYPE_STRING &&
+        fl_value_get_type(phase) == FL_VALUE_TYPE_STRING) {
+      const gchar* p = fl_value_get_string(phase);
+      if (strlen(p) == 1 && strchr("BEi", p[0]) != nullptr) {
+        startup_trace_record(fl_value_get_string(name), p[0]);
+        return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+      }
+    }
+  }
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      "INVALID_ARGUMENT", "Expected {name: string, ph: 'B' | 'E' | 'i'}",
+      nullptr));
+}
+
+// Optional argument: target path, defaults to the requested path or the
+// temp directory
+static FlMethodResponse* dump(FlValue* args) {
+  g_autofree gchar* path = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_STRING &&
+      fl_value_get_string(args)[0] != '\0') {
+    path = g_strdup(fl_value_get_string(args));
+  } else if (g_getenv(STARTUP_TRACE_ENV_VAR) != nullptr &&
+             g_getenv(STARTUP_TRACE_ENV_VAR)[0] != '\0') {
+    path = g_strdup(g_getenv(STARTUP_TRACE_ENV_VAR));
+  } else {
+    path = g_build_filename(g_get_tmp_dir(), "a1_tools_startup_trace.json",
+                            nullptr);
+  }
+
+  if (!startup_trace_dump(path)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "WRITE_FAILED", "Could not write the startup trace", nullptr));
+  }
+  g_autoptr(FlValue) result = fl_value_new_string(path);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static void method_call_cb(FlMethodChannel* method_channel, FlMethodCall* method_call,
+                           gpointer user_data) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "getEvents") == 0) {
+    response = get_events();
+  } else if (strcmp(method, "record") == 0) {
+    response = record(args);
+  } else if (strcmp(method, "dump") == 0) {
+    response = dump(args);
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send startup trace response: %s", error->message);
+  }
+}
+
+void startup_trace_register_channel(FlBinaryMessenger* messenger) {
+  if (channel != nullptr) {
+    return;
+  }
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  channel = fl_method_channel_new(messenger, STARTUP_TRACE_CHANNEL,
+                                  FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel, method_call_cb, nullptr,
+                                            nullptr);
+}
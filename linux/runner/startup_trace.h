@@ -0,0 +1,69 @@
+#ifndef FLUTTER_STARTUP_TRACE_H_
+#define FLUTTER_STARTUP_TRACE_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <glib.h>
+
+// Environment variable naming a file the trace is written to (Chrome trace
+// JSON) once the first frame is shown. Setting STARTUP_TRACE_EXIT_ENV_VAR
+// to 1 additionally quits the app right after, which is how
+// scripts/startup_benchmark.py drives repeated launches.
+#define STARTUP_TRACE_ENV_VAR "A1_TOOLS_STARTUP_TRACE"
+#define STARTUP_TRACE_EXIT_ENV_VAR "A1_TOOLS_STARTUP_TRACE_EXIT"
+
+/**
+ * startup_trace_record:
+ * @name: phase name, truncated to 47 bytes.
+ * @phase: 'B' (begin), 'E' (end) or 'i' (instant), as in Chrome traces.
+ *
+ * Records a cold-start phase into a fixed buffer with a CLOCK_MONOTONIC
+ * timestamp. Never allocates; events past the buffer are dropped.
+ * Timestamps are microseconds since the process started, so time before
+ * main() is included. Safe to call from any thread.
+ */
+void startup_trace_record(const char* name, char phase);
+
+static inline void startup_trace_begin(const char* name) {
+  startup_trace_record(name, 'B');
+}
+
+static inline void startup_trace_end(const char* name) {
+  startup_trace_record(name, 'E');
+}
+
+static inline void startup_trace_instant(const char* name) {
+  startup_trace_record(name, 'i');
+}
+
+/**
+ * startup_trace_dump:
+ * @path: file to write.
+ *
+ * Writes the trace in Chrome trace event format (chrome://tracing,
+ * ui.perfetto.dev).
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean startup_trace_dump(const char* path);
+
+/**
+ * startup_trace_dump_requested:
+ * @exit_after: (out) (optional): whether the app should quit after the dump.
+ *
+ * Writes the trace to the file named by %STARTUP_TRACE_ENV_VAR, if set.
+ *
+ * Returns: %TRUE if a dump was requested and written.
+ */
+gboolean startup_trace_dump_requested(gboolean* exit_after);
+
+/**
+ * startup_trace_register_channel:
+ * @messenger: the engine's binary messenger.
+ *
+ * Registers the com.a1chimney.a1tools/startup_trace method channel the Dart
+ * side (lib/core/services/startup_trace_service.dart) uses to read the
+ * events and add its own phases.
+ */
+void startup_trace_register_channel(FlBinaryMessenger* messenger);
+
+#endif  // FLUTTER_STARTUP_TRACE_H_
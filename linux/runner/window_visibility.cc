@@ -0,0 +1,105 @@
+#include "window_visibility.h"
+
+#include <string.h>
+
+#include "app_heartbeat.h"
+#include "stall_monitor.h"
+
+// Framework lifecycle channel (SystemChannels.lifecycle), string codec.
+static const char kLifecycleChannel[] = "flutter/lifecycle";
+
+typedef struct {
+  FlBinaryMessenger* messenger;
+  gboolean mapped;
+  gboolean iconified;
+  gboolean obscured;
+  gboolean reported_visible;
+} WindowVisibility;
+
+static void window_visibility_free(gpointer data) {
+  WindowVisibility* visibility = static_cast<WindowVisibility*>(data);
+  g_object_unref(visibility->messenger);
+  g_free(visibility);
+}
+
+static void update(GtkWindow* window, WindowVisibility* visibility) {
+  gboolean visible =
+      visibility->mapped && !visibility->iconified && !visibility->obscured;
+  if (visible == visibility->reported_visible) {
+    return;
+  }
+  visibility->reported_visible = visible;
+  stall_monitor_set_visible(visible);
+  app_heartbeat_set_visible(visible);
+
+  const char* state = !visible ? "AppLifecycleState.hidden"
+                      : gtk_window_is_active(window)
+                          ? "AppLifecycleState.resumed"
+                          : "AppLifecycleState.inactive";
+  g_autoptr(GBytes) message = g_bytes_new(state, strlen(state));
+  fl_binary_messenger_send_on_channel(visibility->messenger, kLifecycleChannel,
+                                      message, nullptr, nullptr, nullptr);
+}
+
+static gboolean map_event_cb(GtkWidget* widget, GdkEvent* event,
+                             gpointer user_data) {
+  WindowVisibility* visibility = static_cast<WindowVisibility*>(user_data);
+  visibility->mapped = TRUE;
+  update(GTK_WINDOW(widget), visibility);
+  return FALSE;
+}
+
+static gboolean unmap_event_cb(GtkWidget* widget, GdkEvent* event,
+                               gpointer user_data) {
+  WindowVisibility* visibility = static_cast<WindowVisibility*>(user_data);
+  visibility->mapped = FALSE;
+  // No VisibilityNotify arrives for an unmapped window
+  visibility->obscured = FALSE;
+  update(GTK_WINDOW(widget), visibility);
+  return FALSE;
+}
+
+static gboolean window_state_event_cb(GtkWidget* widget,
+                                      GdkEventWindowState* event,
+                                      gpointer user_data) {
+  WindowVisibility* visibility = static_cast<WindowVisibility*>(user_data);
+  visibility->iconified =
+      (event->new_window_state &
+       (GDK_WINDOW_STATE_ICONIFIED | GDK_WINDOW_STATE_WITHDRAWN)) != 0;
+  update(GTK_WINDOW(widget), visibility);
+  return FALSE;
+}
+
+static gboolean visibility_notify_event_cb(GtkWidget* widget,
+                                           GdkEventVisibility* event,
+                                           gpointer user_data) {
+  WindowVisibility* visibility = static_cast<WindowVisibility*>(user_data);
+  visibility->obscured = event->state == GDK_VISIBILITY_FULLY_OBSCURED;
+  update(GTK_WINDOW(widget), visibility);
+  return FALSE;
+}
+
+void window_visibility_track(GtkWindow* window, FlBinaryMessenger* messenger) {
+  if (g_object_get_data(G_OBJECT(window), "window-visibility") != nullptr) {
+    return;
+  }
+  WindowVisibility* visibility = g_new0(WindowVisibility, 1);
+  visibility->messenger = FL_BINARY_MESSENGER(g_object_ref(messenger));
+  visibility->mapped = gtk_widget_get_mapped(GTK_WIDGET(window));
+  // The framework starts out treating the app as visible
+  visibility->reported_visible = TRUE;
+  g_object_set_data_full(G_OBJECT(window), "window-visibility", visibility,
+                         window_visibility_free);
+
+  gtk_widget_add_events(GTK_WIDGET(window), GDK_VISIBILITY_NOTIFY_MASK |
+                                                GDK_STRUCTURE_MASK);
+  g_signal_connect(window, "map-event", G_CALLBACK(map_event_cb), visibility);
+  g_signal_connect(window, "unmap-event", G_CALLBACK(unmap_event_cb),
+                   visibility);
+  g_signal_connect(window, "window-state-event",
+                   G_CALLBACK(window_state_event_cb), visibility);
+  g_signal_connect(window, "visibility-notify-event",
+                   G_CALLBACK(visibility_notify_event_cb), visibility);
+
+  update(window, visibility);
+}
@@ -0,0 +1,23 @@
+#ifndef FLUTTER_WINDOW_VISIBILITY_H_
+#define FLUTTER_WINDOW_VISIBILITY_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+/**
+ * window_visibility_track:
+ * @window: the toplevel hosting the Flutter view.
+ * @messenger: the engine's binary messenger.
+ *
+ * Reports @window to the framework as AppLifecycleState.hidden while it is
+ * unmapped, iconified or fully obscured, and as resumed (focused) or
+ * inactive once it can be seen again. Hidden stops the framework from
+ * scheduling frames. FlView already reports iconify and focus; this adds
+ * occlusion (X11 VisibilityNotify, which compositing window managers may
+ * not send) and a window that was never mapped, as after a background
+ * launch. Call once the first frame is in; the current state is reported
+ * right away.
+ */
+void window_visibility_track(GtkWindow* window, FlBinaryMessenger* messenger);
+
+#endif  // FLUTTER_WINDOW_VISIBILITY_H_
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""Decodes the Windows runner's binary log into text.
+
+The runner, its plugins and Dart (lib/core/services/native_log.dart) write
+binary records into segment files under %LOCALAPPDATA%\\A1 Tools\\logs
+(runner.a1log is the current one, runner.1.a1log to runner.3.a1log older
+ones); the format is described in windows/runner/native_log.h. Each segment
+carries the strings its records refer to, so any subset decodes on its own.
+
+Usage:
+  scripts/decode_native_log.py "%LOCALAPPDATA%\\A1 Tools\\logs"
+  scripts/decode_native_log.py runner.1.a1log runner.a1log --level warning
+  scripts/decode_native_log.py logs --subsystem privacy --json
+
+Entries from all given files are merged and printed oldest first, one per
+line:
+
+  2026-10-16 09:12:03.481220 INFO    [privacy] 5312 Injected into PID 4120
+"""
+
+import argparse
+import datetime
+import glob
+import json
+import os
+import struct
+import sys
+
+SEGMENT_HEADER = struct.Struct('<IHHIIQQQ24x')
+RECORD_HEADER = struct.Struct('<HBBIQII')
+MAGIC = 0x474C3141
+VERSION = 1
+
+KIND_ENTRY = 1
+KIND_STRING = 2
+
+ARG_INT = 1
+ARG_UINT = 2
+ARG_DOUBLE = 3
+ARG_TEXT = 4
+
+LEVELS = ['TRACE', 'DEBUG', 'INFO', 'WARNING', 'ERROR']
+
+
+def decode_args(payload):
+    """Returns the tagged argument values of an entry; a cut-off tail is
+    ignored."""
+    args = []
+    offset = 0
+    while offset < len(payload):
+        tag = payload[offset]
+        offset += 1
+        if tag in (ARG_INT, ARG_UINT, ARG_DOUBLE):
+            if offset + 8 > len(payload):
+                break
+            code = {ARG_INT: '<q', ARG_UINT: '<Q', ARG_DOUBLE: '<d'}[tag]
+            args.append(struct.unpack_from(code, payload, offset)[0])
+            offset += 8
+        elif tag == ARG_TEXT:
+            if offset + 2 > len(payload):
+                break
+            (length,) = struct.unpack_from('<H', payload, offset)
+            offset += 2
+            args.append(payload[offset:offset + length].decode(
+                'utf-8', errors='replace'))
+            offset += length
+        else:
+            break
+    return args
+
+
+def format_message(text, args):
+    """Substitutes each "{}" in |text| with the next argument; extra
+    arguments are appended."""
+    parts = text.split('{}')
+    out = [parts[0]]
+    for i, part in enumerate(parts[1:]):
+        out.append(str(args[i]) if i < len(args) else '{}')
+        out.append(part)
+    extra = args[len(parts) - 1:]
+    if extra:
+        out.append(' ' + ' '.join(str(arg) for arg in extra))
+    return ''.join(out)
+
+
+def read_segment(path):
+    """Yields the entries of one segment as dicts."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) < SEGMENT_HEADER.size:
+        print(f'{path}: too short', file=sys.stderr)
+        return
+    (magic, version, header_size, pid, _, _, _,
+     write_offset) = SEGMENT_HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        print(f'{path}: not a version {VERSION} log segment', file=sys.stderr)
+        return
+    end = min(write_offset, len(data))
+
+    # Strings first: an entry may precede the definition of a string
+    # interned concurrently
+    strings = {}
+    records = []
+    offset = header_size
+    while offset + RECORD_HEADER.size <= end:
+        (size, kind, level, thread_id, timestamp_us, format_id,
+         subsystem_id) = RECORD_HEADER.unpack_from(data, offset)
+        if size < RECORD_HEADER.size or offset + size > end:
+            print(f'{path}: corrupt record at {offset}', file=sys.stderr)
+            break
+        payload = data[offset + RECORD_HEADER.size:offset + size]
+        if kind == KIND_STRING:
+            strings[format_id] = payload.decode('utf-8', errors='replace')
+        elif kind == KIND_ENTRY:
+            records.append((level, thread_id, timestamp_us, format_id,
+                            subsystem_id, payload))
+        offset += (size + 7) & ~7
+
+    for (level, thread_id, timestamp_us, format_id, subsystem_id,
+         payload) in records:
+        args = decode_args(payload)
+        text = strings.get(format_id, f'<format {format_id}>')
+        yield {
+            'timestamp_us': timestamp_us,
+            'level': LEVELS[level] if level < len(LEVELS) else str(level),
+            'subsystem': strings.get(subsystem_id, f'<{subsystem_id}>'),
+            'pid': pid,
+            'thread_id': thread_id,
+            'message': format_message(text, args),
+        }
+
+
+def segment_paths(paths):
+    result = []
+    for path in paths:
+        if os.path.isdir(path):
+            result.extend(glob.glob(os.path.join(path, 'runner*.a1log')))
+        else:
+            result.append(path)
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('paths', nargs='+',
+                        help='segment files or directories holding them')
+    parser.add_argument('--level', choices=[l.lower() for l in LEVELS],
+                        default='trace', help='lowest level to print')
+    parser.add_argument('--subsystem', action='append',
+                        help='only print these subsystems (repeatable)')
+    parser.add_argument('--json', action='store_true',
+                        help='print one JSON object per line')
+    args = parser.parse_args()
+
+    min_level = LEVELS.index(args.level.upper())
+    entries = []
+    for path in segment_paths(args.paths):
+        entries.extend(read_segment(path))
+    entries.sort(key=lambda entry: entry['timestamp_us'])
+
+    for entry in entries:
+        level = entry['level']
+        if level in LEVELS and LEVELS.index(level) < min_level:
+            continue
+        if args.subsystem and entry['subsystem'] not in args.subsystem:
+            continue
+        if args.json:
+            print(json.dumps(entry, ensure_ascii=False))
+            continue
+        time = datetime.datetime.fromtimestamp(
+            entry['timestamp_us'] / 1e6).strftime('%Y-%m-%d %H:%M:%S.%f')
+        print(f"{time} {level:<7} [{entry['subsystem']}] "
+              f"{entry['thread_id']} {entry['message']}")
+
+
+if __name__ == '__main__':
+    main()
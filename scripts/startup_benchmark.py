@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""Cold/warm start benchmark for the Linux build.
+
+Launches the bundled company_hub repeatedly with the runner's startup tracer
+enabled (A1_TOOLS_STARTUP_TRACE, see linux/runner/startup_trace.h). Each run
+writes a Chrome trace at the first frame and quits, and the script reports
+per-phase timings across runs.
+
+  cold  The bundle's files are evicted from the page cache before each run
+        (posix_fadvise DONTNEED; with --drop-caches and root, the whole page
+        cache is dropped instead).
+  warm  The app is launched once untimed first, then timed with a hot cache.
+
+Usage:
+  flutter build linux --release
+  scripts/startup_benchmark.py --runs 10 --mode both --json startup-1.2.3.json
+  scripts/startup_benchmark.py --runs 10 --baseline startup-1.2.2.json
+
+The runner prefetches libapp.so, icudtl.dat and flutter_assets on a
+background thread at launch (linux/runner/prefetch.h; the "prefetch" phases).
+To measure what that saves, compare cold starts with and without it:
+
+  sudo scripts/startup_benchmark.py --mode cold --drop-caches --no-prefetch \
+      --json no-prefetch.json
+  sudo scripts/startup_benchmark.py --mode cold --drop-caches \
+      --baseline no-prefetch.json
+
+Needs a display (DISPLAY or WAYLAND_DISPLAY; xvfb-run works). Keep the app
+closed while benchmarking.
+"""
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+DEFAULT_BUNDLE = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..',
+                              'build', 'linux', 'x64', 'release', 'bundle')
+APP_NAME = 'company_hub'
+RUN_TIMEOUT_SECONDS = 120
+# Phases every report leads with; anything else the trace contains follows.
+KEY_PHASES = ['main', 'prefetch', 'my_application_activate', 'fl_view_new',
+              'fl_register_plugins', 'channel_setup', 'first_frame']
+
+
+def evict_from_page_cache(bundle):
+    """Drop the bundle's pages from the page cache without needing root."""
+    for root, _, files in os.walk(bundle):
+        for name in files:
+            path = os.path.join(root, name)
+            try:
+                fd = os.open(path, os.O_RDONLY)
+            except OSError:
+                continue
+            try:
+                os.fsync(fd)
+                os.posix_fadvise(fd, 0, 0, os.POSIX_FADV_DONTNEED)
+            except OSError:
+                pass
+            finally:
+                os.close(fd)
+
+
+def drop_all_caches():
+    subprocess.run(['sync'], check=True)
+    with open('/proc/sys/vm/drop_caches', 'w') as f:
+        f.write('3\n')
+
+
+def run_once(app, trace_path, extra_env=None):
+    """Launch the app once; returns the parsed trace events."""
+    env = dict(os.environ)
+    env.update(extra_env or {})
+    env['A1_TOOLS_STARTUP_TRACE'] = trace_path
+    env['A1_TOOLS_STARTUP_TRACE_EXIT'] = '1'
+    if os.path.exists(trace_path):
+        os.remove(trace_path)
+
+    process = subprocess.Popen([app], env=env, stdout=subprocess.DEVNULL,
+                               stderr=subprocess.DEVNULL)
+    try:
+        process.wait(timeout=RUN_TIMEOUT_SECONDS)
+    except subprocess.TimeoutExpired:
+        process.kill()
+        process.wait()
+        raise RuntimeError('app did not reach its first frame within %d s'
+                           % RUN_TIMEOUT_SECONDS)
+
+    if not os.path.exists(trace_path):
+        raise RuntimeError('app exited with %d without writing a trace'
+                           % process.returncode)
+    with open(trace_path) as f:
+        return json.load(f)['traceEvents']
+
+
+def phase_timings(events):
+    """Milliseconds per phase: duration for begin/end pairs, time since
+    process start for instants."""
+    timings = {}
+    open_phases = {}
+    for event in events:
+        name, phase, ts = event['name'], event['ph'], event['ts']
+        if phase == 'B':
+            open_phases.setdefault((name, event['tid']), []).append(ts)
+        elif phase == 'E':
+            starts = open_phases.get((name, event['tid']))
+            if starts:
+                timings.setdefault(name, (ts - starts.pop()) / 1000.0)
+        elif phase == 'i':
+            timings.setdefault(name, ts / 1000.0)
+    return timings
+
+
+def summarize(runs):
+    names = [n for n in KEY_PHASES if any(n in r for r in runs)]
+    names += sorted({n for r in runs for n in r} - set(names))
+    summary = {}
+    for name in names:
+        values = sorted(r[name] for r in runs if name in r)
+        summary[name] = {
+            'runs': len(values),
+            'min_ms': values[0],
+            'median_ms': statistics.median(values),
+            'p90_ms': values[min(len(values) - 1, int(round(0.9 * (len(values) - 1))))],
+            'max_ms': values[-1],
+        }
+    return summary
+
+
+def benchmark(app, bundle, mode, runs, drop_caches, trace_dir, extra_env=None):
+    if mode == 'warm':
+        run_once(app, os.path.join(trace_dir, 'warmup.json'), extra_env)
+
+    results = []
+    for i in range(runs):
+        if mode == 'cold':
+            if drop_caches:
+                drop_all_caches()
+            else:
+                evict_from_page_cache(bundle)
+        trace_path = os.path.join(trace_dir, '%s-%d.json' % (mode, i))
+        results.append(phase_timings(run_once(app, trace_path, extra_env)))
+        print('  %s run %d/%d: first frame at %.1f ms' % (
+            mode, i + 1, runs, results[-1].get('first_frame', float('nan'))),
+            file=sys.stderr)
+        # Let the previous instance finish tearing down
+        time.sleep(0.5)
+    return summarize(results)
+
+
+def print_summary(mode, summary, baseline=None):
+    print('\n%s start' % mode)
+    print('  %-32s %9s %9s %9s %9s' % ('phase', 'min', 'median', 'p90', 'max'))
+    for name, s in summary.items():
+        line = '  %-32s %9.1f %9.1f %9.1f %9.1f' % (
+            name, s['min_ms'], s['median_ms'], s['p90_ms'], s['max_ms'])
+        if baseline and name in baseline:
+            before = baseline[name]['median_ms']
+            if before > 0:
+                line += '  %+6.1f%%' % ((s['median_ms'] - before) * 100.0 / before)
+        print(line)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--bundle', default=DEFAULT_BUNDLE,
+                        help='release bundle directory (default: %(default)s)')
+    parser.add_argument('--runs', type=int, default=10)
+    parser.add_argument('--mode', choices=['cold', 'warm', 'both'], default='both')
+    parser.add_argument('--drop-caches', action='store_true',
+                        help='drop the whole page cache before cold runs (root)')
+    parser.add_argument('--json', help='write the summary to this file')
+    parser.add_argument('--baseline', help='summary of an earlier release to compare to')
+    parser.add_argument('--keep-traces', help='keep the per-run traces in this directory')
+    parser.add_argument('--no-prefetch', action='store_true',
+                        help="disable the runner's startup prefetch (A1_TOOLS_PREFETCH=0)")
+    args = parser.parse_args()
+
+    bundle = os.path.abspath(args.bundle)
+    app = os.path.join(bundle, APP_NAME)
+    if not os.access(app, os.X_OK):
+        parser.error('%s not found; build with flutter build linux --release' % app)
+    if args.drop_caches and os.geteuid() != 0:
+        parser.error('--drop-caches needs root')
+
+    baseline = None
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    modes = ['cold', 'warm'] if args.mode == 'both' else [args.mode]
+    extra_env = {'A1_TOOLS_PREFETCH': '0'} if args.no_prefetch else None
+    report = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        trace_dir = args.keep_traces or tmp
+        os.makedirs(trace_dir, exist_ok=True)
+        for mode in modes:
+            report[mode] = benchmark(app, bundle, mode, args.runs,
+                                     args.drop_caches, trace_dir, extra_env)
+
+    for mode in modes:
+        print_summary(mode, report[mode], (baseline or {}).get(mode))
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(report, f, indent=2)
+            f.write('\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,158 @@
+// A1 Tools Service Helper - Linux build for the company_hub runner
+// Supervises the company_hub binary the same way the Windows helper
+// supervises a1_tools.exe; the check/recover logic is shared through
+// supervisor.cpp. Meant to run as a user service (systemd --user unit or
+// desktop autostart entry), stops cleanly on SIGTERM/SIGINT.
+//
+// Usage: a1_service_helper [--app <path to company_hub>] [--check-once]
+//                          [--max-private-mb <n>] [--max-working-set-mb <n>]
+//                          [--max-handles <n>] [--max-threads <n>]
+//                          [--max-growth-mb-per-hour <n>]
+// Without --app the company_hub binary next to the helper is supervised.
+// A budget of 0 disables that limit.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iterator>
+#include <string>
+
+#include "service_log.h"
+#include "supervisor.h"
+
+// Configuration
+const char* APP_EXE_NAME = "company_hub";
+const char* APPLICATION_ID = "com.example.company_hub";  // linux/CMakeLists.txt
+const char* SERVICE_HELPER_LOCK_FILE = ".service_helper.lock";
+const char* LOG_FILE_NAME = "service_helper.log";
+const size_t MAX_LOG_SIZE = 1024 * 1024;  // 1MB
+const bool COMPRESS_ROTATED_LOGS = true;  // gzip service_helper.log.old when built with zlib
+
+// Default leak budgets for one app instance. The fd budget stays below the
+// usual soft RLIMIT_NOFILE of 1024.
+const uint64_t DEFAULT_MAX_PRIVATE_MB = 1536;
+const uint32_t DEFAULT_MAX_HANDLES = 800;
+const uint32_t DEFAULT_MAX_THREADS = 400;
+const uint64_t DEFAULT_MAX_GROWTH_MB_PER_HOUR = 64;
+
+// Substrings identifying installer/updater processes (case-insensitive)
+const char* INSTALLER_NAMES[] = {
+    "a1-tools-setup",
+    "a1tools_update",
+    "a1_tools_setup"
+};
+
+// Same directory the app gets from getApplicationSupportDirectory()
+static std::string GetAppDataDir() {
+    std::string base;
+    const char* xdgDataHome = getenv("XDG_DATA_HOME");
+    if (xdgDataHome != nullptr && xdgDataHome[0] == '/') {
+        base = xdgDataHome;
+    } else {
+        const char* home = getenv("HOME");
+        if (home == nullptr || home[0] == '\0') {
+            return "";
+        }
+        base = std::string(home) + "/.local/share";
+    }
+
+    std::string dir = base + "/" + APPLICATION_ID;
+    if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        return "";
+    }
+    return dir;
+}
+
+// The bundle layout puts the helper next to the company_hub binary
+static std::string GetDefaultAppPath() {
+    char path[PATH_MAX];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (n <= 0) {
+        return "";
+    }
+    path[n] = '\0';
+    std::string self(path);
+    return self.substr(0, self.find_last_of('/') + 1) + APP_EXE_NAME;
+}
+
+int main(int argc, char** argv) {
+    ResourceBudget budget = {};
+    budget.maxPrivateBytes = DEFAULT_MAX_PRIVATE_MB * 1024 * 1024;
+    budget.maxHandles = DEFAULT_MAX_HANDLES;
+    budget.maxThreads = DEFAULT_MAX_THREADS;
+    budget.maxPrivateGrowthPerHour = DEFAULT_MAX_GROWTH_MB_PER_HOUR * 1024 * 1024;
+
+    bool checkOnce = false;
+    std::string appPath;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check-once") == 0 || strcmp(argv[i], "--verify") == 0) {
+            checkOnce = true;
+        } else if (strcmp(argv[i], "--app") == 0 && i + 1 < argc) {
+            appPath = argv[++i];
+        } else if (i + 1 < argc && ResourceMonitor::ParseBudgetOption(argv[i], argv[i + 1], &budget)) {
+            i++;
+        }
+    }
+    if (appPath.empty()) {
+        appPath = GetDefaultAppPath();
+    }
+
+    std::string appDataDir = GetAppDataDir();
+    if (appDataDir.empty()) {
+        return 1;
+    }
+
+    // Block the stop signals before any thread starts so they are only ever
+    // delivered through the supervisor's signalfd
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGTERM);
+    sigaddset(&stopSignals, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    // Hold an exclusive lock for our lifetime (prevent multiple instances)
+    std::string lockPath = appDataDir + "/" + SERVICE_HELPER_LOCK_FILE;
+    int lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lockFd < 0 || flock(lockFd, LOCK_EX | LOCK_NB) != 0) {
+        // The log belongs to the running instance; opening it here could
+        // rotate it from under that one
+        if (lockFd >= 0) close(lockFd);
+        return 0;
+    }
+
+    ServiceLog::GetInstance().Start(appDataDir + "/" + LOG_FILE_NAME, MAX_LOG_SIZE,
+                                    COMPRESS_ROTATED_LOGS);
+
+    Log("A1 Tools Service Helper started, supervising " + appPath);
+
+    SupervisorConfig config;
+    config.dataDir = appDataDir;
+    config.appPath = appPath;
+    config.appExeName = APP_EXE_NAME;
+    config.installerNames.assign(std::begin(INSTALLER_NAMES), std::end(INSTALLER_NAMES));
+    config.resourceBudget = budget;
+
+    Supervisor supervisor(config);
+    int exitCode = 0;
+    if (checkOnce) {
+        Log("Running in verify mode");
+        supervisor.Start();
+        supervisor.PerformCheck();
+    } else if (supervisor.Start()) {
+        supervisor.Run();
+    } else {
+        exitCode = 1;
+    }
+
+    Log("A1 Tools Service Helper stopped");
+    close(lockFd);
+    ServiceLog::GetInstance().Stop();
+    return exitCode;
+}
@@ -0,0 +1,122 @@
+#include "heartbeat_monitor.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::atomic<int64_t>::is_always_lock_free,
+              "Heartbeat fields must be lock-free to live in shared memory");
+
+static int64_t MonotonicMs() {
+#ifdef _WIN32
+    return static_cast<int64_t>(GetTickCount64());
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+#ifdef _WIN32
+HeartbeatMonitor::HeartbeatMonitor()
+    : heartbeat_(nullptr), pid_(0), last_loop_count_(0), have_last_count_(false),
+      mapping_(NULL) {}
+#else
+HeartbeatMonitor::HeartbeatMonitor()
+    : heartbeat_(nullptr), pid_(0), last_loop_count_(0), have_last_count_(false) {}
+#endif
+
+HeartbeatMonitor::~HeartbeatMonitor() {
+    Close();
+}
+
+bool HeartbeatMonitor::Open(ProcessId pid) {
+    Close();
+
+#ifdef _WIN32
+    mapping_ = OpenFileMappingW(FILE_MAP_READ, FALSE, HEARTBEAT_MAPPING_NAME);
+    if (mapping_ == NULL) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, sizeof(SharedHeartbeat));
+    if (view == NULL) {
+        CloseHandle(mapping_);
+        mapping_ = NULL;
+        return false;
+    }
+#else
+    char name[64];
+    snprintf(name, sizeof(name), "%s%u", HEARTBEAT_SHM_PREFIX, static_cast<unsigned>(getuid()));
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    void* view = mmap(nullptr, sizeof(SharedHeartbeat), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+#endif
+
+    heartbeat_ = static_cast<const SharedHeartbeat*>(view);
+    pid_ = pid;
+    have_last_count_ = false;
+    return true;
+}
+
+void HeartbeatMonitor::Close() {
+    if (heartbeat_ != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(heartbeat_);
+#else
+        munmap(const_cast<SharedHeartbeat*>(heartbeat_), sizeof(SharedHeartbeat));
+#endif
+        heartbeat_ = nullptr;
+    }
+#ifdef _WIN32
+    if (mapping_ != NULL) {
+        CloseHandle(mapping_);
+        mapping_ = NULL;
+    }
+#endif
+    pid_ = 0;
+    have_last_count_ = false;
+}
+
+HeartbeatMonitor::Status HeartbeatMonitor::Check(int64_t loopStallMs, int64_t frameStallMs,
+                                                 int64_t* stalledForMs) {
+    if (heartbeat_ == nullptr) {
+        return Status::Unavailable;
+    }
+
+    uint32_t magic = heartbeat_->magic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (magic != SharedHeartbeat::kMagic || heartbeat_->version != SharedHeartbeat::kVersion ||
+        heartbeat_->pid != static_cast<uint32_t>(pid_)) {
+        return Status::Unavailable;
+    }
+
+    int64_t now = MonotonicMs();
+    uint64_t loopCount = heartbeat_->loop_count.load(std::memory_order_relaxed);
+    bool loopMoved = !have_last_count_ || loopCount != last_loop_count_;
+    last_loop_count_ = loopCount;
+    have_last_count_ = true;
+
+    int64_t loopAge = now - heartbeat_->loop_tick_ms.load(std::memory_order_relaxed);
+    if (loopAge > loopStallMs && !loopMoved) {
+        if (stalledForMs) *stalledForMs = loopAge;
+        return Status::LoopStalled;
+    }
+
+    int64_t probe = heartbeat_->frame_probe_ms.load(std::memory_order_relaxed);
+    if (probe != 0 && now - probe > frameStallMs) {
+        if (stalledForMs) *stalledForMs = now - probe;
+        return Status::FrameStalled;
+    }
+
+    return Status::Healthy;
+}
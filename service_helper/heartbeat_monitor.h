@@ -0,0 +1,79 @@
+#ifndef SERVICE_HELPER_HEARTBEAT_MONITOR_H_
+#define SERVICE_HELPER_HEARTBEAT_MONITOR_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "platform.h"
+
+// Heartbeat Monitor
+// Reads the liveness segment the runner publishes into shared memory and
+// decides whether the app is hung. Once mapped, a check is a few plain
+// memory loads; no process or file system calls are made.
+//
+//   Windows: named file mapping HEARTBEAT_MAPPING_NAME
+//            (windows/runner/app_heartbeat.cpp)
+//   Linux:   POSIX shm object HEARTBEAT_SHM_PREFIX + uid
+//            (linux/runner/app_heartbeat.cc)
+//
+// The names and the SharedHeartbeat layout must match the runner side.
+
+#ifdef _WIN32
+#define HEARTBEAT_MAPPING_NAME L"Local\\A1ToolsHeartbeat"
+#else
+#define HEARTBEAT_SHM_PREFIX "/a1_tools_heartbeat_"
+#endif
+
+struct SharedHeartbeat {
+    static const uint32_t kMagic = 0x42483141;  // "A1HB"
+    static const uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t pid;
+    uint32_t reserved;
+    // Monotonic milliseconds (GetTickCount64 / CLOCK_MONOTONIC)
+    std::atomic<int64_t> loop_tick_ms;    // Last message loop heartbeat
+    std::atomic<int64_t> frame_tick_ms;   // Last frame produced by the engine
+    std::atomic<int64_t> frame_probe_ms;  // Pending frame probe, 0 when none
+    std::atomic<uint64_t> loop_count;
+};
+
+class HeartbeatMonitor {
+public:
+    enum class Status {
+        Unavailable,   // No segment, or it belongs to another process
+        Healthy,
+        LoopStalled,   // Message loop stopped ticking
+        FrameStalled   // A requested frame never arrived
+    };
+
+    HeartbeatMonitor();
+    ~HeartbeatMonitor();
+
+    // Map the segment for the app instance with the given PID.
+    bool Open(ProcessId pid);
+    void Close();
+    bool IsOpen() const { return heartbeat_ != nullptr; }
+
+    // Classify the app's state. A stall is only reported when the loop
+    // counter has not moved since the previous call as well, so a single
+    // late read (e.g. right after resume from sleep) is not a hang.
+    // stalledForMs receives the age of the stale tick.
+    Status Check(int64_t loopStallMs, int64_t frameStallMs, int64_t* stalledForMs);
+
+private:
+    // Disable copy
+    HeartbeatMonitor(const HeartbeatMonitor&) = delete;
+    HeartbeatMonitor& operator=(const HeartbeatMonitor&) = delete;
+
+    const SharedHeartbeat* heartbeat_;
+    ProcessId pid_;
+    uint64_t last_loop_count_;
+    bool have_last_count_;
+#ifdef _WIN32
+    HANDLE mapping_;
+#endif
+};
+
+#endif  // SERVICE_HELPER_HEARTBEAT_MONITOR_H_
@@ -0,0 +1,299 @@
+#include "lock_tracker.h"
+
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+#ifdef _WIN32
+// FILETIME (100 ns since 1601) to ms since the Unix epoch
+static int64_t FileTimeToUnixMs(const FILETIME& ft) {
+    ULARGE_INTEGER value;
+    value.LowPart = ft.dwLowDateTime;
+    value.HighPart = ft.dwHighDateTime;
+    return static_cast<int64_t>(value.QuadPart / 10000ULL) - 11644473600000LL;
+}
+
+LockTracker::LockTracker() : dir_handle_(INVALID_HANDLE_VALUE) {
+    memset(&overlapped_, 0, sizeof(overlapped_));
+}
+#else
+LockTracker::LockTracker() : fd_(-1), watch_(-1) {}
+#endif
+
+LockTracker::~LockTracker() {
+    Stop();
+}
+
+int LockTracker::AddLock(const NativeString& fileName, int64_t staleAfterMs,
+                         bool wakeOnRelease) {
+    Lock lock;
+    lock.fileName = fileName;
+    lock.staleAfterMs = staleAfterMs;
+    lock.wakeOnRelease = wakeOnRelease;
+    lock.held = false;
+    lock.modifiedMs = 0;
+    locks_.push_back(lock);
+    return static_cast<int>(locks_.size() - 1);
+}
+
+bool LockTracker::Refresh(Lock& lock) {
+    bool wasHeld = lock.held;
+
+#ifdef _WIN32
+    std::wstring path = directory_ + L"\\" + lock.fileName;
+    WIN32_FILE_ATTRIBUTE_DATA fileInfo;
+    if (GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &fileInfo)) {
+        lock.held = true;
+        lock.modifiedMs = FileTimeToUnixMs(fileInfo.ftLastWriteTime);
+    } else {
+        lock.held = false;
+    }
+#else
+    std::string path = directory_ + "/" + lock.fileName;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+        lock.held = true;
+        lock.modifiedMs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 +
+                          st.st_mtim.tv_nsec / 1000000;
+    } else {
+        lock.held = false;
+    }
+#endif
+
+    return lock.wakeOnRelease && wasHeld && !lock.held;
+}
+
+bool LockTracker::RefreshAll() {
+    bool released = false;
+    for (auto& lock : locks_) {
+        released |= Refresh(lock);
+    }
+    return released;
+}
+
+bool LockTracker::OnFileChanged(const NativeString& fileName) {
+    for (auto& lock : locks_) {
+#ifdef _WIN32
+        bool match = _wcsicmp(lock.fileName.c_str(), fileName.c_str()) == 0;
+#else
+        bool match = lock.fileName == fileName;
+#endif
+        if (match) {
+            return Refresh(lock);
+        }
+    }
+    return false;
+}
+
+LockTracker::State LockTracker::Query(int lockId) {
+    Lock& lock = locks_[lockId];
+    if (!IsWatching()) {
+        Refresh(lock);
+    }
+    if (!lock.held) {
+        return State::Free;
+    }
+
+    if (NowMs() - lock.modifiedMs > lock.staleAfterMs) {
+        // Only creation and removal are watched; a lock rewritten in place
+        // has a newer time than the one seen when it appeared
+        if (IsWatching()) {
+            Refresh(lock);
+            if (!lock.held) {
+                return State::Free;
+            }
+            if (NowMs() - lock.modifiedMs <= lock.staleAfterMs) {
+                return State::Held;
+            }
+        }
+#ifdef _WIN32
+        DeleteFileW((directory_ + L"\\" + lock.fileName).c_str());
+#else
+        unlink((directory_ + "/" + lock.fileName).c_str());
+#endif
+        lock.held = false;
+        return State::Stale;
+    }
+    return State::Held;
+}
+
+int64_t LockTracker::MsUntilNextExpiry() const {
+    int64_t now = NowMs();
+    int64_t next = -1;
+    for (const auto& lock : locks_) {
+        if (!lock.held) {
+            continue;
+        }
+        int64_t remaining = lock.modifiedMs + lock.staleAfterMs - now;
+        if (remaining < 0) {
+            remaining = 0;
+        }
+        if (next < 0 || remaining < next) {
+            next = remaining;
+        }
+    }
+    return next;
+}
+
+#ifdef _WIN32
+bool LockTracker::Start(const NativeString& directory) {
+    Stop();
+    directory_ = directory;
+
+    dir_handle_ = CreateFileW(directory_.c_str(), FILE_LIST_DIRECTORY,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING,
+                              FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (dir_handle_ == INVALID_HANDLE_VALUE) {
+        RefreshAll();
+        return false;
+    }
+    overlapped_.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+    // Arm before scanning so no change between the two is missed
+    if (overlapped_.hEvent == NULL || !ArmNotification()) {
+        Stop();
+        RefreshAll();
+        return false;
+    }
+    RefreshAll();
+    return true;
+}
+
+void LockTracker::Stop() {
+    if (dir_handle_ != INVALID_HANDLE_VALUE) {
+        CancelIo(dir_handle_);
+        CloseHandle(dir_handle_);
+        dir_handle_ = INVALID_HANDLE_VALUE;
+    }
+    if (overlapped_.hEvent != NULL) {
+        CloseHandle(overlapped_.hEvent);
+    }
+    memset(&overlapped_, 0, sizeof(overlapped_));
+}
+
+bool LockTracker::IsWatching() const {
+    return dir_handle_ != INVALID_HANDLE_VALUE;
+}
+
+bool LockTracker::ArmNotification() {
+    ResetEvent(overlapped_.hEvent);
+    // Names only: the helper's own log and stats in the same directory are
+    // written constantly and must not wake it
+    return ReadDirectoryChangesW(dir_handle_, buffer_, sizeof(buffer_), FALSE,
+                                 FILE_NOTIFY_CHANGE_FILE_NAME,
+                                 NULL, &overlapped_, NULL) != FALSE;
+}
+
+bool LockTracker::Poll() {
+    if (!IsWatching()) {
+        return RefreshAll();
+    }
+
+    DWORD bytes = 0;
+    if (!GetOverlappedResult(dir_handle_, &overlapped_, &bytes, FALSE)) {
+        if (GetLastError() == ERROR_IO_INCOMPLETE) {
+            return false;  // Nothing pending
+        }
+        // Watch broke (directory removed?), degrade to stat-on-query
+        Stop();
+        return RefreshAll();
+    }
+
+    bool released = false;
+    if (bytes == 0) {
+        // Notification buffer overflowed; rescan everything
+        released = RefreshAll();
+    } else {
+        const BYTE* cursor = reinterpret_cast<const BYTE*>(buffer_);
+        while (true) {
+            const FILE_NOTIFY_INFORMATION* info =
+                reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+            std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            released |= OnFileChanged(name);
+            if (info->NextEntryOffset == 0) {
+                break;
+            }
+            cursor += info->NextEntryOffset;
+        }
+    }
+
+    if (!ArmNotification()) {
+        Stop();
+    }
+    return released;
+}
+#else
+bool LockTracker::Start(const NativeString& directory) {
+    Stop();
+    directory_ = directory;
+
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        RefreshAll();
+        return false;
+    }
+    // Creation, removal and renames only: the helper's own log and stats in
+    // the same directory are written constantly and must not wake it
+    watch_ = inotify_add_watch(fd_, directory_.c_str(),
+                               IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+    if (watch_ < 0) {
+        Stop();
+        RefreshAll();
+        return false;
+    }
+    RefreshAll();
+    return true;
+}
+
+void LockTracker::Stop() {
+    if (fd_ >= 0) {
+        close(fd_);  // Also drops the watch
+        fd_ = -1;
+    }
+    watch_ = -1;
+}
+
+bool LockTracker::IsWatching() const {
+    return fd_ >= 0;
+}
+
+bool LockTracker::Poll() {
+    if (!IsWatching()) {
+        return RefreshAll();
+    }
+
+    bool released = false;
+    alignas(struct inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t n = read(fd_, buffer, sizeof(buffer));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;  // EAGAIN: drained
+        }
+        for (char* cursor = buffer; cursor < buffer + n;) {
+            const struct inotify_event* event = reinterpret_cast<struct inotify_event*>(cursor);
+            if (event->mask & (IN_Q_OVERFLOW | IN_IGNORED)) {
+                released |= RefreshAll();
+            } else if (event->len > 0) {
+                released |= OnFileChanged(event->name);
+            }
+            cursor += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return released;
+}
+#endif
@@ -0,0 +1,101 @@
+#ifndef SERVICE_HELPER_LOCK_TRACKER_H_
+#define SERVICE_HELPER_LOCK_TRACKER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "platform.h"
+
+// Lock Tracker
+// Keeps the state of the app's lock files (.update_in_progress,
+// .restart_pending) in memory by watching the AppData directory for files
+// being created, removed or renamed, so supervision decisions are O(1)
+// reads instead of a stat per lock per check, and the helper wakes up the
+// moment a lock is released. Writes are not watched: the helper's own log
+// and stats live in the same directory. A lock that looks stale is stat-ed
+// once more before it is removed, in case it was rewritten in place.
+//
+//   Windows: overlapped ReadDirectoryChangesW on the directory; wait on
+//            changeEvent().
+//   Linux:   inotify; poll/epoll on fd().
+//
+// If the directory cannot be watched the tracker falls back to stat-ing the
+// lock files whenever their state is queried.
+
+class LockTracker {
+public:
+    enum class State {
+        Free,   // No lock file
+        Held,   // Lock file present and fresh
+        Stale   // Lock file was older than its timeout and has been removed
+    };
+
+    LockTracker();
+    ~LockTracker();
+
+    // Register a lock file (name relative to the watched directory) and the
+    // age after which it is considered stale. wakeOnRelease makes Poll()
+    // report its removal. Returns the lock id.
+    int AddLock(const NativeString& fileName, int64_t staleAfterMs, bool wakeOnRelease);
+
+    // Scan the lock files and start watching the directory.
+    bool Start(const NativeString& directory);
+    void Stop();
+    bool IsWatching() const;
+
+    // Consume pending directory notifications without blocking. Returns true
+    // if a wakeOnRelease lock was released (so a skipped check should run now).
+    bool Poll();
+
+    // Current state of a lock. A lock found stale is deleted and reported
+    // once as Stale, then as Free.
+    State Query(int lockId);
+
+    // Milliseconds until the next held lock goes stale, -1 if none is held.
+    int64_t MsUntilNextExpiry() const;
+
+#ifdef _WIN32
+    // Signaled when directory changes are pending; NULL if not watching.
+    HANDLE changeEvent() const { return overlapped_.hEvent; }
+#else
+    // Readable when directory changes are pending; -1 if not watching.
+    int fd() const { return fd_; }
+#endif
+
+private:
+    struct Lock {
+        NativeString fileName;
+        int64_t staleAfterMs;
+        bool wakeOnRelease;
+        bool held;
+        int64_t modifiedMs;  // Last write time, ms since the Unix epoch
+    };
+
+    // Disable copy
+    LockTracker(const LockTracker&) = delete;
+    LockTracker& operator=(const LockTracker&) = delete;
+
+    // Refresh one lock from the file system. Returns true if a
+    // wakeOnRelease lock was released.
+    bool Refresh(Lock& lock);
+    // Refresh every lock (initial scan and notification overflow).
+    bool RefreshAll();
+    // Refresh the lock matching a changed file name, if any.
+    bool OnFileChanged(const NativeString& fileName);
+
+    NativeString directory_;
+    std::vector<Lock> locks_;
+
+#ifdef _WIN32
+    bool ArmNotification();
+
+    HANDLE dir_handle_;
+    OVERLAPPED overlapped_;
+    DWORD buffer_[2048];  // DWORD-aligned FILE_NOTIFY_INFORMATION records
+#else
+    int fd_;
+    int watch_;
+#endif
+};
+
+#endif  // SERVICE_HELPER_LOCK_TRACKER_H_
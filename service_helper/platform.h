@@ -0,0 +1,44 @@
+#ifndef SERVICE_HELPER_PLATFORM_H_
+#define SERVICE_HELPER_PLATFORM_H_
+
+// Small portability layer shared by the service helper modules.
+// Windows builds work with UTF-16 paths and DWORD process ids, the Linux
+// build (company_hub) works with UTF-8 paths and pid_t.
+
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+typedef DWORD ProcessId;
+typedef wchar_t NativeChar;
+#define NATIVE_TEXT(s) L##s
+#else
+#include <sys/types.h>
+
+typedef pid_t ProcessId;
+typedef char NativeChar;
+#define NATIVE_TEXT(s) s
+#endif
+
+typedef std::basic_string<NativeChar> NativeString;
+
+#ifdef _WIN32
+#define NATIVE_PATH_SEPARATOR L"\\"
+#else
+#define NATIVE_PATH_SEPARATOR "/"
+#endif
+
+// Decimal formatting for log messages
+inline NativeString ToNativeString(long long value) {
+#ifdef _WIN32
+    return std::to_wstring(value);
+#else
+    return std::to_string(value);
+#endif
+}
+
+#endif  // SERVICE_HELPER_PLATFORM_H_
@@ -0,0 +1,281 @@
+#include "process_snapshot.h"
+
+#include <algorithm>
+#include <deque>
+
+#ifdef _WIN32
+#include <tlhelp32.h>
+#include <cwctype>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Kernel truncates comm to 15 characters; longer names are read from argv[0]
+static const size_t kMaxCommLength = 15;
+#endif
+
+NativeString FoldProcessName(const NativeString& name) {
+    NativeString result;
+    result.reserve(name.size());
+    for (NativeChar c : name) {
+#ifdef _WIN32
+        result.push_back(static_cast<wchar_t>(towlower(static_cast<wint_t>(c))));
+#else
+        result.push_back(static_cast<char>(tolower(static_cast<unsigned char>(c))));
+#endif
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// PatternMatcher
+// ---------------------------------------------------------------------------
+
+PatternMatcher::PatternMatcher(const std::vector<NativeString>& patterns) {
+    patterns_.reserve(patterns.size());
+    for (const auto& pattern : patterns) {
+        patterns_.push_back(FoldProcessName(pattern));
+    }
+
+    // Build the trie
+    nodes_.push_back(Node{{}, 0, -1});
+    for (size_t i = 0; i < patterns_.size(); i++) {
+        int state = 0;
+        for (NativeChar c : patterns_[i]) {
+            int child = Child(state, c);
+            if (child < 0) {
+                child = static_cast<int>(nodes_.size());
+                nodes_.push_back(Node{{}, 0, -1});
+                auto& next = nodes_[state].next;
+                next.insert(std::lower_bound(next.begin(), next.end(),
+                                             std::make_pair(c, 0)),
+                            std::make_pair(c, child));
+            }
+            state = child;
+        }
+        if (nodes_[state].output < 0) {
+            nodes_[state].output = static_cast<int>(i);
+        }
+    }
+
+    // Breadth-first pass to compute failure links; a node inherits the output
+    // of its failure state so a match is reported without walking the chain
+    std::deque<int> queue;
+    for (const auto& edge : nodes_[0].next) {
+        nodes_[edge.second].fail = 0;
+        queue.push_back(edge.second);
+    }
+    while (!queue.empty()) {
+        int state = queue.front();
+        queue.pop_front();
+        for (const auto& edge : nodes_[state].next) {
+            int child = edge.second;
+            nodes_[child].fail = Step(nodes_[state].fail, edge.first);
+            if (nodes_[child].output < 0) {
+                nodes_[child].output = nodes_[nodes_[child].fail].output;
+            }
+            queue.push_back(child);
+        }
+    }
+}
+
+int PatternMatcher::Child(int state, NativeChar c) const {
+    const auto& next = nodes_[state].next;
+    auto it = std::lower_bound(next.begin(), next.end(), std::make_pair(c, 0));
+    if (it != next.end() && it->first == c) {
+        return it->second;
+    }
+    return -1;
+}
+
+int PatternMatcher::Step(int state, NativeChar c) const {
+    while (true) {
+        int child = Child(state, c);
+        if (child >= 0) {
+            return child;
+        }
+        if (state == 0) {
+            return 0;
+        }
+        state = nodes_[state].fail;
+    }
+}
+
+int PatternMatcher::FindIn(const NativeString& foldedText) const {
+    if (nodes_.size() == 1) {
+        return -1;
+    }
+
+    int state = 0;
+    for (NativeChar c : foldedText) {
+        state = Step(state, c);
+        if (nodes_[state].output >= 0) {
+            return nodes_[state].output;
+        }
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// ProcessSnapshot
+// ---------------------------------------------------------------------------
+
+ProcessSnapshot::ProcessSnapshot() {}
+
+void ProcessSnapshot::Clear() {
+    entries_.clear();
+    name_index_.clear();
+}
+
+void ProcessSnapshot::Add(ProcessId pid, ProcessId parentPid, const NativeString& exeName) {
+    ProcessEntry entry;
+    entry.pid = pid;
+    entry.parentPid = parentPid;
+    entry.exeName = exeName;
+    entry.foldedName = FoldProcessName(exeName);
+
+    name_index_.emplace(entry.foldedName, entries_.size());
+    entries_.push_back(std::move(entry));
+}
+
+#ifdef _WIN32
+bool ProcessSnapshot::Capture() {
+    Clear();
+
+    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (hSnapshot == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    PROCESSENTRY32W pe32;
+    pe32.dwSize = sizeof(pe32);
+
+    if (Process32FirstW(hSnapshot, &pe32)) {
+        do {
+            Add(pe32.th32ProcessID, pe32.th32ParentProcessID, pe32.szExeFile);
+        } while (Process32NextW(hSnapshot, &pe32));
+    }
+
+    CloseHandle(hSnapshot);
+    return true;
+}
+#else
+// Read a small /proc file into buffer, returns the number of bytes read
+static ssize_t ReadProcFile(const std::string& path, char* buffer, size_t size) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t total = 0;
+    while (static_cast<size_t>(total) < size) {
+        ssize_t n = read(fd, buffer + total, size - total);
+        if (n <= 0) {
+            break;
+        }
+        total += n;
+    }
+    close(fd);
+    return total;
+}
+
+bool ProcessSnapshot::Capture() {
+    return CaptureFromProc("/proc");
+}
+
+bool ProcessSnapshot::CaptureFromProc(const std::string& procRoot) {
+    Clear();
+
+    DIR* dir = opendir(procRoot.c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+
+    char buffer[512];
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        const char* name = entry->d_name;
+        if (name[0] < '0' || name[0] > '9') {
+            continue;
+        }
+        char* end = nullptr;
+        long pid = strtol(name, &end, 10);
+        if (*end != '\0' || pid <= 0) {
+            continue;
+        }
+
+        std::string pidDir = procRoot + "/" + name;
+
+        // stat format: "<pid> (<comm>) <state> <ppid> ..."; comm may itself
+        // contain ')' so search from the end
+        ssize_t n = ReadProcFile(pidDir + "/stat", buffer, sizeof(buffer) - 1);
+        if (n <= 0) {
+            continue;  // Process exited while walking
+        }
+        buffer[n] = '\0';
+
+        char* lparen = strchr(buffer, '(');
+        char* rparen = strrchr(buffer, ')');
+        if (lparen == nullptr || rparen == nullptr || rparen < lparen) {
+            continue;
+        }
+        std::string comm(lparen + 1, rparen);
+
+        long ppid = 0;
+        char state = 0;
+        sscanf(rparen + 1, " %c %ld", &state, &ppid);
+        if (state == 'Z' || state == 'X') {
+            continue;  // Exited, not yet reaped by its parent
+        }
+
+        if (comm.size() >= kMaxCommLength) {
+            ssize_t len = ReadProcFile(pidDir + "/cmdline", buffer, sizeof(buffer) - 1);
+            if (len > 0) {
+                buffer[len] = '\0';
+                std::string argv0(buffer);
+                size_t slash = argv0.find_last_of('/');
+                std::string base = slash == std::string::npos ? argv0 : argv0.substr(slash + 1);
+                if (base.compare(0, comm.size(), comm) == 0) {
+                    comm = base;
+                }
+            }
+        }
+
+        Add(static_cast<ProcessId>(pid), static_cast<ProcessId>(ppid), comm);
+    }
+
+    closedir(dir);
+    return true;
+}
+#endif
+
+const ProcessEntry* ProcessSnapshot::FindByName(const NativeString& exeName) const {
+    auto it = name_index_.find(FoldProcessName(exeName));
+    if (it == name_index_.end()) {
+        return nullptr;
+    }
+    return &entries_[it->second];
+}
+
+size_t ProcessSnapshot::CountByName(const NativeString& exeName) const {
+    return name_index_.count(FoldProcessName(exeName));
+}
+
+const ProcessEntry* ProcessSnapshot::FindMatching(const PatternMatcher& matcher,
+                                                  int* matchedPattern) const {
+    for (const auto& entry : entries_) {
+        int index = matcher.FindIn(entry.foldedName);
+        if (index >= 0) {
+            if (matchedPattern) {
+                *matchedPattern = index;
+            }
+            return &entry;
+        }
+    }
+    return nullptr;
+}
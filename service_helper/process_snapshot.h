@@ -0,0 +1,97 @@
+#ifndef SERVICE_HELPER_PROCESS_SNAPSHOT_H_
+#define SERVICE_HELPER_PROCESS_SNAPSHOT_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "platform.h"
+
+// Process Snapshot
+// Captures the process table once per supervision check and answers every
+// query the checks need from that single capture:
+//   - exact, case-insensitive lookups by executable name (hash index)
+//   - "does any process name contain one of these patterns" (multi-pattern
+//     matcher, one pass over all names)
+//
+//   Windows: CreateToolhelp32Snapshot walk.
+//   Linux:   /proc walk; the root is configurable so synthetic process
+//            trees can be captured the same way as the real one.
+
+// Lowercase a process name or pattern. Windows folds the full UTF-16 range,
+// Linux folds ASCII only (names are UTF-8).
+NativeString FoldProcessName(const NativeString& name);
+
+// Aho-Corasick automaton over case-folded patterns. Built once, then finds
+// any of the patterns inside a name in a single scan of that name.
+class PatternMatcher {
+public:
+    explicit PatternMatcher(const std::vector<NativeString>& patterns);
+
+    // Index of a pattern contained in foldedText, -1 if none matches.
+    int FindIn(const NativeString& foldedText) const;
+
+    const NativeString& pattern(int index) const { return patterns_[index]; }
+
+private:
+    struct Node {
+        std::vector<std::pair<NativeChar, int>> next;  // Sorted by character
+        int fail;
+        int output;  // Pattern ending here or at a suffix state, -1 if none
+    };
+
+    int Child(int state, NativeChar c) const;
+    int Step(int state, NativeChar c) const;
+
+    std::vector<NativeString> patterns_;
+    std::vector<Node> nodes_;
+};
+
+struct ProcessEntry {
+    ProcessId pid;
+    ProcessId parentPid;
+    NativeString exeName;     // As reported by the OS
+    NativeString foldedName;  // Lowercased exeName
+};
+
+class ProcessSnapshot {
+public:
+    ProcessSnapshot();
+
+    // Replace the contents with the current process table.
+    bool Capture();
+
+#ifndef _WIN32
+    // Replace the contents with the process table found under procRoot
+    // (normally "/proc").
+    bool CaptureFromProc(const std::string& procRoot);
+#endif
+
+    // Drop all entries.
+    void Clear();
+
+    // Append an entry. Used by the capture backends and for building
+    // synthetic snapshots.
+    void Add(ProcessId pid, ProcessId parentPid, const NativeString& exeName);
+
+    size_t size() const { return entries_.size(); }
+    const std::vector<ProcessEntry>& entries() const { return entries_; }
+
+    // A process whose executable name equals exeName (case-insensitive),
+    // nullptr if none.
+    const ProcessEntry* FindByName(const NativeString& exeName) const;
+
+    // Number of processes with the given executable name (case-insensitive).
+    size_t CountByName(const NativeString& exeName) const;
+
+    // First process whose name contains any of the matcher's patterns,
+    // nullptr if none. matchedPattern receives the pattern index.
+    const ProcessEntry* FindMatching(const PatternMatcher& matcher,
+                                     int* matchedPattern = nullptr) const;
+
+private:
+    std::vector<ProcessEntry> entries_;
+    std::unordered_multimap<NativeString, size_t> name_index_;  // foldedName -> entry
+};
+
+#endif  // SERVICE_HELPER_PROCESS_SNAPSHOT_H_
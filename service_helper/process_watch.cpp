@@ -0,0 +1,222 @@
+#include "process_watch.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+// Slice used when the kernel has no pidfd support (< 5.3) and we have to
+// fall back to probing the PID with kill(pid, 0).
+static const int kLegacyProbeIntervalMs = 1000;
+
+static bool IsProcessAlive(pid_t pid) {
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+static long long MonotonicMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+#endif
+
+#ifdef _WIN32
+ProcessWatch::ProcessWatch() : pid_(0), handle_(NULL) {}
+#else
+ProcessWatch::ProcessWatch() : pid_(0), fd_(-1), reaped_(false), exit_status_(0) {}
+#endif
+
+ProcessWatch::~ProcessWatch() {
+    Detach();
+}
+
+bool ProcessWatch::Attach(ProcessId pid) {
+    Detach();
+
+#ifdef _WIN32
+    HANDLE process = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (process == NULL) {
+        return false;
+    }
+    handle_ = process;
+#else
+    int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    if (fd < 0) {
+        if (errno != ENOSYS || !IsProcessAlive(pid)) {
+            return false;
+        }
+        // Legacy kernel: keep the PID and poll it in Wait()
+    }
+    fd_ = fd;
+    reaped_ = false;
+    exit_status_ = 0;
+#endif
+
+    pid_ = pid;
+    return true;
+}
+
+#ifdef _WIN32
+void ProcessWatch::Adopt(HANDLE process, ProcessId pid) {
+    Detach();
+    handle_ = process;
+    pid_ = pid;
+}
+#endif
+
+void ProcessWatch::Detach() {
+#ifdef _WIN32
+    if (handle_ != NULL) {
+        CloseHandle(handle_);
+        handle_ = NULL;
+    }
+#else
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+#endif
+    pid_ = 0;
+}
+
+bool ProcessWatch::IsAttached() const {
+    return pid_ != 0;
+}
+
+ProcessWatch::WaitResult ProcessWatch::Wait(unsigned long timeoutMs) {
+    if (!IsAttached()) {
+        return WaitResult::Error;
+    }
+
+#ifdef _WIN32
+    switch (WaitForSingleObject(handle_, timeoutMs)) {
+        case WAIT_OBJECT_0:
+            return WaitResult::Exited;
+        case WAIT_TIMEOUT:
+            return WaitResult::Timeout;
+        default:
+            return WaitResult::Error;
+    }
+#else
+    if (fd_ < 0) {
+        long long deadline = MonotonicMs() + static_cast<long long>(timeoutMs);
+        // Reap our own children first so an exited child is not seen as a
+        // live zombie
+        while (!Reap() && IsProcessAlive(pid_)) {
+            long long remaining = deadline - MonotonicMs();
+            if (remaining <= 0) {
+                return WaitResult::Timeout;
+            }
+            usleep(static_cast<useconds_t>(
+                (remaining < kLegacyProbeIntervalMs ? remaining : kLegacyProbeIntervalMs) * 1000));
+        }
+        return WaitResult::Exited;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int rc;
+    do {
+        rc = poll(&pfd, 1, static_cast<int>(timeoutMs));
+    } while (rc < 0 && errno == EINTR);
+
+    if (rc == 0) {
+        return WaitResult::Timeout;
+    }
+    if (rc < 0) {
+        return WaitResult::Error;
+    }
+
+    Reap();
+    return WaitResult::Exited;
+#endif
+}
+
+#ifndef _WIN32
+bool ProcessWatch::Reap() {
+    if (reaped_) {
+        return true;
+    }
+    int status = 0;
+    if (waitpid(pid_, &status, WNOHANG) == pid_) {
+        reaped_ = true;
+        exit_status_ = status;
+    }
+    return reaped_;
+}
+#endif
+
+bool ProcessWatch::GetExitCode(unsigned long* exitCode) {
+    if (!IsAttached()) {
+        return false;
+    }
+
+#ifdef _WIN32
+    DWORD code = 0;
+    if (!GetExitCodeProcess(handle_, &code) || code == STILL_ACTIVE) {
+        return false;
+    }
+    *exitCode = code;
+    return true;
+#else
+    if (!Reap()) {
+        return false;
+    }
+    if (WIFEXITED(exit_status_)) {
+        *exitCode = static_cast<unsigned long>(WEXITSTATUS(exit_status_));
+    } else {
+        // Killed by a signal; report it shell-style as 128 + signal
+        *exitCode = 128 + static_cast<unsigned long>(WTERMSIG(exit_status_));
+    }
+    return true;
+#endif
+}
+
+bool ProcessWatch::GetExitTime(int64_t* unixMs) {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!IsAttached() || !GetProcessTimes(handle_, &creation, &exit, &kernel, &user) ||
+        (exit.dwLowDateTime == 0 && exit.dwHighDateTime == 0)) {
+        return false;
+    }
+    // FILETIME (100 ns since 1601) to ms since the Unix epoch
+    ULARGE_INTEGER value;
+    value.LowPart = exit.dwLowDateTime;
+    value.HighPart = exit.dwHighDateTime;
+    *unixMs = static_cast<int64_t>(value.QuadPart / 10000ULL) - 11644473600000LL;
+    return true;
+#else
+    (void)unixMs;
+    return false;
+#endif
+}
+
+bool ProcessWatch::Terminate(unsigned int exitCode) {
+    if (!IsAttached()) {
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_TERMINATE, FALSE, pid_);
+    if (process == NULL) {
+        return false;
+    }
+    BOOL ok = TerminateProcess(process, exitCode);
+    CloseHandle(process);
+    return ok != FALSE;
+#else
+    (void)exitCode;
+    return kill(pid_, SIGKILL) == 0;
+#endif
+}
@@ -0,0 +1,85 @@
+#ifndef SERVICE_HELPER_PROCESS_WATCH_H_
+#define SERVICE_HELPER_PROCESS_WATCH_H_
+
+#include <cstdint>
+
+#include "platform.h"
+
+// Process Watch
+// Holds an OS handle to a single running process and blocks until it exits,
+// so the service helper reacts to a crash as soon as it happens instead of
+// waiting for the next timed check.
+//
+//   Windows: process handle opened with SYNCHRONIZE (or adopted from
+//            CreateProcessW) and waited on with WaitForSingleObject.
+//   Linux:   pidfd from pidfd_open(), which becomes readable when the
+//            process exits and can be polled alone or added to an epoll set.
+
+class ProcessWatch {
+public:
+    enum class WaitResult {
+        Exited,   // The watched process has terminated
+        Timeout,  // Timeout elapsed, process still alive
+        Error     // Nothing attached or the wait failed
+    };
+
+    ProcessWatch();
+    ~ProcessWatch();
+
+    // Start watching a process by PID. Replaces any previous watch.
+    bool Attach(ProcessId pid);
+
+#ifdef _WIN32
+    // Take ownership of a process handle (e.g. PROCESS_INFORMATION::hProcess)
+    // so a freshly launched app can be watched without reopening it.
+    void Adopt(HANDLE process, ProcessId pid);
+#endif
+
+    // Stop watching and release the handle.
+    void Detach();
+
+    bool IsAttached() const;
+    ProcessId pid() const { return pid_; }
+
+    // Block until the process exits or timeoutMs elapses.
+    WaitResult Wait(unsigned long timeoutMs);
+
+    // Exit code of a process that has exited. On Linux this is only known
+    // for our own children (reaped here); returns false otherwise.
+    bool GetExitCode(unsigned long* exitCode);
+
+    // When an exited process ended (ms since the Unix epoch). Only known on
+    // Windows; Linux returns false.
+    bool GetExitTime(int64_t* unixMs);
+
+    // Forcefully end the watched process (used for hung apps). The exit is
+    // then reported by Wait() like any other.
+    bool Terminate(unsigned int exitCode);
+
+#ifdef _WIN32
+    HANDLE handle() const { return handle_; }
+#else
+    // pidfd for integration into an external poll/epoll loop, -1 if detached
+    // or running on a kernel without pidfd support.
+    int fd() const { return fd_; }
+#endif
+
+private:
+    // Disable copy
+    ProcessWatch(const ProcessWatch&) = delete;
+    ProcessWatch& operator=(const ProcessWatch&) = delete;
+
+    ProcessId pid_;
+#ifdef _WIN32
+    HANDLE handle_;
+#else
+    // Reap the process if it is our child; returns true once reaped.
+    bool Reap();
+
+    int fd_;
+    bool reaped_;
+    int exit_status_;
+#endif
+};
+
+#endif  // SERVICE_HELPER_PROCESS_WATCH_H_
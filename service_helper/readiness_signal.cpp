@@ -0,0 +1,106 @@
+#include "readiness_signal.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+ReadinessSignal::ReadinessSignal() : event_(NULL) {}
+
+ReadinessSignal::~ReadinessSignal() {
+    if (event_ != NULL) {
+        CloseHandle(event_);
+    }
+}
+
+bool ReadinessSignal::Arm() {
+    if (event_ == NULL) {
+        // Manual reset so the state survives until we look at it, even if the
+        // runner fires before we start waiting
+        event_ = CreateEventW(NULL, TRUE, FALSE, READY_EVENT_NAME);
+        if (event_ == NULL) {
+            return false;
+        }
+    }
+    return ResetEvent(event_) != FALSE;
+}
+
+ReadinessSignal::WaitResult ReadinessSignal::Wait(const ProcessWatch& app,
+                                                  unsigned long timeoutMs) {
+    if (event_ == NULL) {
+        return WaitResult::Error;
+    }
+
+    HANDLE handles[2] = { event_, app.handle() };
+    DWORD count = app.IsAttached() ? 2 : 1;
+
+    switch (WaitForMultipleObjects(count, handles, FALSE, timeoutMs)) {
+        case WAIT_OBJECT_0:
+            return WaitResult::Ready;
+        case WAIT_OBJECT_0 + 1:
+            return WaitResult::Exited;
+        case WAIT_TIMEOUT:
+            return WaitResult::Timeout;
+        default:
+            return WaitResult::Error;
+    }
+}
+#else
+ReadinessSignal::ReadinessSignal() : fd_(-1) {}
+
+ReadinessSignal::~ReadinessSignal() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool ReadinessSignal::Arm() {
+    // A fresh eventfd per launch; an old app instance holding the previous
+    // one can no longer signal us
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    fd_ = eventfd(0, EFD_NONBLOCK);
+    return fd_ >= 0;
+}
+
+ReadinessSignal::WaitResult ReadinessSignal::Wait(const ProcessWatch& app,
+                                                  unsigned long timeoutMs) {
+    if (fd_ < 0) {
+        return WaitResult::Error;
+    }
+
+    struct pollfd fds[2];
+    fds[0].fd = fd_;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = app.fd();
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+    nfds_t count = app.fd() >= 0 ? 2 : 1;
+
+    int rc;
+    do {
+        rc = poll(fds, count, static_cast<int>(timeoutMs));
+    } while (rc < 0 && errno == EINTR);
+
+    if (rc == 0) {
+        return WaitResult::Timeout;
+    }
+    if (rc < 0) {
+        return WaitResult::Error;
+    }
+    if (fds[0].revents & POLLIN) {
+        uint64_t value = 0;
+        if (read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+            return WaitResult::Error;
+        }
+        return WaitResult::Ready;
+    }
+    return WaitResult::Exited;
+}
+#endif
@@ -0,0 +1,62 @@
+#ifndef SERVICE_HELPER_READINESS_SIGNAL_H_
+#define SERVICE_HELPER_READINESS_SIGNAL_H_
+
+#include "platform.h"
+#include "process_watch.h"
+
+// Readiness Signal
+// Helper side of the first-frame handshake with the runner. The helper arms
+// the signal before launching the app and then waits for the runner to fire
+// it when Flutter produces its first frame, so recovery completes as soon as
+// the app is actually usable.
+//
+//   Windows: named manual-reset event READY_EVENT_NAME; the runner opens it
+//            and calls SetEvent (windows/runner/readiness_signal.cpp).
+//   Linux:   eventfd inherited by the launched app, whose number is passed in
+//            READY_FD_ENV_VAR; the runner writes to it on "first-frame"
+//            (linux/runner/my_application.cc).
+//
+// The names must match the runner side.
+
+#ifdef _WIN32
+#define READY_EVENT_NAME L"A1ToolsFirstFrameEvent"
+#endif
+#define READY_FD_ENV_VAR "A1_TOOLS_READY_FD"
+
+class ReadinessSignal {
+public:
+    enum class WaitResult {
+        Ready,    // Runner reported its first frame
+        Exited,   // The app process exited before becoming ready
+        Timeout,  // Deadline passed without a signal
+        Error
+    };
+
+    ReadinessSignal();
+    ~ReadinessSignal();
+
+    // Create (or reset) the signal. Must be called before launching the app.
+    bool Arm();
+
+    // Wait until the runner signals, the watched app exits, or timeoutMs
+    // passes. A detached watch only waits on the signal.
+    WaitResult Wait(const ProcessWatch& app, unsigned long timeoutMs);
+
+#ifndef _WIN32
+    // Descriptor to hand to the child (without FD_CLOEXEC), -1 if not armed.
+    int childFd() const { return fd_; }
+#endif
+
+private:
+    // Disable copy
+    ReadinessSignal(const ReadinessSignal&) = delete;
+    ReadinessSignal& operator=(const ReadinessSignal&) = delete;
+
+#ifdef _WIN32
+    HANDLE event_;
+#else
+    int fd_;
+#endif
+};
+
+#endif  // SERVICE_HELPER_READINESS_SIGNAL_H_
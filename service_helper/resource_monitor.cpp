@@ -0,0 +1,235 @@
+#include "resource_monitor.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <psapi.h>
+#include <tlhelp32.h>
+#else
+#include <dirent.h>
+#include <stdio.h>
+#endif
+
+static const uint64_t kBytesPerMb = 1024 * 1024;
+
+ResourceMonitor::ResourceMonitor()
+    : budget_(), pid_(0), window_(), count_(0), next_(0), over_budget_streak_(0) {}
+
+void ResourceMonitor::Reset() {
+    pid_ = 0;
+    count_ = 0;
+    next_ = 0;
+    over_budget_streak_ = 0;
+}
+
+ResourceMonitor::Verdict ResourceMonitor::Sample(ProcessId pid, int64_t nowMs,
+                                                 NativeString* reason) {
+    if (pid != pid_) {
+        Reset();
+        pid_ = pid;
+    }
+
+    ResourceSample sample;
+    if (!ReadSample(pid, &sample)) {
+        return Verdict::Unavailable;
+    }
+    sample.timeMs = nowMs;
+    window_[next_] = sample;
+    next_ = (next_ + 1) % kWindowSize;
+    if (count_ < kWindowSize) {
+        count_++;
+    }
+
+    // Absolute budgets
+    const NativeChar* over = nullptr;
+    uint64_t value = 0;
+    uint64_t limit = 0;
+    if (budget_.maxPrivateBytes != 0 && sample.privateBytes > budget_.maxPrivateBytes) {
+        over = NATIVE_TEXT("private bytes");
+        value = sample.privateBytes;
+        limit = budget_.maxPrivateBytes;
+    } else if (budget_.maxWorkingSetBytes != 0 &&
+               sample.workingSetBytes > budget_.maxWorkingSetBytes) {
+        over = NATIVE_TEXT("working set");
+        value = sample.workingSetBytes;
+        limit = budget_.maxWorkingSetBytes;
+    } else if (budget_.maxHandles != 0 && sample.handleCount > budget_.maxHandles) {
+        over = NATIVE_TEXT("handles");
+        value = sample.handleCount;
+        limit = budget_.maxHandles;
+    } else if (budget_.maxThreads != 0 && sample.threadCount > budget_.maxThreads) {
+        over = NATIVE_TEXT("threads");
+        value = sample.threadCount;
+        limit = budget_.maxThreads;
+    }
+
+    if (over != nullptr) {
+        if (++over_budget_streak_ >= kOverBudgetSamples) {
+            if (reason != nullptr) {
+                *reason = NativeString(over) + NATIVE_TEXT(" ") +
+                          ToNativeString(static_cast<long long>(value)) +
+                          NATIVE_TEXT(" over budget ") +
+                          ToNativeString(static_cast<long long>(limit));
+            }
+            return Verdict::OverBudget;
+        }
+    } else {
+        over_budget_streak_ = 0;
+    }
+
+    // Growth trend, only over a full window so startup growth is not a leak
+    if (budget_.maxPrivateGrowthPerHour != 0 && count_ == kWindowSize) {
+        const ResourceSample& oldest = window_[next_];
+        if (sample.timeMs - oldest.timeMs >= kMinWindowSpanMs) {
+            double growth = PrivateGrowthPerHour();
+            if (growth > static_cast<double>(budget_.maxPrivateGrowthPerHour)) {
+                if (reason != nullptr) {
+                    *reason = NATIVE_TEXT("private bytes growing ") +
+                              ToNativeString(static_cast<long long>(growth / kBytesPerMb)) +
+                              NATIVE_TEXT(" MB/h, now ") +
+                              ToNativeString(static_cast<long long>(sample.privateBytes / kBytesPerMb)) +
+                              NATIVE_TEXT(" MB");
+                }
+                return Verdict::Leaking;
+            }
+        }
+    }
+
+    return Verdict::WithinBudget;
+}
+
+double ResourceMonitor::PrivateGrowthPerHour() const {
+    // Times relative to the first sample keep the sums well conditioned
+    int64_t t0 = window_[count_ == kWindowSize ? next_ : 0].timeMs;
+    double sumT = 0, sumV = 0, sumTT = 0, sumTV = 0;
+    for (int i = 0; i < count_; i++) {
+        double t = static_cast<double>(window_[i].timeMs - t0) / (60.0 * 60.0 * 1000.0);
+        double v = static_cast<double>(window_[i].privateBytes);
+        sumT += t;
+        sumV += v;
+        sumTT += t * t;
+        sumTV += t * v;
+    }
+    double n = static_cast<double>(count_);
+    double denominator = n * sumTT - sumT * sumT;
+    if (count_ < 2 || denominator <= 0) {
+        return 0;
+    }
+    return (n * sumTV - sumT * sumV) / denominator;
+}
+
+bool ResourceMonitor::ParseBudgetOption(const NativeString& name, const NativeString& value,
+                                        ResourceBudget* budget) {
+#ifdef _WIN32
+    unsigned long long number = wcstoull(value.c_str(), nullptr, 10);
+#else
+    unsigned long long number = strtoull(value.c_str(), nullptr, 10);
+#endif
+
+    if (name == NATIVE_TEXT("--max-private-mb")) {
+        budget->maxPrivateBytes = number * kBytesPerMb;
+    } else if (name == NATIVE_TEXT("--max-working-set-mb")) {
+        budget->maxWorkingSetBytes = number * kBytesPerMb;
+    } else if (name == NATIVE_TEXT("--max-handles")) {
+        budget->maxHandles = static_cast<uint32_t>(number);
+    } else if (name == NATIVE_TEXT("--max-threads")) {
+        budget->maxThreads = static_cast<uint32_t>(number);
+    } else if (name == NATIVE_TEXT("--max-growth-mb-per-hour")) {
+        budget->maxPrivateGrowthPerHour = number * kBytesPerMb;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+#ifdef _WIN32
+bool ResourceMonitor::ReadSample(ProcessId pid, ResourceSample* sample) {
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (process == NULL) {
+        return false;
+    }
+
+    PROCESS_MEMORY_COUNTERS_EX memory;
+    memset(&memory, 0, sizeof(memory));
+    memory.cb = sizeof(memory);
+    DWORD handles = 0;
+    bool ok = GetProcessMemoryInfo(process, reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&memory),
+                                   sizeof(memory)) &&
+              GetProcessHandleCount(process, &handles);
+    CloseHandle(process);
+    if (!ok) {
+        return false;
+    }
+
+    sample->workingSetBytes = memory.WorkingSetSize;
+    sample->privateBytes = memory.PrivateUsage;
+    sample->handleCount = handles;
+    sample->threadCount = 0;
+
+    // Toolhelp reports the thread count per process for free
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snapshot != INVALID_HANDLE_VALUE) {
+        PROCESSENTRY32W pe32;
+        pe32.dwSize = sizeof(pe32);
+        if (Process32FirstW(snapshot, &pe32)) {
+            do {
+                if (pe32.th32ProcessID == pid) {
+                    sample->threadCount = pe32.cntThreads;
+                    break;
+                }
+            } while (Process32NextW(snapshot, &pe32));
+        }
+        CloseHandle(snapshot);
+    }
+    return true;
+}
+#else
+bool ResourceMonitor::ReadSample(ProcessId pid, ResourceSample* sample) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/status", static_cast<int>(pid));
+    FILE* status = fopen(path, "re");
+    if (status == nullptr) {
+        return false;
+    }
+
+    // Sizes in status are in kB
+    unsigned long long rssKb = 0, anonKb = 0, swapKb = 0;
+    unsigned int threads = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), status) != nullptr) {
+        if (strncmp(line, "VmRSS:", 6) == 0) {
+            rssKb = strtoull(line + 6, nullptr, 10);
+        } else if (strncmp(line, "RssAnon:", 8) == 0) {
+            anonKb = strtoull(line + 8, nullptr, 10);
+        } else if (strncmp(line, "VmSwap:", 7) == 0) {
+            swapKb = strtoull(line + 7, nullptr, 10);
+        } else if (strncmp(line, "Threads:", 8) == 0) {
+            threads = static_cast<unsigned int>(strtoul(line + 8, nullptr, 10));
+        }
+    }
+    fclose(status);
+    if (threads == 0) {
+        return false;  // Exited (zombies have no memory lines either)
+    }
+
+    snprintf(path, sizeof(path), "/proc/%d/fd", static_cast<int>(pid));
+    uint32_t fds = 0;
+    DIR* dir = opendir(path);
+    if (dir != nullptr) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (entry->d_name[0] != '.') {
+                fds++;
+            }
+        }
+        closedir(dir);
+    }
+
+    sample->workingSetBytes = rssKb * 1024;
+    sample->privateBytes = (anonKb + swapKb) * 1024;
+    sample->handleCount = fds;
+    sample->threadCount = threads;
+    return true;
+}
+#endif
@@ -0,0 +1,82 @@
+#ifndef SERVICE_HELPER_RESOURCE_MONITOR_H_
+#define SERVICE_HELPER_RESOURCE_MONITOR_H_
+
+#include <cstdint>
+
+#include "platform.h"
+
+// Resource Monitor
+// Samples the app's memory, handle and thread usage at low frequency and
+// decides when a long-running instance has leaked enough to be restarted.
+//
+//   Windows: GetProcessMemoryInfo (working set, private bytes),
+//            GetProcessHandleCount, Toolhelp thread count.
+//   Linux:   /proc/<pid>/status (VmRSS, RssAnon + VmSwap, Threads) and the
+//            number of entries in /proc/<pid>/fd.
+//
+// Besides the absolute budgets, a least-squares fit over the last hour of
+// private bytes catches a steady leak before it reaches the budget.
+
+struct ResourceSample {
+    int64_t timeMs;             // Monotonic
+    uint64_t workingSetBytes;   // Resident memory
+    uint64_t privateBytes;      // Committed private / anonymous memory
+    uint32_t handleCount;       // Kernel handles / open file descriptors
+    uint32_t threadCount;
+};
+
+// Limits for one app instance; 0 disables a limit.
+struct ResourceBudget {
+    uint64_t maxWorkingSetBytes;
+    uint64_t maxPrivateBytes;
+    uint32_t maxHandles;
+    uint32_t maxThreads;
+    uint64_t maxPrivateGrowthPerHour;  // Sustained growth over a full window
+};
+
+class ResourceMonitor {
+public:
+    enum class Verdict {
+        Unavailable,   // The process could not be sampled
+        WithinBudget,
+        OverBudget,    // An absolute budget was exceeded on consecutive samples
+        Leaking        // Private bytes grew faster than the growth budget
+    };
+
+    ResourceMonitor();
+
+    void SetBudget(const ResourceBudget& budget) { budget_ = budget; }
+    const ResourceBudget& budget() const { return budget_; }
+
+    // Forget the samples of the previous app instance.
+    void Reset();
+
+    // Take a sample of the process and classify it. A different pid than
+    // the previous call starts a new history. reason receives a short
+    // description when the verdict is OverBudget or Leaking.
+    Verdict Sample(ProcessId pid, int64_t nowMs, NativeString* reason);
+
+    // Apply a "--max-...=<n>" style budget option. Returns false if name is
+    // not a budget option.
+    static bool ParseBudgetOption(const NativeString& name, const NativeString& value,
+                                  ResourceBudget* budget);
+
+private:
+    static const int kWindowSize = 12;  // Samples in the trend window
+    static const int64_t kMinWindowSpanMs = 50 * 60 * 1000;
+    static const int kOverBudgetSamples = 2;  // Ignore a single spike
+
+    static bool ReadSample(ProcessId pid, ResourceSample* sample);
+
+    // Least-squares slope of private bytes over the window, in bytes/hour.
+    double PrivateGrowthPerHour() const;
+
+    ResourceBudget budget_;
+    ProcessId pid_;
+    ResourceSample window_[kWindowSize];  // Ring of the newest samples
+    int count_;
+    int next_;
+    int over_budget_streak_;
+};
+
+#endif  // SERVICE_HELPER_RESOURCE_MONITOR_H_
@@ -0,0 +1,236 @@
+#include "restart_history.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+static const char* StateName(RestartHistory::State state) {
+    switch (state) {
+        case RestartHistory::State::Open:
+            return "open";
+        case RestartHistory::State::HalfOpen:
+            return "half_open";
+        default:
+            return "closed";
+    }
+}
+
+static FILE* OpenFile(const NativeString& path, bool write) {
+#ifdef _WIN32
+    return _wfopen(path.c_str(), write ? L"wb" : L"rb");
+#else
+    return fopen(path.c_str(), write ? "we" : "re");
+#endif
+}
+
+// Value of the first "key": <number> at or after from; end receives the
+// position after the number.
+static bool FindNumber(const std::string& text, const char* key, size_t from,
+                       long long* value, size_t* end) {
+    std::string needle = std::string("\"") + key + "\":";
+    size_t pos = text.find(needle, from);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    const char* start = text.c_str() + pos + needle.size();
+    char* stop = nullptr;
+    *value = strtoll(start, &stop, 10);
+    if (stop == start) {
+        return false;
+    }
+    if (end != nullptr) {
+        *end = static_cast<size_t>(stop - text.c_str());
+    }
+    return true;
+}
+
+RestartHistory::RestartHistory()
+    : state_(State::Closed),
+      trips_(0),
+      early_exits_(0),
+      backoff_ms_(0),
+      next_attempt_ms_(0),
+      random_(std::random_device()()) {}
+
+void RestartHistory::Load(const NativeString& path) {
+    path_ = path;
+
+    FILE* file = OpenFile(path_, false);
+    if (file == nullptr) {
+        return;
+    }
+    std::string text;
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, n);
+    }
+    fclose(file);
+
+    // Only our own fixed layout is ever read back, see Save()
+    long long value = 0;
+    if (text.find("\"state\":\"open\"") != std::string::npos) {
+        state_ = State::Open;
+    } else if (text.find("\"state\":\"half_open\"") != std::string::npos) {
+        state_ = State::HalfOpen;
+    }
+    if (FindNumber(text, "trips", 0, &value, nullptr)) trips_ = static_cast<int>(value);
+    if (FindNumber(text, "early_exits", 0, &value, nullptr)) early_exits_ = static_cast<int>(value);
+    if (FindNumber(text, "backoff_ms", 0, &value, nullptr)) backoff_ms_ = value;
+    if (FindNumber(text, "next_attempt_ms", 0, &value, nullptr)) next_attempt_ms_ = value;
+
+    size_t pos = text.find("\"launches\"");
+    while (pos != std::string::npos) {
+        Launch launch;
+        long long launchMs = 0, exitMs = 0, exitCode = 0;
+        if (!FindNumber(text, "launch_ms", pos, &launchMs, &pos) ||
+            !FindNumber(text, "exit_ms", pos, &exitMs, &pos) ||
+            !FindNumber(text, "exit_code", pos, &exitCode, &pos)) {
+            break;
+        }
+        launch.launchMs = launchMs;
+        launch.exitMs = exitMs;
+        launch.exitCode = exitCode;
+        launches_.push_back(launch);
+    }
+    while (launches_.size() > kMaxLaunches) {
+        launches_.pop_front();
+    }
+}
+
+bool RestartHistory::MayLaunch(int64_t nowMs, int64_t* waitMs) {
+    if (state_ != State::Open) {
+        return true;
+    }
+    // Guard against the wall clock having been set back
+    if (next_attempt_ms_ - nowMs > kMaxBackoffMs) {
+        next_attempt_ms_ = nowMs + kMaxBackoffMs;
+    }
+    if (nowMs < next_attempt_ms_) {
+        if (waitMs != nullptr) {
+            *waitMs = next_attempt_ms_ - nowMs;
+        }
+        return false;
+    }
+    state_ = State::HalfOpen;
+    Save();
+    return true;
+}
+
+int64_t RestartHistory::MsUntilNextAttempt(int64_t nowMs) const {
+    if (state_ != State::Open) {
+        return -1;
+    }
+    return next_attempt_ms_ > nowMs ? next_attempt_ms_ - nowMs : 0;
+}
+
+void RestartHistory::RecordLaunch(int64_t nowMs) {
+    Launch launch;
+    launch.launchMs = nowMs;
+    launch.exitMs = 0;
+    launch.exitCode = 0;
+    launches_.push_back(launch);
+    while (launches_.size() > kMaxLaunches) {
+        launches_.pop_front();
+    }
+    Save();
+}
+
+void RestartHistory::RecordExit(int64_t nowMs, long long exitCode, bool countsAsCrash) {
+    if (launches_.empty() || launches_.back().exitMs != 0) {
+        return;  // Not an instance we launched, or already recorded
+    }
+    Launch& launch = launches_.back();
+    launch.exitMs = nowMs;
+    launch.exitCode = exitCode;
+
+    bool early = nowMs - launch.launchMs < kCrashLoopWindowMs;
+    if (countsAsCrash && early) {
+        // A failed trial re-opens right away
+        if (state_ == State::HalfOpen || ++early_exits_ >= kCrashLoopExits) {
+            Trip(nowMs);
+        }
+    } else if (!early) {
+        Close();
+    }
+    Save();
+}
+
+void RestartHistory::RecordRunning(int64_t nowMs) {
+    if (launches_.empty() || launches_.back().exitMs != 0) {
+        return;
+    }
+    if (nowMs - launches_.back().launchMs >= kCrashLoopWindowMs &&
+        (state_ != State::Closed || early_exits_ != 0)) {
+        Close();
+        Save();
+    }
+}
+
+void RestartHistory::Trip(int64_t nowMs) {
+    trips_++;
+    int shift = trips_ - 1 < 16 ? trips_ - 1 : 16;
+    backoff_ms_ = kBaseBackoffMs << shift;
+    if (backoff_ms_ > kMaxBackoffMs) {
+        backoff_ms_ = kMaxBackoffMs;
+    }
+    // Jitter so a fleet of machines on the same broken build spreads out
+    std::uniform_int_distribution<int64_t> jitter(-backoff_ms_ * kJitterPercent / 100,
+                                                   backoff_ms_ * kJitterPercent / 100);
+    backoff_ms_ += jitter(random_);
+
+    state_ = State::Open;
+    early_exits_ = 0;
+    next_attempt_ms_ = nowMs + backoff_ms_;
+}
+
+void RestartHistory::Close() {
+    state_ = State::Closed;
+    trips_ = 0;
+    early_exits_ = 0;
+    backoff_ms_ = 0;
+    next_attempt_ms_ = 0;
+}
+
+bool RestartHistory::Save() const {
+    if (path_.empty()) {
+        return false;
+    }
+
+    std::string json = "{\n";
+    json += "  \"version\":1,\n";
+    json += std::string("  \"state\":\"") + StateName(state_) + "\",\n";
+    json += "  \"trips\":" + std::to_string(trips_) + ",\n";
+    json += "  \"early_exits\":" + std::to_string(early_exits_) + ",\n";
+    json += "  \"crash_loop_exits\":" + std::to_string(kCrashLoopExits) + ",\n";
+    json += "  \"crash_loop_window_ms\":" + std::to_string(kCrashLoopWindowMs) + ",\n";
+    json += "  \"backoff_ms\":" + std::to_string(backoff_ms_) + ",\n";
+    json += "  \"next_attempt_ms\":" + std::to_string(next_attempt_ms_) + ",\n";
+    json += "  \"launches\":[";
+    for (size_t i = 0; i < launches_.size(); i++) {
+        const Launch& launch = launches_[i];
+        json += i == 0 ? "\n" : ",\n";
+        json += "    {\"launch_ms\":" + std::to_string(launch.launchMs) +
+                ",\"exit_ms\":" + std::to_string(launch.exitMs) +
+                ",\"exit_code\":" + std::to_string(launch.exitCode) + "}";
+    }
+    json += "\n  ]\n}\n";
+
+    // Write a temporary file and rename it over the state so a reader never
+    // sees a partial file
+    NativeString tmpPath = path_ + NATIVE_TEXT(".tmp");
+    FILE* file = OpenFile(tmpPath, true);
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(json.data(), 1, json.size(), file) == json.size();
+    ok = fclose(file) == 0 && ok;
+#ifdef _WIN32
+    ok = ok && MoveFileExW(tmpPath.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+#else
+    ok = ok && rename(tmpPath.c_str(), path_.c_str()) == 0;
+#endif
+    return ok;
+}
@@ -0,0 +1,91 @@
+#ifndef SERVICE_HELPER_RESTART_HISTORY_H_
+#define SERVICE_HELPER_RESTART_HISTORY_H_
+
+#include <cstdint>
+#include <deque>
+#include <random>
+
+#include "platform.h"
+
+// Restart History
+// Remembers the helper's recent app launches across helper restarts and
+// reboots, and stops relaunching an app that keeps dying right after start.
+//
+// A launch that exits within kCrashLoopWindowMs counts as an early exit;
+// kCrashLoopExits of them in a row trip a circuit breaker. While the
+// circuit is open no launch is attempted; after an exponentially growing,
+// jittered backoff one trial launch is allowed (half-open). If it survives
+// the window the circuit closes again, otherwise it re-opens with a longer
+// backoff.
+//
+// The state is written as JSON to RESTART_STATE_FILE next to the lock files
+// so the app (lib/core/services/crash_recovery_service.dart) can read it.
+// All times are wall-clock milliseconds since the Unix epoch.
+
+#define RESTART_STATE_FILE NATIVE_TEXT("service_restart_state.json")
+
+class RestartHistory {
+public:
+    enum class State {
+        Closed,    // Launching normally
+        Open,      // Crash loop, launches suspended until the backoff passes
+        HalfOpen   // One trial launch allowed
+    };
+
+    RestartHistory();
+
+    // Load the persisted state (a missing or unreadable file starts fresh).
+    void Load(const NativeString& path);
+
+    // Whether a launch may be attempted now. If not, waitMs receives the
+    // time until the next trial launch.
+    bool MayLaunch(int64_t nowMs, int64_t* waitMs);
+
+    // Milliseconds until the open circuit allows a trial, -1 if not open.
+    int64_t MsUntilNextAttempt(int64_t nowMs) const;
+
+    void RecordLaunch(int64_t nowMs);
+
+    // Record the exit of the last launched instance. exitCode is -1 when it
+    // could not be read. countsAsCrash is true only for abnormal exits
+    // (non-zero code, killed by a signal, unknown code); it is false for
+    // clean exits, exits the helper caused and a second instance deferring
+    // to a running one.
+    void RecordExit(int64_t nowMs, long long exitCode, bool countsAsCrash);
+
+    // Note that the last launched instance is still running; closes the
+    // circuit once it has survived the crash-loop window.
+    void RecordRunning(int64_t nowMs);
+
+    State state() const { return state_; }
+    int trips() const { return trips_; }
+
+private:
+    static const int kCrashLoopExits = 3;
+    static const int64_t kCrashLoopWindowMs = 2 * 60 * 1000;
+    static const int64_t kBaseBackoffMs = 60 * 1000;
+    static const int64_t kMaxBackoffMs = 60 * 60 * 1000;
+    static const int kJitterPercent = 20;
+    static const size_t kMaxLaunches = 16;  // History kept in the file
+
+    struct Launch {
+        int64_t launchMs;
+        int64_t exitMs;  // 0 while running (or exit not observed)
+        long long exitCode;
+    };
+
+    void Trip(int64_t nowMs);
+    void Close();
+    bool Save() const;
+
+    NativeString path_;
+    State state_;
+    int trips_;        // Consecutive times the circuit opened
+    int early_exits_;  // Consecutive early exits while closed
+    int64_t backoff_ms_;
+    int64_t next_attempt_ms_;
+    std::deque<Launch> launches_;
+    std::mt19937 random_;
+};
+
+#endif  // SERVICE_HELPER_RESTART_HISTORY_H_
@@ -0,0 +1,357 @@
+#include "service_log.h"
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+#ifdef _WIN32
+#include <winioctl.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef SERVICE_HELPER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#endif
+
+// How long the writer sleeps when no append woke it up
+static const int kWriterIdleMs = 250;
+
+ServiceLog& ServiceLog::GetInstance() {
+    static ServiceLog instance;
+    return instance;
+}
+
+ServiceLog::ServiceLog()
+    : enqueue_pos_(0),
+      dequeue_pos_(0),
+      dropped_(0),
+      reported_dropped_(0),
+      max_file_size_(0),
+      compress_rotated_(false),
+      file_size_(0),
+#ifdef _WIN32
+      file_(INVALID_HANDLE_VALUE),
+#else
+      file_(-1),
+#endif
+      cached_second_(-1),
+      running_(false) {
+    for (size_t i = 0; i < kRingCapacity; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    cached_timestamp_[0] = '\0';
+}
+
+ServiceLog::~ServiceLog() {
+    Stop();
+}
+
+bool ServiceLog::Start(const NativeString& path, size_t maxFileSize, bool compressRotated) {
+    if (running_.load()) {
+        return true;
+    }
+
+    path_ = path;
+    max_file_size_ = maxFileSize;
+    compress_rotated_ = compressRotated;
+
+    if (!OpenFile()) {
+        return false;
+    }
+
+    running_.store(true);
+    writer_ = std::thread(&ServiceLog::WriterLoop, this);
+    return true;
+}
+
+void ServiceLog::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    wake_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    CloseFile();
+}
+
+void ServiceLog::Append(const NativeChar* message, size_t length) {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    int64_t timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+
+    // Bounded MPMC ring (Vyukov): claim a slot by advancing enqueue_pos_,
+    // then publish it by bumping the slot's sequence
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots_[pos & (kRingCapacity - 1)];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;  // Full
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    size_t count = length < kMaxRecordChars ? length : kMaxRecordChars;
+    slot->record.timestampMs = timestampMs;
+    slot->record.length = static_cast<uint16_t>(count);
+    memcpy(slot->record.text, message, count * sizeof(NativeChar));
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    // A missed wakeup only delays the write until the idle timeout
+    wake_.notify_one();
+}
+
+bool ServiceLog::Pop(Record* record) {
+    Slot* slot = &slots_[dequeue_pos_ & (kRingCapacity - 1)];
+    size_t seq = slot->sequence.load(std::memory_order_acquire);
+    if (seq != dequeue_pos_ + 1) {
+        return false;  // Empty, or the producer has not published yet
+    }
+
+    record->timestampMs = slot->record.timestampMs;
+    record->length = slot->record.length;
+    memcpy(record->text, slot->record.text, record->length * sizeof(NativeChar));
+
+    slot->sequence.store(dequeue_pos_ + kRingCapacity, std::memory_order_release);
+    dequeue_pos_++;
+    return true;
+}
+
+void ServiceLog::WriterLoop() {
+    std::string batch;
+    batch.reserve(kMaxBatchBytes + 1024);
+    Record record;
+
+    while (true) {
+        bool stopping = !running_.load();
+
+        batch.clear();
+        uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reported_dropped_) {
+            Record note;
+            note.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            std::string text = "Log ring full, dropped " +
+                               std::to_string(dropped - reported_dropped_) + " messages";
+            note.length = static_cast<uint16_t>(text.size());
+            for (size_t i = 0; i < text.size(); i++) {
+                note.text[i] = static_cast<NativeChar>(text[i]);
+            }
+            FormatRecord(note, &batch);
+            reported_dropped_ = dropped;
+        }
+
+        while (batch.size() < kMaxBatchBytes && Pop(&record)) {
+            FormatRecord(record, &batch);
+        }
+
+        if (!batch.empty()) {
+            WriteBatch(batch);
+            continue;  // Drain fully before sleeping
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait_for(lock, std::chrono::milliseconds(kWriterIdleMs));
+    }
+}
+
+void ServiceLog::FormatRecord(const Record& record, std::string* out) {
+    int64_t second = record.timestampMs / 1000;
+    if (second != cached_second_) {
+        time_t now = static_cast<time_t>(second);
+        struct tm timeinfo;
+#ifdef _WIN32
+        localtime_s(&timeinfo, &now);
+#else
+        localtime_r(&now, &timeinfo);
+#endif
+        strftime(cached_timestamp_, sizeof(cached_timestamp_), "%Y-%m-%d %H:%M:%S", &timeinfo);
+        cached_second_ = second;
+    }
+
+    out->push_back('[');
+    out->append(cached_timestamp_);
+    out->append("] ");
+
+#ifdef _WIN32
+    if (record.length > 0) {
+        int bytes = WideCharToMultiByte(CP_UTF8, 0, record.text, record.length,
+                                        nullptr, 0, nullptr, nullptr);
+        if (bytes > 0) {
+            size_t offset = out->size();
+            out->resize(offset + bytes);
+            WideCharToMultiByte(CP_UTF8, 0, record.text, record.length,
+                                &(*out)[offset], bytes, nullptr, nullptr);
+        }
+    }
+    out->append("\r\n");
+#else
+    out->append(record.text, record.length);
+    out->push_back('\n');
+#endif
+}
+
+void ServiceLog::WriteBatch(const std::string& batch) {
+    if (file_size_ > 0 && file_size_ + batch.size() > max_file_size_) {
+        Rotate();
+    }
+
+#ifdef _WIN32
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    DWORD written = 0;
+    if (WriteFile(file_, batch.data(), static_cast<DWORD>(batch.size()), &written, NULL)) {
+        file_size_ += written;
+    }
+#else
+    if (file_ < 0) {
+        return;
+    }
+    size_t offset = 0;
+    while (offset < batch.size()) {
+        ssize_t n = write(file_, batch.data() + offset, batch.size() - offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    file_size_ += offset;
+#endif
+}
+
+bool ServiceLog::OpenFile() {
+#ifdef _WIN32
+    file_ = CreateFileW(path_.c_str(), FILE_APPEND_DATA,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    file_size_ = GetFileSizeEx(file_, &size) ? static_cast<size_t>(size.QuadPart) : 0;
+    if (file_size_ == 0) {
+        // UTF-8 BOM, as the previous ccs=UTF-8 writer produced
+        static const char kBom[] = "\xEF\xBB\xBF";
+        DWORD written = 0;
+        WriteFile(file_, kBom, 3, &written, NULL);
+        file_size_ = written;
+    }
+#else
+    file_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (file_ < 0) {
+        return false;
+    }
+    struct stat st;
+    file_size_ = fstat(file_, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+#endif
+    return true;
+}
+
+void ServiceLog::CloseFile() {
+#ifdef _WIN32
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (file_ >= 0) {
+        close(file_);
+        file_ = -1;
+    }
+#endif
+    file_size_ = 0;
+}
+
+void ServiceLog::Rotate() {
+    NativeString backupPath = path_ + NATIVE_TEXT(".old");
+
+#ifdef _WIN32
+    FlushFileBuffers(file_);
+    CloseFile();
+    // Atomic replace of the previous segment; no delete+move window
+    MoveFileExW(path_.c_str(), backupPath.c_str(),
+                MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    fsync(file_);
+    CloseFile();
+    rename(path_.c_str(), backupPath.c_str());
+#endif
+
+    if (compress_rotated_) {
+        CompressSegment(backupPath);
+    }
+
+    OpenFile();
+}
+
+void ServiceLog::CompressSegment(const NativeString& segmentPath) {
+#ifdef _WIN32
+    // Transparent NTFS compression keeps the segment readable by any tool
+    HANDLE segment = CreateFileW(segmentPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (segment == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    USHORT format = COMPRESSION_FORMAT_DEFAULT;
+    DWORD returned = 0;
+    DeviceIoControl(segment, FSCTL_SET_COMPRESSION, &format, sizeof(format),
+                    NULL, 0, &returned, NULL);
+    CloseHandle(segment);
+#elif defined(SERVICE_HELPER_HAVE_ZLIB)
+    // Write "<log>.old.gz" through a temp file and rename it into place, so a
+    // crash never leaves a truncated archive behind
+    std::string gzPath = segmentPath + ".gz";
+    std::string tmpPath = gzPath + ".tmp";
+
+    int in = open(segmentPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return;
+    }
+    gzFile out = gzopen(tmpPath.c_str(), "wb6");
+    if (out == nullptr) {
+        close(in);
+        return;
+    }
+
+    bool ok = true;
+    char buffer[16 * 1024];
+    ssize_t n;
+    while ((n = read(in, buffer, sizeof(buffer))) > 0) {
+        if (gzwrite(out, buffer, static_cast<unsigned>(n)) != n) {
+            ok = false;
+            break;
+        }
+    }
+    close(in);
+    if (gzclose(out) != Z_OK || n < 0) {
+        ok = false;
+    }
+
+    if (ok && rename(tmpPath.c_str(), gzPath.c_str()) == 0) {
+        unlink(segmentPath.c_str());
+    } else {
+        unlink(tmpPath.c_str());
+    }
+#else
+    (void)segmentPath;
+#endif
+}
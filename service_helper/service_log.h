@@ -0,0 +1,109 @@
+#ifndef SERVICE_HELPER_SERVICE_LOG_H_
+#define SERVICE_HELPER_SERVICE_LOG_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "platform.h"
+
+// Service Log
+// Asynchronous logger for the service helper. Callers copy a fixed-size
+// record into a lock-free ring and return; a background thread batches the
+// records to a file it keeps open, tracking the file size in memory.
+//
+// Rotation is done by the writer thread only, with a single atomic rename
+// of the current file over "<log>.old", so it never races with writes and a
+// crash leaves either the old or the new segment intact. Rotated segments
+// can optionally be compressed (NTFS compression on Windows, gzip on Linux
+// when built with zlib).
+
+class ServiceLog {
+public:
+    static ServiceLog& GetInstance();
+
+    // Open the log file and start the writer thread. Records appended before
+    // Start() are kept in the ring and written once it runs.
+    bool Start(const NativeString& path, size_t maxFileSize, bool compressRotated);
+
+    // Write everything still queued and stop the writer thread.
+    void Stop();
+
+    // Queue a line. Never blocks on I/O; messages longer than a record are
+    // truncated and records are dropped (and counted) if the ring is full.
+    void Append(const NativeChar* message, size_t length);
+    void Append(const NativeString& message) { Append(message.data(), message.size()); }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static const size_t kRingCapacity = 256;     // Must be a power of two
+    static const size_t kMaxRecordChars = 500;
+    static const size_t kMaxBatchBytes = 64 * 1024;
+
+    struct Record {
+        int64_t timestampMs;  // Wall clock, milliseconds since the Unix epoch
+        uint16_t length;
+        NativeChar text[kMaxRecordChars];
+    };
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    ServiceLog();
+    ~ServiceLog();
+
+    // Disable copy
+    ServiceLog(const ServiceLog&) = delete;
+    ServiceLog& operator=(const ServiceLog&) = delete;
+
+    // Single consumer side of the ring
+    bool Pop(Record* record);
+
+    void WriterLoop();
+    void WriteBatch(const std::string& batch);
+    void FormatRecord(const Record& record, std::string* out);
+
+    bool OpenFile();
+    void CloseFile();
+    void Rotate();
+    void CompressSegment(const NativeString& segmentPath);
+
+    Slot slots_[kRingCapacity];
+    std::atomic<size_t> enqueue_pos_;
+    size_t dequeue_pos_;
+    std::atomic<uint64_t> dropped_;
+    uint64_t reported_dropped_;
+
+    NativeString path_;
+    size_t max_file_size_;
+    bool compress_rotated_;
+    size_t file_size_;  // Tracked in memory, never stat-ed per line
+
+#ifdef _WIN32
+    HANDLE file_;
+#else
+    int file_;
+#endif
+
+    // Cached "YYYY-MM-DD HH:MM:SS" for the last second formatted
+    int64_t cached_second_;
+    char cached_timestamp_[32];
+
+    std::thread writer_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> running_;
+};
+
+// Queue a line on the service helper log
+inline void Log(const NativeString& message) {
+    ServiceLog::GetInstance().Append(message);
+}
+
+#endif  // SERVICE_HELPER_SERVICE_LOG_H_
@@ -0,0 +1,493 @@
+#include "supervisor.h"
+
+#include <chrono>
+
+#include "service_log.h"
+
+// Configuration
+const int CHECK_INTERVAL_MS = 2 * 60 * 1000;  // 2 minutes (no app process to watch)
+const int FALLBACK_CHECK_INTERVAL_MS = 15 * 60 * 1000;  // 15 minutes while watching the app
+const int EXIT_SETTLE_MS = 500;  // Let updater/crash-restart lock files land after an exit
+const int READY_TIMEOUT_MS = 60 * 1000;  // Deadline for the first frame after a restart
+const int READY_FALLBACK_DELAY_MS = 5000;  // Startup delay when no readiness signal is usable
+const int HANG_CHECK_INTERVAL_MS = 10 * 1000;  // Heartbeat read while watching the app
+const int LOOP_STALL_THRESHOLD_MS = 60 * 1000;  // Message loop silent this long = hung
+const int FRAME_STALL_THRESHOLD_MS = 90 * 1000;  // Requested frame missing this long = hung
+const unsigned int HUNG_APP_EXIT_CODE = 0xA1DEAD;
+const int RESOURCE_SAMPLE_INTERVAL_MS = 5 * 60 * 1000;  // Leak watchdog sampling
+const int GRACEFUL_EXIT_TIMEOUT_MS = 30 * 1000;  // Before a leak restart turns forceful
+const unsigned int RESOURCE_RESTART_EXIT_CODE = 0xA1FA7;
+const int UPDATE_LOCK_TIMEOUT_MINUTES = 10;
+const int RESTART_LOCK_TIMEOUT_SECONDS = 30;
+
+// Wall clock for the persisted restart history
+static int64_t WallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+Supervisor::Supervisor(const SupervisorConfig& config)
+    : config_(config),
+      update_lock_(-1),
+      restart_lock_(-1),
+      installer_matcher_(config.installerNames),
+      next_resource_sample_ms_(0),
+      last_seen_running_ms_(0),
+      down_since_ms_(0)
+#ifdef _WIN32
+      , shutdown_event_(NULL)
+#else
+      , epoll_fd_(-1),
+      timer_fd_(-1),
+      signal_fd_(-1)
+#endif
+{
+}
+
+Supervisor::~Supervisor() {
+    StopPlatform();
+    locks_.Stop();
+}
+
+bool Supervisor::Start() {
+    // A finished update should relaunch the app right away; the restart lock
+    // is also ours, so its release is not a reason to wake up
+    update_lock_ = locks_.AddLock(UPDATE_LOCK_FILE, UPDATE_LOCK_TIMEOUT_MINUTES * 60 * 1000LL, true);
+    restart_lock_ = locks_.AddLock(RESTART_LOCK_FILE, RESTART_LOCK_TIMEOUT_SECONDS * 1000LL, false);
+    if (!locks_.Start(config_.dataDir)) {
+        Log(NATIVE_TEXT("Could not watch app data directory, lock files will be polled"));
+    }
+    resources_.SetBudget(config_.resourceBudget);
+    history_.Load(config_.dataDir + NATIVE_PATH_SEPARATOR + RESTART_STATE_FILE);
+    if (!stats_.Open(config_.dataDir + NATIVE_PATH_SEPARATOR + STATS_FILE)) {
+        Log(NATIVE_TEXT("Could not open the stats file, stats are kept in memory only"));
+    }
+    return StartPlatform();
+}
+
+void Supervisor::Run() {
+    // Sleeps on the app's process while it is healthy and only falls back to
+    // timed checks when there is nothing to watch
+    do {
+        PerformCheck();
+    } while (WaitForNextCheck());
+}
+
+// Perform the availability check
+void Supervisor::PerformCheck() {
+    Log(NATIVE_TEXT("Performing availability check..."));
+
+    // Recovery waits for the relaunched app, so it is not part of the
+    // check's own duration
+    int64_t checkStart = MonotonicMs();
+    bool recover = IsRecoveryNeeded();
+    stats_.Record(kStatsCheckDuration, MonotonicMs() - checkStart);
+
+    if (recover) {
+        RecoverApp();
+    }
+}
+
+// Returns true if the app has to be relaunched
+bool Supervisor::IsRecoveryNeeded() {
+    // Query both locks up front so stale ones are always cleaned up
+    bool updateInProgress = IsUpdateInProgress();
+    bool restartPending = IsRestartPending();
+
+    // Check if update is in progress
+    if (updateInProgress) {
+        Log(NATIVE_TEXT("Update in progress, skipping check"));
+        return false;
+    }
+
+    // Check if a restart is already pending
+    if (restartPending) {
+        Log(NATIVE_TEXT("Restart already pending, skipping"));
+        return false;
+    }
+
+    // One process table walk serves both the installer and the app checks
+    if (!CaptureSnapshot()) {
+        Log(NATIVE_TEXT("Failed to capture process list"));
+    }
+
+    // Check if the installer is running
+    if (IsInstallerRunning(snapshot_)) {
+        Log(NATIVE_TEXT("Installer is running, skipping check"));
+        return false;
+    }
+
+    // Check if app is running
+    if (!IsAppRunning(snapshot_)) {
+        Log(NATIVE_TEXT("App is NOT running, initiating recovery..."));
+        if (down_since_ms_ == 0) {
+            // Not seen by a watch; it went away at some point after we last
+            // saw it, so the detection time is an upper bound
+            int64_t now = MonotonicMs();
+            if (last_seen_running_ms_ != 0) {
+                stats_.Record(kStatsDetectExit, now - last_seen_running_ms_);
+                down_since_ms_ = last_seen_running_ms_;
+            } else {
+                down_since_ms_ = now;
+            }
+        }
+        return true;
+    }
+
+    Log(NATIVE_TEXT("App is running normally"));
+    // Back after an outage we did not recover from ourselves (in-app crash
+    // recovery, the user, the updater)
+    NoteAppUsable();
+    history_.RecordRunning(WallClockMs());
+    WatchApp(snapshot_);
+    return false;
+}
+
+bool Supervisor::CaptureSnapshot() {
+    int64_t start = MonotonicMs();
+    bool ok = snapshot_.Capture();
+    stats_.Record(kStatsSnapshotDuration, MonotonicMs() - start);
+    return ok;
+}
+
+// The app is running (and usable, as far as we can tell): close the open
+// downtime incident, if any
+void Supervisor::NoteAppUsable() {
+    int64_t now = MonotonicMs();
+    if (down_since_ms_ != 0) {
+        stats_.Record(kStatsDowntime, now - down_since_ms_);
+        down_since_ms_ = 0;
+    }
+    last_seen_running_ms_ = now;
+}
+
+// Attach the exit watcher to the running app if we are not watching it yet
+void Supervisor::WatchApp(const ProcessSnapshot& snapshot) {
+    if (app_watch_.IsAttached()) {
+        return;
+    }
+
+    ProcessId pid = FindAppProcessId(snapshot);
+    if (pid == 0 || !app_watch_.Attach(pid)) {
+        Log(NATIVE_TEXT("Could not open app process for watching, using timed checks"));
+        return;
+    }
+
+    Log(NATIVE_TEXT("Watching app process (PID: ") + ToNativeString(pid) + NATIVE_TEXT(")"));
+}
+
+// Block until the next check is due. That is the earliest of: the watched
+// app exiting, a lock file being released, a held lock going stale, or the
+// timed check (fallback interval while watching, check interval otherwise).
+// While watching, the wait is sliced so the app's heartbeat can be checked.
+bool Supervisor::WaitForNextCheck() {
+    bool watching = app_watch_.IsAttached();
+    ProcessId pid = app_watch_.pid();
+    int64_t deadline = MonotonicMs() +
+        (watching ? FALLBACK_CHECK_INTERVAL_MS : CHECK_INTERVAL_MS);
+
+    while (true) {
+        int64_t now = MonotonicMs();
+        if (now >= deadline) {
+            return true;  // Timed check, the watch stays attached
+        }
+
+        int64_t timeout = deadline - now;
+        if (watching && timeout > HANG_CHECK_INTERVAL_MS) {
+            timeout = HANG_CHECK_INTERVAL_MS;
+        }
+        int64_t expiry = locks_.MsUntilNextExpiry();
+        bool expiryWake = expiry >= 0 && expiry < timeout;
+        if (expiryWake) {
+            timeout = expiry + 1;
+        }
+        // Relaunch as soon as a crash-loop backoff has passed
+        int64_t backoff = watching ? -1 : history_.MsUntilNextAttempt(WallClockMs());
+        bool backoffWake = backoff >= 0 && backoff < timeout;
+        if (backoffWake) {
+            timeout = backoff + 1;
+            expiryWake = true;
+        }
+
+        switch (WaitForEvent(timeout)) {
+            case WakeReason::Timeout:
+                if (watching) {
+                    last_seen_running_ms_ = MonotonicMs();
+                }
+                if (expiryWake) {
+                    return true;  // A lock went stale or a backoff ended, check now
+                }
+                if (watching && !CheckForHang() && CheckResources()) {
+                    return true;  // Restarted for leaking, relaunch now
+                }
+                continue;
+
+            case WakeReason::LocksChanged:
+                if (locks_.Poll()) {
+                    Log(NATIVE_TEXT("Lock file released, checking now"));
+                    return true;
+                }
+                continue;
+
+            case WakeReason::AppExited: {
+                // Also reaps the app on Linux when we launched it
+                unsigned long exitCode = 0;
+                NativeString detail;
+                long long recordedCode = -1;
+                if (app_watch_.GetExitCode(&exitCode)) {
+                    recordedCode = static_cast<long long>(exitCode);
+                    detail = NATIVE_TEXT(", exit code: ") + ToNativeString(recordedCode);
+                }
+                // A clean exit (code 0) is the user closing the app; anything
+                // else, a signal or an unknown code counts toward the breaker
+                history_.RecordExit(WallClockMs(), recordedCode, recordedCode != 0);
+
+                // An exit signalled through the watch is seen as it happens
+                // unless the OS can tell us exactly when it was
+                int64_t exitedAtMs = 0;
+                int64_t detectMs = 0;
+                if (app_watch_.GetExitTime(&exitedAtMs)) {
+                    detectMs = WallClockMs() - exitedAtMs;
+                }
+                stats_.Record(kStatsDetectExit, detectMs);
+                down_since_ms_ = MonotonicMs() - detectMs;
+                Log(NATIVE_TEXT("App process exited (PID: ") + ToNativeString(pid) + detail +
+                    NATIVE_TEXT("), checking now"));
+                app_watch_.Detach();
+                heartbeat_.Close();
+                SleepMs(EXIT_SETTLE_MS);
+                locks_.Poll();
+                return true;
+            }
+
+            case WakeReason::Stop:
+                Log(NATIVE_TEXT("Stop requested"));
+                return false;
+
+            case WakeReason::Error:
+                Log(NATIVE_TEXT("Waiting for events failed, falling back to timed checks"));
+                app_watch_.Detach();
+                heartbeat_.Close();
+                SleepMs(CHECK_INTERVAL_MS);
+                return true;
+        }
+    }
+}
+
+// Read the app's shared-memory heartbeat and terminate it if it is hung.
+// The exit then wakes the watch and the normal recovery path relaunches it.
+bool Supervisor::CheckForHang() {
+    if (!heartbeat_.IsOpen() && !heartbeat_.Open(app_watch_.pid())) {
+        return false;  // Older build without a heartbeat, or not published yet
+    }
+
+    int64_t stalledForMs = 0;
+    HeartbeatMonitor::Status status =
+        heartbeat_.Check(LOOP_STALL_THRESHOLD_MS, FRAME_STALL_THRESHOLD_MS, &stalledForMs);
+    if (status != HeartbeatMonitor::Status::LoopStalled &&
+        status != HeartbeatMonitor::Status::FrameStalled) {
+        return false;
+    }
+
+    Log(NATIVE_TEXT("App is hung (") +
+        NativeString(status == HeartbeatMonitor::Status::LoopStalled
+                         ? NATIVE_TEXT("message loop") : NATIVE_TEXT("frame")) +
+        NATIVE_TEXT(" stalled for ") + ToNativeString(stalledForMs) +
+        NATIVE_TEXT(" ms), terminating PID ") + ToNativeString(app_watch_.pid()));
+
+    if (!app_watch_.Terminate(HUNG_APP_EXIT_CODE)) {
+        Log(NATIVE_TEXT("Failed to terminate hung app"));
+        return false;
+    }
+    return true;
+}
+
+// Sample the watched app's memory, handles and threads every few minutes
+// and restart it through the normal recovery path once it is over budget.
+bool Supervisor::CheckResources() {
+    int64_t now = MonotonicMs();
+    if (now < next_resource_sample_ms_) {
+        return false;
+    }
+    next_resource_sample_ms_ = now + RESOURCE_SAMPLE_INTERVAL_MS;
+
+    NativeString reason;
+    ResourceMonitor::Verdict verdict = resources_.Sample(app_watch_.pid(), now, &reason);
+    if (verdict != ResourceMonitor::Verdict::OverBudget &&
+        verdict != ResourceMonitor::Verdict::Leaking) {
+        return false;
+    }
+
+    Log(NATIVE_TEXT("App exceeded its resource budget (") + reason +
+        NATIVE_TEXT("), restarting PID ") + ToNativeString(app_watch_.pid()));
+    StopAppGracefully(RESOURCE_RESTART_EXIT_CODE);
+    return true;
+}
+
+void Supervisor::StopAppGracefully(unsigned int exitCode) {
+    if (!RequestGracefulExit() ||
+        app_watch_.Wait(GRACEFUL_EXIT_TIMEOUT_MS) != ProcessWatch::WaitResult::Exited) {
+        Log(NATIVE_TEXT("App did not exit on request, terminating it"));
+        app_watch_.Terminate(exitCode);
+        app_watch_.Wait(GRACEFUL_EXIT_TIMEOUT_MS);
+    }
+    ClearGracefulExitRequest();
+    down_since_ms_ = MonotonicMs();
+    history_.RecordExit(WallClockMs(), static_cast<long long>(exitCode), false);
+    app_watch_.Detach();
+    heartbeat_.Close();
+    resources_.Reset();
+}
+
+// Check if an update is in progress
+bool Supervisor::IsUpdateInProgress() {
+    switch (locks_.Query(update_lock_)) {
+        case LockTracker::State::Held:
+            Log(NATIVE_TEXT("Update in progress detected"));
+            return true;
+        case LockTracker::State::Stale:
+            Log(NATIVE_TEXT("Update lock file is stale, removing"));
+            return false;
+        default:
+            return false;
+    }
+}
+
+// Check if a restart is pending
+bool Supervisor::IsRestartPending() {
+    switch (locks_.Query(restart_lock_)) {
+        case LockTracker::State::Held:
+            return true;
+        case LockTracker::State::Stale:
+            Log(NATIVE_TEXT("Restart lock file is stale, removing"));
+            return false;
+        default:
+            return false;
+    }
+}
+
+// Check if installer is running
+bool Supervisor::IsInstallerRunning(const ProcessSnapshot& snapshot) {
+    const ProcessEntry* installer = snapshot.FindMatching(installer_matcher_);
+    if (installer != nullptr) {
+        Log(NATIVE_TEXT("Found installer process running: ") + installer->exeName);
+        return true;
+    }
+    return false;
+}
+
+// Check if the app is running
+bool Supervisor::IsAppRunning(const ProcessSnapshot& snapshot) {
+    // Method 1: Check via mutex
+    if (IsAppMutexHeld()) {
+        Log(NATIVE_TEXT("App detected via mutex"));
+        return true;
+    }
+
+    // Method 2: Check via process list
+    if (snapshot.FindByName(config_.appExeName) != nullptr) {
+        Log(NATIVE_TEXT("App detected via process list"));
+        return true;
+    }
+
+    Log(NATIVE_TEXT("App not detected by any method"));
+    return false;
+}
+
+// Find the PID of the running app, 0 if not found
+ProcessId Supervisor::FindAppProcessId(const ProcessSnapshot& snapshot) {
+    const ProcessEntry* app = snapshot.FindByName(config_.appExeName);
+    return app != nullptr ? app->pid : 0;
+}
+
+// Recover/restart the app
+void Supervisor::RecoverApp() {
+    // Don't keep paying the full startup cost for a build that crashes at start
+    int64_t waitMs = 0;
+    if (!history_.MayLaunch(WallClockMs(), &waitMs)) {
+        Log(NATIVE_TEXT("App is crash-looping (") + ToNativeString(history_.trips()) +
+            NATIVE_TEXT(" trips), next launch attempt in ") +
+            ToNativeString(waitMs / 1000) + NATIVE_TEXT(" s"));
+        return;
+    }
+    if (history_.state() == RestartHistory::State::HalfOpen) {
+        Log(NATIVE_TEXT("Crash-loop backoff over, trying one launch"));
+    }
+
+    CreateRestartLock();
+
+    // Check if executable exists
+    if (!AppExecutableExists()) {
+        Log(NATIVE_TEXT("App executable not found at: ") + config_.appPath);
+        RemoveRestartLock();
+        return;
+    }
+
+    Log(NATIVE_TEXT("Starting app: ") + config_.appPath);
+
+    // Arm the first-frame signal before the runner can fire it
+    if (!ready_signal_.Arm()) {
+        Log(NATIVE_TEXT("Failed to create readiness signal, falling back to process check"));
+    }
+
+    bool launched = LaunchApp();
+    // The process now exists and is found through the snapshot; holding the
+    // lock through the readiness wait (up to READY_TIMEOUT_MS) would outlast
+    // its own RESTART_LOCK_TIMEOUT_SECONDS and let another restarter take it
+    // for abandoned
+    RemoveRestartLock();
+    if (!launched) {
+        return;
+    }
+
+    int64_t launchMs = MonotonicMs();
+    history_.RecordLaunch(WallClockMs());
+    Log(NATIVE_TEXT("App started with PID: ") + ToNativeString(app_watch_.pid()));
+
+    // Wait for the runner to report its first frame (or for the app to die)
+    ReadinessSignal::WaitResult ready = ready_signal_.Wait(app_watch_, READY_TIMEOUT_MS);
+    int64_t elapsedMs = MonotonicMs() - launchMs;
+
+    switch (ready) {
+        case ReadinessSignal::WaitResult::Ready:
+            Log(NATIVE_TEXT("App recovery successful, first frame after ") +
+                ToNativeString(elapsedMs) + NATIVE_TEXT(" ms"));
+            stats_.Record(kStatsFirstFrame, elapsedMs);
+            NoteAppUsable();
+            break;
+        case ReadinessSignal::WaitResult::Exited: {
+            unsigned long exitCode = 0;
+            long long recordedCode = -1;
+            if (app_watch_.GetExitCode(&exitCode)) {
+                recordedCode = static_cast<long long>(exitCode);
+            }
+            Log(NATIVE_TEXT("App exited during startup after ") + ToNativeString(elapsedMs) +
+                NATIVE_TEXT(" ms, exit code: ") + ToNativeString(recordedCode));
+            // Don't spin on an app that dies at startup; the next check is a timed one
+            app_watch_.Detach();
+            // A second instance exits right away if one is already running
+            CaptureSnapshot();
+            bool deferred = IsAppRunning(snapshot_);
+            if (deferred) {
+                Log(NATIVE_TEXT("Another app instance is running"));
+                NoteAppUsable();
+            }
+            history_.RecordExit(WallClockMs(), recordedCode, !deferred && recordedCode != 0);
+            break;
+        }
+        case ReadinessSignal::WaitResult::Error:
+            // No usable signal, give the app the old fixed startup delay
+            SleepMs(READY_FALLBACK_DELAY_MS);
+            // Fall through
+        case ReadinessSignal::WaitResult::Timeout:
+            // Old builds without the handshake end up here; verify the old way
+            CaptureSnapshot();
+            if (IsAppRunning(snapshot_)) {
+                Log(NATIVE_TEXT("App is running but did not report a first frame"));
+                NoteAppUsable();
+            } else {
+                Log(NATIVE_TEXT("App may not have started properly"));
+            }
+            break;
+    }
+}
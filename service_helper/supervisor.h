@@ -0,0 +1,136 @@
+#ifndef SERVICE_HELPER_SUPERVISOR_H_
+#define SERVICE_HELPER_SUPERVISOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "heartbeat_monitor.h"
+#include "lock_tracker.h"
+#include "platform.h"
+#include "process_snapshot.h"
+#include "process_watch.h"
+#include "readiness_signal.h"
+#include "resource_monitor.h"
+#include "restart_history.h"
+#include "supervisor_stats.h"
+
+// Supervisor
+// Portable core of the service helper: the availability check, app
+// recovery, hang detection and lock file handling. Everything that talks to
+// the OS beyond the shared modules is a small set of hooks implemented per
+// platform:
+//
+//   Windows: supervisor_win.cpp   - WaitForMultipleObjects over the lock
+//            change event and the app's process handle; CreateProcessW.
+//   Linux:   supervisor_linux.cpp - one epoll loop over the inotify fd, the
+//            app's pidfd, a timerfd for the next deadline and a signalfd for
+//            SIGTERM/SIGINT; posix_spawn.
+
+// Lock files in SupervisorConfig::dataDir; the updater and the app's crash
+// recovery create them too
+#define UPDATE_LOCK_FILE NATIVE_TEXT(".update_in_progress")
+#define RESTART_LOCK_FILE NATIVE_TEXT(".restart_pending")
+
+struct SupervisorConfig {
+    NativeString dataDir;     // App data directory holding the lock files
+    NativeString appPath;     // Executable launched on recovery
+    NativeString appExeName;  // Process name used to find the running app
+    std::vector<NativeString> installerNames;  // Substrings, case-insensitive
+    ResourceBudget resourceBudget;  // Leak budgets, all zero to disable
+};
+
+class Supervisor {
+public:
+    explicit Supervisor(const SupervisorConfig& config);
+    ~Supervisor();
+
+    // Start watching the lock files and set up the platform wait set.
+    bool Start();
+
+    // Run one availability check and recover the app if needed.
+    void PerformCheck();
+
+    // Check, then sleep until the next check is due, until a stop is
+    // requested (SIGTERM/SIGINT on Linux) or waiting fails for good.
+    void Run();
+
+private:
+    enum class WakeReason {
+        Timeout,       // The requested timeout elapsed
+        LocksChanged,  // Lock directory notifications are pending
+        AppExited,     // The watched app process exited
+        Stop,          // Shutdown requested
+        Error
+    };
+
+    // Disable copy
+    Supervisor(const Supervisor&) = delete;
+    Supervisor& operator=(const Supervisor&) = delete;
+
+    bool IsRecoveryNeeded();
+    bool CaptureSnapshot();
+    void NoteAppUsable();
+    void WatchApp(const ProcessSnapshot& snapshot);
+    // Returns false when the supervisor should stop.
+    bool WaitForNextCheck();
+    bool CheckForHang();
+    // Sample the app's resources when due; returns true if it was restarted
+    // for exceeding its budget.
+    bool CheckResources();
+    // Ask the app to exit, terminating it if it does not in time.
+    void StopAppGracefully(unsigned int exitCode);
+    void RecoverApp();
+    bool IsUpdateInProgress();
+    bool IsRestartPending();
+    bool IsInstallerRunning(const ProcessSnapshot& snapshot);
+    bool IsAppRunning(const ProcessSnapshot& snapshot);
+    ProcessId FindAppProcessId(const ProcessSnapshot& snapshot);
+
+    // Platform hooks
+    bool StartPlatform();
+    void StopPlatform();
+    // Block until one of the wait sources fires or timeoutMs elapses.
+    WakeReason WaitForEvent(int64_t timeoutMs);
+    // Single-instance mutex held by the running app (Windows only).
+    bool IsAppMutexHeld();
+    bool AppExecutableExists();
+    // Ask the running app to shut down cleanly (named event on Windows,
+    // SIGTERM on Linux).
+    bool RequestGracefulExit();
+    // Withdraw the request once the app is gone, so no later instance sees it.
+    void ClearGracefulExitRequest();
+    // Launch the app for recovery and adopt it into app_watch_.
+    bool LaunchApp();
+    void CreateRestartLock();
+    void RemoveRestartLock();
+    static int64_t MonotonicMs();
+    static void SleepMs(int64_t ms);
+
+    SupervisorConfig config_;
+    ProcessWatch app_watch_;
+    ReadinessSignal ready_signal_;
+    HeartbeatMonitor heartbeat_;
+    LockTracker locks_;  // In-memory lock file state, fed by directory notifications
+    int update_lock_;
+    int restart_lock_;
+    ProcessSnapshot snapshot_;  // Captured once per check, shared by all queries
+    PatternMatcher installer_matcher_;
+    ResourceMonitor resources_;
+    int64_t next_resource_sample_ms_;
+    RestartHistory history_;  // Crash-loop circuit breaker for our launches
+    SupervisorStats stats_;
+    int64_t last_seen_running_ms_;  // Monotonic, 0 if never seen
+    int64_t down_since_ms_;         // Start of the open downtime incident, 0 if none
+
+#ifdef _WIN32
+    HANDLE shutdown_event_;  // Created on the first graceful exit request
+#endif
+
+#ifndef _WIN32
+    int epoll_fd_;
+    int timer_fd_;
+    int signal_fd_;
+#endif
+};
+
+#endif  // SERVICE_HELPER_SUPERVISOR_H_
@@ -0,0 +1,259 @@
+// Linux hooks of the Supervisor (see supervisor.h)
+
+#include "supervisor.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <ctime>
+#include <vector>
+
+#include "service_log.h"
+
+extern char** environ;
+
+// Probe interval for the app when the kernel has no pidfd support
+static const int64_t kLegacyProbeIntervalMs = 1000;
+
+// epoll user data identifying each wait source
+enum EpollSource : uint64_t {
+    kSourceLocks = 1,
+    kSourceTimer,
+    kSourceSignal,
+    kSourceApp
+};
+
+static void FillStopSignals(sigset_t* set) {
+    sigemptyset(set);
+    sigaddset(set, SIGTERM);
+    sigaddset(set, SIGINT);
+}
+
+static bool AddToEpoll(int epollFd, int fd, uint64_t source) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = source;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0 || errno == EEXIST;
+}
+
+static void DrainFd(int fd, size_t size) {
+    char buffer[sizeof(struct signalfd_siginfo)];
+    while (read(fd, buffer, size) > 0) {
+    }
+}
+
+bool Supervisor::StartPlatform() {
+    StopPlatform();
+
+    // The stop signals must already be blocked in every thread (the entry
+    // point does so before starting the log writer); blocking them here again
+    // only covers this thread
+    sigset_t stopSignals;
+    FillStopSignals(&stopSignals);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    signal_fd_ = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (epoll_fd_ < 0 || timer_fd_ < 0 || signal_fd_ < 0 ||
+        !AddToEpoll(epoll_fd_, timer_fd_, kSourceTimer) ||
+        !AddToEpoll(epoll_fd_, signal_fd_, kSourceSignal)) {
+        Log("Failed to set up the event loop");
+        StopPlatform();
+        return false;
+    }
+    if (locks_.fd() >= 0) {
+        AddToEpoll(epoll_fd_, locks_.fd(), kSourceLocks);
+    }
+    return true;
+}
+
+void Supervisor::StopPlatform() {
+    int* fds[] = { &epoll_fd_, &timer_fd_, &signal_fd_ };
+    for (int* fd : fds) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+Supervisor::WakeReason Supervisor::WaitForEvent(int64_t timeoutMs) {
+    if (epoll_fd_ < 0) {
+        return WakeReason::Error;
+    }
+
+    if (!app_watch_.IsAttached()) {
+        // Reap earlier launches we stopped watching so they do not linger as
+        // zombies (the process snapshot ignores them either way)
+        while (waitpid(-1, nullptr, WNOHANG) > 0) {
+        }
+    }
+
+    // A closed pidfd drops out of the epoll set by itself, so only the
+    // current one ever needs to be added (EEXIST if it already is)
+    int appFd = app_watch_.IsAttached() ? app_watch_.fd() : -1;
+    if (appFd >= 0 && !AddToEpoll(epoll_fd_, appFd, kSourceApp)) {
+        return WakeReason::Error;
+    }
+    bool probeApp = app_watch_.IsAttached() && appFd < 0;
+
+    int64_t deadline = MonotonicMs() + timeoutMs;
+    while (true) {
+        int64_t remaining = deadline - MonotonicMs();
+        if (remaining <= 0) {
+            return WakeReason::Timeout;
+        }
+        if (probeApp && remaining > kLegacyProbeIntervalMs) {
+            remaining = kLegacyProbeIntervalMs;
+        }
+
+        // it_value of zero would disarm the timer
+        struct itimerspec spec;
+        memset(&spec, 0, sizeof(spec));
+        spec.it_value.tv_sec = remaining / 1000;
+        spec.it_value.tv_nsec = (remaining % 1000) * 1000000;
+        if (timerfd_settime(timer_fd_, 0, &spec, nullptr) != 0) {
+            return WakeReason::Error;
+        }
+
+        struct epoll_event events[4];
+        int count = epoll_wait(epoll_fd_, events, 4, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return WakeReason::Error;
+        }
+
+        // Report the most important source first
+        bool stop = false, exited = false, locks = false;
+        for (int i = 0; i < count; i++) {
+            switch (events[i].data.u64) {
+                case kSourceSignal: stop = true; break;
+                case kSourceApp: exited = true; break;
+                case kSourceLocks: locks = true; break;
+                default: break;
+            }
+        }
+        DrainFd(timer_fd_, sizeof(uint64_t));
+
+        if (stop) {
+            DrainFd(signal_fd_, sizeof(struct signalfd_siginfo));
+            return WakeReason::Stop;
+        }
+        if (exited || (probeApp && app_watch_.Wait(0) == ProcessWatch::WaitResult::Exited)) {
+            return WakeReason::AppExited;
+        }
+        if (locks) {
+            return WakeReason::LocksChanged;
+        }
+    }
+}
+
+bool Supervisor::IsAppMutexHeld() {
+    return false;  // The Linux runner has no named single-instance mutex
+}
+
+bool Supervisor::AppExecutableExists() {
+    return access(config_.appPath.c_str(), X_OK) == 0;
+}
+
+bool Supervisor::RequestGracefulExit() {
+    // The runner quits its GApplication on SIGTERM
+    return app_watch_.IsAttached() && kill(app_watch_.pid(), SIGTERM) == 0;
+}
+
+void Supervisor::ClearGracefulExitRequest() {}
+
+bool Supervisor::LaunchApp() {
+    std::string autoStart = "--auto-start";
+    std::string serviceRestart = "--service-restart";
+    std::string appPath = config_.appPath;
+    char* argv[] = { &appPath[0], &autoStart[0], &serviceRestart[0], nullptr };
+
+    // Hand the readiness eventfd to the runner through the environment
+    std::string readyVar;
+    std::vector<char*> envp;
+    for (char** env = environ; *env != nullptr; env++) {
+        if (strncmp(*env, READY_FD_ENV_VAR "=", sizeof(READY_FD_ENV_VAR)) != 0) {
+            envp.push_back(*env);
+        }
+    }
+    if (ready_signal_.childFd() >= 0) {
+        readyVar = std::string(READY_FD_ENV_VAR "=") + std::to_string(ready_signal_.childFd());
+        envp.push_back(&readyVar[0]);
+    }
+    envp.push_back(nullptr);
+
+    // New session so the app outlives the helper's terminal or unit, with
+    // the stop signals we block here unblocked again
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t emptyMask;
+    sigemptyset(&emptyMask);
+    posix_spawnattr_setsigmask(&attr, &emptyMask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK);
+
+    pid_t pid = 0;
+    int rc = posix_spawn(&pid, appPath.c_str(), nullptr, &attr, argv, envp.data());
+    posix_spawnattr_destroy(&attr);
+    if (rc != 0) {
+        Log("Failed to start app, error: " + std::string(strerror(rc)));
+        return false;
+    }
+
+    // Keep a pidfd so the main loop can wait on its exit
+    if (!app_watch_.Attach(pid)) {
+        Log("Could not open app process for watching, using timed checks");
+    }
+    return true;
+}
+
+// Create restart lock file
+void Supervisor::CreateRestartLock() {
+    std::string lockPath = config_.dataDir + "/" + RESTART_LOCK_FILE;
+
+    int fd = open(lockPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+        // Write timestamp
+        char buffer[64];
+        int length = snprintf(buffer, sizeof(buffer), "{\"timestamp\":%lld,\"pid\":%ld}",
+                              (long long)time(nullptr), (long)getpid());
+        if (write(fd, buffer, length) < 0) {
+            Log("Failed to write restart lock file");
+        }
+        close(fd);
+    }
+}
+
+// Remove restart lock file
+void Supervisor::RemoveRestartLock() {
+    std::string lockPath = config_.dataDir + "/" + RESTART_LOCK_FILE;
+    unlink(lockPath.c_str());
+}
+
+int64_t Supervisor::MonotonicMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+void Supervisor::SleepMs(int64_t ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
@@ -0,0 +1,152 @@
+#include "supervisor_stats.h"
+
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const uint64_t kBucketUpperMs[kStatsBucketCount] = {
+    1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 120000,
+    UINT64_MAX
+};
+
+static int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+#ifdef _WIN32
+SupervisorStats::SupervisorStats() : file_(INVALID_HANDLE_VALUE) {
+    Reset();
+}
+#else
+SupervisorStats::SupervisorStats() : file_(-1) {
+    Reset();
+}
+#endif
+
+SupervisorStats::~SupervisorStats() {
+    Close();
+}
+
+void SupervisorStats::Reset() {
+    memset(&header_, 0, sizeof(header_));
+    memset(histograms_, 0, sizeof(histograms_));
+    header_.magic = kStatsMagic;
+    header_.version = kStatsVersion;
+    header_.metricCount = kStatsMetricCount;
+    header_.bucketCount = kStatsBucketCount;
+    header_.createdMs = NowMs();
+    memcpy(header_.bucketUpperMs, kBucketUpperMs, sizeof(kBucketUpperMs));
+}
+
+bool SupervisorStats::Open(const NativeString& path) {
+    Close();
+
+    StatsFileHeader header;
+    StatsHistogram histograms[kStatsMetricCount];
+    uint64_t trailer = 0;
+
+#ifdef _WIN32
+    file_ = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    DWORD read1 = 0, read2 = 0, read3 = 0;
+    bool loaded = ReadFile(file_, &header, sizeof(header), &read1, NULL) &&
+                  ReadFile(file_, histograms, sizeof(histograms), &read2, NULL) &&
+                  ReadFile(file_, &trailer, sizeof(trailer), &read3, NULL) &&
+                  read1 == sizeof(header) && read2 == sizeof(histograms) &&
+                  read3 == sizeof(trailer);
+#else
+    file_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (file_ < 0) {
+        return false;
+    }
+    bool loaded = pread(file_, &header, sizeof(header), 0) == sizeof(header) &&
+                  pread(file_, histograms, sizeof(histograms), sizeof(header)) ==
+                      static_cast<ssize_t>(sizeof(histograms)) &&
+                  pread(file_, &trailer, sizeof(trailer), sizeof(header) + sizeof(histograms)) ==
+                      sizeof(trailer);
+#endif
+
+    // Keep the counts of an intact file with the same layout, start over
+    // otherwise
+    if (loaded && header.magic == kStatsMagic && header.version == kStatsVersion &&
+        header.metricCount == kStatsMetricCount && header.bucketCount == kStatsBucketCount &&
+        trailer == header.sequence &&
+        memcmp(header.bucketUpperMs, kBucketUpperMs, sizeof(kBucketUpperMs)) == 0) {
+        header_ = header;
+        memcpy(histograms_, histograms, sizeof(histograms_));
+    } else {
+        Reset();
+    }
+    return Write();
+}
+
+void SupervisorStats::Close() {
+#ifdef _WIN32
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (file_ >= 0) {
+        close(file_);
+        file_ = -1;
+    }
+#endif
+}
+
+void SupervisorStats::Record(StatsMetric metric, int64_t valueMs) {
+    if (metric < 0 || metric >= kStatsMetricCount) {
+        return;
+    }
+    uint64_t value = valueMs > 0 ? static_cast<uint64_t>(valueMs) : 0;
+
+    StatsHistogram& histogram = histograms_[metric];
+    histogram.count++;
+    histogram.sumMs += value;
+    if (value > histogram.maxMs) {
+        histogram.maxMs = value;
+    }
+    uint32_t bucket = 0;
+    while (value > kBucketUpperMs[bucket]) {
+        bucket++;  // The last bound is UINT64_MAX, so this always stops
+    }
+    histogram.buckets[bucket]++;
+
+    Write();
+}
+
+bool SupervisorStats::Write() {
+    header_.sequence++;
+    header_.updatedMs = NowMs();
+
+    // One write of the whole image at offset 0; readers detect a torn read
+    // by comparing the header and trailer sequence numbers
+    char image[sizeof(StatsFileHeader) + sizeof(histograms_) + sizeof(uint64_t)];
+    memcpy(image, &header_, sizeof(header_));
+    memcpy(image + sizeof(header_), histograms_, sizeof(histograms_));
+    memcpy(image + sizeof(header_) + sizeof(histograms_), &header_.sequence, sizeof(uint64_t));
+
+#ifdef _WIN32
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    OVERLAPPED at;
+    memset(&at, 0, sizeof(at));
+    DWORD written = 0;
+    return WriteFile(file_, image, sizeof(image), &written, &at) && written == sizeof(image);
+#else
+    if (file_ < 0) {
+        return false;
+    }
+    return pwrite(file_, image, sizeof(image), 0) == static_cast<ssize_t>(sizeof(image));
+#endif
+}
@@ -0,0 +1,91 @@
+#ifndef SERVICE_HELPER_SUPERVISOR_STATS_H_
+#define SERVICE_HELPER_SUPERVISOR_STATS_H_
+
+#include <cstdint>
+
+#include "platform.h"
+
+// Supervisor Stats
+// Fixed-bucket latency histograms kept in a small binary file next to the
+// lock files and rewritten in place after every update, so the app can
+// report supervision quality without parsing service_helper.log.
+//
+// File layout (little-endian, see lib/core/services/service_helper_stats.dart):
+//
+//   StatsFileHeader
+//   StatsHistogram[kStatsMetricCount]   in StatsMetric order
+//   uint64_t trailerSequence            equals header.sequence when the
+//                                       file was read without tearing
+//
+// Bucket i counts samples <= header.bucketUpperMs[i]; the last bucket is
+// the overflow bucket (upper bound UINT64_MAX).
+
+#define STATS_FILE NATIVE_TEXT("service_helper_stats.bin")
+
+enum StatsMetric {
+    kStatsCheckDuration = 0,     // One availability check
+    kStatsSnapshotDuration,      // One process table capture
+    kStatsDetectExit,            // App exit until the helper noticed it
+    kStatsFirstFrame,            // Relaunch until the runner's first frame
+    kStatsDowntime,              // App gone until usable again, per incident
+    kStatsMetricCount
+};
+
+static const uint32_t kStatsBucketCount = 16;
+
+#pragma pack(push, 1)
+struct StatsFileHeader {
+    uint32_t magic;           // kStatsMagic
+    uint16_t version;         // kStatsVersion
+    uint16_t metricCount;     // kStatsMetricCount
+    uint32_t bucketCount;     // kStatsBucketCount
+    uint32_t reserved;
+    uint64_t sequence;        // Bumped on every write
+    int64_t createdMs;        // Wall clock, ms since the Unix epoch
+    int64_t updatedMs;
+    uint64_t bucketUpperMs[kStatsBucketCount];
+};
+
+struct StatsHistogram {
+    uint64_t count;
+    uint64_t sumMs;
+    uint64_t maxMs;
+    uint64_t buckets[kStatsBucketCount];
+};
+#pragma pack(pop)
+
+class SupervisorStats {
+public:
+    static const uint32_t kStatsMagic = 0x54533141;  // "A1ST"
+    static const uint16_t kStatsVersion = 1;
+
+    SupervisorStats();
+    ~SupervisorStats();
+
+    // Open (or create) the stats file and load existing counts. Without a
+    // file the stats are still kept in memory.
+    bool Open(const NativeString& path);
+    void Close();
+
+    // Add one sample and rewrite the file.
+    void Record(StatsMetric metric, int64_t valueMs);
+
+private:
+    // Disable copy
+    SupervisorStats(const SupervisorStats&) = delete;
+    SupervisorStats& operator=(const SupervisorStats&) = delete;
+
+    void Reset();
+    bool Write();
+
+    StatsFileHeader header_;
+    StatsHistogram histograms_[kStatsMetricCount];
+
+#ifdef _WIN32
+    HANDLE file_;
+#else
+    int file_;
+#endif
+};
+
+#endif  // SERVICE_HELPER_SUPERVISOR_STATS_H_
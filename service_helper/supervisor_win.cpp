@@ -0,0 +1,147 @@
+// Windows hooks of the Supervisor (see supervisor.h)
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "supervisor.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctime>
+
+#include "service_log.h"
+
+const wchar_t* APP_MUTEX_NAME = L"A1ToolsSingleInstanceMutex";
+// Must match RUNNER_SHUTDOWN_EVENT_NAME in windows/runner/shutdown_request.h
+const wchar_t* SHUTDOWN_EVENT_NAME = L"A1ToolsShutdownRequestEvent";
+
+bool Supervisor::StartPlatform() {
+    return true;  // Everything waited on is owned by the shared modules
+}
+
+void Supervisor::StopPlatform() {
+    if (shutdown_event_ != NULL) {
+        CloseHandle(shutdown_event_);
+        shutdown_event_ = NULL;
+    }
+}
+
+Supervisor::WakeReason Supervisor::WaitForEvent(int64_t timeoutMs) {
+    HANDLE handles[2];
+    DWORD count = 0;
+    HANDLE lockEvent = locks_.changeEvent();
+    if (lockEvent != NULL) {
+        handles[count++] = lockEvent;
+    }
+    HANDLE appHandle = app_watch_.IsAttached() ? app_watch_.handle() : NULL;
+    if (appHandle != NULL) {
+        handles[count++] = appHandle;
+    }
+
+    DWORD rc;
+    if (count > 0) {
+        rc = WaitForMultipleObjects(count, handles, FALSE, (DWORD)timeoutMs);
+    } else {
+        Sleep((DWORD)timeoutMs);
+        rc = WAIT_TIMEOUT;
+    }
+
+    if (rc == WAIT_TIMEOUT) {
+        return WakeReason::Timeout;
+    }
+    if (rc >= WAIT_OBJECT_0 && rc < WAIT_OBJECT_0 + count) {
+        HANDLE signaled = handles[rc - WAIT_OBJECT_0];
+        if (signaled == lockEvent) {
+            return WakeReason::LocksChanged;
+        }
+        if (signaled == appHandle) {
+            return WakeReason::AppExited;
+        }
+    }
+    return WakeReason::Error;
+}
+
+bool Supervisor::IsAppMutexHeld() {
+    HANDLE hMutex = OpenMutexW(SYNCHRONIZE, FALSE, APP_MUTEX_NAME);
+    if (hMutex != NULL) {
+        CloseHandle(hMutex);
+        return true;
+    }
+    return false;
+}
+
+bool Supervisor::AppExecutableExists() {
+    return GetFileAttributesW(config_.appPath.c_str()) != INVALID_FILE_ATTRIBUTES;
+}
+
+bool Supervisor::RequestGracefulExit() {
+    // The runner checks the event from its heartbeat timer and closes its
+    // window, which ends the message loop like a normal quit
+    if (shutdown_event_ == NULL) {
+        shutdown_event_ = CreateEventW(NULL, TRUE, FALSE, SHUTDOWN_EVENT_NAME);
+        if (shutdown_event_ == NULL) {
+            return false;
+        }
+    }
+    return SetEvent(shutdown_event_) != FALSE;
+}
+
+void Supervisor::ClearGracefulExitRequest() {
+    if (shutdown_event_ != NULL) {
+        ResetEvent(shutdown_event_);
+    }
+}
+
+bool Supervisor::LaunchApp() {
+    // Start the app with service-restart flag
+    STARTUPINFOW si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+
+    std::wstring cmdLine = L"\"" + config_.appPath + L"\" --auto-start --service-restart";
+
+    // CREATE_NEW_PROCESS_GROUP | DETACHED_PROCESS
+    if (!CreateProcessW(NULL, &cmdLine[0], NULL, NULL, FALSE,
+                        CREATE_NEW_PROCESS_GROUP | DETACHED_PROCESS,
+                        NULL, NULL, &si, &pi)) {
+        DWORD error = GetLastError();
+        wchar_t msg[128];
+        swprintf_s(msg, L"Failed to start app, error: %lu", error);
+        Log(msg);
+        return false;
+    }
+
+    // Keep the process handle so the main loop can wait on its exit
+    CloseHandle(pi.hThread);
+    app_watch_.Adopt(pi.hProcess, pi.dwProcessId);
+    return true;
+}
+
+// Create restart lock file
+void Supervisor::CreateRestartLock() {
+    std::wstring lockPath = config_.dataDir + L"\\" + RESTART_LOCK_FILE;
+
+    HANDLE hFile = CreateFileW(lockPath.c_str(), GENERIC_WRITE, 0, NULL,
+                               CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile != INVALID_HANDLE_VALUE) {
+        // Write timestamp
+        time_t now = time(nullptr);
+        char buffer[64];
+        sprintf_s(buffer, "{\"timestamp\":%lld,\"pid\":%lu}", (long long)now, GetCurrentProcessId());
+        DWORD written;
+        WriteFile(hFile, buffer, (DWORD)strlen(buffer), &written, NULL);
+        CloseHandle(hFile);
+    }
+}
+
+// Remove restart lock file
+void Supervisor::RemoveRestartLock() {
+    std::wstring lockPath = config_.dataDir + L"\\" + RESTART_LOCK_FILE;
+    DeleteFileW(lockPath.c_str());
+}
+
+int64_t Supervisor::MonotonicMs() {
+    return static_cast<int64_t>(GetTickCount64());
+}
+
+void Supervisor::SleepMs(int64_t ms) {
+    Sleep((DWORD)ms);
+}
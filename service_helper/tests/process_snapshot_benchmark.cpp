@@ -0,0 +1,81 @@
+// Benchmark for ProcessSnapshot over a large synthetic process table, the
+// way a supervision check uses it: rebuild the snapshot, look the app up by
+// name, count its instances and scan every name for installer patterns.
+// Built only with -DSERVICE_HELPER_BENCHMARKS=ON and run by hand:
+//
+//   process_snapshot_benchmark [processes] [rounds]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../process_snapshot.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double ElapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int processes = argc > 1 ? atoi(argv[1]) : 10000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 200;
+    if (processes <= 0 || rounds <= 0) {
+        fprintf(stderr, "Usage: %s [processes] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    // Distinct names mixed with a few common ones repeated, like a busy
+    // desktop; the app itself is the last entry
+    std::vector<std::string> names;
+    names.reserve(processes);
+    static const char* kCommon[] = {"bash", "kworker/0:1", "Chrome_ChildIOT", "gvfsd"};
+    for (int i = 0; i < processes - 1; i++) {
+        if (i % 4 == 0) {
+            names.push_back("Process_" + std::to_string(i) + "_worker");
+        } else {
+            names.push_back(kCommon[(i / 4) % 4]);
+        }
+    }
+    names.push_back("company_hub");
+
+    // Patterns that never match, so every check scans all names
+    PatternMatcher installers({"a1-tools-setup", "a1tools_update", "a1_tools_setup"});
+
+    ProcessSnapshot snapshot;
+    double addUs = 0;
+    double findUs = 0;
+    double countUs = 0;
+    double matchUs = 0;
+    size_t found = 0;
+    for (int round = 0; round < rounds; round++) {
+        Clock::time_point start = Clock::now();
+        snapshot.Clear();
+        for (int i = 0; i < processes; i++) {
+            snapshot.Add(static_cast<ProcessId>(i + 1), 1, names[i]);
+        }
+        addUs += ElapsedUs(start);
+
+        start = Clock::now();
+        found += snapshot.FindByName("Company_Hub") != nullptr;
+        findUs += ElapsedUs(start);
+
+        start = Clock::now();
+        found += snapshot.CountByName("BASH");
+        countUs += ElapsedUs(start);
+
+        start = Clock::now();
+        found += snapshot.FindMatching(installers) != nullptr;
+        matchUs += ElapsedUs(start);
+    }
+
+    printf("%d processes, %d rounds (%zu hits)\n", processes, rounds, found);
+    printf("  Clear + Add all   %10.1f us\n", addUs / rounds);
+    printf("  FindByName        %10.3f us\n", findUs / rounds);
+    printf("  CountByName       %10.3f us\n", countUs / rounds);
+    printf("  FindMatching miss %10.1f us\n", matchUs / rounds);
+    return 0;
+}
@@ -0,0 +1,169 @@
+// Unit test for ProcessSnapshot and PatternMatcher: captures a synthetic
+// /proc tree through CaptureFromProc and checks the lookups the supervisor
+// relies on. Exits non-zero if any check fails.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../process_snapshot.h"
+
+static int g_failures = 0;
+
+#define CHECK(condition)                                                      \
+    do {                                                                      \
+        if (!(condition)) {                                                   \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, \
+                    #condition);                                              \
+            g_failures++;                                                     \
+        }                                                                     \
+    } while (0)
+
+// Writes <root>/<pid>/stat and, if given, <root>/<pid>/cmdline (argv
+// separated by '\0' like the kernel's)
+static void AddProc(const std::string& root, const std::string& pid, const std::string& stat,
+                    const std::string& cmdline = std::string()) {
+    std::string dir = root + "/" + pid;
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir + "/stat") << stat;
+    if (!cmdline.empty()) {
+        std::ofstream(dir + "/cmdline", std::ios::binary) << cmdline;
+    }
+}
+
+static void TestCaptureFromProc() {
+    char rootTemplate[] = "/tmp/process_snapshot_test.XXXXXX";
+    const char* created = mkdtemp(rootTemplate);
+    CHECK(created != nullptr);
+    if (created == nullptr) {
+        return;
+    }
+    std::string root(created);
+
+    AddProc(root, "1", "1 (systemd) S 0 1 1 0 -1 4194560");
+    // comm with spaces and parentheses; only the last ')' ends it
+    AddProc(root, "42", "42 (a) b (c d) S 1 42 42 0 -1 4194560");
+    // Exited, not yet reaped
+    AddProc(root, "43", "43 (defunct_app) Z 1 43 43 0 -1 4194564");
+    // Truncated comm, full name from argv[0]
+    AddProc(root, "100", "100 (company_hub_rel) S 1 100 100 0 -1 4194560",
+            std::string("/opt/a1/company_hub_release\0--auto-start\0", 41));
+    // Truncated comm whose argv[0] was rewritten; comm is kept
+    AddProc(root, "101", "101 (a1tools_update_) S 1 101 101 0 -1 4194560",
+            std::string("worker\0", 7));
+    // Truncated comm without a readable cmdline (kernel thread)
+    AddProc(root, "102", "102 (kworker/u16:3-e) I 2 0 0 0 -1 69238880");
+    // Not processes, or gone before stat could be read
+    std::filesystem::create_directories(root + "/self");
+    std::filesystem::create_directories(root + "/12abc");
+    std::filesystem::create_directories(root + "/200");
+
+    ProcessSnapshot snapshot;
+    CHECK(snapshot.CaptureFromProc(root));
+    CHECK(snapshot.size() == 5);
+
+    const ProcessEntry* parens = snapshot.FindByName("a) b (c d");
+    CHECK(parens != nullptr && parens->pid == 42 && parens->parentPid == 1);
+
+    CHECK(snapshot.FindByName("defunct_app") == nullptr);
+
+    const ProcessEntry* hub = snapshot.FindByName("company_hub_release");
+    CHECK(hub != nullptr && hub->pid == 100);
+    CHECK(snapshot.FindByName("company_hub_rel") == nullptr);
+
+    const ProcessEntry* renamed = snapshot.FindByName("a1tools_update_");
+    CHECK(renamed != nullptr && renamed->pid == 101);
+
+    const ProcessEntry* kernel = snapshot.FindByName("kworker/u16:3-e");
+    CHECK(kernel != nullptr && kernel->parentPid == 2);
+
+    // A later capture replaces the earlier one
+    std::filesystem::remove_all(root + "/42");
+    CHECK(snapshot.CaptureFromProc(root));
+    CHECK(snapshot.size() == 4);
+    CHECK(snapshot.FindByName("a) b (c d") == nullptr);
+
+    std::filesystem::remove_all(root);
+    CHECK(!snapshot.CaptureFromProc(root));
+}
+
+static void TestPatternMatcher() {
+    // Overlapping patterns: "she" and "he" end on the same character, "hers"
+    // continues past "he"
+    PatternMatcher classic({"he", "she", "his", "hers"});
+    CHECK(classic.FindIn("ushers") == 1);
+    CHECK(classic.FindIn("ahishe") == 2);
+    CHECK(classic.FindIn("xyz") == -1);
+    CHECK(classic.FindIn("") == -1);
+
+    // "bc" is only reachable through the failure link of "abc", which has no
+    // output of its own and must inherit it
+    PatternMatcher inherited({"abcd", "bc"});
+    CHECK(inherited.FindIn("abce") == 1);
+    CHECK(inherited.FindIn("abcd") == 1);
+
+    // Failure links several levels deep
+    PatternMatcher chained({"aaab", "ab"});
+    CHECK(chained.FindIn("aaaab") == 0);
+    CHECK(chained.FindIn("aab") == 1);
+
+    // Patterns are folded, text is folded by the caller
+    PatternMatcher installers({"A1-Tools-Setup", "a1tools_update", "a1_tools_setup"});
+    CHECK(installers.FindIn(FoldProcessName("A1-TOOLS-SETUP-2.4.exe")) == 0);
+    CHECK(installers.FindIn("xa1tools_updater") == 1);
+    CHECK(installers.FindIn("a1_tools") == -1);
+    CHECK(installers.pattern(0) == "a1-tools-setup");
+
+    // Duplicates keep the first index
+    PatternMatcher duplicates({"hub", "HUB"});
+    CHECK(duplicates.FindIn("company_hub") == 0);
+
+    PatternMatcher empty{std::vector<NativeString>()};
+    CHECK(empty.FindIn("anything") == -1);
+}
+
+static void TestLookups() {
+    ProcessSnapshot snapshot;
+    snapshot.Add(10, 1, "Company_Hub");
+    snapshot.Add(11, 1, "company_hub");
+    snapshot.Add(12, 1, "COMPANY_HUB.bin");
+    snapshot.Add(13, 12, "A1-Tools-Setup-2.4");
+
+    CHECK(snapshot.CountByName("COMPANY_HUB") == 2);
+    CHECK(snapshot.CountByName("company_hub.bin") == 1);
+    CHECK(snapshot.CountByName("missing") == 0);
+
+    const ProcessEntry* hub = snapshot.FindByName("company_HUB");
+    CHECK(hub != nullptr && (hub->pid == 10 || hub->pid == 11));
+    CHECK(hub != nullptr && hub->foldedName == "company_hub");
+    CHECK(snapshot.FindByName("company") == nullptr);
+
+    PatternMatcher installers({"a1-tools-setup", "a1tools_update"});
+    int matched = -1;
+    const ProcessEntry* installer = snapshot.FindMatching(installers, &matched);
+    CHECK(installer != nullptr && installer->pid == 13 && matched == 0);
+
+    PatternMatcher none({"updater"});
+    CHECK(snapshot.FindMatching(none) == nullptr);
+
+    snapshot.Clear();
+    CHECK(snapshot.size() == 0);
+    CHECK(snapshot.FindByName("company_hub") == nullptr);
+}
+
+int main() {
+    TestCaptureFromProc();
+    TestPatternMatcher();
+    TestLookups();
+
+    if (g_failures != 0) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("All process snapshot checks passed\n");
+    return 0;
+}
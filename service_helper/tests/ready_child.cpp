@@ -0,0 +1,27 @@
+// Stand-in for the company_hub runner in the relaunch test: reports its
+// first frame through the readiness eventfd like the real runner does
+// (linux/runner/my_application.cc) and then idles until it is killed.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../readiness_signal.h"
+
+int main() {
+    const char* fdString = getenv(READY_FD_ENV_VAR);
+    if (fdString != nullptr) {
+        int fd = atoi(fdString);
+        if (fd > 2) {
+            uint64_t value = 1;
+            if (write(fd, &value, sizeof(value)) != sizeof(value)) {
+                return 1;
+            }
+            close(fd);
+        }
+    }
+
+    while (true) {
+        pause();
+    }
+}
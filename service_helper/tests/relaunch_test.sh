@@ -0,0 +1,70 @@
+#!/bin/sh
+# Relaunch test for the Linux service helper: supervises the ready_child
+# stand-in, SIGKILLs it once it is up and expects the helper to start a new
+# instance and record the crash in service_restart_state.json.
+#
+# Usage: relaunch_test.sh <a1_service_helper> <company_hub stand-in>
+
+HELPER="$1"
+APP="$2"
+TIMEOUT_S=20
+
+WORK_DIR=$(mktemp -d)
+DATA_DIR="$WORK_DIR/com.example.company_hub"
+LOG="$DATA_DIR/service_helper.log"
+STATE="$DATA_DIR/service_restart_state.json"
+HELPER_PID=
+
+cleanup() {
+    [ -n "$HELPER_PID" ] && kill "$HELPER_PID" 2>/dev/null && wait "$HELPER_PID"
+    # The app runs in its own session and outlives the helper
+    for pid in $(started_pids); do
+        kill -9 "$pid" 2>/dev/null
+    done
+    rm -rf "$WORK_DIR"
+}
+trap cleanup EXIT
+
+fail() {
+    echo "FAIL: $1"
+    [ -f "$LOG" ] && cat "$LOG"
+    exit 1
+}
+
+started_pids() {
+    [ -f "$LOG" ] && sed -n 's/.*App started with PID: \([0-9]*\).*/\1/p' "$LOG"
+}
+
+# Waits until the helper has logged <count> launches
+wait_for_launches() {
+    i=0
+    while [ "$(started_pids | wc -l)" -lt "$1" ]; do
+        i=$((i + 1))
+        [ "$i" -gt $((TIMEOUT_S * 10)) ] && fail "expected $1 launch(es)"
+        sleep 0.1
+    done
+}
+
+XDG_DATA_HOME="$WORK_DIR" "$HELPER" --app "$APP" &
+HELPER_PID=$!
+
+wait_for_launches 1
+FIRST_PID=$(started_pids | head -n 1)
+i=0
+until grep -q "App recovery successful" "$LOG"; do
+    i=$((i + 1))
+    [ "$i" -gt $((TIMEOUT_S * 10)) ] && fail "no readiness signal from the first instance"
+    sleep 0.1
+done
+
+kill -9 "$FIRST_PID" || fail "could not kill the app (PID $FIRST_PID)"
+
+wait_for_launches 2
+SECOND_PID=$(started_pids | sed -n 2p)
+[ "$SECOND_PID" != "$FIRST_PID" ] || fail "relaunch reused PID $FIRST_PID"
+kill -0 "$SECOND_PID" 2>/dev/null || fail "relaunched app (PID $SECOND_PID) is not running"
+
+# SIGKILL is reported shell-style as 128 + 9
+grep -q '"exit_code":137' "$STATE" || fail "crash not recorded in $STATE"
+
+echo "PASS: app relaunched (PID $FIRST_PID -> $SECOND_PID)"
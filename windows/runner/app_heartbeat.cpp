@@ -0,0 +1,91 @@
+#include "app_heartbeat.h"
+
+static_assert(std::atomic<int64_t>::is_always_lock_free,
+              "Heartbeat fields must be lock-free to live in shared memory");
+
+static int64_t NowMs() {
+  return static_cast<int64_t>(::GetTickCount64());
+}
+
+AppHeartbeat& AppHeartbeat::GetInstance() {
+  static AppHeartbeat instance;
+  return instance;
+}
+
+AppHeartbeat::AppHeartbeat() : mapping_(nullptr), heartbeat_(nullptr) {}
+
+AppHeartbeat::~AppHeartbeat() {
+  if (heartbeat_) {
+    ::UnmapViewOfFile(heartbeat_);
+  }
+  if (mapping_) {
+    ::CloseHandle(mapping_);
+  }
+}
+
+bool AppHeartbeat::Open() {
+  if (heartbeat_) {
+    return true;
+  }
+
+  mapping_ = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                  0, sizeof(SharedHeartbeat),
+                                  RUNNER_HEARTBEAT_MAPPING_NAME);
+  if (mapping_ == nullptr) {
+    return false;
+  }
+
+  void* view = ::MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0,
+                               sizeof(SharedHeartbeat));
+  if (view == nullptr) {
+    ::CloseHandle(mapping_);
+    mapping_ = nullptr;
+    return false;
+  }
+
+  heartbeat_ = static_cast<SharedHeartbeat*>(view);
+  int64_t now = NowMs();
+  heartbeat_->pid = ::GetCurrentProcessId();
+  heartbeat_->loop_tick_ms.store(now);
+  heartbeat_->frame_tick_ms.store(0);
+  heartbeat_->frame_probe_ms.store(0);
+  heartbeat_->loop_count.store(0);
+  heartbeat_->version = SharedHeartbeat::kVersion;
+  // Publish the magic last so a reader never sees a half-initialized segment.
+  std::atomic_thread_fence(std::memory_order_release);
+  heartbeat_->magic = SharedHeartbeat::kMagic;
+  return true;
+}
+
+void AppHeartbeat::TouchLoop() {
+  if (!heartbeat_) {
+    return;
+  }
+  heartbeat_->loop_tick_ms.store(NowMs(), std::memory_order_relaxed);
+  heartbeat_->loop_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AppHeartbeat::TouchFrame() {
+  if (!heartbeat_) {
+    return;
+  }
+  heartbeat_->frame_tick_ms.store(NowMs(), std::memory_order_relaxed);
+  heartbeat_->frame_probe_ms.store(0, std::memory_order_relaxed);
+}
+
+void AppHeartbeat::BeginFrameProbe() {
+  if (!heartbeat_) {
+    return;
+  }
+  // Keep the original request time if a probe is already outstanding.
+  int64_t expected = 0;
+  heartbeat_->frame_probe_ms.compare_exchange_strong(expected, NowMs(),
+                                                     std::memory_order_relaxed);
+}
+
+void AppHeartbeat::CancelFrameProbe() {
+  if (!heartbeat_) {
+    return;
+  }
+  heartbeat_->frame_probe_ms.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,67 @@
+#ifndef RUNNER_APP_HEARTBEAT_H_
+#define RUNNER_APP_HEARTBEAT_H_
+
+#include <windows.h>
+
+#include <atomic>
+#include <cstdint>
+
+// Name of the shared-memory segment the service helper reads to detect a
+// hung app. Must match HEARTBEAT_MAPPING_NAME in
+// service_helper/heartbeat_monitor.h.
+#define RUNNER_HEARTBEAT_MAPPING_NAME L"Local\\A1ToolsHeartbeat"
+
+// Layout of the heartbeat segment. Shared with the service helper; bump
+// kVersion on any change.
+struct SharedHeartbeat {
+  static const uint32_t kMagic = 0x42483141;  // "A1HB"
+  static const uint32_t kVersion = 1;
+
+  uint32_t magic;
+  uint32_t version;
+  uint32_t pid;
+  uint32_t reserved;
+  // All times are GetTickCount64() milliseconds.
+  std::atomic<int64_t> loop_tick_ms;    // Last message loop heartbeat
+  std::atomic<int64_t> frame_tick_ms;   // Last frame produced by the engine
+  std::atomic<int64_t> frame_probe_ms;  // Pending frame probe, 0 when none
+  std::atomic<uint64_t> loop_count;
+};
+
+// Publishes the runner's liveness into shared memory. The platform thread
+// touches it from a 1 s window timer, so a stuck message loop stops the
+// ticks; periodic frame probes do the same for a stuck engine/UI isolate.
+class AppHeartbeat {
+ public:
+  static AppHeartbeat& GetInstance();
+
+  // Creates the mapping. Returns false if shared memory is unavailable, in
+  // which case all other calls are no-ops.
+  bool Open();
+
+  // Records a turn of the platform message loop.
+  void TouchLoop();
+
+  // Records that the engine produced a frame; completes a pending probe.
+  void TouchFrame();
+
+  // Marks that a frame has been requested and is expected shortly.
+  void BeginFrameProbe();
+
+  // Clears any pending probe (e.g. when the window is minimized and frames
+  // are legitimately not produced).
+  void CancelFrameProbe();
+
+ private:
+  AppHeartbeat();
+  ~AppHeartbeat();
+
+  // Disable copy
+  AppHeartbeat(const AppHeartbeat&) = delete;
+  AppHeartbeat& operator=(const AppHeartbeat&) = delete;
+
+  HANDLE mapping_;
+  SharedHeartbeat* heartbeat_;
+};
+
+#endif  // RUNNER_APP_HEARTBEAT_H_
@@ -0,0 +1,255 @@
+#include "bulk_channel.h"
+
+#include <malloc.h>
+#include <string.h>
+
+#include <algorithm>
+
+static const uint64_t kHeaderSize = sizeof(BulkHeader);
+static const uint64_t kMaxPayloadBytes = 64ull << 20;  // One 4K RGBA frame is 32 MB
+static const uint64_t kMaxInUseBytes = 256ull << 20;
+static const uint64_t kMaxPooledBytes = 64ull << 20;
+static const uint64_t kMinCapacity = 4096;
+
+// Buffers are pooled by power-of-two capacity, so payloads that vary a
+// little (encoded images) still reuse allocations.
+static uint64_t RoundCapacity(uint64_t payload_size) {
+  uint64_t capacity = kMinCapacity;
+  while (capacity < payload_size) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+static uint64_t NowMicroseconds() {
+  static LARGE_INTEGER frequency = []() {
+    LARGE_INTEGER value;
+    ::QueryPerformanceFrequency(&value);
+    return value;
+  }();
+  LARGE_INTEGER counter;
+  ::QueryPerformanceCounter(&counter);
+  return static_cast<uint64_t>(counter.QuadPart / frequency.QuadPart * 1000000 +
+                               counter.QuadPart % frequency.QuadPart * 1000000 /
+                                   frequency.QuadPart);
+}
+
+BulkChannel& BulkChannel::GetInstance() {
+  static BulkChannel instance;
+  return instance;
+}
+
+BulkChannel::BulkChannel() {}
+
+BulkChannel::~BulkChannel() {
+  for (auto& slot : slots_) {
+    if (slot.memory != nullptr) {
+      _aligned_free(slot.memory);
+    }
+  }
+  for (auto& entry : pool_) {
+    _aligned_free(entry.second);
+  }
+}
+
+void BulkChannel::SetTarget(HWND window) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  target_ = window;
+  if (target_ != nullptr && !ready_.empty()) {
+    ::PostMessageW(target_, RUNNER_BULK_READY_MESSAGE, 0, 0);
+  }
+}
+
+void BulkChannel::SetListening(bool listening) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  listening_ = listening;
+}
+
+BulkChannel::Slot* BulkChannel::Lookup(int64_t handle) {
+  uint32_t index = static_cast<uint32_t>(handle & 0xFFFFFFFF);
+  uint32_t generation = static_cast<uint32_t>(static_cast<uint64_t>(handle) >> 32);
+  if (index == 0 || index > slots_.size()) {
+    return nullptr;
+  }
+  Slot& slot = slots_[index - 1];
+  if (slot.memory == nullptr || slot.refs == 0 || slot.generation != generation) {
+    return nullptr;
+  }
+  return &slot;
+}
+
+int64_t BulkChannel::Acquire(uint64_t payload_size, uint8_t** payload) {
+  if (payload_size > kMaxPayloadBytes) {
+    return 0;
+  }
+  uint64_t capacity = RoundCapacity(payload_size);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (in_use_bytes_ + capacity > kMaxInUseBytes) {
+    return 0;
+  }
+  uint8_t* memory = nullptr;
+  auto pooled = pool_.find(capacity);
+  if (pooled != pool_.end()) {
+    memory = pooled->second;
+    pool_.erase(pooled);
+    pooled_bytes_ -= capacity;
+  } else {
+    memory = static_cast<uint8_t*>(
+        _aligned_malloc(static_cast<size_t>(kHeaderSize + capacity), 64));
+    if (memory == nullptr) {
+      return 0;
+    }
+  }
+
+  uint32_t index;
+  if (!free_slots_.empty()) {
+    index = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    slots_.emplace_back();
+    index = static_cast<uint32_t>(slots_.size());
+  }
+  Slot& slot = slots_[index - 1];
+  slot.memory = memory;
+  slot.capacity = capacity;
+  slot.generation++;
+  slot.refs = 1;
+  in_use_bytes_ += capacity;
+
+  memset(memory, 0, kHeaderSize);
+  *payload = memory + kHeaderSize;
+  return static_cast<int64_t>((static_cast<uint64_t>(slot.generation) << 32) | index);
+}
+
+bool BulkChannel::Publish(int64_t handle, const BulkHeader& header) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slot* slot = Lookup(handle);
+  if (slot == nullptr) {
+    return false;
+  }
+  if (!listening_ || header.payload_size > slot->capacity) {
+    ReleaseLocked(handle);
+    return false;
+  }
+
+  BulkHeader* target = reinterpret_cast<BulkHeader*>(slot->memory);
+  *target = header;
+  target->magic = BulkHeader::kMagic;
+  target->version = BulkHeader::kVersion;
+  target->sequence = ++sequence_;
+  target->timestamp_us = NowMicroseconds();
+
+  bool post = ready_.empty();
+  ready_.push_back(handle);
+  if (post && target_ != nullptr) {
+    ::PostMessageW(target_, RUNNER_BULK_READY_MESSAGE, 0, 0);
+  }
+  return true;
+}
+
+std::vector<int64_t> BulkChannel::TakeReady() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<int64_t> ready(ready_.begin(), ready_.end());
+  ready_.clear();
+  return ready;
+}
+
+bool BulkChannel::Map(int64_t handle, uint8_t** base, uint64_t* size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slot* slot = Lookup(handle);
+  if (slot == nullptr) {
+    return false;
+  }
+  slot->refs++;
+  *base = slot->memory;
+  *size = kHeaderSize + slot->capacity;
+  return true;
+}
+
+void BulkChannel::Release(int64_t handle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReleaseLocked(handle);
+}
+
+void BulkChannel::ReleaseLocked(int64_t handle) {
+  Slot* slot = Lookup(handle);
+  if (slot == nullptr || --slot->refs > 0) {
+    return;
+  }
+  in_use_bytes_ -= slot->capacity;
+  if (pooled_bytes_ + slot->capacity <= kMaxPooledBytes) {
+    pool_.emplace(slot->capacity, slot->memory);
+    pooled_bytes_ += slot->capacity;
+  } else {
+    _aligned_free(slot->memory);
+  }
+  slot->memory = nullptr;
+  slot->capacity = 0;
+  // The generation stays, so the old handle no longer matches once reused
+  free_slots_.push_back(static_cast<uint32_t>(slot - slots_.data()) + 1);
+}
+
+bool BulkChannel::Submit(int64_t handle, uint16_t kind, uint64_t payload_size) {
+  Consumer consumer;
+  BulkHeader header;
+  const uint8_t* payload = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot* slot = Lookup(handle);
+    if (slot == nullptr) {
+      return false;
+    }
+    auto it = consumers_.find(kind);
+    if (it == consumers_.end() || payload_size > slot->capacity) {
+      ReleaseLocked(handle);
+      return false;
+    }
+    consumer = it->second;
+    BulkHeader* target = reinterpret_cast<BulkHeader*>(slot->memory);
+    target->magic = BulkHeader::kMagic;
+    target->version = BulkHeader::kVersion;
+    target->kind = kind;
+    target->payload_size = payload_size;
+    target->timestamp_us = NowMicroseconds();
+    header = *target;
+    payload = slot->memory + kHeaderSize;
+  }
+  // Outside the lock: the consumer may map the buffer to keep it
+  consumer(handle, header, payload);
+  Release(handle);
+  return true;
+}
+
+void BulkChannel::SetConsumer(uint16_t kind, Consumer consumer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (consumer) {
+    consumers_[kind] = std::move(consumer);
+  } else {
+    consumers_.erase(kind);
+  }
+}
+
+extern "C" {
+
+int64_t a1_bulk_acquire(uint64_t payload_size, uint8_t** payload) {
+  return BulkChannel::GetInstance().Acquire(payload_size, payload);
+}
+
+int32_t a1_bulk_map(int64_t handle, uint8_t** base, uint64_t* size) {
+  return BulkChannel::GetInstance().Map(handle, base, size) ? 1 : 0;
+}
+
+void a1_bulk_release(int64_t handle) {
+  BulkChannel::GetInstance().Release(handle);
+}
+
+int32_t a1_bulk_submit(int64_t handle, uint16_t kind, uint64_t payload_size) {
+  return BulkChannel::GetInstance().Submit(handle, kind, payload_size) ? 1 : 0;
+}
+
+void a1_bulk_set_listening(int32_t listening) {
+  BulkChannel::GetInstance().SetListening(listening != 0);
+}
+
+}  // extern "C"
@@ -0,0 +1,144 @@
+#ifndef RUNNER_BULK_CHANNEL_H_
+#define RUNNER_BULK_CHANNEL_H_
+
+#include <windows.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Posted to the target window when published buffers are waiting in
+// BulkChannel::TakeReady().
+#define RUNNER_BULK_READY_MESSAGE (WM_APP + 0x43)
+
+// Platform channel announcing published buffers: each message is one
+// little-endian int64 handle, sent with no codec.
+#define RUNNER_BULK_CHANNEL_NAME "com.a1chimney.a1tools/bulk"
+
+// Fixed header at the start of every bulk buffer; the payload follows at
+// offset 64. Shared with lib/core/services/bulk_channel.dart; bump kVersion
+// on any change.
+struct BulkHeader {
+  static const uint32_t kMagic = 0x4B423141;  // "A1BK"
+  static const uint16_t kVersion = 1;
+
+  uint32_t magic;
+  uint16_t version;
+  uint16_t kind;  // Producer-defined payload type
+  uint32_t sequence;  // Per-channel publish counter
+  uint32_t flags;
+  uint64_t timestamp_us;  // QueryPerformanceCounter time of publish
+  uint64_t payload_size;
+  // Image payloads; 0 otherwise
+  uint32_t width;
+  uint32_t height;
+  uint32_t stride;
+  uint32_t format;
+  uint8_t reserved[16];
+};
+static_assert(sizeof(BulkHeader) == 64, "BulkHeader is part of the Dart ABI");
+
+// Bulk data between the runner and Dart without going through a method
+// codec. Buffers are native memory that Dart maps with dart:ffi as external
+// typed data (no copy, no EncodableValue boxing) and must release
+// explicitly.
+//
+// Native to Dart: Acquire, fill, Publish. The handle is announced on
+// RUNNER_BULK_CHANNEL_NAME from the platform thread; Dart maps it and
+// releases it when done. Nothing is published while Dart is not listening.
+//
+// Dart to native: Dart acquires and fills a buffer through the exported
+// functions below and submits it to the consumer registered for its kind.
+//
+// Handles carry a generation, so a stale or double release is ignored
+// instead of freeing someone else's buffer. All members are thread-safe.
+class BulkChannel {
+ public:
+  using Consumer = std::function<void(int64_t handle, const BulkHeader& header,
+                                      const uint8_t* payload)>;
+
+  static BulkChannel& GetInstance();
+
+  // Window that receives RUNNER_BULK_READY_MESSAGE; nullptr to detach.
+  void SetTarget(HWND window);
+
+  // Reserves a buffer with room for |payload_size| bytes. Returns the handle
+  // and sets |payload|, or returns 0 when the size or the total of buffers
+  // in use is over the limit.
+  int64_t Acquire(uint64_t payload_size, uint8_t** payload);
+
+  // Fills in the header of |handle| (|header|'s magic, version, sequence,
+  // timestamp and payload size are set here) and queues it for Dart, which
+  // takes over the reference. Releases the buffer and returns false if Dart
+  // is not listening.
+  bool Publish(int64_t handle, const BulkHeader& header);
+
+  // Published handles not yet announced to Dart, oldest first.
+  std::vector<int64_t> TakeReady();
+
+  // Adds a reference for a mapper and returns the header address (the
+  // payload follows at +64) and total size. False for an unknown handle.
+  bool Map(int64_t handle, uint8_t** base, uint64_t* size);
+
+  // Drops one reference; the buffer goes back to the pool at zero.
+  void Release(int64_t handle);
+
+  // Hands a Dart-filled buffer to the consumer of its kind, which runs on
+  // the calling thread and must not keep the buffer past the call unless it
+  // maps it. The submitter's reference is released afterwards.
+  bool Submit(int64_t handle, uint16_t kind, uint64_t payload_size);
+
+  // Consumer for buffers Dart submits with |kind|.
+  void SetConsumer(uint16_t kind, Consumer consumer);
+
+  void SetListening(bool listening);
+
+ private:
+  BulkChannel();
+  ~BulkChannel();
+
+  // Disable copy
+  BulkChannel(const BulkChannel&) = delete;
+  BulkChannel& operator=(const BulkChannel&) = delete;
+
+  struct Slot {
+    uint8_t* memory = nullptr;  // Header + payload, 64-byte aligned
+    uint64_t capacity = 0;      // Payload bytes
+    uint32_t generation = 0;
+    uint32_t refs = 0;
+  };
+
+  // Returns the live slot of |handle|; requires mutex_.
+  Slot* Lookup(int64_t handle);
+  void ReleaseLocked(int64_t handle);
+
+  std::mutex mutex_;  // Guards everything below
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_slots_;
+  std::multimap<uint64_t, uint8_t*> pool_;  // Idle allocations by capacity
+  uint64_t pooled_bytes_ = 0;
+  uint64_t in_use_bytes_ = 0;
+  std::deque<int64_t> ready_;
+  std::map<uint16_t, Consumer> consumers_;
+  uint32_t sequence_ = 0;
+  bool listening_ = false;
+  HWND target_ = nullptr;
+};
+
+// dart:ffi entry points into BulkChannel, looked up through
+// DynamicLibrary.executable(). Return 0 on failure.
+extern "C" {
+__declspec(dllexport) int64_t a1_bulk_acquire(uint64_t payload_size,
+                                              uint8_t** payload);
+__declspec(dllexport) int32_t a1_bulk_map(int64_t handle, uint8_t** base,
+                                          uint64_t* size);
+__declspec(dllexport) void a1_bulk_release(int64_t handle);
+__declspec(dllexport) int32_t a1_bulk_submit(int64_t handle, uint16_t kind,
+                                             uint64_t payload_size);
+__declspec(dllexport) void a1_bulk_set_listening(int32_t listening);
+}
+
+#endif  // RUNNER_BULK_CHANNEL_H_
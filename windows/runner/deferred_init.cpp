@@ -0,0 +1,106 @@
+#include "deferred_init.h"
+
+#include <flutter/standard_method_codec.h>
+
+#include "startup_trace.h"
+
+// Window timer draining the deferred queue; must not clash with the timers
+// in flutter_window.cpp.
+static const UINT_PTR kDeferredInitTimerId = 2;
+
+void DeferredInitQueue::Add(const std::string& name, Task task) {
+  Entry entry{name, std::move(task)};
+  if (drained_) {
+    Run(entry);
+    return;
+  }
+  tasks_.push_back(std::move(entry));
+}
+
+void DeferredInitQueue::Start(HWND window) {
+  if (window_ != nullptr || drained_) {
+    return;
+  }
+  window_ = window;
+  ::SetTimer(window_, kDeferredInitTimerId, USER_TIMER_MINIMUM, nullptr);
+}
+
+void DeferredInitQueue::Stop() {
+  if (window_ != nullptr) {
+    ::KillTimer(window_, kDeferredInitTimerId);
+    window_ = nullptr;
+  }
+  tasks_.clear();
+}
+
+bool DeferredInitQueue::HandleTimer(WPARAM timer_id) {
+  if (timer_id != kDeferredInitTimerId) {
+    return false;
+  }
+  if (!tasks_.empty()) {
+    // Pop first; a task may queue more work
+    Entry entry = std::move(tasks_.front());
+    tasks_.pop_front();
+    Run(entry);
+  }
+  if (tasks_.empty() && window_ != nullptr) {
+    ::KillTimer(window_, kDeferredInitTimerId);
+    window_ = nullptr;
+    drained_ = true;
+  }
+  return true;
+}
+
+void DeferredInitQueue::Run(const Entry& entry) {
+  std::string traceName = "deferred:" + entry.name;
+  StartupTrace::GetInstance().Begin(traceName.c_str());
+  entry.task();
+  StartupTrace::GetInstance().End(traceName.c_str());
+}
+
+LazyChannelRegistry::LazyChannelRegistry(flutter::BinaryMessenger* messenger)
+    : messenger_(messenger) {}
+
+LazyChannelRegistry::~LazyChannelRegistry() {
+  // Handlers point back at the entries; unregister before they go away
+  for (auto& pair : entries_) {
+    pair.second->channel->SetMethodCallHandler(nullptr);
+  }
+}
+
+void LazyChannelRegistry::Register(const std::string& channel_name,
+                                   HandlerFactory factory) {
+  auto entry = std::make_unique<Entry>();
+  entry->name = channel_name;
+  entry->factory = std::move(factory);
+  entry->channel =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger_, channel_name,
+          &flutter::StandardMethodCodec::GetInstance());
+
+  Entry* raw = entry.get();
+  raw->channel->SetMethodCallHandler(
+      [raw](const flutter::MethodCall<flutter::EncodableValue>& call,
+            std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        Resolve(raw)(call, std::move(result));
+      });
+  entries_[channel_name] = std::move(entry);
+}
+
+void LazyChannelRegistry::Warm(const std::string& channel_name) {
+  auto it = entries_.find(channel_name);
+  if (it != entries_.end()) {
+    Resolve(it->second.get());
+  }
+}
+
+LazyChannelRegistry::Handler& LazyChannelRegistry::Resolve(Entry* entry) {
+  if (!entry->handler) {
+    std::string traceName = "lazy:" + entry->name;
+    StartupTrace::GetInstance().Begin(traceName.c_str());
+    entry->handler = entry->factory();
+    entry->factory = nullptr;  // Release whatever the factory captured
+    StartupTrace::GetInstance().End(traceName.c_str());
+  }
+  return entry->handler;
+}
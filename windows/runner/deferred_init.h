@@ -0,0 +1,98 @@
+#ifndef RUNNER_DEFERRED_INIT_H_
+#define RUNNER_DEFERRED_INIT_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+#include <windows.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+// Startup work that the first frame does not need. The runner registers it
+// here instead of doing it in FlutterWindow::OnCreate, so time-to-first-frame
+// only pays for what the splash screen uses.
+//
+// Every task and lazy handler creation is recorded in the startup trace
+// (startup_trace.h) as "deferred:<name>" / "lazy:<channel>".
+
+// Runs queued tasks on the platform thread once the first frame is shown,
+// one task per WM_TIMER. Timer messages are only generated when no other
+// message is pending, so input and frames are never held up by the queue.
+class DeferredInitQueue {
+ public:
+  using Task = std::function<void()>;
+
+  DeferredInitQueue() = default;
+
+  // Queues a task; runs immediately when the queue already drained.
+  void Add(const std::string& name, Task task);
+
+  // Starts draining on |window|'s message loop.
+  void Start(HWND window);
+
+  // Stops draining; queued tasks are dropped.
+  void Stop();
+
+  // Handles WM_TIMER; returns false if |timer_id| is not the queue's.
+  bool HandleTimer(WPARAM timer_id);
+
+ private:
+  // Disable copy
+  DeferredInitQueue(const DeferredInitQueue&) = delete;
+  DeferredInitQueue& operator=(const DeferredInitQueue&) = delete;
+
+  struct Entry {
+    std::string name;
+    Task task;
+  };
+
+  static void Run(const Entry& entry);
+
+  std::deque<Entry> tasks_;
+  HWND window_ = nullptr;
+  bool drained_ = false;
+};
+
+// Method channels whose handler, and whatever state it needs, is created on
+// the first call instead of at startup. The channel itself is registered
+// right away (a map insertion in the messenger), so early calls from Dart
+// still reach it.
+class LazyChannelRegistry {
+ public:
+  using Handler = flutter::MethodCallHandler<flutter::EncodableValue>;
+  using HandlerFactory = std::function<Handler()>;
+
+  explicit LazyChannelRegistry(flutter::BinaryMessenger* messenger);
+  ~LazyChannelRegistry();
+
+  // Registers |channel_name| with the standard method codec. |factory| runs
+  // on the first call, or from Warm().
+  void Register(const std::string& channel_name, HandlerFactory factory);
+
+  // Creates the handler of |channel_name| now unless it already exists, so
+  // the first real call does not pay for it. Meant for DeferredInitQueue.
+  void Warm(const std::string& channel_name);
+
+ private:
+  // Disable copy
+  LazyChannelRegistry(const LazyChannelRegistry&) = delete;
+  LazyChannelRegistry& operator=(const LazyChannelRegistry&) = delete;
+
+  struct Entry {
+    std::string name;
+    HandlerFactory factory;
+    Handler handler;
+    std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> channel;
+  };
+
+  static Handler& Resolve(Entry* entry);
+
+  flutter::BinaryMessenger* messenger_;
+  std::map<std::string, std::unique_ptr<Entry>> entries_;
+};
+
+#endif  // RUNNER_DEFERRED_INIT_H_
@@ -1,13 +1,50 @@
 #include "flutter_window.h"
 
+#include <string.h>
+
+#include <algorithm>
 #include <optional>
 #include <vector>
 #include <string>
 
 #include "flutter/generated_plugin_registrant.h"
+#include <flutter/event_channel.h>
+#include <flutter/event_stream_handler_functions.h>
 #include <flutter/method_channel.h>
 #include <flutter/standard_method_codec.h>
+#include "app_heartbeat.h"
+#include "bulk_channel.h"
+#include "deferred_init.h"
+#include "instance_channel.h"
+#include "native_executor.h"
 #include "privacy_injector.h"
+#include "readiness_signal.h"
+#include "screen_capture.h"
+#include "shutdown_request.h"
+#include "stall_monitor.h"
+#include "startup_trace.h"
+#include "window_visibility.h"
+
+// Window timer driving the hang-detection heartbeat.
+static const UINT_PTR kHeartbeatTimerId = 1;
+static const UINT kHeartbeatIntervalMs = 1000;
+
+// Heartbeat ticks between frame probes.
+static const unsigned int kFrameProbeEveryTicks = 15;
+
+// Framework lifecycle channel (SystemChannels.lifecycle), string codec.
+static const char kLifecycleChannel[] = "flutter/lifecycle";
+
+static const char kCaptureProtectionChannel[] = "com.a1chimney.a1tools/capture_protection";
+static const char kPrivacyInjectionChannel[] = "com.a1chimney.a1tools/privacy_injection";
+static const char kNativeExecutorChannel[] = "com.a1chimney.a1tools/native_executor";
+static const char kBulkBenchmarkChannel[] = "com.a1chimney.a1tools/bulk_benchmark";
+static const char kStallMonitorChannel[] = "com.a1chimney.a1tools/stall_monitor";
+static const char kScreenCaptureChannel[] = "com.a1chimney.a1tools/screen_capture";
+
+// BulkHeader::kind of benchmark payloads; must match
+// BulkChannel.benchmarkKind in Dart.
+static const uint16_t kBulkBenchmarkKind = 0xFFFF;
 
 // Helper function to convert UTF-8 std::string to std::wstring
 static std::wstring Utf8ToWstring(const std::string& str) {
@@ -31,152 +68,239 @@ static std::string WstringToUtf8(const std::wstring& wstr) {
     return result;
 }
 
+using SharedMethodResult =
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+
+static NativeExecutor::Completion ReplySuccess(SharedMethodResult result,
+                                               flutter::EncodableValue value) {
+  return [result, value = std::move(value)]() { result->Success(value); };
+}
+
+static NativeExecutor::Completion ReplyError(SharedMethodResult result,
+                                             const std::string& code,
+                                             const std::string& message) {
+  return [result, code, message]() { result->Error(code, message); };
+}
+
+// Runs a com.a1chimney.a1tools/privacy_injection call on the native
+// executor: injecting waits on a remote thread for up to 5 s per process.
+// The returned completion replies on the platform thread. PrivacyInjector
+// is initialized by the channel's lazy factory before the first call.
+static NativeExecutor::Completion RunPrivacyInjectionCall(
+    const std::string& method, const flutter::EncodableValue& arguments,
+    SharedMethodResult result) {
+  if (method == "hideProcessWindows") {
+    // Expected args: {"processName": "notepad", "hide": true}
+    const auto* args = std::get_if<flutter::EncodableMap>(&arguments);
+    if (args) {
+      auto nameIt = args->find(flutter::EncodableValue("processName"));
+      auto hideIt = args->find(flutter::EncodableValue("hide"));
+
+      if (nameIt != args->end() && hideIt != args->end()) {
+        const auto* name = std::get_if<std::string>(&nameIt->second);
+        const auto* hide = std::get_if<bool>(&hideIt->second);
+
+        if (name && hide) {
+          // Convert UTF-8 string to wstring
+          std::wstring wname = Utf8ToWstring(*name);
+          int affected = PrivacyInjector::GetInstance().HideProcessWindows(wname, *hide);
+          return ReplySuccess(result, flutter::EncodableValue(affected));
+        }
+      }
+    }
+    return ReplyError(result, "INVALID_ARGUMENT",
+                      "Expected {processName: string, hide: bool}");
+
+  } else if (method == "hideMultipleProcesses") {
+    // Expected args: {"processes": ["notepad", "chrome"], "hide": true}
+    const auto* args = std::get_if<flutter::EncodableMap>(&arguments);
+    if (args) {
+      auto processesIt = args->find(flutter::EncodableValue("processes"));
+      auto hideIt = args->find(flutter::EncodableValue("hide"));
+
+      if (processesIt != args->end() && hideIt != args->end()) {
+        const auto* processes = std::get_if<flutter::EncodableList>(&processesIt->second);
+        const auto* hide = std::get_if<bool>(&hideIt->second);
+
+        if (processes && hide) {
+          int totalAffected = 0;
+          for (const auto& proc : *processes) {
+            const auto* name = std::get_if<std::string>(&proc);
+            if (name) {
+              std::wstring wname = Utf8ToWstring(*name);
+              totalAffected += PrivacyInjector::GetInstance().HideProcessWindows(wname, *hide);
+            }
+          }
+          return ReplySuccess(result, flutter::EncodableValue(totalAffected));
+        }
+      }
+    }
+    return ReplyError(result, "INVALID_ARGUMENT",
+                      "Expected {processes: string[], hide: bool}");
+
+  } else if (method == "getHiddenProcesses") {
+    auto hiddenList = PrivacyInjector::GetInstance().GetHiddenProcesses();
+    flutter::EncodableList encodedList;
+    for (const auto& name : hiddenList) {
+      encodedList.push_back(flutter::EncodableValue(WstringToUtf8(name)));
+    }
+    return ReplySuccess(result, flutter::EncodableValue(encodedList));
+
+  } else if (method == "restoreAll") {
+    PrivacyInjector::GetInstance().RestoreAll();
+    return ReplySuccess(result, flutter::EncodableValue());
+
+  } else if (method == "isProcessHidden") {
+    const auto* args = std::get_if<std::string>(&arguments);
+    if (args) {
+      std::wstring wname = Utf8ToWstring(*args);
+      bool hidden = PrivacyInjector::GetInstance().IsProcessHidden(wname);
+      return ReplySuccess(result, flutter::EncodableValue(hidden));
+    }
+    return ReplyError(result, "INVALID_ARGUMENT", "Expected process name string");
+  }
+  return [result]() { result->NotImplemented(); };
+}
+
 FlutterWindow::FlutterWindow(const flutter::DartProject& project)
     : project_(project) {}
 
 FlutterWindow::~FlutterWindow() {}
 
+void FlutterWindow::StartInBackground(const Win32Window::Size& shown_size) {
+  collapsed_in_background_ = true;
+  shown_width_ = shown_size.width;
+  shown_height_ = shown_size.height;
+}
+
 bool FlutterWindow::OnCreate() {
+  StartupTraceScope onCreateScope("FlutterWindow::OnCreate");
+  StartupTrace& trace = StartupTrace::GetInstance();
+
   if (!Win32Window::OnCreate()) {
     return false;
   }
 
   RECT frame = GetClientArea();
+  if (collapsed_in_background_) {
+    ::GetWindowRect(GetHandle(), &collapsed_rect_);
+  }
 
   // The size here must match the window dimensions to avoid unnecessary surface
   // creation / destruction in the startup path.
+  trace.Begin("FlutterViewController");
   flutter_controller_ = std::make_unique<flutter::FlutterViewController>(
       frame.right - frame.left, frame.bottom - frame.top, project_);
+  trace.End("FlutterViewController");
   // Ensure that basic setup of the controller was successful.
   if (!flutter_controller_->engine() || !flutter_controller_->view()) {
     return false;
   }
+  trace.Begin("RegisterPlugins");
   RegisterPlugins(flutter_controller_->engine());
+  trace.End("RegisterPlugins");
   SetChildContent(flutter_controller_->view()->GetNativeWindow());
 
-  // Set up method channel for capture protection toggle
-  auto channel = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
-      flutter_controller_->engine()->messenger(),
-      "com.a1chimney.a1tools/capture_protection",
-      &flutter::StandardMethodCodec::GetInstance());
-
-  channel->SetMethodCallHandler(
-      [this](const flutter::MethodCall<flutter::EncodableValue>& call,
-             std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-        if (call.method_name() == "setCaptureProtection") {
-          const auto* args = std::get_if<bool>(call.arguments());
-          if (args) {
-            this->SetCaptureProtection(*args);
-            result->Success();
-          } else {
-            result->Error("INVALID_ARGUMENT", "Expected boolean argument");
-          }
+  trace.Begin("channel_setup");
+  SetUpStartupTraceChannel();
+  SetUpInstanceArgsChannel();
+
+  // Handler state for these channels is created on the first call (or after
+  // the first frame, see below), not on the startup path
+  lazy_channels_ = std::make_unique<LazyChannelRegistry>(
+      flutter_controller_->engine()->messenger());
+
+  // Capture protection toggle
+  lazy_channels_->Register(kCaptureProtectionChannel, [this]() -> LazyChannelRegistry::Handler {
+    return [this](const flutter::MethodCall<flutter::EncodableValue>& call,
+                  std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+      if (call.method_name() == "setCaptureProtection") {
+        const auto* args = std::get_if<bool>(call.arguments());
+        if (args) {
+          this->SetCaptureProtection(*args);
+          result->Success();
         } else {
-          result->NotImplemented();
+          result->Error("INVALID_ARGUMENT", "Expected boolean argument");
         }
-      });
-
-  // Set up method channel for privacy injection (hide other windows from capture)
-  auto privacyChannel = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
-      flutter_controller_->engine()->messenger(),
-      "com.a1chimney.a1tools/privacy_injection",
-      &flutter::StandardMethodCodec::GetInstance());
-
-  // Initialize privacy injector with DLL path
-  wchar_t exePath[MAX_PATH];
-  GetModuleFileNameW(nullptr, exePath, MAX_PATH);
-  std::wstring exeDir(exePath);
-  size_t lastSlash = exeDir.find_last_of(L"\\/");
-  if (lastSlash != std::wstring::npos) {
-    exeDir = exeDir.substr(0, lastSlash + 1);
-  }
-  std::wstring dllPath = exeDir + L"privacy_payload.dll";
-  PrivacyInjector::GetInstance().Initialize(dllPath);
-
-  privacyChannel->SetMethodCallHandler(
-      [](const flutter::MethodCall<flutter::EncodableValue>& call,
-         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-
-        if (call.method_name() == "hideProcessWindows") {
-          // Expected args: {"processName": "notepad", "hide": true}
-          const auto* args = std::get_if<flutter::EncodableMap>(call.arguments());
-          if (args) {
-            auto nameIt = args->find(flutter::EncodableValue("processName"));
-            auto hideIt = args->find(flutter::EncodableValue("hide"));
-
-            if (nameIt != args->end() && hideIt != args->end()) {
-              const auto* name = std::get_if<std::string>(&nameIt->second);
-              const auto* hide = std::get_if<bool>(&hideIt->second);
-
-              if (name && hide) {
-                // Convert UTF-8 string to wstring
-                std::wstring wname = Utf8ToWstring(*name);
-                int affected = PrivacyInjector::GetInstance().HideProcessWindows(wname, *hide);
-                result->Success(flutter::EncodableValue(affected));
-                return;
-              }
-            }
-          }
-          result->Error("INVALID_ARGUMENT", "Expected {processName: string, hide: bool}");
-
-        } else if (call.method_name() == "hideMultipleProcesses") {
-          // Expected args: {"processes": ["notepad", "chrome"], "hide": true}
-          const auto* args = std::get_if<flutter::EncodableMap>(call.arguments());
-          if (args) {
-            auto processesIt = args->find(flutter::EncodableValue("processes"));
-            auto hideIt = args->find(flutter::EncodableValue("hide"));
-
-            if (processesIt != args->end() && hideIt != args->end()) {
-              const auto* processes = std::get_if<flutter::EncodableList>(&processesIt->second);
-              const auto* hide = std::get_if<bool>(&hideIt->second);
-
-              if (processes && hide) {
-                int totalAffected = 0;
-                for (const auto& proc : *processes) {
-                  const auto* name = std::get_if<std::string>(&proc);
-                  if (name) {
-                    std::wstring wname = Utf8ToWstring(*name);
-                    totalAffected += PrivacyInjector::GetInstance().HideProcessWindows(wname, *hide);
-                  }
-                }
-                result->Success(flutter::EncodableValue(totalAffected));
-                return;
-              }
-            }
-          }
-          result->Error("INVALID_ARGUMENT", "Expected {processes: string[], hide: bool}");
-
-        } else if (call.method_name() == "getHiddenProcesses") {
-          auto hiddenList = PrivacyInjector::GetInstance().GetHiddenProcesses();
-          flutter::EncodableList encodedList;
-          for (const auto& name : hiddenList) {
-            encodedList.push_back(flutter::EncodableValue(WstringToUtf8(name)));
-          }
-          result->Success(flutter::EncodableValue(encodedList));
+      } else {
+        result->NotImplemented();
+      }
+    };
+  });
 
-        } else if (call.method_name() == "restoreAll") {
-          PrivacyInjector::GetInstance().RestoreAll();
-          result->Success();
+  // Blocking native work of the channels below; workers start on first use
+  native_executor_ = std::make_unique<NativeExecutor>(GetHandle());
+  SetUpNativeExecutorChannel();
+
+  // Watchdog for this thread's message loop
+  StallMonitor::GetInstance().Start(GetHandle());
+  SetUpStallMonitorChannel();
+
+  // Bulk data is announced to Dart from this window's message loop
+  BulkChannel::GetInstance().SetTarget(GetHandle());
+  SetUpBulkBenchmarkChannel();
+
+  SetUpScreenCaptureChannel();
+
+  // Privacy injection (hide other windows from capture). Resolving the
+  // payload path probes the filesystem, so it waits for first use.
+  // PrivacyInjector is not thread-safe; the executor runs one call at a time
+  // per key, which keeps it serialized.
+  lazy_channels_->Register(kPrivacyInjectionChannel, [this]() -> LazyChannelRegistry::Handler {
+    wchar_t exePath[MAX_PATH];
+    GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+    std::wstring exeDir(exePath);
+    size_t lastSlash = exeDir.find_last_of(L"\\/");
+    if (lastSlash != std::wstring::npos) {
+      exeDir = exeDir.substr(0, lastSlash + 1);
+    }
+    std::wstring dllPath = exeDir + L"privacy_payload.dll";
+    PrivacyInjector::GetInstance().Initialize(dllPath);
+    return [this](const flutter::MethodCall<flutter::EncodableValue>& call,
+                  std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+      // The call is only valid during this handler; the work gets copies
+      std::string method = call.method_name();
+      flutter::EncodableValue arguments =
+          call.arguments() ? *call.arguments() : flutter::EncodableValue();
+      SharedMethodResult shared_result(std::move(result));
+      bool queued = native_executor_->Submit(
+          kPrivacyInjectionChannel, [method, arguments, shared_result]() {
+            return RunPrivacyInjectionCall(method, arguments, shared_result);
+          });
+      if (!queued) {
+        shared_result->Error("BUSY", "Too many native calls pending");
+      }
+    };
+  });
 
-        } else if (call.method_name() == "isProcessHidden") {
-          const auto* args = std::get_if<std::string>(call.arguments());
-          if (args) {
-            std::wstring wname = Utf8ToWstring(*args);
-            bool hidden = PrivacyInjector::GetInstance().IsProcessHidden(wname);
-            result->Success(flutter::EncodableValue(hidden));
-          } else {
-            result->Error("INVALID_ARGUMENT", "Expected process name string");
-          }
+  // Warm the privacy injector once the first frame is up, so its first real
+  // call is not slowed down either
+  deferred_init_.Add("privacy_injector", [this]() {
+    lazy_channels_->Warm(kPrivacyInjectionChannel);
+  });
 
-        } else {
-          result->NotImplemented();
-        }
-      });
+  trace.End("channel_setup");
 
   flutter_controller_->engine()->SetNextFrameCallback([&]() {
-    this->Show();
+    StartupTrace::GetInstance().Instant("first_frame");
+    // A background launch stays hidden until the user opens it from the tray
+    if (!collapsed_in_background_) {
+      this->Show();
+    }
+    first_frame_shown_ = true;
+    // A background launch is hidden from here on; let the framework know
+    UpdateVisibility();
+    AppHeartbeat::GetInstance().TouchFrame();
+    // Let a relaunching service helper know the app is usable
+    SignalFirstFrame();
+    DumpRequestedStartupTrace();
+    // Non-critical setup runs from here on, between frames and input
+    deferred_init_.Start(GetHandle());
   });
 
+  // Heartbeat for the service helper's hang detector
+  ::SetTimer(GetHandle(), kHeartbeatTimerId, kHeartbeatIntervalMs, nullptr);
+
   // Flutter can complete the first frame before the "show window" callback is
   // registered. The following call ensures a frame is pending to ensure the
   // window is shown. It is a no-op if the first frame hasn't completed yet.
@@ -186,6 +310,22 @@ bool FlutterWindow::OnCreate() {
 }
 
 void FlutterWindow::OnDestroy() {
+  if (GetHandle()) {
+    ::KillTimer(GetHandle(), kHeartbeatTimerId);
+  }
+  deferred_init_.Stop();
+  StallMonitor::GetInstance().Stop();
+  InstanceChannel::GetInstance().SetTarget(nullptr);
+  BulkChannel::GetInstance().SetTarget(nullptr);
+  // The channels live on the engine's messenger
+  instance_args_sink_ = nullptr;
+  if (instance_args_channel_) {
+    instance_args_channel_->SetStreamHandler(nullptr);
+    instance_args_channel_ = nullptr;
+  }
+  lazy_channels_ = nullptr;
+  // Waits for native work in progress; unsent replies are dropped
+  native_executor_ = nullptr;
   if (flutter_controller_) {
     flutter_controller_ = nullptr;
   }
@@ -211,7 +351,523 @@ FlutterWindow::MessageHandler(HWND hwnd, UINT const message,
     case WM_FONTCHANGE:
       flutter_controller_->engine()->ReloadSystemFonts();
       break;
+    case WM_TIMER:
+      if (wparam == kHeartbeatTimerId) {
+        OnHeartbeatTimer();
+        return 0;
+      }
+      if (deferred_init_.HandleTimer(wparam)) {
+        return 0;
+      }
+      break;
+    case RUNNER_FORWARDED_ARGS_MESSAGE:
+      DeliverForwardedArgs();
+      return 0;
+    case RUNNER_BULK_READY_MESSAGE:
+      AnnounceBulkBuffers();
+      return 0;
+    case RUNNER_STALL_PROBE_MESSAGE:
+      StallMonitor::GetInstance().OnProbe(wparam);
+      return 0;
+    case RUNNER_EXECUTOR_COMPLETION_MESSAGE:
+      if (native_executor_) {
+        native_executor_->RunCompletions();
+      }
+      return 0;
+    case WM_WINDOWPOSCHANGED:
+      // Show, hide, minimize, restore and z-order changes of this window.
+      // Other windows covering it are picked up by the heartbeat timer.
+      UpdateVisibility();
+      break;
+    case WM_SHOWWINDOW:
+      // Sent before the window becomes visible, whoever shows it (tray
+      // handler via window_manager, a forwarded launch, the shell)
+      if (wparam && collapsed_in_background_) {
+        ExpandFromBackground();
+      }
+      break;
   }
 
   return Win32Window::MessageHandler(hwnd, message, wparam, lparam);
 }
+
+void FlutterWindow::ExpandFromBackground() {
+  collapsed_in_background_ = false;
+  HWND hwnd = GetHandle();
+  // Dart applies its own window options before showing from the tray
+  RECT current;
+  if (!::GetWindowRect(hwnd, &current) || !::EqualRect(&current, &collapsed_rect_)) {
+    return;
+  }
+  HMONITOR monitor = ::MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST);
+  MONITORINFO monitor_info = {sizeof(monitor_info)};
+  if (!::GetMonitorInfoW(monitor, &monitor_info)) {
+    return;
+  }
+  double scale_factor = FlutterDesktopGetDpiForMonitor(monitor) / 96.0;
+  const RECT& work = monitor_info.rcWork;
+  int width = std::min<int>(static_cast<int>(shown_width_ * scale_factor),
+                            work.right - work.left);
+  int height = std::min<int>(static_cast<int>(shown_height_ * scale_factor),
+                             work.bottom - work.top);
+  ::SetWindowPos(hwnd, nullptr,
+                 work.left + (work.right - work.left - width) / 2,
+                 work.top + (work.bottom - work.top - height) / 2, width, height,
+                 SWP_NOZORDER | SWP_NOACTIVATE);
+}
+
+void FlutterWindow::UpdateVisibility() {
+  // Before the first frame the window is hidden on purpose
+  if (!first_frame_shown_ || !flutter_controller_) {
+    return;
+  }
+  HWND hwnd = GetHandle();
+  WindowVisibility visibility = GetWindowVisibility(hwnd);
+  bool was_visible = visibility_ == WindowVisibility::kVisible;
+  visibility_ = visibility;
+  bool visible = visibility == WindowVisibility::kVisible;
+  if (visible == was_visible) {
+    return;
+  }
+  StallMonitor::GetInstance().SetVisible(visible);
+
+  // The engine reports minimize and focus itself, but not occlusion or a
+  // window that never left the tray. Hidden stops the framework from
+  // scheduling frames (animations, tickers) until we resume it.
+  std::string state = !visible ? "AppLifecycleState.hidden"
+                      : ::GetForegroundWindow() == hwnd
+                          ? "AppLifecycleState.resumed"
+                          : "AppLifecycleState.inactive";
+  flutter_controller_->engine()->messenger()->Send(
+      kLifecycleChannel, reinterpret_cast<const uint8_t*>(state.data()),
+      state.size());
+}
+
+void FlutterWindow::OnHeartbeatTimer() {
+  AppHeartbeat& heartbeat = AppHeartbeat::GetInstance();
+  heartbeat.TouchLoop();
+
+  // The service helper restarts a leaking instance this way. Destroying the
+  // window skips the close-to-tray handler and quits like a normal exit.
+  if (IsShutdownRequested()) {
+    ::DestroyWindow(GetHandle());
+    return;
+  }
+
+  // A startup benchmark run is over once the trace is written.
+  if (exit_after_startup_trace_) {
+    ::DestroyWindow(GetHandle());
+    return;
+  }
+
+  // The startup path owns the next-frame callback until the first frame.
+  if (!first_frame_shown_ || !flutter_controller_) {
+    return;
+  }
+
+  // Occlusion by other windows has no notification; poll it here.
+  UpdateVisibility();
+
+  // A window nobody can see legitimately produces no frames, and probing
+  // would render one for nothing.
+  if (visibility_ != WindowVisibility::kVisible) {
+    heartbeat.CancelFrameProbe();
+    ticks_since_probe_ = 0;
+    return;
+  }
+
+  if (++ticks_since_probe_ < kFrameProbeEveryTicks) {
+    return;
+  }
+  ticks_since_probe_ = 0;
+
+  // Request a frame; if the engine or the Dart UI isolate is stuck the
+  // probe stays pending and the helper sees it age past its threshold.
+  heartbeat.BeginFrameProbe();
+  flutter_controller_->engine()->SetNextFrameCallback([]() {
+    AppHeartbeat::GetInstance().TouchFrame();
+  });
+  flutter_controller_->ForceRedraw();
+}
+
+void FlutterWindow::SetUpStartupTraceChannel() {
+  auto channel = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+      flutter_controller_->engine()->messenger(),
+      "com.a1chimney.a1tools/startup_trace",
+      &flutter::StandardMethodCodec::GetInstance());
+
+  channel->SetMethodCallHandler(
+      [](const flutter::MethodCall<flutter::EncodableValue>& call,
+         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        StartupTrace& trace = StartupTrace::GetInstance();
+
+        if (call.method_name() == "getEvents") {
+          flutter::EncodableList events;
+          for (size_t i = 0; i < trace.size(); i++) {
+            const StartupTrace::Event* event = trace.At(i);
+            if (event == nullptr) {
+              continue;
+            }
+            events.push_back(flutter::EncodableValue(flutter::EncodableMap{
+                {flutter::EncodableValue("name"), flutter::EncodableValue(std::string(event->name))},
+                {flutter::EncodableValue("ph"), flutter::EncodableValue(std::string(1, event->phase))},
+                {flutter::EncodableValue("ts_us"), flutter::EncodableValue(event->ts_us)},
+                {flutter::EncodableValue("tid"), flutter::EncodableValue(static_cast<int64_t>(event->tid))},
+            }));
+          }
+          result->Success(flutter::EncodableValue(events));
+
+        } else if (call.method_name() == "record") {
+          // Expected args: {"name": "dart_main", "ph": "B" | "E" | "i"}
+          const auto* args = std::get_if<flutter::EncodableMap>(call.arguments());
+          if (args) {
+            auto nameIt = args->find(flutter::EncodableValue("name"));
+            auto phaseIt = args->find(flutter::EncodableValue("ph"));
+            if (nameIt != args->end() && phaseIt != args->end()) {
+              const auto* name = std::get_if<std::string>(&nameIt->second);
+              const auto* phase = std::get_if<std::string>(&phaseIt->second);
+              if (name && phase && phase->size() == 1 &&
+                  ((*phase)[0] == 'B' || (*phase)[0] == 'E' || (*phase)[0] == 'i')) {
+                trace.Record(name->c_str(), (*phase)[0]);
+                result->Success();
+                return;
+              }
+            }
+          }
+          result->Error("INVALID_ARGUMENT", "Expected {name: string, ph: 'B' | 'E' | 'i'}");
+
+        } else if (call.method_name() == "dump") {
+          // Optional argument: target path, defaults to the requested path
+          // or the temp directory
+          std::wstring path;
+          if (const auto* arg = std::get_if<std::string>(call.arguments())) {
+            path = Utf8ToWstring(*arg);
+          }
+          if (path.empty()) {
+            path = StartupTrace::RequestedDumpPath();
+          }
+          if (path.empty()) {
+            wchar_t tempDir[MAX_PATH];
+            DWORD length = ::GetTempPathW(MAX_PATH, tempDir);
+            if (length == 0 || length >= MAX_PATH) {
+              result->Error("NO_PATH", "No dump path available");
+              return;
+            }
+            path = std::wstring(tempDir, length) + L"a1_tools_startup_trace.json";
+          }
+          if (!trace.Dump(path)) {
+            result->Error("WRITE_FAILED", "Could not write the startup trace");
+            return;
+          }
+          result->Success(flutter::EncodableValue(WstringToUtf8(path)));
+
+        } else {
+          result->NotImplemented();
+        }
+      });
+}
+
+void FlutterWindow::SetUpNativeExecutorChannel() {
+  lazy_channels_->Register(kNativeExecutorChannel, [this]() -> LazyChannelRegistry::Handler {
+    return [this](const flutter::MethodCall<flutter::EncodableValue>& call,
+                  std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+      if (call.method_name() != "getStats") {
+        result->NotImplemented();
+        return;
+      }
+      // {channel: {completed, rejected, running, waiting, queueUsTotal, ...}}
+      flutter::EncodableMap stats;
+      for (const auto& entry : native_executor_->GetStats()) {
+        const NativeExecutor::KeyStats& key = entry.second;
+        stats[flutter::EncodableValue(entry.first)] = flutter::EncodableValue(flutter::EncodableMap{
+            {flutter::EncodableValue("completed"), flutter::EncodableValue(static_cast<int64_t>(key.completed))},
+            {flutter::EncodableValue("rejected"), flutter::EncodableValue(static_cast<int64_t>(key.rejected))},
+            {flutter::EncodableValue("running"), flutter::EncodableValue(static_cast<int32_t>(key.running))},
+            {flutter::EncodableValue("waiting"), flutter::EncodableValue(static_cast<int32_t>(key.waiting))},
+            {flutter::EncodableValue("queueUsTotal"), flutter::EncodableValue(key.queue_us_total)},
+            {flutter::EncodableValue("queueUsMax"), flutter::EncodableValue(key.queue_us_max)},
+            {flutter::EncodableValue("runUsTotal"), flutter::EncodableValue(key.run_us_total)},
+            {flutter::EncodableValue("runUsMax"), flutter::EncodableValue(key.run_us_max)},
+        });
+      }
+      result->Success(flutter::EncodableValue(stats));
+    };
+  });
+}
+
+void FlutterWindow::SetUpStallMonitorChannel() {
+  lazy_channels_->Register(kStallMonitorChannel, []() -> LazyChannelRegistry::Handler {
+    return [](const flutter::MethodCall<flutter::EncodableValue>& call,
+              std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+      if (call.method_name() != "takeStalls") {
+        result->NotImplemented();
+        return;
+      }
+      // {dropped: n, stalls: [{startedMs, durationMs, message, frames}]}
+      uint64_t dropped = 0;
+      flutter::EncodableList stalls;
+      for (const auto& stall : StallMonitor::GetInstance().TakeStalls(&dropped)) {
+        flutter::EncodableList frames;
+        for (const auto& frame : stall.frames) {
+          frames.push_back(flutter::EncodableValue(frame));
+        }
+        stalls.push_back(flutter::EncodableValue(flutter::EncodableMap{
+            {flutter::EncodableValue("startedMs"), flutter::EncodableValue(stall.started_ms)},
+            {flutter::EncodableValue("durationMs"), flutter::EncodableValue(stall.duration_ms)},
+            {flutter::EncodableValue("message"), flutter::EncodableValue(static_cast<int32_t>(stall.message))},
+            {flutter::EncodableValue("frames"), flutter::EncodableValue(frames)},
+        }));
+      }
+      result->Success(flutter::EncodableValue(flutter::EncodableMap{
+          {flutter::EncodableValue("dropped"), flutter::EncodableValue(static_cast<int64_t>(dropped))},
+          {flutter::EncodableValue("stalls"), flutter::EncodableValue(stalls)},
+      }));
+    };
+  });
+}
+
+void FlutterWindow::AnnounceBulkBuffers() {
+  if (!flutter_controller_) {
+    return;
+  }
+  flutter::BinaryMessenger* messenger = flutter_controller_->engine()->messenger();
+  for (int64_t handle : BulkChannel::GetInstance().TakeReady()) {
+    // Raw little-endian handle; Dart takes over the published reference
+    messenger->Send(RUNNER_BULK_CHANNEL_NAME,
+                    reinterpret_cast<const uint8_t*>(&handle), sizeof(handle));
+  }
+}
+
+void FlutterWindow::SetUpBulkBenchmarkChannel() {
+  // Both directions of the same payload, once through the standard codec
+  // and once through BulkChannel; see benchmark/bulk_channel_benchmark.dart
+  lazy_channels_->Register(kBulkBenchmarkChannel, []() -> LazyChannelRegistry::Handler {
+    BulkChannel::GetInstance().SetConsumer(
+        kBulkBenchmarkKind,
+        [](int64_t handle, const BulkHeader& header, const uint8_t* payload) {
+          // Touch every page like a real consumer would
+          volatile uint8_t sink = 0;
+          for (uint64_t i = 0; i < header.payload_size; i += 4096) {
+            sink ^= payload[i];
+          }
+        });
+
+    return [](const flutter::MethodCall<flutter::EncodableValue>& call,
+              std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+      const auto* size = std::get_if<int32_t>(call.arguments());
+      if (call.method_name() == "produceEncoded" && size && *size >= 0) {
+        std::vector<uint8_t> payload(static_cast<size_t>(*size));
+        memset(payload.data(), 0xA1, payload.size());
+        result->Success(flutter::EncodableValue(std::move(payload)));
+
+      } else if (call.method_name() == "produceBulk" && size && *size >= 0) {
+        uint8_t* payload = nullptr;
+        int64_t handle = BulkChannel::GetInstance().Acquire(*size, &payload);
+        if (handle == 0) {
+          result->Error("NO_BUFFER", "Bulk buffer limit reached");
+          return;
+        }
+        memset(payload, 0xA1, static_cast<size_t>(*size));
+        BulkHeader header = {};
+        header.kind = kBulkBenchmarkKind;
+        header.payload_size = static_cast<uint64_t>(*size);
+        result->Success(flutter::EncodableValue(
+            BulkChannel::GetInstance().Publish(handle, header)));
+
+      } else if (call.method_name() == "consumeEncoded") {
+        const auto* payload = std::get_if<std::vector<uint8_t>>(call.arguments());
+        if (!payload) {
+          result->Error("INVALID_ARGUMENT", "Expected Uint8List");
+          return;
+        }
+        volatile uint8_t sink = 0;
+        for (size_t i = 0; i < payload->size(); i += 4096) {
+          sink ^= (*payload)[i];
+        }
+        result->Success();
+
+      } else {
+        result->NotImplemented();
+      }
+    };
+  });
+}
+
+void FlutterWindow::SetUpScreenCaptureChannel() {
+  // Capture and encode take tens of milliseconds and share one frame
+  // buffer: they run on the executor, one at a time
+  lazy_channels_->Register(kScreenCaptureChannel, [this]() -> LazyChannelRegistry::Handler {
+    auto capture = std::make_shared<ScreenCapture>();
+    return [this, capture](const flutter::MethodCall<flutter::EncodableValue>& call,
+                           std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+      const bool tiles = call.method_name() == "captureTiles";
+      if (!tiles && call.method_name() != "capture") {
+        result->NotImplemented();
+        return;
+      }
+      // Expected args: null or {quality: 1-100, scale: 0.25-1,
+      // source: "screen" | "synthetic", width, height}, plus {tileSize, full}
+      // for "captureTiles"; the size only applies to "synthetic"
+      ScreenCapture::Source source = ScreenCapture::Source::kScreen;
+      int quality = 75;
+      double scale = 1.0;
+      int width = 1920;
+      int height = 1080;
+      int tile_size = 64;
+      bool full = false;
+      if (const auto* args = std::get_if<flutter::EncodableMap>(call.arguments())) {
+        auto int_arg = [args](const char* key, int* value) {
+          auto it = args->find(flutter::EncodableValue(key));
+          if (it != args->end()) {
+            if (const auto* number = std::get_if<int32_t>(&it->second)) {
+              *value = *number;
+            }
+          }
+        };
+        int_arg("quality", &quality);
+        int_arg("width", &width);
+        int_arg("height", &height);
+        int_arg("tileSize", &tile_size);
+        auto scale_it = args->find(flutter::EncodableValue("scale"));
+        if (scale_it != args->end()) {
+          if (const auto* number = std::get_if<double>(&scale_it->second)) {
+            scale = *number;
+          }
+        }
+        auto full_it = args->find(flutter::EncodableValue("full"));
+        if (full_it != args->end()) {
+          const auto* value = std::get_if<bool>(&full_it->second);
+          full = value && *value;
+        }
+        auto source_it = args->find(flutter::EncodableValue("source"));
+        if (source_it != args->end()) {
+          const auto* name = std::get_if<std::string>(&source_it->second);
+          if (name && *name == "synthetic") {
+            source = ScreenCapture::Source::kSynthetic;
+          } else if (!name || *name != "screen") {
+            result->Error("INVALID_ARGUMENT", "Unknown capture source");
+            return;
+          }
+        }
+      }
+      if (quality < 1 || quality > 100) {
+        result->Error("INVALID_ARGUMENT", "Quality must be 1-100");
+        return;
+      }
+      if (!(scale >= ScreenCapture::kMinScale && scale <= 1)) {
+        result->Error("INVALID_ARGUMENT", "Scale must be in 0.25-1");
+        return;
+      }
+      if (source == ScreenCapture::Source::kSynthetic &&
+          (width <= 0 || width > ScreenCapture::kMaxSyntheticSize ||
+           height <= 0 || height > ScreenCapture::kMaxSyntheticSize)) {
+        result->Error("INVALID_ARGUMENT", "Synthetic frame size out of range");
+        return;
+      }
+      if (tile_size < ScreenCapture::kMinTileSize ||
+          tile_size > ScreenCapture::kMaxTileSize || tile_size % 16 != 0) {
+        result->Error("INVALID_ARGUMENT",
+                      "Tile size must be a multiple of 16 in 32-256");
+        return;
+      }
+
+      SharedMethodResult shared_result(std::move(result));
+      bool queued = native_executor_->Submit(
+          kScreenCaptureChannel,
+          [capture, tiles, source, width, height, quality, scale, tile_size,
+           full, shared_result]() {
+            ScreenCapture::Frame frame;
+            std::string code;
+            std::string message;
+            bool captured =
+                tiles ? capture->CaptureTiles(source, width, height, quality,
+                                              scale, tile_size, full, &frame,
+                                              &code, &message)
+                      : capture->Capture(source, width, height, quality, scale,
+                                         &frame, &code, &message);
+            if (!captured) {
+              return ReplyError(shared_result, code, message);
+            }
+            // Same keys as linux/runner/screen_capture.h; jpeg and atlas
+            // only when encoded
+            flutter::EncodableMap reply{
+                {flutter::EncodableValue("width"), flutter::EncodableValue(frame.width)},
+                {flutter::EncodableValue("height"), flutter::EncodableValue(frame.height)},
+                {flutter::EncodableValue("captureUs"), flutter::EncodableValue(frame.capture_us)},
+                {flutter::EncodableValue("scaleUs"), flutter::EncodableValue(frame.scale_us)},
+                {flutter::EncodableValue("encodeUs"), flutter::EncodableValue(frame.encode_us)},
+            };
+            if (!tiles || full) {
+              reply[flutter::EncodableValue("jpeg")] =
+                  flutter::EncodableValue(std::move(frame.jpeg));
+            }
+            if (tiles) {
+              reply[flutter::EncodableValue("tileSize")] =
+                  flutter::EncodableValue(frame.tile_size);
+              reply[flutter::EncodableValue("tiles")] =
+                  flutter::EncodableValue(std::move(frame.tile_indices));
+              if (!frame.atlas.empty()) {
+                reply[flutter::EncodableValue("atlas")] =
+                    flutter::EncodableValue(std::move(frame.atlas));
+              }
+              reply[flutter::EncodableValue("hashUs")] =
+                  flutter::EncodableValue(frame.hash_us);
+            }
+            return ReplySuccess(shared_result, flutter::EncodableValue(std::move(reply)));
+          });
+      if (!queued) {
+        shared_result->Error("BUSY", "Too many native calls pending");
+      }
+    };
+  });
+}
+
+void FlutterWindow::DumpRequestedStartupTrace() {
+  std::wstring path = StartupTrace::RequestedDumpPath();
+  if (path.empty()) {
+    return;
+  }
+  StartupTrace::GetInstance().Dump(path);
+  // Quit from the next heartbeat tick rather than from inside the engine's
+  // frame callback
+  exit_after_startup_trace_ = StartupTrace::ExitAfterDumpRequested();
+}
+
+void FlutterWindow::SetUpInstanceArgsChannel() {
+  instance_args_channel_ = std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+      flutter_controller_->engine()->messenger(),
+      "com.a1chimney.a1tools/instance_args",
+      &flutter::StandardMethodCodec::GetInstance());
+
+  instance_args_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            instance_args_sink_ = std::move(events);
+            // Launches that arrived before Dart listened
+            DeliverForwardedArgs();
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            instance_args_sink_ = nullptr;
+            return nullptr;
+          }));
+
+  InstanceChannel::GetInstance().SetTarget(GetHandle());
+}
+
+void FlutterWindow::DeliverForwardedArgs() {
+  // Keep them queued until Dart listens
+  if (!instance_args_sink_) {
+    return;
+  }
+  for (const auto& args : InstanceChannel::GetInstance().TakePending()) {
+    flutter::EncodableList list;
+    for (const auto& arg : args) {
+      list.push_back(flutter::EncodableValue(arg));
+    }
+    instance_args_sink_->Success(flutter::EncodableValue(list));
+  }
+}
@@ -2,11 +2,16 @@
 #define RUNNER_FLUTTER_WINDOW_H_
 
 #include <flutter/dart_project.h>
+#include <flutter/encodable_value.h>
+#include <flutter/event_channel.h>
 #include <flutter/flutter_view_controller.h>
 
 #include <memory>
 
+#include "deferred_init.h"
+#include "native_executor.h"
 #include "win32_window.h"
+#include "window_visibility.h"
 
 // A window that does nothing but host a Flutter view.
 class FlutterWindow : public Win32Window {
@@ -15,6 +20,13 @@ class FlutterWindow : public Win32Window {
   explicit FlutterWindow(const flutter::DartProject& project);
   virtual ~FlutterWindow();
 
+  // Background launch (auto-start, restarts): the window is created at a
+  // minimal size and not shown on the first frame, so the engine and Dart
+  // services run without presenting anything. The first time the window is
+  // shown (from the tray) it grows to |shown_size|, in logical pixels.
+  // Must be called before Create.
+  void StartInBackground(const Win32Window::Size& shown_size);
+
  protected:
   // Win32Window:
   bool OnCreate() override;
@@ -28,6 +40,76 @@ class FlutterWindow : public Win32Window {
 
   // The Flutter instance hosted by this window.
   std::unique_ptr<flutter::FlutterViewController> flutter_controller_;
+
+  // Runner channels whose state is created on first use.
+  std::unique_ptr<LazyChannelRegistry> lazy_channels_;
+
+  // Startup work run after the first frame.
+  DeferredInitQueue deferred_init_;
+
+  // Runs blocking native work of channel handlers off the platform thread.
+  std::unique_ptr<NativeExecutor> native_executor_;
+
+  // Delivers command lines forwarded by later launches to Dart.
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> instance_args_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> instance_args_sink_;
+
+  // Publishes a heartbeat tick and, every few ticks, probes for a frame so
+  // the service helper can detect a hung app.
+  void OnHeartbeatTimer();
+
+  // Registers the com.a1chimney.a1tools/startup_trace method channel.
+  void SetUpStartupTraceChannel();
+
+  // Registers the com.a1chimney.a1tools/native_executor stats channel.
+  void SetUpNativeExecutorChannel();
+
+  // Registers the com.a1chimney.a1tools/stall_monitor channel.
+  void SetUpStallMonitorChannel();
+
+  // Sends handles published on BulkChannel to Dart.
+  void AnnounceBulkBuffers();
+
+  // Registers the com.a1chimney.a1tools/bulk_benchmark channel.
+  void SetUpBulkBenchmarkChannel();
+
+  // Registers the com.a1chimney.a1tools/screen_capture channel.
+  void SetUpScreenCaptureChannel();
+
+  // Writes the startup trace if the environment asked for it.
+  void DumpRequestedStartupTrace();
+
+  // Registers the com.a1chimney.a1tools/instance_args event channel.
+  void SetUpInstanceArgsChannel();
+
+  // Sends queued forwarded command lines to Dart if it is listening.
+  void DeliverForwardedArgs();
+
+  // Grows a background-launched window to its normal size and centers it
+  // on its monitor, unless something else sized it since creation.
+  void ExpandFromBackground();
+
+  // Re-evaluates minimized / hidden / occluded and tells the framework when
+  // the window stops or starts being visible.
+  void UpdateVisibility();
+
+  // Last visibility reported through the lifecycle channel.
+  WindowVisibility visibility_ = WindowVisibility::kVisible;
+
+  // Set by StartInBackground until the window is first shown.
+  bool collapsed_in_background_ = false;
+  RECT collapsed_rect_ = {};
+  unsigned int shown_width_ = 0;
+  unsigned int shown_height_ = 0;
+
+  // Set once the first frame has been shown.
+  bool first_frame_shown_ = false;
+
+  // Set when a startup benchmark run asked the app to quit after the trace.
+  bool exit_after_startup_trace_ = false;
+
+  // Heartbeat timer ticks since the last frame probe.
+  unsigned int ticks_since_probe_ = 0;
 };
 
 #endif  // RUNNER_FLUTTER_WINDOW_H_
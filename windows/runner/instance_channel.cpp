@@ -0,0 +1,265 @@
+#include "instance_channel.h"
+
+#include <string.h>
+
+#include <cstdint>
+
+static const uint32_t kMessageMagic = 0x41493141;  // "A1IA"
+static const DWORD kMaxMessageBytes = 64 * 1024;
+static const DWORD kClientTimeoutMs = 2000;  // Second launch waiting on the primary
+static const DWORD kServerIoTimeoutMs = 1000;  // Primary waiting on a client
+// Clients are served one at a time; the second instance only exists so the
+// name never disappears while the next one is set up.
+static const DWORD kPipeInstances = 2;
+
+static void AppendUint32(std::string* out, uint32_t value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static bool ReadUint32(const char** cursor, const char* end, uint32_t* value) {
+  if (end - *cursor < static_cast<ptrdiff_t>(sizeof(uint32_t))) {
+    return false;
+  }
+  memcpy(value, *cursor, sizeof(uint32_t));
+  *cursor += sizeof(uint32_t);
+  return true;
+}
+
+static std::string EncodeArgs(const std::vector<std::string>& args) {
+  std::string message;
+  AppendUint32(&message, kMessageMagic);
+  AppendUint32(&message, static_cast<uint32_t>(args.size()));
+  for (const auto& arg : args) {
+    AppendUint32(&message, static_cast<uint32_t>(arg.size()));
+    message += arg;
+  }
+  return message;
+}
+
+static bool DecodeArgs(const char* data, size_t size,
+                       std::vector<std::string>* args) {
+  const char* cursor = data;
+  const char* end = data + size;
+  uint32_t magic = 0, count = 0;
+  if (!ReadUint32(&cursor, end, &magic) || magic != kMessageMagic ||
+      !ReadUint32(&cursor, end, &count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t length = 0;
+    if (!ReadUint32(&cursor, end, &length) ||
+        static_cast<size_t>(end - cursor) < length) {
+      return false;
+    }
+    args->emplace_back(cursor, length);
+    cursor += length;
+  }
+  return cursor == end;
+}
+
+InstanceChannel& InstanceChannel::GetInstance() {
+  static InstanceChannel instance;
+  return instance;
+}
+
+InstanceChannel::InstanceChannel()
+    : stop_event_(::CreateEventW(nullptr, TRUE, FALSE, nullptr)),
+      target_(nullptr) {}
+
+InstanceChannel::~InstanceChannel() {
+  Stop();
+  if (stop_event_) {
+    ::CloseHandle(stop_event_);
+  }
+}
+
+std::wstring InstanceChannel::PipeName() {
+  // Per session, like the single-instance mutex
+  DWORD session = 0;
+  ::ProcessIdToSessionId(::GetCurrentProcessId(), &session);
+  return L"\\\\.\\pipe\\A1ToolsInstance-" + std::to_wstring(session);
+}
+
+bool InstanceChannel::ForwardToPrimary(const std::vector<std::string>& args) {
+  std::string message = EncodeArgs(args);
+  if (message.size() > kMaxMessageBytes) {
+    return false;
+  }
+
+  std::wstring name = PipeName();
+  ULONGLONG deadline = ::GetTickCount64() + kClientTimeoutMs;
+  HANDLE pipe = INVALID_HANDLE_VALUE;
+  while (true) {
+    pipe = ::CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                         OPEN_EXISTING, 0, nullptr);
+    if (pipe != INVALID_HANDLE_VALUE) {
+      break;
+    }
+    ULONGLONG now = ::GetTickCount64();
+    if (now >= deadline) {
+      return false;
+    }
+    DWORD error = ::GetLastError();
+    if (error == ERROR_PIPE_BUSY) {
+      ::WaitNamedPipeW(name.c_str(), static_cast<DWORD>(deadline - now));
+    } else if (error == ERROR_FILE_NOT_FOUND) {
+      // The primary holds the mutex but may not have created the pipe yet
+      ::Sleep(50);
+    } else {
+      return false;
+    }
+  }
+
+  DWORD mode = PIPE_READMODE_MESSAGE;
+  ::SetNamedPipeHandleState(pipe, &mode, nullptr, nullptr);
+
+  // Let the primary bring its window to the front if Dart decides to
+  ::AllowSetForegroundWindow(ASFW_ANY);
+
+  DWORD written = 0, read = 0;
+  char ack = 0;
+  bool ok = ::WriteFile(pipe, message.data(), static_cast<DWORD>(message.size()),
+                        &written, nullptr) &&
+            written == message.size() &&
+            ::ReadFile(pipe, &ack, 1, &read, nullptr) && read == 1 && ack == 1;
+  ::CloseHandle(pipe);
+  return ok;
+}
+
+bool InstanceChannel::Start() {
+  if (thread_.joinable() || stop_event_ == nullptr) {
+    return thread_.joinable();
+  }
+  // FILE_FLAG_FIRST_PIPE_INSTANCE fails if any other process already serves
+  // the name, so a squatter cannot receive our arguments
+  HANDLE pipe = ::CreateNamedPipeW(
+      PipeName().c_str(),
+      PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+      PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT |
+          PIPE_REJECT_REMOTE_CLIENTS,
+      kPipeInstances, 16, kMaxMessageBytes, 0, nullptr);
+  if (pipe == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  ::ResetEvent(stop_event_);
+  thread_ = std::thread(&InstanceChannel::Serve, this, pipe);
+  return true;
+}
+
+void InstanceChannel::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  ::SetEvent(stop_event_);
+  thread_.join();
+}
+
+void InstanceChannel::SetTarget(HWND window) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  target_ = window;
+  if (target_ != nullptr && !pending_.empty()) {
+    ::PostMessageW(target_, RUNNER_FORWARDED_ARGS_MESSAGE, 0, 0);
+  }
+}
+
+std::vector<std::vector<std::string>> InstanceChannel::TakePending() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::vector<std::string>> pending;
+  pending.swap(pending_);
+  return pending;
+}
+
+bool InstanceChannel::WaitForIo(HANDLE pipe, OVERLAPPED* overlapped,
+                                BOOL started, DWORD timeout_ms,
+                                DWORD* transferred) {
+  if (!started && ::GetLastError() != ERROR_IO_PENDING) {
+    return false;
+  }
+  HANDLE events[] = {stop_event_, overlapped->hEvent};
+  DWORD wait = ::WaitForMultipleObjects(2, events, FALSE, timeout_ms);
+  if (wait != WAIT_OBJECT_0 + 1) {
+    ::CancelIoEx(pipe, overlapped);
+  }
+  // Always collect the result so the OVERLAPPED is no longer in use
+  DWORD bytes = 0;
+  BOOL ok = ::GetOverlappedResult(pipe, overlapped, &bytes, TRUE);
+  if (transferred != nullptr) {
+    *transferred = bytes;
+  }
+  return ok && wait == WAIT_OBJECT_0 + 1;
+}
+
+void InstanceChannel::Serve(HANDLE first_pipe) {
+  HANDLE io_event = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  HANDLE pipe = first_pipe;
+  std::wstring name = PipeName();
+
+  while (io_event != nullptr && pipe != INVALID_HANDLE_VALUE) {
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = io_event;
+    ::ResetEvent(io_event);
+    BOOL connected = ::ConnectNamedPipe(pipe, &overlapped);
+    if (!connected && ::GetLastError() == ERROR_PIPE_CONNECTED) {
+      connected = TRUE;  // Client connected between create and connect
+    } else {
+      connected = WaitForIo(pipe, &overlapped, connected, INFINITE, nullptr);
+    }
+    if (::WaitForSingleObject(stop_event_, 0) == WAIT_OBJECT_0) {
+      break;
+    }
+    if (connected) {
+      ServeClient(pipe, io_event);
+    }
+
+    // Set up the next instance before dropping this one, so another
+    // process never gets the chance to create the name
+    HANDLE next = ::CreateNamedPipeW(
+        name.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT |
+            PIPE_REJECT_REMOTE_CLIENTS,
+        kPipeInstances, 16, kMaxMessageBytes, 0, nullptr);
+    ::DisconnectNamedPipe(pipe);
+    ::CloseHandle(pipe);
+    pipe = next;
+  }
+
+  if (pipe != INVALID_HANDLE_VALUE) {
+    ::CloseHandle(pipe);
+  }
+  if (io_event != nullptr) {
+    ::CloseHandle(io_event);
+  }
+}
+
+void InstanceChannel::ServeClient(HANDLE pipe, HANDLE io_event) {
+  std::vector<char> buffer(kMaxMessageBytes);
+  OVERLAPPED overlapped = {};
+  overlapped.hEvent = io_event;
+  ::ResetEvent(io_event);
+
+  DWORD read = 0;
+  BOOL started = ::ReadFile(pipe, buffer.data(), kMaxMessageBytes, nullptr,
+                            &overlapped);
+  if (!WaitForIo(pipe, &overlapped, started, kServerIoTimeoutMs, &read)) {
+    return;  // Includes ERROR_MORE_DATA for oversized messages
+  }
+
+  std::vector<std::string> args;
+  if (!DecodeArgs(buffer.data(), read, &args)) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(std::move(args));
+    if (target_ != nullptr) {
+      ::PostMessageW(target_, RUNNER_FORWARDED_ARGS_MESSAGE, 0, 0);
+    }
+  }
+
+  const char ack = 1;
+  overlapped = {};
+  overlapped.hEvent = io_event;
+  ::ResetEvent(io_event);
+  started = ::WriteFile(pipe, &ack, 1, nullptr, &overlapped);
+  WaitForIo(pipe, &overlapped, started, kServerIoTimeoutMs, nullptr);
+}
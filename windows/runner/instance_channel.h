@@ -0,0 +1,69 @@
+#ifndef RUNNER_INSTANCE_CHANNEL_H_
+#define RUNNER_INSTANCE_CHANNEL_H_
+
+#include <windows.h>
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Posted to the target window when forwarded arguments are waiting in
+// InstanceChannel::TakePending().
+#define RUNNER_FORWARDED_ARGS_MESSAGE (WM_APP + 0x41)
+
+// Single-instance IPC. The primary instance serves a named pipe
+// (\\.\pipe\A1ToolsInstance-<session id>); a second launch sends its
+// command line over it and exits instead of starting another engine. The
+// primary hands the arguments to Dart over the
+// com.a1chimney.a1tools/instance_args event channel.
+//
+// Wire format (little-endian): uint32 magic, uint32 argument count, then per
+// argument a uint32 byte length and the UTF-8 bytes. The primary answers
+// with one byte (1) once the arguments are queued.
+class InstanceChannel {
+ public:
+  static InstanceChannel& GetInstance();
+
+  // Second launch: sends |args| to the primary. Returns true if the primary
+  // acknowledged them; false if no primary is reachable.
+  static bool ForwardToPrimary(const std::vector<std::string>& args);
+
+  // Primary: creates the pipe and starts serving it on a background thread.
+  // Returns false if another process already owns the pipe.
+  bool Start();
+
+  // Stops the server thread.
+  void Stop();
+
+  // Window that receives RUNNER_FORWARDED_ARGS_MESSAGE; nullptr to detach.
+  // Arguments received before a target is set are kept.
+  void SetTarget(HWND window);
+
+  // Forwarded command lines received so far, oldest first.
+  std::vector<std::vector<std::string>> TakePending();
+
+ private:
+  InstanceChannel();
+  ~InstanceChannel();
+
+  // Disable copy
+  InstanceChannel(const InstanceChannel&) = delete;
+  InstanceChannel& operator=(const InstanceChannel&) = delete;
+
+  static std::wstring PipeName();
+  void Serve(HANDLE first_pipe);
+  void ServeClient(HANDLE pipe, HANDLE io_event);
+
+  // Waits for overlapped I/O on |pipe|; false on failure, timeout or stop.
+  bool WaitForIo(HANDLE pipe, OVERLAPPED* overlapped, BOOL started,
+                 DWORD timeout_ms, DWORD* transferred);
+
+  std::thread thread_;
+  HANDLE stop_event_;
+  std::mutex mutex_;  // Guards the members below
+  HWND target_;
+  std::vector<std::vector<std::string>> pending_;
+};
+
+#endif  // RUNNER_INSTANCE_CHANNEL_H_
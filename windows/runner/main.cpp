@@ -3,22 +3,39 @@
 #include <windows.h>
 #include <wchar.h>
 
+#include "app_heartbeat.h"
 #include "flutter_window.h"
+#include "instance_channel.h"
+#include "native_log.h"
+#include "prefetch.h"
+#include "stall_monitor.h"
+#include "startup_trace.h"
 #include "utils.h"
 
 int APIENTRY wWinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prev,
                       _In_ wchar_t *command_line, _In_ int show_command) {
+  StartupTrace& trace = StartupTrace::GetInstance();
+  trace.Begin("wWinMain");
+
   // ******** SINGLE INSTANCE GUARD ********
   // Use a unique, stable name for your app's mutex
   const wchar_t* kMutexName = L"A1ToolsSingleInstanceMutex";
 
   // Create (or open if it already exists) a named mutex
+  trace.Begin("single_instance_mutex");
   HANDLE hMutex = ::CreateMutexW(nullptr, FALSE, kMutexName);
+  trace.End("single_instance_mutex");
 
   if (hMutex != nullptr && ::GetLastError() == ERROR_ALREADY_EXISTS) {
-    // Another instance is already running.
+    // Another instance is already running. Hand it our arguments (deep
+    // links, --auto-start, ...) and let it decide whether to show itself.
+    if (InstanceChannel::ForwardToPrimary(GetCommandLineArguments())) {
+      ::CloseHandle(hMutex);
+      return 0;
+    }
 
-    // Try to find the existing window by its title and bring it to front.
+    // No answer from the primary (older version or stuck): at least try to
+    // find the existing window by its title and bring it to front.
     // IMPORTANT: this must match the title you use in window.Create(...)
     HWND existing = ::FindWindowW(nullptr, L"A1 Tools");
     if (existing != nullptr) {
@@ -32,6 +49,19 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prev,
   }
   // ******** END SINGLE INSTANCE GUARD ********
 
+  // As early as possible, so the reads overlap everything else on a cold
+  // start; only after the guard since a second instance exits right away
+  StartPrefetch();
+
+  // Binary log shared with plugins and Dart; records before this are queued
+  NativeLog::GetInstance().Start(NativeLog::DefaultDirectory());
+
+  // Accept arguments from later launches; FlutterWindow delivers them to Dart
+  InstanceChannel::GetInstance().Start();
+
+  // Shared-memory heartbeat read by the service helper's hang detector
+  AppHeartbeat::GetInstance().Open();
+
   // Detect launch source from command line flags
   bool autoStart = false;
   bool crashRestart = false;
@@ -66,7 +96,9 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prev,
 
   // Initialize COM, so that it is available for use in the library and/or
   // plugins.
+  trace.Begin("CoInitializeEx");
   ::CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+  trace.End("CoInitializeEx");
 
   flutter::DartProject project(L"data");
 
@@ -78,7 +110,20 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prev,
   FlutterWindow window(project);
   Win32Window::Point origin(10, 10);
   Win32Window::Size size(1280, 720);
-  if (!window.Create(L"A1 Tools", origin, size)) {
+
+  // Launched by Windows auto-start or a restart mechanism: run the engine and
+  // Dart services from the tray without presenting the window. It starts at
+  // a minimal size, so the first frame is cheap, and grows to |size| when
+  // the user opens it.
+  if (autoStart || crashRestart || serviceRestart) {
+    window.StartInBackground(size);
+    size = Win32Window::Size(1, 1);
+  }
+
+  trace.Begin("window_create");
+  bool created = window.Create(L"A1 Tools", origin, size);
+  trace.End("window_create");
+  if (!created) {
     ::CoUninitialize();
     if (hMutex) {
       ::CloseHandle(hMutex);
@@ -87,21 +132,21 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prev,
   }
   window.SetQuitOnClose(true);
 
-  // If we were launched by Windows auto-start or a restart mechanism, minimize the window
-  // This keeps the app running in the system tray without interrupting the user
-  if (autoStart || crashRestart || serviceRestart) {
-    HWND hwnd = ::FindWindowW(nullptr, L"A1 Tools");
-    if (hwnd != nullptr) {
-      ::ShowWindow(hwnd, SW_MINIMIZE);
-    }
-  }
+  // Everything after this runs from the message loop; the first frame is
+  // recorded by FlutterWindow
+  trace.End("wWinMain");
 
+  StallMonitor& stall_monitor = StallMonitor::GetInstance();
   ::MSG msg;
   while (::GetMessage(&msg, nullptr, 0, 0)) {
     ::TranslateMessage(&msg);
+    stall_monitor.OnDispatch(msg.message);
     ::DispatchMessage(&msg);
+    stall_monitor.OnDispatch(0);
   }
 
+  InstanceChannel::GetInstance().Stop();
+  NativeLog::GetInstance().Stop();
   ::CoUninitialize();
 
   // Clean up our mutex handle before exiting
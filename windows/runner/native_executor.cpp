@@ -0,0 +1,199 @@
+#include "native_executor.h"
+
+#include <algorithm>
+
+// Queued, waiting and running work across all keys.
+static const size_t kMaxPending = 256;
+
+// Native handler work is mostly waiting on the OS, not CPU, but a couple of
+// workers keep one slow key from holding up the others.
+static const unsigned int kMinWorkers = 2;
+static const unsigned int kMaxWorkers = 4;
+
+static int64_t ToMicroseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+NativeExecutor::NativeExecutor(HWND window) : window_(window) {}
+
+NativeExecutor::~NativeExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  // Workers check stopping_ before taking a task, so only the work already
+  // running is waited for; nothing queued starts on the way out
+  for (auto& worker : workers_) {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    worker->tasks.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(keys_mutex_);
+    for (auto& entry : keys_) {
+      entry.second.waiting.clear();
+    }
+  }
+  for (auto& worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+bool NativeExecutor::Submit(const std::string& key, Work work) {
+  Task task;
+  {
+    std::lock_guard<std::mutex> lock(keys_mutex_);
+    KeyState& state = keys_[key];
+    if (pending_ >= kMaxPending) {
+      state.stats.rejected++;
+      return false;
+    }
+    pending_++;
+    task = Task{&state, std::move(work), Clock::now()};
+    if (state.stats.running > 0) {
+      state.waiting.push_back(std::move(task));
+      state.stats.waiting = static_cast<unsigned int>(state.waiting.size());
+      return true;
+    }
+    state.stats.running++;
+  }
+
+  if (workers_.empty()) {
+    StartWorkers();
+  }
+  Dispatch(next_worker_++, std::move(task));
+  return true;
+}
+
+void NativeExecutor::RunCompletions() {
+  std::vector<Completion> completions;
+  {
+    std::lock_guard<std::mutex> lock(completions_mutex_);
+    completions.swap(completions_);
+  }
+  for (auto& completion : completions) {
+    completion();
+  }
+}
+
+std::map<std::string, NativeExecutor::KeyStats> NativeExecutor::GetStats() {
+  std::lock_guard<std::mutex> lock(keys_mutex_);
+  std::map<std::string, KeyStats> stats;
+  for (const auto& entry : keys_) {
+    stats[entry.first] = entry.second.stats;
+  }
+  return stats;
+}
+
+void NativeExecutor::StartWorkers() {
+  unsigned int count = std::clamp(std::thread::hardware_concurrency() / 2,
+                                  kMinWorkers, kMaxWorkers);
+  // All workers exist before any thread starts, so workers_ never changes
+  // while they read it
+  for (unsigned int i = 0; i < count; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < workers_.size(); i++) {
+    workers_[i]->thread = std::thread(&NativeExecutor::WorkerLoop, this, i);
+  }
+}
+
+void NativeExecutor::Dispatch(size_t worker_index, Task task) {
+  Worker& worker = *workers_[worker_index % workers_.size()];
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    queued_++;
+  }
+  wake_.notify_one();
+}
+
+bool NativeExecutor::TakeTask(size_t worker_index, Task* task) {
+  // Own queue oldest first, then steal the newest work of the others
+  for (size_t i = 0; i < workers_.size(); i++) {
+    Worker& worker = *workers_[(worker_index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+      continue;
+    }
+    if (i == 0) {
+      *task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+    } else {
+      *task = std::move(worker.tasks.back());
+      worker.tasks.pop_back();
+    }
+    queued_--;
+    return true;
+  }
+  return false;
+}
+
+void NativeExecutor::WorkerLoop(size_t worker_index) {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      if (stopping_) {
+        return;
+      }
+    }
+    Task task;
+    if (TakeTask(worker_index, &task)) {
+      Clock::time_point started = Clock::now();
+      Completion completion = task.work();
+      Finish(worker_index, task, started, std::move(completion));
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_.wait(lock, [this]() { return stopping_ || queued_ > 0; });
+  }
+}
+
+void NativeExecutor::Finish(size_t worker_index, const Task& task,
+                            Clock::time_point started, Completion completion) {
+  Clock::time_point finished = Clock::now();
+  Task next;
+  bool has_next = false;
+  {
+    std::lock_guard<std::mutex> lock(keys_mutex_);
+    KeyStats& stats = task.key->stats;
+    int64_t queue_us = ToMicroseconds(started - task.submitted);
+    int64_t run_us = ToMicroseconds(finished - started);
+    stats.completed++;
+    stats.queue_us_total += queue_us;
+    stats.queue_us_max = std::max(stats.queue_us_max, queue_us);
+    stats.run_us_total += run_us;
+    stats.run_us_max = std::max(stats.run_us_max, run_us);
+    pending_--;
+    // Hand the freed slot straight to the key's next waiting work
+    if (!task.key->waiting.empty()) {
+      next = std::move(task.key->waiting.front());
+      task.key->waiting.pop_front();
+      stats.waiting = static_cast<unsigned int>(task.key->waiting.size());
+      has_next = true;
+    } else {
+      stats.running--;
+    }
+  }
+  if (has_next) {
+    Dispatch(worker_index, std::move(next));
+  }
+
+  if (!completion) {
+    return;
+  }
+  bool post = false;
+  {
+    std::lock_guard<std::mutex> lock(completions_mutex_);
+    post = completions_.empty();
+    completions_.push_back(std::move(completion));
+  }
+  if (post) {
+    ::PostMessageW(window_, RUNNER_EXECUTOR_COMPLETION_MESSAGE, 0, 0);
+  }
+}
@@ -0,0 +1,122 @@
+#ifndef RUNNER_NATIVE_EXECUTOR_H_
+#define RUNNER_NATIVE_EXECUTOR_H_
+
+#include <windows.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Posted to the platform window when completions are waiting in
+// NativeExecutor::RunCompletions().
+#define RUNNER_EXECUTOR_COMPLETION_MESSAGE (WM_APP + 0x42)
+
+// Runs blocking native work for method-channel handlers off the platform
+// thread, so a slow call (process injection, file system probes) cannot
+// stall frame production or input.
+//
+// Work runs on a small pool of workers with per-worker queues; an idle
+// worker steals from the others. Each piece of work returns a completion,
+// which is posted back to the platform window and run there, since
+// MethodResult and the messenger must only be used on the platform thread.
+//
+// Work is grouped by key (normally the channel name) and work under one key
+// runs one at a time, in submit order, so handlers whose native state is not
+// thread-safe stay serialized without their own locking. Everything queued
+// in the executor is bounded; Submit fails instead of growing.
+class NativeExecutor {
+ public:
+  // Runs on the platform thread.
+  using Completion = std::function<void()>;
+  // Runs on a worker; returns what to run on the platform thread after.
+  using Work = std::function<Completion()>;
+
+  struct KeyStats {
+    uint64_t completed = 0;
+    uint64_t rejected = 0;  // Submit failed because the executor was full
+    unsigned int running = 0;
+    unsigned int waiting = 0;  // Held back behind the key's running work
+    int64_t queue_us_total = 0;  // Submit to start of work
+    int64_t queue_us_max = 0;
+    int64_t run_us_total = 0;
+    int64_t run_us_max = 0;
+  };
+
+  // |window| receives RUNNER_EXECUTOR_COMPLETION_MESSAGE. Workers are
+  // started on the first Submit.
+  explicit NativeExecutor(HWND window);
+
+  // Waits for work already running; queued work and completions are dropped
+  // without running.
+  ~NativeExecutor();
+
+  // Queues |work| under |key|. Returns false if the executor is full or
+  // shutting down; |work| is then dropped without running.
+  bool Submit(const std::string& key, Work work);
+
+  // Runs completions posted so far. Call on RUNNER_EXECUTOR_COMPLETION_MESSAGE.
+  void RunCompletions();
+
+  // Snapshot of per-key timing and queue stats.
+  std::map<std::string, KeyStats> GetStats();
+
+ private:
+  // Disable copy
+  NativeExecutor(const NativeExecutor&) = delete;
+  NativeExecutor& operator=(const NativeExecutor&) = delete;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct KeyState;
+
+  struct Task {
+    KeyState* key;
+    Work work;
+    Clock::time_point submitted;
+  };
+
+  struct KeyState {
+    std::deque<Task> waiting;
+    KeyStats stats;
+  };
+
+  struct Worker {
+    std::mutex mutex;  // Guards tasks
+    std::deque<Task> tasks;
+    std::thread thread;
+  };
+
+  void StartWorkers();
+  void Dispatch(size_t worker_index, Task task);
+  bool TakeTask(size_t worker_index, Task* task);
+  void WorkerLoop(size_t worker_index);
+  void Finish(size_t worker_index, const Task& task, Clock::time_point started,
+              Completion completion);
+
+  HWND window_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  size_t next_worker_ = 0;  // Round-robin target for Submit
+
+  std::mutex sleep_mutex_;  // Guards the wake condition (queued_, stopping_)
+  std::condition_variable wake_;
+  std::atomic<size_t> queued_{0};  // Tasks in worker queues
+  bool stopping_ = false;
+
+  std::mutex keys_mutex_;  // Guards keys_ and pending_
+  std::map<std::string, KeyState> keys_;
+  size_t pending_ = 0;  // Queued, waiting or running
+
+  std::mutex completions_mutex_;
+  std::vector<Completion> completions_;
+};
+
+#endif  // RUNNER_NATIVE_EXECUTOR_H_
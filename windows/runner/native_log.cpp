@@ -0,0 +1,457 @@
+#include "native_log.h"
+
+#include <algorithm>
+#include <chrono>
+
+static const uint64_t kSegmentSize = 4ull << 20;
+// runner.a1log and runner.1.a1log up to runner.3.a1log.
+static const int kKeptSegments = 4;
+static const int64_t kFlushIntervalMs = 20;
+
+static uint64_t UnixNowMicroseconds() {
+  FILETIME file_time;
+  ::GetSystemTimePreciseAsFileTime(&file_time);
+  ULARGE_INTEGER value;
+  value.LowPart = file_time.dwLowDateTime;
+  value.HighPart = file_time.dwHighDateTime;
+  // 100 ns intervals since 1601-01-01
+  return (value.QuadPart - 116444736000000000ull) / 10;
+}
+
+static size_t Padded(size_t size) {
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
+static std::wstring SegmentPath(const std::wstring& directory, int index) {
+  return directory + L"\\runner" +
+         (index == 0 ? std::wstring() : L"." + std::to_wstring(index)) +
+         L".a1log";
+}
+
+void NativeLog::ArgEncoder::Add(std::string_view text) {
+  if (size + 3 > capacity) {
+    return;
+  }
+  uint16_t length =
+      static_cast<uint16_t>(std::min(text.size(), capacity - size - 3));
+  data[size] = LogRecordHeader::kText;
+  memcpy(data + size + 1, &length, 2);
+  memcpy(data + size + 3, text.data(), length);
+  size += 3 + length;
+}
+
+// UTF-16 code units of the longest prefix of |text| whose UTF-8 form fits in
+// |max_bytes|, never ending inside a surrogate pair. Unpaired surrogates
+// become U+FFFD (3 bytes) like WideCharToMultiByte does.
+static size_t Utf8FittingPrefix(std::wstring_view text, size_t max_bytes) {
+  size_t units = 0;
+  size_t bytes = 0;
+  while (units < text.size()) {
+    wchar_t c = text[units];
+    size_t code_units = 1;
+    size_t encoded = 3;
+    if (c < 0x80) {
+      encoded = 1;
+    } else if (c < 0x800) {
+      encoded = 2;
+    } else if (IS_HIGH_SURROGATE(c) && units + 1 < text.size() &&
+               IS_LOW_SURROGATE(text[units + 1])) {
+      code_units = 2;
+      encoded = 4;
+    }
+    if (bytes + encoded > max_bytes) {
+      break;
+    }
+    bytes += encoded;
+    units += code_units;
+  }
+  return units;
+}
+
+void NativeLog::ArgEncoder::Add(std::wstring_view text) {
+  if (size + 3 > capacity) {
+    return;
+  }
+  size_t room = capacity - size - 3;
+  int length = 0;
+  if (!text.empty() && room > 0) {
+    int count = static_cast<int>(text.size());
+    int needed = ::WideCharToMultiByte(CP_UTF8, 0, text.data(), count,
+                                       nullptr, 0, nullptr, nullptr);
+    // WideCharToMultiByte fails outright when the output does not fit, so
+    // cut too long text short on a code point boundary first
+    if (needed > static_cast<int>(room)) {
+      count = static_cast<int>(Utf8FittingPrefix(text, room));
+    }
+    if (count > 0) {
+      length = ::WideCharToMultiByte(
+          CP_UTF8, 0, text.data(), count,
+          reinterpret_cast<char*>(data + size + 3), static_cast<int>(room),
+          nullptr, nullptr);
+    }
+  }
+  uint16_t stored = static_cast<uint16_t>(length);
+  data[size] = LogRecordHeader::kText;
+  memcpy(data + size + 1, &stored, 2);
+  size += 3 + stored;
+}
+
+std::wstring NativeLog::DefaultDirectory() {
+  wchar_t local_app_data[MAX_PATH];
+  DWORD length =
+      ::GetEnvironmentVariableW(L"LOCALAPPDATA", local_app_data, MAX_PATH);
+  if (length == 0 || length >= MAX_PATH) {
+    return std::wstring();
+  }
+  return std::wstring(local_app_data, length) + L"\\A1 Tools\\logs";
+}
+
+NativeLog& NativeLog::GetInstance() {
+  static NativeLog instance;
+  return instance;
+}
+
+NativeLog::NativeLog() {
+  log_subsystem_ = InternLocked("native_log");
+  dropped_format_ = InternLocked("Dropped {} records of thread {}");
+}
+
+NativeLog::~NativeLog() {
+  Stop();
+}
+
+uint32_t NativeLog::Intern(std::string_view text) {
+  NativeLog& log = GetInstance();
+  std::lock_guard<std::mutex> lock(log.mutex_);
+  return log.InternLocked(text);
+}
+
+uint32_t NativeLog::InternLocked(std::string_view text) {
+  std::string key(text.substr(0, kMaxRecordSize - sizeof(LogRecordHeader)));
+  auto it = ids_.find(key);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  strings_.push_back(key);
+  uint32_t id = static_cast<uint32_t>(strings_.size());
+  ids_.emplace(std::move(key), id);
+  return id;
+}
+
+void NativeLog::Start(const std::wstring& directory) {
+  std::lock_guard<std::mutex> lock(segment_mutex_);
+  if (writer_.joinable() || directory.empty()) {
+    return;
+  }
+  directory_ = directory;
+  stopping_ = false;
+  writer_ = std::thread(&NativeLog::WriterLoop, this);
+}
+
+void NativeLog::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+  std::lock_guard<std::mutex> lock(segment_mutex_);
+  if (segment_ != nullptr) {
+    Drain();
+    CloseSegment();
+  }
+}
+
+NativeLog::ThreadBuffer* NativeLog::CurrentBuffer() {
+  // Retires the ring when its thread exits; the writer frees it once drained
+  struct Owner {
+    std::shared_ptr<ThreadBuffer> buffer;
+    ~Owner() {
+      if (buffer) {
+        buffer->retired.store(true, std::memory_order_release);
+      }
+    }
+  };
+  thread_local Owner owner;
+  if (!owner.buffer) {
+    owner.buffer = std::make_shared<ThreadBuffer>();
+    owner.buffer->thread_id = ::GetCurrentThreadId();
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.push_back(owner.buffer);
+  }
+  return owner.buffer.get();
+}
+
+void NativeLog::WriteEncoded(LogLevel level, uint32_t subsystem,
+                             uint32_t format, const uint8_t* args,
+                             size_t args_size) {
+  alignas(8) uint8_t record[kMaxRecordSize];
+  // Arguments cut short are skipped by the reader
+  args_size = std::min(args_size, kMaxRecordSize - sizeof(LogRecordHeader));
+  memcpy(record + sizeof(LogRecordHeader), args, args_size);
+  Commit(record, args_size, level, subsystem, format);
+}
+
+void NativeLog::Commit(uint8_t* record, size_t args_size, LogLevel level,
+                       uint32_t subsystem, uint32_t format) {
+  ThreadBuffer* buffer = CurrentBuffer();
+  LogRecordHeader* header = reinterpret_cast<LogRecordHeader*>(record);
+  header->size = static_cast<uint16_t>(sizeof(LogRecordHeader) + args_size);
+  header->kind = LogRecordHeader::kEntry;
+  header->level = static_cast<uint8_t>(level);
+  header->thread_id = buffer->thread_id;
+  header->timestamp_us = UnixNowMicroseconds();
+  header->format_id = format;
+  header->subsystem_id = subsystem;
+  size_t padded = Padded(header->size);
+  memset(record + header->size, 0, padded - header->size);
+
+  uint64_t head = buffer->head.load(std::memory_order_relaxed);
+  uint64_t tail = buffer->tail.load(std::memory_order_acquire);
+  if (ThreadBuffer::kCapacity - (head - tail) < padded) {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  size_t offset = static_cast<size_t>(head & (ThreadBuffer::kCapacity - 1));
+  size_t first = std::min(padded, ThreadBuffer::kCapacity - offset);
+  memcpy(buffer->data + offset, record, first);
+  memcpy(buffer->data, record + first, padded - first);
+  buffer->head.store(head + padded, std::memory_order_release);
+}
+
+void NativeLog::WriterLoop() {
+  {
+    std::lock_guard<std::mutex> lock(segment_mutex_);
+    size_t separator = directory_.find_last_of(L'\\');
+    if (separator != std::wstring::npos) {
+      ::CreateDirectoryW(directory_.substr(0, separator).c_str(), nullptr);
+    }
+    ::CreateDirectoryW(directory_.c_str(), nullptr);
+    if (!OpenSegment()) {
+      return;
+    }
+  }
+  while (true) {
+    bool stopping;
+    {
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      wake_.wait_for(lock, std::chrono::milliseconds(kFlushIntervalMs),
+                     [this]() { return stopping_; });
+      stopping = stopping_;
+    }
+    if (stopping) {
+      // Stop drains what is left
+      return;
+    }
+    std::lock_guard<std::mutex> lock(segment_mutex_);
+    Drain();
+  }
+}
+
+// Copies |length| bytes from the ring at |position|, wrapping around.
+static void CopyFromRing(const uint8_t* ring, size_t capacity,
+                         uint64_t position, void* out, size_t length) {
+  size_t offset = static_cast<size_t>(position & (capacity - 1));
+  size_t first = std::min(length, capacity - offset);
+  memcpy(out, ring + offset, first);
+  memcpy(static_cast<uint8_t*>(out) + first, ring, length - first);
+}
+
+void NativeLog::Drain() {
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers = buffers_;
+  }
+  // Heads first: every string an entry up to them refers to is interned by
+  // then, so it is in the table read next
+  std::vector<uint64_t> heads;
+  for (const auto& buffer : buffers) {
+    heads.push_back(buffer->head.load(std::memory_order_acquire));
+  }
+  std::vector<std::pair<uint32_t, std::string>> new_strings;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = strings_written_; i < strings_.size(); i++) {
+      new_strings.emplace_back(static_cast<uint32_t>(i + 1), strings_[i]);
+    }
+    strings_written_ = strings_.size();
+  }
+  for (const auto& entry : new_strings) {
+    AppendString(entry.first, entry.second);
+  }
+
+  alignas(8) uint8_t record[kMaxRecordSize];
+  bool retired = false;
+  for (size_t i = 0; i < buffers.size(); i++) {
+    ThreadBuffer& buffer = *buffers[i];
+    uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+    while (tail < heads[i]) {
+      LogRecordHeader header;
+      CopyFromRing(buffer.data, ThreadBuffer::kCapacity, tail, &header,
+                   sizeof(header));
+      size_t padded = Padded(header.size);
+      CopyFromRing(buffer.data, ThreadBuffer::kCapacity, tail, record, padded);
+      Append(record, header.size);
+      tail += padded;
+    }
+    buffer.tail.store(tail, std::memory_order_release);
+
+    uint64_t dropped = buffer.dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+      LogRecordHeader* header = reinterpret_cast<LogRecordHeader*>(record);
+      ArgEncoder encoder{record + sizeof(LogRecordHeader),
+                         kMaxRecordSize - sizeof(LogRecordHeader)};
+      encoder.Add(dropped);
+      encoder.Add(buffer.thread_id);
+      header->size =
+          static_cast<uint16_t>(sizeof(LogRecordHeader) + encoder.size);
+      header->kind = LogRecordHeader::kEntry;
+      header->level = static_cast<uint8_t>(LogLevel::kWarning);
+      header->thread_id = ::GetCurrentThreadId();
+      header->timestamp_us = UnixNowMicroseconds();
+      header->format_id = dropped_format_;
+      header->subsystem_id = log_subsystem_;
+      Append(record, header->size);
+    }
+    retired |= buffer.retired.load(std::memory_order_acquire) &&
+               buffer.tail.load(std::memory_order_relaxed) ==
+                   buffer.head.load(std::memory_order_acquire);
+  }
+
+  if (retired) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.erase(
+        std::remove_if(buffers_.begin(), buffers_.end(),
+                       [](const std::shared_ptr<ThreadBuffer>& buffer) {
+                         return buffer->retired.load(std::memory_order_acquire) &&
+                                buffer->tail.load(std::memory_order_relaxed) ==
+                                    buffer->head.load(std::memory_order_acquire);
+                       }),
+        buffers_.end());
+  }
+
+  if (segment_ != nullptr) {
+    reinterpret_cast<LogSegmentHeader*>(segment_)->write_offset = offset_;
+  }
+}
+
+void NativeLog::Append(const uint8_t* record, size_t size) {
+  size_t padded = Padded(size);
+  if (segment_ != nullptr && offset_ + padded > kSegmentSize) {
+    CloseSegment();
+    OpenSegment();
+  }
+  if (segment_ == nullptr) {
+    return;
+  }
+  memcpy(segment_ + offset_, record, size);
+  memset(segment_ + offset_ + size, 0, padded - size);
+  offset_ += padded;
+}
+
+void NativeLog::AppendString(uint32_t id, const std::string& text) {
+  alignas(8) uint8_t record[kMaxRecordSize];
+  LogRecordHeader* header = reinterpret_cast<LogRecordHeader*>(record);
+  // Interned strings are capped to fit
+  memcpy(record + sizeof(LogRecordHeader), text.data(), text.size());
+  header->size = static_cast<uint16_t>(sizeof(LogRecordHeader) + text.size());
+  header->kind = LogRecordHeader::kString;
+  header->level = 0;
+  header->thread_id = 0;
+  header->timestamp_us = 0;
+  header->format_id = id;
+  header->subsystem_id = 0;
+  Append(record, header->size);
+}
+
+bool NativeLog::OpenSegment() {
+  // Shift the older segments; the oldest is replaced
+  for (int i = kKeptSegments - 1; i > 0; i--) {
+    ::MoveFileExW(SegmentPath(directory_, i - 1).c_str(),
+                  SegmentPath(directory_, i).c_str(), MOVEFILE_REPLACE_EXISTING);
+  }
+  // Readable (and deletable) by others while open, e.g. a support tool
+  file_ = ::CreateFileW(SegmentPath(directory_, 0).c_str(),
+                        GENERIC_READ | GENERIC_WRITE,
+                        FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file_ == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  mapping_ = ::CreateFileMappingW(file_, nullptr, PAGE_READWRITE,
+                                  static_cast<DWORD>(kSegmentSize >> 32),
+                                  static_cast<DWORD>(kSegmentSize), nullptr);
+  if (mapping_ != nullptr) {
+    segment_ = static_cast<uint8_t*>(
+        ::MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, kSegmentSize));
+  }
+  if (segment_ == nullptr) {
+    CloseSegment();
+    return false;
+  }
+
+  LogSegmentHeader* header = reinterpret_cast<LogSegmentHeader*>(segment_);
+  header->magic = LogSegmentHeader::kMagic;
+  header->version = LogSegmentHeader::kVersion;
+  header->header_size = sizeof(LogSegmentHeader);
+  header->pid = ::GetCurrentProcessId();
+  header->capacity = kSegmentSize;
+  header->created_us = UnixNowMicroseconds();
+  offset_ = sizeof(LogSegmentHeader);
+  header->write_offset = offset_;
+
+  // Each segment decodes on its own, so it repeats every string so far
+  std::vector<std::string> strings;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    strings = strings_;
+    strings_written_ = strings_.size();
+  }
+  for (size_t i = 0; i < strings.size(); i++) {
+    AppendString(static_cast<uint32_t>(i + 1), strings[i]);
+  }
+  header->write_offset = offset_;
+  return true;
+}
+
+void NativeLog::CloseSegment() {
+  if (segment_ != nullptr) {
+    reinterpret_cast<LogSegmentHeader*>(segment_)->write_offset = offset_;
+    ::UnmapViewOfFile(segment_);
+    segment_ = nullptr;
+  }
+  if (mapping_ != nullptr) {
+    ::CloseHandle(mapping_);
+    mapping_ = nullptr;
+  }
+  if (file_ != INVALID_HANDLE_VALUE) {
+    // Drop the unused tail
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(offset_);
+    if (offset_ > 0 && ::SetFilePointerEx(file_, size, nullptr, FILE_BEGIN)) {
+      ::SetEndOfFile(file_);
+    }
+    ::CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+  }
+  offset_ = 0;
+}
+
+extern "C" {
+
+uint32_t a1_log_intern(const char* text) {
+  return NativeLog::Intern(text);
+}
+
+void a1_log_write(uint8_t level, uint32_t subsystem, uint32_t format,
+                  const uint8_t* args, uint32_t args_size) {
+  NativeLog::GetInstance().WriteEncoded(
+      static_cast<LogLevel>(std::min<uint8_t>(
+          level, static_cast<uint8_t>(LogLevel::kError))),
+      subsystem, format, args, args_size);
+}
+
+}  // extern "C"
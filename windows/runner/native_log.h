@@ -0,0 +1,228 @@
+#ifndef RUNNER_NATIVE_LOG_H_
+#define RUNNER_NATIVE_LOG_H_
+
+#include <windows.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Segment files (%LOCALAPPDATA%\A1 Tools\logs\runner*.a1log) start with a
+// LogSegmentHeader followed by records, each padded to 8 bytes. Decode them
+// with scripts/decode_native_log.py; bump the versions on any change.
+struct LogSegmentHeader {
+  static const uint32_t kMagic = 0x474C3141;  // "A1LG"
+  static const uint16_t kVersion = 1;
+
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;
+  uint32_t pid;
+  uint32_t reserved0;
+  uint64_t capacity;     // File size
+  uint64_t created_us;   // Unix time
+  // End of the records written so far; advanced after they are copied in,
+  // so a crash leaves a readable prefix
+  volatile uint64_t write_offset;
+  uint8_t reserved[24];
+};
+static_assert(sizeof(LogSegmentHeader) == 64,
+              "LogSegmentHeader is part of the file format");
+
+enum class LogLevel : uint8_t { kTrace, kDebug, kInfo, kWarning, kError };
+
+struct LogRecordHeader {
+  // kEntry: format_id with "{}" placeholders, arguments follow.
+  // kString: defines format_id as the UTF-8 text that follows.
+  enum Kind : uint8_t { kEntry = 1, kString = 2 };
+  // Argument tags; each is followed by its value, strings by a uint16
+  // length and the bytes. Values are unaligned.
+  enum Arg : uint8_t { kInt = 1, kUint = 2, kDouble = 3, kText = 4 };
+
+  uint16_t size;  // Header and payload, before padding
+  uint8_t kind;
+  uint8_t level;
+  uint32_t thread_id;
+  uint64_t timestamp_us;  // Unix time
+  uint32_t format_id;
+  uint32_t subsystem_id;  // Interned subsystem name
+};
+static_assert(sizeof(LogRecordHeader) == 24,
+              "LogRecordHeader is part of the file format");
+
+// Binary log for the runner, plugins and Dart (through the exports below),
+// cheap enough to leave verbose logging on in production.
+//
+// A call encodes a fixed-size record (interned format and subsystem ids plus
+// raw argument values; no formatting) into a per-thread ring and returns:
+// no lock, no syscall, no allocation after the thread's first record. A
+// writer thread copies the rings into a memory-mapped segment file every
+// few milliseconds and rotates segments when full. Records that do not fit
+// a full ring are dropped and counted in the log.
+class NativeLog {
+ public:
+  static const size_t kMaxRecordSize = 4096;
+
+  static NativeLog& GetInstance();
+
+  // Returns the id of |text| (a format or subsystem name), adding it to the
+  // table and to the log on first use. Call once per call site; see
+  // NATIVE_LOG.
+  static uint32_t Intern(std::string_view text);
+
+  // %LOCALAPPDATA%\A1 Tools\logs, or empty if it cannot be determined.
+  static std::wstring DefaultDirectory();
+
+  // Starts the writer thread, which creates |directory| and opens a new
+  // segment there, shifting older ones (runner.a1log to runner.1.a1log and
+  // so on). Records written before are kept as long as their ring has room.
+  void Start(const std::wstring& directory);
+
+  // Writes out everything queued and closes the segment.
+  void Stop();
+
+  // Appends an entry whose arguments are already encoded.
+  void WriteEncoded(LogLevel level, uint32_t subsystem, uint32_t format,
+                    const uint8_t* args, size_t args_size);
+
+  template <typename... Args>
+  void Write(LogLevel level, uint32_t subsystem, uint32_t format,
+             const Args&... args) {
+    alignas(8) uint8_t record[kMaxRecordSize];
+    ArgEncoder encoder{record + sizeof(LogRecordHeader),
+                       kMaxRecordSize - sizeof(LogRecordHeader)};
+    (encoder.Add(args), ...);
+    Commit(record, encoder.size, level, subsystem, format);
+  }
+
+ private:
+  // Single-producer (its thread) single-consumer (the writer) byte ring of
+  // whole records.
+  struct ThreadBuffer {
+    static const size_t kCapacity = 64 * 1024;  // Must be a power of two
+
+    uint8_t data[kCapacity];
+    std::atomic<uint64_t> head{0};  // Written by the owning thread
+    std::atomic<uint64_t> tail{0};  // Written by the writer thread
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> retired{false};  // The owning thread has exited
+    uint32_t thread_id = 0;
+  };
+
+  // Appends tagged arguments (LogRecordHeader::Arg) to a record; values
+  // that do not fit are left out.
+  struct ArgEncoder {
+    uint8_t* data;
+    size_t capacity;
+    size_t size = 0;
+
+    void PutValue(uint8_t tag, const void* value, size_t length) {
+      if (size + 1 + length > capacity) {
+        return;
+      }
+      data[size] = tag;
+      memcpy(data + size + 1, value, length);
+      size += 1 + length;
+    }
+    void Add(std::string_view text);
+    void Add(std::wstring_view text);  // As UTF-8
+    void Add(const std::wstring& text) { Add(std::wstring_view(text)); }
+    void Add(const wchar_t* text) { Add(std::wstring_view(text)); }
+    void Add(const char* text) { Add(std::string_view(text)); }
+    void Add(const std::string& text) { Add(std::string_view(text)); }
+    void Add(double value) { PutValue(LogRecordHeader::kDouble, &value, 8); }
+    void Add(float value) { Add(static_cast<double>(value)); }
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    void Add(T value) {
+      if constexpr (std::is_signed_v<T>) {
+        int64_t wide = value;
+        PutValue(LogRecordHeader::kInt, &wide, 8);
+      } else {
+        uint64_t wide = value;
+        PutValue(LogRecordHeader::kUint, &wide, 8);
+      }
+    }
+  };
+
+  NativeLog();
+  ~NativeLog();
+
+  // Disable copy
+  NativeLog(const NativeLog&) = delete;
+  NativeLog& operator=(const NativeLog&) = delete;
+
+  // The calling thread's ring, registered on first use.
+  ThreadBuffer* CurrentBuffer();
+
+  uint32_t InternLocked(std::string_view text);
+
+  // Fills in the header of |record|, whose arguments are in place, and
+  // queues it on the calling thread's ring.
+  void Commit(uint8_t* record, size_t args_size, LogLevel level,
+              uint32_t subsystem, uint32_t format);
+
+  void WriterLoop();
+  // Copies everything queued into the segment; requires segment_mutex_.
+  void Drain();
+  // Appends one record; rotates when the segment is full.
+  void Append(const uint8_t* record, size_t size);
+  void AppendString(uint32_t id, const std::string& text);
+  bool OpenSegment();
+  void CloseSegment();
+
+  std::mutex mutex_;  // Guards the string table and buffers_
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<std::string> strings_;  // By id - 1
+  size_t strings_written_ = 0;  // Prefix of strings_ in the current segment
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+  // Ids for the writer's own "records dropped" entries
+  uint32_t log_subsystem_ = 0;
+  uint32_t dropped_format_ = 0;
+
+  std::mutex segment_mutex_;  // Guards the segment
+  std::wstring directory_;
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+  uint8_t* segment_ = nullptr;
+  uint64_t offset_ = 0;
+
+  std::thread writer_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+};
+
+// Logs |format|, with each "{}" standing for the next argument, under the
+// subsystem named |subsystem| (both string literals). Arguments are
+// integers, floating point values and narrow (UTF-8) or wide strings.
+//
+//   NATIVE_LOG(LogLevel::kInfo, "privacy", "Injected into PID {}", pid);
+#define NATIVE_LOG(level, subsystem, format, ...)                          \
+  do {                                                                     \
+    static const uint32_t native_log_subsystem = NativeLog::Intern(subsystem); \
+    static const uint32_t native_log_format = NativeLog::Intern(format);   \
+    NativeLog::GetInstance().Write(level, native_log_subsystem,            \
+                                   native_log_format, ##__VA_ARGS__);      \
+  } while (0)
+
+// dart:ffi entry points (lib/core/services/native_log.dart), looked up
+// through DynamicLibrary.executable().
+extern "C" {
+// |text| is UTF-8 and NUL-terminated.
+__declspec(dllexport) uint32_t a1_log_intern(const char* text);
+// |args| is encoded as in LogRecordHeader::Arg.
+__declspec(dllexport) void a1_log_write(uint8_t level, uint32_t subsystem,
+                                        uint32_t format, const uint8_t* args,
+                                        uint32_t args_size);
+}
+
+#endif  // RUNNER_NATIVE_LOG_H_
@@ -0,0 +1,430 @@
+#include "pixel_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// MSVC compiles any intrinsic without /arch flags, so the SIMD versions sit
+// next to the scalar one and are only called after the CPUID check in
+// GetPixelKernels.
+#if defined(_M_X64) || defined(_M_IX86)
+#define PIXEL_KERNELS_X86 1
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace {
+
+// Fixed-point sample positions for bilinear scaling: source pixel index and
+// weight of the next pixel, in 1/128ths, for each target pixel centre.
+void BilinearPositions(int src_size, int dst_size, int* index, int* weight) {
+  for (int i = 0; i < dst_size; i++) {
+    int64_t position =
+        (static_cast<int64_t>(2 * i + 1) * src_size * 128) / (2 * dst_size) -
+        64;
+    position = std::max<int64_t>(position, 0);
+    index[i] = static_cast<int>(position >> 7);
+    weight[i] = static_cast<int>(position & 127);
+    if (index[i] >= src_size - 1) {
+      index[i] = src_size - 1;
+      weight[i] = 0;
+    }
+  }
+}
+
+inline uint8_t Lerp(int a, int b, int weight) {
+  return static_cast<uint8_t>(a + (((b - a) * weight + 64) >> 7));
+}
+
+// The parts of each kernel the SIMD versions leave to scalar code: columns
+// from |x| (in target pixels) to the end of the row.
+
+void BoxRowTail(const uint8_t* src, int src_stride, int factor, uint8_t* dst,
+                int x, int width) {
+  int shift = factor == 2 ? 2 : 4;
+  for (; x < width; x++) {
+    const uint8_t* block = src + static_cast<size_t>(x) * factor * 4;
+    for (int c = 0; c < 4; c++) {
+      int sum = 0;
+      for (int y = 0; y < factor; y++) {
+        for (int i = 0; i < factor; i++) {
+          sum += block[static_cast<size_t>(src_stride) * y + i * 4 + c];
+        }
+      }
+      dst[x * 4 + c] = static_cast<uint8_t>((sum + (1 << (shift - 1))) >> shift);
+    }
+  }
+}
+
+void LerpRowTail(const uint8_t* row0, const uint8_t* row1, int weight,
+                 uint8_t* dst, int x, int bytes) {
+  for (; x < bytes; x++) {
+    dst[x] = Lerp(row0[x], row1[x], weight);
+  }
+}
+
+void BilinearRowTail(const uint8_t* row, const int* index, const int* weight,
+                     uint8_t* dst, int x, int width) {
+  for (; x < width; x++) {
+    const uint8_t* a = row + index[x] * 4;
+    const uint8_t* b = a + (weight[x] != 0 ? 4 : 0);
+    for (int c = 0; c < 4; c++) {
+      dst[x * 4 + c] = Lerp(a[c], b[c], weight[x]);
+    }
+  }
+}
+
+// Shared drivers: |RowFunctions| supply the row kernels of one instruction
+// set, each returning how far it got for the scalar tail to finish.
+
+template <typename RowFunctions>
+void DownscaleBox(const uint8_t* src, int src_stride, int src_width,
+                  int src_height, int factor, uint8_t* dst, int dst_stride) {
+  int width = src_width / factor;
+  int height = src_height / factor;
+  for (int y = 0; y < height; y++) {
+    const uint8_t* row = src + static_cast<size_t>(src_stride) * y * factor;
+    uint8_t* target = dst + static_cast<size_t>(dst_stride) * y;
+    int x = factor == 2 ? RowFunctions::Box2(row, src_stride, target, width)
+                        : RowFunctions::Box4(row, src_stride, target, width);
+    BoxRowTail(row, src_stride, factor, target, x, width);
+  }
+}
+
+template <typename RowFunctions>
+void DownscaleBilinear(const uint8_t* src, int src_stride, int src_width,
+                       int src_height, uint8_t* dst, int dst_stride,
+                       int dst_width, int dst_height) {
+  std::vector<int> columns(static_cast<size_t>(dst_width) * 2);
+  std::vector<int> rows(static_cast<size_t>(dst_height) * 2);
+  BilinearPositions(src_width, dst_width, columns.data(),
+                    columns.data() + dst_width);
+  BilinearPositions(src_height, dst_height, rows.data(),
+                    rows.data() + dst_height);
+  // Each target row blends two source rows into |blended|, then samples it
+  std::vector<uint8_t> blended(static_cast<size_t>(src_width) * 4);
+  int bytes = src_width * 4;
+  for (int y = 0; y < dst_height; y++) {
+    const uint8_t* row0 = src + static_cast<size_t>(src_stride) * rows[y];
+    int weight = rows[dst_height + y];
+    const uint8_t* row = row0;
+    if (weight != 0) {
+      const uint8_t* row1 = row0 + src_stride;
+      int x = RowFunctions::Lerp(row0, row1, weight, blended.data(), bytes);
+      LerpRowTail(row0, row1, weight, blended.data(), x, bytes);
+      row = blended.data();
+    }
+    uint8_t* target = dst + static_cast<size_t>(dst_stride) * y;
+    int x = RowFunctions::Bilinear(row, columns.data(),
+                                   columns.data() + dst_width, target,
+                                   dst_width);
+    BilinearRowTail(row, columns.data(), columns.data() + dst_width, target, x,
+                    dst_width);
+  }
+}
+
+struct ScalarRows {
+  static int Box2(const uint8_t*, int, uint8_t*, int) { return 0; }
+  static int Box4(const uint8_t*, int, uint8_t*, int) { return 0; }
+  static int Lerp(const uint8_t*, const uint8_t*, int, uint8_t*, int) {
+    return 0;
+  }
+  static int Bilinear(const uint8_t*, const int*, const int*, uint8_t*, int) {
+    return 0;
+  }
+};
+
+#if defined(PIXEL_KERNELS_X86)
+
+// SSE4.1: four target pixels at a time, 16-bit sums two pixels to a
+// register.
+
+// [p0 p1] [p2 p3] (16-bit BGRX) -> [p0+p1 p2+p3]
+inline __m128i PairSumsSse41(__m128i a, __m128i b) {
+  return _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+}
+
+inline __m128i LoadPixels2Sse41(const uint8_t* p) {
+  return _mm_cvtepu8_epi16(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+}
+
+template <int kFactor>
+int BoxRowSse41(const uint8_t* src, int src_stride, uint8_t* dst, int width) {
+  const int kShift = kFactor == 2 ? 2 : 4;
+  const __m128i round = _mm_set1_epi16(static_cast<short>(1 << (kShift - 1)));
+  int x = 0;
+  for (; x + 4 <= width; x += 4) {
+    // 4 * kFactor source pixels per row, summed down the block
+    __m128i sums[2 * kFactor];
+    const uint8_t* block = src + static_cast<size_t>(x) * kFactor * 4;
+    for (int i = 0; i < 2 * kFactor; i++) {
+      sums[i] = LoadPixels2Sse41(block + i * 8);
+    }
+    for (int y = 1; y < kFactor; y++) {
+      const uint8_t* row = block + static_cast<size_t>(src_stride) * y;
+      for (int i = 0; i < 2 * kFactor; i++) {
+        sums[i] = _mm_add_epi16(sums[i], LoadPixels2Sse41(row + i * 8));
+      }
+    }
+    // Then across it, halving the pixels each round
+    for (int n = 2 * kFactor; n > 2; n /= 2) {
+      for (int i = 0; i < n / 2; i++) {
+        sums[i] = PairSumsSse41(sums[2 * i], sums[2 * i + 1]);
+      }
+    }
+    __m128i low = _mm_srli_epi16(_mm_add_epi16(sums[0], round), kShift);
+    __m128i high = _mm_srli_epi16(_mm_add_epi16(sums[1], round), kShift);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4),
+                     _mm_packus_epi16(low, high));
+  }
+  return x;
+}
+
+int LerpRowSse41(const uint8_t* row0, const uint8_t* row1, int weight,
+                 uint8_t* dst, int bytes) {
+  const __m128i factor = _mm_set1_epi16(static_cast<short>(weight));
+  const __m128i round = _mm_set1_epi16(64);
+  const __m128i zero = _mm_setzero_si128();
+  int x = 0;
+  for (; x + 16 <= bytes; x += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x));
+    __m128i result[2];
+    for (int i = 0; i < 2; i++) {
+      __m128i a16 = i == 0 ? _mm_unpacklo_epi8(a, zero)
+                           : _mm_unpackhi_epi8(a, zero);
+      __m128i b16 = i == 0 ? _mm_unpacklo_epi8(b, zero)
+                           : _mm_unpackhi_epi8(b, zero);
+      __m128i delta = _mm_mullo_epi16(_mm_sub_epi16(b16, a16), factor);
+      result[i] = _mm_add_epi16(
+          a16, _mm_srai_epi16(_mm_add_epi16(delta, round), 7));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                     _mm_packus_epi16(result[0], result[1]));
+  }
+  return x;
+}
+
+int BilinearRowSse41(const uint8_t* row, const int* index, const int* weight,
+                     uint8_t* dst, int width) {
+  const __m128i round = _mm_set1_epi16(64);
+  int x = 0;
+  // The last pixel's neighbour may be past the row; leave it to the tail
+  for (; x + 4 < width; x += 4) {
+    uint32_t a[4], b[4];
+    for (int i = 0; i < 4; i++) {
+      memcpy(&a[i], row + index[x + i] * 4, 4);
+      memcpy(&b[i], row + index[x + i] * 4 + 4, 4);
+    }
+    __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+    // Each pixel's weight in its four channels
+    __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weight + x));
+    w = _mm_packus_epi32(w, w);
+    __m128i w_low = _mm_unpacklo_epi16(w, w);
+    __m128i result[2];
+    for (int i = 0; i < 2; i++) {
+      __m128i factor = i == 0 ? _mm_unpacklo_epi32(w_low, w_low)
+                              : _mm_unpackhi_epi32(w_low, w_low);
+      __m128i a16 = i == 0 ? _mm_cvtepu8_epi16(pa)
+                           : _mm_cvtepu8_epi16(_mm_srli_si128(pa, 8));
+      __m128i b16 = i == 0 ? _mm_cvtepu8_epi16(pb)
+                           : _mm_cvtepu8_epi16(_mm_srli_si128(pb, 8));
+      __m128i delta = _mm_mullo_epi16(_mm_sub_epi16(b16, a16), factor);
+      result[i] = _mm_add_epi16(
+          a16, _mm_srai_epi16(_mm_add_epi16(delta, round), 7));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4),
+                     _mm_packus_epi16(result[0], result[1]));
+  }
+  return x;
+}
+
+struct Sse41Rows {
+  static int Box2(const uint8_t* src, int stride, uint8_t* dst, int width) {
+    return BoxRowSse41<2>(src, stride, dst, width);
+  }
+  static int Box4(const uint8_t* src, int stride, uint8_t* dst, int width) {
+    return BoxRowSse41<4>(src, stride, dst, width);
+  }
+  static int Lerp(const uint8_t* row0, const uint8_t* row1, int weight,
+                  uint8_t* dst, int bytes) {
+    return LerpRowSse41(row0, row1, weight, dst, bytes);
+  }
+  static int Bilinear(const uint8_t* row, const int* index, const int* weight,
+                      uint8_t* dst, int width) {
+    return BilinearRowSse41(row, index, weight, dst, width);
+  }
+};
+
+// AVX2: eight target pixels at a time. Most AVX2 instructions work on each
+// 128-bit half separately, so results come out interleaved by half and are
+// put back in order with a cross-lane permute. Each function clears the
+// upper halves on return, as the SSE code around it is not VEX-encoded.
+
+// [p0 p1 | p2 p3] [p4 p5 | p6 p7] (16-bit BGRX) -> [s0 s1 | s2 s3] where
+// sN = p2N + p2N+1
+inline __m256i PairSumsAvx2(__m256i a, __m256i b) {
+  __m256i sums = _mm256_add_epi16(_mm256_unpacklo_epi64(a, b),
+                                  _mm256_unpackhi_epi64(a, b));
+  return _mm256_permute4x64_epi64(sums, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+inline __m256i LoadPixels4Avx2(const uint8_t* p) {
+  return _mm256_cvtepu8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+template <int kFactor>
+int BoxRowAvx2(const uint8_t* src, int src_stride, uint8_t* dst, int width) {
+  const int kShift = kFactor == 2 ? 2 : 4;
+  const __m256i round =
+      _mm256_set1_epi16(static_cast<short>(1 << (kShift - 1)));
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i sums[2 * kFactor];
+    const uint8_t* block = src + static_cast<size_t>(x) * kFactor * 4;
+    for (int i = 0; i < 2 * kFactor; i++) {
+      sums[i] = LoadPixels4Avx2(block + i * 16);
+    }
+    for (int y = 1; y < kFactor; y++) {
+      const uint8_t* row = block + static_cast<size_t>(src_stride) * y;
+      for (int i = 0; i < 2 * kFactor; i++) {
+        sums[i] = _mm256_add_epi16(sums[i], LoadPixels4Avx2(row + i * 16));
+      }
+    }
+    for (int n = 2 * kFactor; n > 2; n /= 2) {
+      for (int i = 0; i < n / 2; i++) {
+        sums[i] = PairSumsAvx2(sums[2 * i], sums[2 * i + 1]);
+      }
+    }
+    __m256i low = _mm256_srli_epi16(_mm256_add_epi16(sums[0], round), kShift);
+    __m256i high = _mm256_srli_epi16(_mm256_add_epi16(sums[1], round), kShift);
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high),
+                                              _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), packed);
+  }
+  _mm256_zeroupper();
+  return x;
+}
+
+int LerpRowAvx2(const uint8_t* row0, const uint8_t* row1, int weight,
+                uint8_t* dst, int bytes) {
+  const __m256i factor = _mm256_set1_epi16(static_cast<short>(weight));
+  const __m256i round = _mm256_set1_epi16(64);
+  int x = 0;
+  for (; x + 16 <= bytes; x += 16) {
+    __m256i a = LoadPixels4Avx2(row0 + x);
+    __m256i b = LoadPixels4Avx2(row1 + x);
+    __m256i delta = _mm256_mullo_epi16(_mm256_sub_epi16(b, a), factor);
+    __m256i result = _mm256_add_epi16(
+        a, _mm256_srai_epi16(_mm256_add_epi16(delta, round), 7));
+    __m256i packed = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(result, result), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                     _mm256_castsi256_si128(packed));
+  }
+  _mm256_zeroupper();
+  return x;
+}
+
+int BilinearRowAvx2(const uint8_t* row, const int* index, const int* weight,
+                    uint8_t* dst, int width) {
+  const __m256i round = _mm256_set1_epi16(64);
+  const __m256i zero = _mm256_setzero_si256();
+  const int* pixels = reinterpret_cast<const int*>(row);
+  int x = 0;
+  for (; x + 8 < width; x += 8) {
+    __m256i columns =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index + x));
+    __m256i pa = _mm256_i32gather_epi32(pixels, columns, 4);
+    __m256i pb = _mm256_i32gather_epi32(
+        pixels, _mm256_add_epi32(columns, _mm256_set1_epi32(1)), 4);
+    __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weight + x));
+    // Each weight into the four 16-bit channels of its pixel, halves as
+    // unpacking the pixels below lays them out
+    w = _mm256_or_si256(w, _mm256_slli_epi32(w, 16));
+    __m256i result[2];
+    for (int i = 0; i < 2; i++) {
+      __m256i factor = i == 0 ? _mm256_unpacklo_epi32(w, w)
+                              : _mm256_unpackhi_epi32(w, w);
+      __m256i a16 = i == 0 ? _mm256_unpacklo_epi8(pa, zero)
+                           : _mm256_unpackhi_epi8(pa, zero);
+      __m256i b16 = i == 0 ? _mm256_unpacklo_epi8(pb, zero)
+                           : _mm256_unpackhi_epi8(pb, zero);
+      __m256i delta = _mm256_mullo_epi16(_mm256_sub_epi16(b16, a16), factor);
+      result[i] = _mm256_add_epi16(
+          a16, _mm256_srai_epi16(_mm256_add_epi16(delta, round), 7));
+    }
+    // Unpacking and packing within halves cancel out
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4),
+                        _mm256_packus_epi16(result[0], result[1]));
+  }
+  _mm256_zeroupper();
+  return x;
+}
+
+struct Avx2Rows {
+  static int Box2(const uint8_t* src, int stride, uint8_t* dst, int width) {
+    return BoxRowAvx2<2>(src, stride, dst, width);
+  }
+  static int Box4(const uint8_t* src, int stride, uint8_t* dst, int width) {
+    return BoxRowAvx2<4>(src, stride, dst, width);
+  }
+  static int Lerp(const uint8_t* row0, const uint8_t* row1, int weight,
+                  uint8_t* dst, int bytes) {
+    return LerpRowAvx2(row0, row1, weight, dst, bytes);
+  }
+  static int Bilinear(const uint8_t* row, const int* index, const int* weight,
+                      uint8_t* dst, int width) {
+    return BilinearRowAvx2(row, index, weight, dst, width);
+  }
+};
+
+bool CpuHasSse41() {
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 19)) != 0;
+}
+
+bool CpuHasAvx2() {
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  // The OS must save the YMM registers (OSXSAVE, then XCR0 bits 1 and 2)
+  if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+}
+
+#endif  // PIXEL_KERNELS_X86
+
+template <typename RowFunctions>
+PixelKernels MakeKernels(const char* name) {
+  return {name, DownscaleBox<RowFunctions>, DownscaleBilinear<RowFunctions>};
+}
+
+PixelKernels SelectKernels() {
+#if defined(PIXEL_KERNELS_X86)
+  if (CpuHasAvx2()) {
+    return MakeKernels<Avx2Rows>("avx2");
+  }
+  if (CpuHasSse41()) {
+    return MakeKernels<Sse41Rows>("sse4.1");
+  }
+#endif
+  return MakeKernels<ScalarRows>("scalar");
+}
+
+}  // namespace
+
+const PixelKernels& GetPixelKernels() {
+  static const PixelKernels kernels = SelectKernels();
+  return kernels;
+}
@@ -0,0 +1,30 @@
+#ifndef RUNNER_PIXEL_KERNELS_H_
+#define RUNNER_PIXEL_KERNELS_H_
+
+#include <cstdint>
+
+// Downscaling for the screen capture channel (screen_capture.h), in AVX2,
+// SSE4.1 and scalar versions; GetPixelKernels picks the fastest the CPU
+// runs. Every version gives bit-identical results, the same as
+// linux/runner/pixel_kernels.cc. Strides are in bytes.
+struct PixelKernels {
+  const char* name;  // "avx2", "sse4.1" or "scalar"
+
+  // Averages each |factor| x |factor| block (|factor| 2 or 4) of a 32-bit
+  // BGRX image into one pixel of |dst|, which is src_width / factor x
+  // src_height / factor; leftover columns and rows are dropped.
+  void (*downscale_box)(const uint8_t* src, int src_stride, int src_width,
+                        int src_height, int factor, uint8_t* dst,
+                        int dst_stride);
+
+  // Resamples a 32-bit BGRX image to |dst_width| x |dst_height| (at most the
+  // source size) by bilinear interpolation between pixel centres, weights
+  // in 1/128ths.
+  void (*downscale_bilinear)(const uint8_t* src, int src_stride, int src_width,
+                             int src_height, uint8_t* dst, int dst_stride,
+                             int dst_width, int dst_height);
+};
+
+const PixelKernels& GetPixelKernels();
+
+#endif  // RUNNER_PIXEL_KERNELS_H_
@@ -0,0 +1,106 @@
+#include "prefetch.h"
+
+#include <wchar.h>
+#include <windows.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "startup_trace.h"
+
+// Assets beyond this are left to demand paging; the splash and the first
+// screens only touch a fraction of them.
+static const uint64_t kMaxAssetBytes = 64ull << 20;
+
+static const DWORD kChunkSize = 1 << 20;
+
+// Reads |path| once so its pages land in the file cache. Returns the bytes
+// read.
+static uint64_t PrefetchFile(const std::wstring& path, uint8_t* buffer) {
+  // Sequential scan doubles the read-ahead the cache manager issues
+  HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return 0;
+  }
+  uint64_t total = 0;
+  DWORD read = 0;
+  while (::ReadFile(file, buffer, kChunkSize, &read, nullptr) && read > 0) {
+    total += read;
+  }
+  ::CloseHandle(file);
+  return total;
+}
+
+static void PrefetchDirectory(const std::wstring& path, uint8_t* buffer,
+                              uint64_t* budget) {
+  WIN32_FIND_DATAW data;
+  HANDLE find = ::FindFirstFileW((path + L"\\*").c_str(), &data);
+  if (find == INVALID_HANDLE_VALUE) {
+    return;
+  }
+  do {
+    std::wstring name = data.cFileName;
+    if (name == L"." || name == L".." ||
+        // License text, only read by the about dialog
+        name == L"NOTICES.Z") {
+      continue;
+    }
+    std::wstring child = path + L"\\" + name;
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      PrefetchDirectory(child, buffer, budget);
+    } else {
+      uint64_t size = PrefetchFile(child, buffer);
+      *budget = size < *budget ? *budget - size : 0;
+    }
+  } while (*budget > 0 && ::FindNextFileW(find, &data));
+  ::FindClose(find);
+}
+
+static void PrefetchBundle(std::wstring data_dir) {
+  StartupTrace& trace = StartupTrace::GetInstance();
+  StartupTraceScope scope("prefetch");
+  std::unique_ptr<uint8_t[]> buffer(new uint8_t[kChunkSize]);
+
+  // In the order the engine needs them: the AOT snapshot when the Dart VM
+  // starts, ICU data right after, then the assets for the first frames
+  trace.Begin("prefetch:app.so");
+  PrefetchFile(data_dir + L"\\app.so", buffer.get());
+  trace.End("prefetch:app.so");
+
+  trace.Begin("prefetch:icudtl.dat");
+  PrefetchFile(data_dir + L"\\icudtl.dat", buffer.get());
+  trace.End("prefetch:icudtl.dat");
+
+  uint64_t budget = kMaxAssetBytes;
+  trace.Begin("prefetch:flutter_assets");
+  PrefetchDirectory(data_dir + L"\\flutter_assets", buffer.get(), &budget);
+  trace.End("prefetch:flutter_assets");
+}
+
+void StartPrefetch() {
+  wchar_t value[8];
+  DWORD length = ::GetEnvironmentVariableW(RUNNER_PREFETCH_ENV_VAR, value, 8);
+  if (length > 0 && length < 8 && wcscmp(value, L"0") == 0) {
+    StartupTrace::GetInstance().Instant("prefetch:disabled");
+    return;
+  }
+  wchar_t exe[MAX_PATH];
+  length = ::GetModuleFileNameW(nullptr, exe, MAX_PATH);
+  if (length == 0 || length >= MAX_PATH) {
+    return;
+  }
+  std::wstring data_dir(exe, length);
+  size_t separator = data_dir.find_last_of(L'\\');
+  if (separator == std::wstring::npos) {
+    return;
+  }
+  data_dir.resize(separator);
+  data_dir += L"\\data";
+  // Detached: the thread only warms the cache and owns nothing the process
+  // needs at exit
+  std::thread(PrefetchBundle, std::move(data_dir)).detach();
+}
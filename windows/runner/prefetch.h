@@ -0,0 +1,19 @@
+#ifndef RUNNER_PREFETCH_H_
+#define RUNNER_PREFETCH_H_
+
+// Set to 0 to skip prefetching, e.g. for A/B runs of
+// scripts/startup_benchmark.py (--no-prefetch).
+#define RUNNER_PREFETCH_ENV_VAR L"A1_TOOLS_PREFETCH"
+
+// Reads the files the engine needs at startup (data\app.so,
+// data\icudtl.dat, data\flutter_assets) into the file cache on a background
+// thread, so a cold start overlaps that I/O with window creation instead of
+// faulting it in page by page on the platform thread. On a warm cache it is
+// a memory copy.
+//
+// Recorded in the startup trace as "prefetch" on its own thread, with one
+// "prefetch:<file>" phase per file and "prefetch:flutter_assets" for the
+// asset directory.
+void StartPrefetch();
+
+#endif  // RUNNER_PREFETCH_H_
@@ -1,4 +1,5 @@
 #include "privacy_injector.h"
+#include "native_log.h"
 #include <tlhelp32.h>
 #include <psapi.h>
 #include <cwctype>
@@ -51,13 +52,13 @@ bool PrivacyInjector::Initialize(const std::wstring& payloadDllPath) {
     // Verify the DLL exists
     DWORD attrs = GetFileAttributesW(payloadDllPath.c_str());
     if (attrs == INVALID_FILE_ATTRIBUTES) {
-        OutputDebugStringW(L"[PrivacyInjector] Payload DLL not found\n");
+        NATIVE_LOG(LogLevel::kWarning, "privacy", "Payload DLL not found");
         return false;
     }
 
     payload_dll_path_ = payloadDllPath;
     initialized_ = true;
-    OutputDebugStringW(L"[PrivacyInjector] Initialized\n");
+    NATIVE_LOG(LogLevel::kInfo, "privacy", "Initialized");
     return true;
 }
 
@@ -115,7 +116,7 @@ bool PrivacyInjector::InjectDll(DWORD pid) {
         FALSE, pid);
 
     if (!hProcess) {
-        OutputDebugStringW(L"[PrivacyInjector] Failed to open process\n");
+        NATIVE_LOG(LogLevel::kWarning, "privacy", "Failed to open process");
         return false;
     }
 
@@ -171,7 +172,7 @@ bool PrivacyInjector::InjectDll(DWORD pid) {
 
     if (remoteModule) {
         injected_processes_[pid] = remoteModule;
-        OutputDebugStringW(L"[PrivacyInjector] DLL injected successfully\n");
+        NATIVE_LOG(LogLevel::kInfo, "privacy", "DLL injected successfully");
         return true;
     }
 
@@ -184,7 +185,7 @@ bool PrivacyInjector::CallSetWindowVisibility(DWORD pid, HWND hwnd, bool hide) {
 
     // First, make sure DLL is injected
     if (!InjectDll(pid)) {
-        OutputDebugStringW(L"[PrivacyInjector] Failed to inject DLL\n");
+        NATIVE_LOG(LogLevel::kWarning, "privacy", "Failed to inject DLL");
         return false;
     }
 
@@ -195,7 +196,7 @@ bool PrivacyInjector::CallSetWindowVisibility(DWORD pid, HWND hwnd, bool hide) {
         FALSE, pid);
 
     if (!hProcess) {
-        OutputDebugStringW(L"[PrivacyInjector] Failed to open process for remote call\n");
+        NATIVE_LOG(LogLevel::kWarning, "privacy", "Failed to open process for remote call");
         return false;
     }
 
@@ -218,7 +219,7 @@ bool PrivacyInjector::CallSetWindowVisibility(DWORD pid, HWND hwnd, bool hide) {
     }
 
     if (!targetModule) {
-        OutputDebugStringW(L"[PrivacyInjector] Could not find injected DLL in target process\n");
+        NATIVE_LOG(LogLevel::kWarning, "privacy", "Could not find injected DLL in target process");
         CloseHandle(hProcess);
         return false;
     }
@@ -227,14 +228,14 @@ bool PrivacyInjector::CallSetWindowVisibility(DWORD pid, HWND hwnd, bool hide) {
     // We use HideAllProcessWindows because it only takes one param (compatible with CreateRemoteThread)
     HMODULE localDll = LoadLibraryW(payload_dll_path_.c_str());
     if (!localDll) {
-        OutputDebugStringW(L"[PrivacyInjector] Failed to load DLL locally\n");
+        NATIVE_LOG(LogLevel::kWarning, "privacy", "Failed to load DLL locally");
         CloseHandle(hProcess);
         return false;
     }
 
     FARPROC localHideAll = GetProcAddress(localDll, "HideAllProcessWindows");
     if (!localHideAll) {
-        OutputDebugStringW(L"[PrivacyInjector] HideAllProcessWindows not found in DLL\n");
+        NATIVE_LOG(LogLevel::kWarning, "privacy", "HideAllProcessWindows not found in DLL");
         FreeLibrary(localDll);
         CloseHandle(hProcess);
         return false;
@@ -253,9 +254,8 @@ bool PrivacyInjector::CallSetWindowVisibility(DWORD pid, HWND hwnd, bool hide) {
         0, nullptr);
 
     if (!hThread) {
-        wchar_t msg[256];
-        swprintf_s(msg, L"[PrivacyInjector] CreateRemoteThread failed: %lu\n", GetLastError());
-        OutputDebugStringW(msg);
+        NATIVE_LOG(LogLevel::kWarning, "privacy",
+                   "CreateRemoteThread failed: {}", GetLastError());
         CloseHandle(hProcess);
         return false;
     }
@@ -269,9 +269,8 @@ bool PrivacyInjector::CallSetWindowVisibility(DWORD pid, HWND hwnd, bool hide) {
     CloseHandle(hThread);
     CloseHandle(hProcess);
 
-    wchar_t msg[256];
-    swprintf_s(msg, L"[PrivacyInjector] Remote call completed, windows affected: %lu\n", exitCode);
-    OutputDebugStringW(msg);
+    NATIVE_LOG(LogLevel::kInfo, "privacy",
+               "Remote call completed, windows affected: {}", exitCode);
 
     return exitCode > 0;
 }
@@ -304,16 +303,14 @@ bool PrivacyInjector::HideProcessWindowsByPid(DWORD pid, bool hide) {
 
     std::vector<HWND> windows = GetProcessWindows(pid);
     if (windows.empty()) {
-        wchar_t msg[256];
-        swprintf_s(msg, L"[PrivacyInjector] No visible windows found for PID %lu\n", pid);
-        OutputDebugStringW(msg);
+        NATIVE_LOG(LogLevel::kInfo, "privacy",
+                   "No visible windows found for PID {}", pid);
         return false;
     }
 
-    wchar_t msg[256];
-    swprintf_s(msg, L"[PrivacyInjector] Found %zu windows for PID %lu, attempting injection\n",
-        windows.size(), pid);
-    OutputDebugStringW(msg);
+    NATIVE_LOG(LogLevel::kInfo, "privacy",
+               "Found {} windows for PID {}, attempting injection",
+               windows.size(), pid);
 
     // Use injection to call the function from within the target process
     return CallSetWindowVisibility(pid, windows[0], hide);
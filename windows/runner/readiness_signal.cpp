@@ -0,0 +1,19 @@
+#include "readiness_signal.h"
+
+#include <windows.h>
+
+void SignalFirstFrame() {
+  static bool signaled = false;
+  if (signaled) {
+    return;
+  }
+  signaled = true;
+
+  // Only open, never create: without a waiting helper there is nobody to tell.
+  HANDLE event = ::OpenEventW(EVENT_MODIFY_STATE, FALSE, RUNNER_READY_EVENT_NAME);
+  if (event == nullptr) {
+    return;
+  }
+  ::SetEvent(event);
+  ::CloseHandle(event);
+}
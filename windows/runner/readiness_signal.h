@@ -0,0 +1,15 @@
+#ifndef RUNNER_READINESS_SIGNAL_H_
+#define RUNNER_READINESS_SIGNAL_H_
+
+// Runner side of the first-frame handshake with the service helper
+// (service_helper/readiness_signal.h). The helper arms a named event before
+// relaunching the app and waits on it instead of sleeping a fixed time.
+//
+// Must match READY_EVENT_NAME in the service helper.
+#define RUNNER_READY_EVENT_NAME L"A1ToolsFirstFrameEvent"
+
+// Signals the readiness event if a service helper created it. Safe to call
+// more than once; only the first call does anything.
+void SignalFirstFrame();
+
+#endif  // RUNNER_READINESS_SIGNAL_H_
@@ -0,0 +1,574 @@
+#include "screen_capture.h"
+
+#include <objbase.h>
+#include <wincodec.h>
+#include <wrl/client.h>
+
+#include "pixel_kernels.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+namespace {
+
+// Rows converted per WritePixels call when the encoder wants 24-bit input
+const int kBandRows = 64;
+
+int64_t NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string HresultMessage(const char* step, HRESULT hr) {
+  char message[96];
+  snprintf(message, sizeof(message), "%s failed (0x%08lX)", step,
+           static_cast<unsigned long>(hr));
+  return message;
+}
+
+// Encodes |height| top-down BGRX rows at |pixels| into |jpeg|. Returns the
+// name of the failing step in |failed_step|.
+HRESULT EncodeJpeg(const uint8_t* pixels, int width, int height, int quality,
+                   std::vector<uint8_t>* jpeg, const char** failed_step) {
+  const UINT stride = static_cast<UINT>(width) * 4;
+  ComPtr<IWICImagingFactory> factory;
+  *failed_step = "CoCreateInstance(WICImagingFactory)";
+  HRESULT hr = ::CoCreateInstance(CLSID_WICImagingFactory, nullptr,
+                                  CLSCTX_INPROC_SERVER,
+                                  IID_PPV_ARGS(&factory));
+  if (FAILED(hr)) return hr;
+
+  ComPtr<IStream> stream;
+  *failed_step = "CreateStreamOnHGlobal";
+  hr = ::CreateStreamOnHGlobal(nullptr, TRUE, &stream);
+  if (FAILED(hr)) return hr;
+
+  ComPtr<IWICBitmapEncoder> encoder;
+  *failed_step = "CreateEncoder";
+  hr = factory->CreateEncoder(GUID_ContainerFormatJpeg, nullptr, &encoder);
+  if (FAILED(hr)) return hr;
+  hr = encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache);
+  if (FAILED(hr)) return hr;
+
+  ComPtr<IWICBitmapFrameEncode> frame;
+  ComPtr<IPropertyBag2> options;
+  *failed_step = "CreateNewFrame";
+  hr = encoder->CreateNewFrame(&frame, &options);
+  if (FAILED(hr)) return hr;
+  PROPBAG2 option = {};
+  option.pstrName = const_cast<LPOLESTR>(L"ImageQuality");
+  VARIANT value = {};
+  value.vt = VT_R4;
+  value.fltVal = quality / 100.0f;
+  *failed_step = "Initialize frame";
+  hr = options->Write(1, &option, &value);
+  if (FAILED(hr)) return hr;
+  hr = frame->Initialize(options.Get());
+  if (FAILED(hr)) return hr;
+  hr = frame->SetSize(width, height);
+  if (FAILED(hr)) return hr;
+
+  // Newer encoders take BGRX as is; older ones ask for 24-bit BGR, which is
+  // converted a band at a time rather than copying the whole frame
+  WICPixelFormatGUID format = GUID_WICPixelFormat32bppBGR;
+  hr = frame->SetPixelFormat(&format);
+  if (FAILED(hr)) return hr;
+  *failed_step = "WritePixels";
+  if (IsEqualGUID(format, GUID_WICPixelFormat32bppBGR)) {
+    hr = frame->WritePixels(height, stride, stride * height,
+                            const_cast<BYTE*>(pixels));
+    if (FAILED(hr)) return hr;
+  } else if (IsEqualGUID(format, GUID_WICPixelFormat24bppBGR)) {
+    const UINT band_stride = static_cast<UINT>(width) * 3;
+    std::vector<BYTE> band(static_cast<size_t>(band_stride) * kBandRows);
+    for (int y = 0; y < height; y += kBandRows) {
+      int rows = std::min(kBandRows, height - y);
+      for (int row = 0; row < rows; row++) {
+        const uint8_t* in = pixels + static_cast<size_t>(stride) * (y + row);
+        BYTE* out = band.data() + static_cast<size_t>(band_stride) * row;
+        for (int x = 0; x < width; x++) {
+          out[x * 3] = in[x * 4];
+          out[x * 3 + 1] = in[x * 4 + 1];
+          out[x * 3 + 2] = in[x * 4 + 2];
+        }
+      }
+      hr = frame->WritePixels(rows, band_stride, band_stride * rows,
+                              band.data());
+      if (FAILED(hr)) return hr;
+    }
+  } else {
+    *failed_step = "SetPixelFormat";
+    return WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT;
+  }
+
+  *failed_step = "Commit";
+  hr = frame->Commit();
+  if (FAILED(hr)) return hr;
+  hr = encoder->Commit();
+  if (FAILED(hr)) return hr;
+
+  *failed_step = "Read encoded stream";
+  STATSTG stat = {};
+  hr = stream->Stat(&stat, STATFLAG_NONAME);
+  if (FAILED(hr)) return hr;
+  HGLOBAL memory = nullptr;
+  hr = ::GetHGlobalFromStream(stream.Get(), &memory);
+  if (FAILED(hr)) return hr;
+  const void* data = ::GlobalLock(memory);
+  if (!data) return HRESULT_FROM_WIN32(::GetLastError());
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  jpeg->assign(bytes, bytes + stat.cbSize.QuadPart);
+  ::GlobalUnlock(memory);
+  return S_OK;
+}
+
+uint64_t RotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+// Hashes |rows| rows of |row_bytes| bytes (a multiple of 4) for change
+// detection. Each 16-byte block is keyed, mixed with a 32 x 32 -> 64-bit
+// multiply and added to a rotated accumulator, four accumulators in flight;
+// accumulators are scrambled after every row so rows cannot trade places
+// unnoticed. SSE2 is part of x64; ARM64 builds use a scalar version with
+// the same structure. Hashes are only compared within one process.
+// Keep in sync with hash_tile in linux/runner/screen_capture.cc.
+uint64_t HashTile(const uint8_t* pixels, size_t stride, int row_bytes,
+                  int rows) {
+  static const uint64_t kKeys[8] = {
+      0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull,
+      0x1f67b3b7a4a44072ull, 0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull,
+      0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull};
+  static const uint32_t kPrime = 0x9e3779b1u;
+  uint64_t lanes[8];
+#if defined(_M_X64) || defined(__SSE2__)
+  __m128i acc[4];
+  __m128i keys[4];
+  for (int i = 0; i < 4; i++) {
+    keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kKeys + i * 2));
+    acc[i] = keys[i];
+  }
+  const __m128i prime = _mm_set1_epi32(static_cast<int>(kPrime));
+  auto mix = [](__m128i value, __m128i data, __m128i key) {
+    __m128i keyed = _mm_xor_si128(data, key);
+    __m128i product = _mm_mul_epu32(
+        keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+    value = _mm_or_si128(_mm_slli_epi64(value, 17), _mm_srli_epi64(value, 47));
+    return _mm_add_epi64(
+        value, _mm_add_epi64(product, _mm_shuffle_epi32(
+                                          data, _MM_SHUFFLE(1, 0, 3, 2))));
+  };
+  for (int y = 0; y < rows; y++) {
+    const uint8_t* row = pixels + stride * y;
+    int x = 0;
+    for (; x + 64 <= row_bytes; x += 64) {
+      for (int i = 0; i < 4; i++) {
+        __m128i data =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + i * 16));
+        acc[i] = mix(acc[i], data, keys[i]);
+      }
+    }
+    for (; x + 16 <= row_bytes; x += 16) {
+      __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+      acc[0] = mix(acc[0], data, keys[0]);
+    }
+    if (x < row_bytes) {
+      uint8_t tail[16] = {};
+      memcpy(tail, row + x, static_cast<size_t>(row_bytes - x));
+      acc[1] = mix(acc[1],
+                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail)),
+                   keys[1]);
+    }
+    // acc = (acc ^ (acc >> 47) ^ key) * prime
+    for (int i = 0; i < 4; i++) {
+      __m128i value = _mm_xor_si128(
+          _mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47)), keys[i]);
+      __m128i low = _mm_mul_epu32(value, prime);
+      __m128i high = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+      acc[i] = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+    }
+  }
+  for (int i = 0; i < 4; i++) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + i * 2), acc[i]);
+  }
+#else
+  memcpy(lanes, kKeys, sizeof(lanes));
+  for (int y = 0; y < rows; y++) {
+    const uint8_t* row = pixels + stride * y;
+    int lane = 0;
+    for (int x = 0; x < row_bytes; x += 8) {
+      uint64_t data = 0;
+      memcpy(&data, row + x, static_cast<size_t>(std::min(8, row_bytes - x)));
+      uint64_t keyed = data ^ kKeys[lane];
+      lanes[lane] = RotateLeft(lanes[lane], 17) +
+                    (keyed & 0xffffffffu) * (keyed >> 32) + data;
+      lane = (lane + 1) & 7;
+    }
+    for (int i = 0; i < 8; i++) {
+      lanes[i] = (lanes[i] ^ (lanes[i] >> 47) ^ kKeys[i]) * kPrime;
+    }
+  }
+#endif
+  uint64_t hash =
+      (static_cast<uint64_t>(rows) << 32) | static_cast<uint32_t>(row_bytes);
+  for (int i = 0; i < 8; i++) {
+    hash = RotateLeft(hash ^ lanes[i], 29) * 0x9e3779b97f4a7c15ull;
+  }
+  // MurmurHash3 finalizer
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ull;
+  return hash ^ (hash >> 33);
+}
+
+}  // namespace
+
+ScreenCapture::ScreenCapture() {}
+
+ScreenCapture::~ScreenCapture() {
+  ReleaseBuffer();
+  if (memory_dc_) {
+    ::DeleteDC(memory_dc_);
+  }
+}
+
+bool ScreenCapture::Capture(Source source, int width, int height, int quality,
+                            double scale, Frame* frame,
+                            std::string* error_code,
+                            std::string* error_message) {
+  int64_t started = NowUs();
+  if (!Grab(source, width, height, error_code, error_message)) {
+    return false;
+  }
+  int64_t grabbed = NowUs();
+  Scale(scale);
+  int64_t scaled = NowUs();
+  if (!Encode(frame_pixels_, frame_width_, frame_height_, quality,
+              &frame->jpeg, error_code, error_message)) {
+    return false;
+  }
+  frame->width = frame_width_;
+  frame->height = frame_height_;
+  frame->capture_us = grabbed - started;
+  frame->scale_us = scaled - grabbed;
+  frame->encode_us = NowUs() - scaled;
+  return true;
+}
+
+bool ScreenCapture::CaptureTiles(Source source, int width, int height,
+                                 int quality, double scale, int tile_size,
+                                 bool full, Frame* frame,
+                                 std::string* error_code,
+                                 std::string* error_message) {
+  int64_t started = NowUs();
+  if (!Grab(source, width, height, error_code, error_message)) {
+    return false;
+  }
+  int64_t grabbed = NowUs();
+  Scale(scale);
+  int64_t scaled = NowUs();
+  std::vector<uint16_t> changed;
+  DiffTiles(tile_size, &changed);
+  int64_t hashed = NowUs();
+
+  bool encoded = true;
+  if (!changed.empty()) {
+    int atlas_width = 0;
+    int atlas_height = 0;
+    PackAtlas(tile_size, changed, &atlas_width, &atlas_height);
+    encoded = Encode(atlas_pixels_.data(), atlas_width, atlas_height, quality,
+                     &frame->atlas, error_code, error_message);
+  }
+  if (encoded && full) {
+    encoded = Encode(frame_pixels_, frame_width_, frame_height_, quality,
+                     &frame->jpeg, error_code, error_message);
+  }
+  if (!encoded) {
+    // The caller never sees these tiles; resend everything next time
+    tile_hashes_.clear();
+    return false;
+  }
+
+  frame->tile_indices.reserve(changed.size() * 2);
+  for (uint16_t index : changed) {
+    frame->tile_indices.push_back(static_cast<uint8_t>(index & 0xff));
+    frame->tile_indices.push_back(static_cast<uint8_t>(index >> 8));
+  }
+  frame->tile_size = tile_size;
+  frame->width = frame_width_;
+  frame->height = frame_height_;
+  frame->capture_us = grabbed - started;
+  frame->scale_us = scaled - grabbed;
+  frame->hash_us = hashed - scaled;
+  frame->encode_us = NowUs() - hashed;
+  return true;
+}
+
+bool ScreenCapture::Grab(Source source, int width, int height,
+                         std::string* error_code, std::string* error_message) {
+  if (source == Source::kScreen) {
+    width = ::GetSystemMetrics(SM_CXSCREEN);
+    height = ::GetSystemMetrics(SM_CYSCREEN);
+  }
+  if (width <= 0 || height <= 0) {
+    *error_code = "UNAVAILABLE";
+    *error_message = "No screen to capture";
+    return false;
+  }
+  if (!EnsureBuffer(width, height)) {
+    *error_code = "CAPTURE_FAILED";
+    *error_message = "Could not allocate the frame buffer";
+    return false;
+  }
+  if (source == Source::kSynthetic) {
+    FillSyntheticFrame();
+  } else if (!GrabScreen()) {
+    *error_code = "CAPTURE_FAILED";
+    *error_message = "BitBlt from the screen failed";
+    return false;
+  }
+  return true;
+}
+
+void ScreenCapture::Scale(double scale) {
+  frame_pixels_ = pixels_;
+  frame_width_ = width_;
+  frame_height_ = height_;
+  if (scale >= 1) {
+    return;
+  }
+  const PixelKernels& kernels = GetPixelKernels();
+  const int source_stride = width_ * 4;
+  int factor = static_cast<int>(1 / scale + 0.5);
+  bool box = (factor == 2 || factor == 4) &&
+             std::abs(1 / scale - factor) < 0.01 && width_ >= factor &&
+             height_ >= factor;
+  if (box) {
+    frame_width_ = width_ / factor;
+    frame_height_ = height_ / factor;
+  } else {
+    frame_width_ = std::max(1, static_cast<int>(width_ * scale + 0.5));
+    frame_height_ = std::max(1, static_cast<int>(height_ * scale + 0.5));
+  }
+  scaled_pixels_.resize(static_cast<size_t>(frame_width_) * frame_height_ * 4);
+  if (box) {
+    kernels.downscale_box(pixels_, source_stride, width_, height_, factor,
+                          scaled_pixels_.data(), frame_width_ * 4);
+  } else {
+    kernels.downscale_bilinear(pixels_, source_stride, width_, height_,
+                               scaled_pixels_.data(), frame_width_ * 4,
+                               frame_width_, frame_height_);
+  }
+  frame_pixels_ = scaled_pixels_.data();
+}
+
+bool ScreenCapture::Encode(const uint8_t* pixels, int width, int height,
+                           int quality, std::vector<uint8_t>* jpeg,
+                           std::string* error_code,
+                           std::string* error_message) {
+  // Executor workers have no apartment of their own; join the MTA for the
+  // encoder and leave it again
+  HRESULT com = ::CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+  const char* failed_step = "";
+  HRESULT hr = EncodeJpeg(pixels, width, height, quality, jpeg, &failed_step);
+  if (SUCCEEDED(com)) {
+    ::CoUninitialize();
+  }
+  if (FAILED(hr)) {
+    *error_code = "ENCODE_FAILED";
+    *error_message = HresultMessage(failed_step, hr);
+    return false;
+  }
+  return true;
+}
+
+bool ScreenCapture::EnsureBuffer(int width, int height) {
+  if (bitmap_ && width == width_ && height == height_) {
+    return true;
+  }
+  ReleaseBuffer();
+  if (!memory_dc_) {
+    memory_dc_ = ::CreateCompatibleDC(nullptr);
+    if (!memory_dc_) {
+      return false;
+    }
+  }
+  BITMAPINFO info = {};
+  info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  info.bmiHeader.biWidth = width;
+  info.bmiHeader.biHeight = -height;  // Top-down
+  info.bmiHeader.biPlanes = 1;
+  info.bmiHeader.biBitCount = 32;
+  info.bmiHeader.biCompression = BI_RGB;
+  void* bits = nullptr;
+  bitmap_ = ::CreateDIBSection(memory_dc_, &info, DIB_RGB_COLORS, &bits,
+                               nullptr, 0);
+  if (!bitmap_) {
+    return false;
+  }
+  previous_bitmap_ = ::SelectObject(memory_dc_, bitmap_);
+  pixels_ = static_cast<uint8_t*>(bits);
+  width_ = width;
+  height_ = height;
+  return true;
+}
+
+void ScreenCapture::ReleaseBuffer() {
+  if (!bitmap_) {
+    return;
+  }
+  ::SelectObject(memory_dc_, previous_bitmap_);
+  ::DeleteObject(bitmap_);
+  bitmap_ = nullptr;
+  previous_bitmap_ = nullptr;
+  pixels_ = nullptr;
+  width_ = 0;
+  height_ = 0;
+}
+
+bool ScreenCapture::GrabScreen() {
+  HWND desktop = ::GetDesktopWindow();
+  HDC screen = ::GetDC(desktop);
+  if (!screen) {
+    return false;
+  }
+  BOOL copied = ::BitBlt(memory_dc_, 0, 0, width_, height_, screen, 0, 0,
+                         SRCCOPY);
+  ::ReleaseDC(desktop, screen);
+  // The DIB's bits are read directly; make sure GDI is done writing them
+  ::GdiFlush();
+  return copied != FALSE;
+}
+
+// Gradient background with a 3 x 3 grid of "windows" of ragged text lines;
+// the one under the centre scrolls by a pixel every frame, like a screen
+// with one busy window. Compresses about like a real desktop.
+// Keep in sync with grab_synthetic in linux/runner/screen_capture.cc.
+void ScreenCapture::FillSyntheticFrame() {
+  const size_t stride = static_cast<size_t>(width_) * 4;
+  uint64_t scroll = synthetic_frame_++;
+  int active_column = (width_ / 2) / 640;
+  int active_row = (height_ / 2) / 360;
+  for (int y = 0; y < height_; y++) {
+    uint8_t* row = pixels_ + stride * y;
+    // 16-pixel lines of 9-pixel glyphs, ragged right; [0] still, [1] scrolled
+    uint64_t offset[2] = {0, y / 360 == active_row ? scroll : 0};
+    uint64_t line[2];
+    bool glyph_row[2];
+    int line_length[2];
+    for (int i = 0; i < 2; i++) {
+      line[i] = (y + offset[i]) / 16;
+      glyph_row[i] = ((y + offset[i]) % 16) < 9;
+      line_length[i] = 200 + static_cast<int>((line[i] * 97) % 380);
+    }
+    for (int x = 0; x < width_; x++) {
+      uint8_t* pixel = row + x * 4;
+      bool in_window = (x % 640) >= 40 && (y % 360) >= 40;
+      if (in_window) {
+        int i = x / 640 == active_column ? 1 : 0;
+        bool ink = false;
+        if (glyph_row[i] && (x % 640) - 40 < line_length[i] &&
+            ((x + line[i] * 13) / 6) % 8 != 7) {
+          uint32_t cell = static_cast<uint32_t>((x / 2) * 2654435761u) ^
+                          static_cast<uint32_t>(((y + offset[i]) / 2) * 40503u);
+          ink = ((cell >> 13) % 3) == 0;
+        }
+        uint8_t value = ink ? 32 : 245;
+        pixel[0] = value;
+        pixel[1] = value;
+        pixel[2] = value;
+      } else {
+        pixel[0] = static_cast<uint8_t>(x * 255 / width_);
+        pixel[1] = static_cast<uint8_t>(y * 255 / height_);
+        pixel[2] = 128;
+      }
+      pixel[3] = 255;
+    }
+  }
+}
+
+void ScreenCapture::DiffTiles(int tile_size, std::vector<uint16_t>* changed) {
+  int columns = (frame_width_ + tile_size - 1) / tile_size;
+  int rows = (frame_height_ + tile_size - 1) / tile_size;
+  bool reset = frame_width_ != tiled_width_ ||
+               frame_height_ != tiled_height_ || columns != tile_columns_ ||
+               rows != tile_rows_ || tile_size != tile_size_ ||
+               tile_hashes_.size() != static_cast<size_t>(columns) * rows;
+  if (reset) {
+    tile_hashes_.assign(static_cast<size_t>(columns) * rows, 0);
+    tiled_width_ = frame_width_;
+    tiled_height_ = frame_height_;
+    tile_columns_ = columns;
+    tile_rows_ = rows;
+    tile_size_ = tile_size;
+  }
+  const size_t stride = static_cast<size_t>(frame_width_) * 4;
+  changed->clear();
+  for (int row = 0; row < rows; row++) {
+    int y = row * tile_size;
+    int height = std::min(tile_size, frame_height_ - y);
+    for (int column = 0; column < columns; column++) {
+      int x = column * tile_size;
+      int width = std::min(tile_size, frame_width_ - x);
+      uint64_t hash = HashTile(frame_pixels_ + stride * y + x * 4, stride,
+                               width * 4, height);
+      size_t index = static_cast<size_t>(row) * columns + column;
+      if (reset || hash != tile_hashes_[index]) {
+        changed->push_back(static_cast<uint16_t>(index));
+      }
+      tile_hashes_[index] = hash;
+    }
+  }
+}
+
+void ScreenCapture::PackAtlas(int tile_size,
+                              const std::vector<uint16_t>& changed,
+                              int* atlas_width, int* atlas_height) {
+  const size_t frame_stride = static_cast<size_t>(frame_width_) * 4;
+  int count = static_cast<int>(changed.size());
+  int columns = std::min(count, kAtlasColumns);
+  int rows = (count + columns - 1) / columns;
+  const size_t stride = static_cast<size_t>(columns) * tile_size * 4;
+  atlas_pixels_.resize(stride * rows * tile_size);
+  auto cell_at = [&](int i) {
+    return atlas_pixels_.data() + stride * (i / columns) * tile_size +
+           static_cast<size_t>(i % columns) * tile_size * 4;
+  };
+  for (int i = 0; i < count; i++) {
+    int source_x = (changed[i] % tile_columns_) * tile_size;
+    int source_y = (changed[i] / tile_columns_) * tile_size;
+    int width = std::min(tile_size, frame_width_ - source_x);
+    int height = std::min(tile_size, frame_height_ - source_y);
+    uint8_t* cell = cell_at(i);
+    for (int y = 0; y < tile_size; y++) {
+      const uint8_t* source =
+          frame_pixels_ + frame_stride * (source_y + std::min(y, height - 1)) +
+          static_cast<size_t>(source_x) * 4;
+      uint8_t* target = cell + stride * y;
+      memcpy(target, source, static_cast<size_t>(width) * 4);
+      for (int x = width; x < tile_size; x++) {
+        memcpy(target + x * 4, source + (width - 1) * 4, 4);
+      }
+    }
+  }
+  // Blank the unused cells of the last row so they cost next to nothing
+  for (int i = count; i < columns * rows; i++) {
+    uint8_t* cell = cell_at(i);
+    for (int y = 0; y < tile_size; y++) {
+      memset(cell + stride * y, 0, static_cast<size_t>(tile_size) * 4);
+    }
+  }
+  *atlas_width = columns * tile_size;
+  *atlas_height = rows * tile_size;
+}
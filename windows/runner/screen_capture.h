@@ -0,0 +1,132 @@
+#ifndef RUNNER_SCREEN_CAPTURE_H_
+#define RUNNER_SCREEN_CAPTURE_H_
+
+#include <windows.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Captures the primary monitor and JPEG-encodes it natively, so Dart only
+// receives the compressed bytes (com.a1chimney.a1tools/screen_capture,
+// lib/core/services/native_screen_capture.dart).
+//
+// The screen is copied with BitBlt into a 32-bit DIB section that is kept
+// while the resolution holds, optionally shrunk by the SIMD kernels of
+// pixel_kernels.h, and encoded by the Windows Imaging Component JPEG
+// encoder. Not thread-safe; the channel runs captures one at a time on the
+// native executor.
+//
+// CaptureTiles sends only what changed since its previous call: the scaled
+// frame is cut into square tiles, each hashed, and the changed ones are
+// packed into one atlas JPEG, kAtlasColumns to a row.
+class ScreenCapture {
+ public:
+  enum class Source {
+    kScreen,
+    // Desktop-like content of any size that changes every frame, for
+    // benchmarks; matches the Linux runner's synthetic source
+    kSynthetic,
+  };
+
+  struct Frame {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> jpeg;  // Tiled captures: empty unless |full|
+    // Tiled captures: row-major indices of the changed tiles as
+    // little-endian uint16s, in atlas order, and the atlas (empty when
+    // nothing changed)
+    int tile_size = 0;
+    std::vector<uint8_t> tile_indices;
+    std::vector<uint8_t> atlas;
+    int64_t capture_us = 0;
+    int64_t scale_us = 0;
+    int64_t hash_us = 0;
+    int64_t encode_us = 0;
+  };
+
+  // Largest synthetic frame side the channel accepts
+  static const int kMaxSyntheticSize = 8192;
+
+  // Smallest scale accepted, as ScreenStreamServer's SET_SCALE
+  static constexpr double kMinScale = 0.25;
+
+  // Tiles are whole JPEG MCUs (16 x 16 with 4:2:0 chroma), so tiles side by
+  // side in the atlas never share a block. At most 256 x 256 tiles, so
+  // indices fit 16 bits.
+  static const int kMinTileSize = 32;
+  static const int kMaxTileSize = 256;
+  static const int kAtlasColumns = 16;
+
+  ScreenCapture();
+  ~ScreenCapture();
+
+  // Grabs a frame from |source| (|width| x |height| for kSynthetic, ignored
+  // otherwise), shrinks it by |scale| (kMinScale-1) and encodes it at
+  // |quality| (1-100). On failure returns false and sets |error_code| and
+  // |error_message|.
+  bool Capture(Source source, int width, int height, int quality,
+               double scale, Frame* frame, std::string* error_code,
+               std::string* error_message);
+
+  // Like Capture, but fills in the tiles of |tile_size| (a multiple of 16
+  // in kMinTileSize-kMaxTileSize) that changed since the previous call, all
+  // of them after a size change or a failure; with |full| the whole frame
+  // is encoded as well.
+  bool CaptureTiles(Source source, int width, int height, int quality,
+                    double scale, int tile_size, bool full, Frame* frame,
+                    std::string* error_code, std::string* error_message);
+
+ private:
+  // Disable copy
+  ScreenCapture(const ScreenCapture&) = delete;
+  ScreenCapture& operator=(const ScreenCapture&) = delete;
+
+  // (Re)creates the DIB section when the size changes.
+  bool EnsureBuffer(int width, int height);
+  void ReleaseBuffer();
+  bool Grab(Source source, int width, int height, std::string* error_code,
+            std::string* error_message);
+  bool GrabScreen();
+  void FillSyntheticFrame();
+  // Points frame_pixels_ at the grabbed frame, or at scaled_pixels_ holding
+  // it shrunk by |scale|: by averaging whole blocks when that is 1/2 or
+  // 1/4, by bilinear interpolation otherwise.
+  void Scale(double scale);
+  bool Encode(const uint8_t* pixels, int width, int height, int quality,
+              std::vector<uint8_t>* jpeg, std::string* error_code,
+              std::string* error_message);
+  // Hashes every tile of the frame and lists those that differ from the
+  // previous call.
+  void DiffTiles(int tile_size, std::vector<uint16_t>* changed);
+  // Copies the |changed| tiles into atlas_pixels_; partial tiles at the
+  // right and bottom edges are padded by repeating their last column/row.
+  void PackAtlas(int tile_size, const std::vector<uint16_t>& changed,
+                 int* atlas_width, int* atlas_height);
+
+  HDC memory_dc_ = nullptr;
+  HBITMAP bitmap_ = nullptr;
+  HGDIOBJ previous_bitmap_ = nullptr;
+  uint8_t* pixels_ = nullptr;  // Top-down BGRX rows of bitmap_
+  int width_ = 0;
+  int height_ = 0;
+  uint64_t synthetic_frame_ = 0;
+
+  // The frame to encode: pixels_ or scaled_pixels_, top-down BGRX rows
+  std::vector<uint8_t> scaled_pixels_;
+  const uint8_t* frame_pixels_ = nullptr;
+  int frame_width_ = 0;
+  int frame_height_ = 0;
+
+  // Tile hashes of the previous CaptureTiles, row-major; empty when the
+  // next one must send every tile, and the frame size they were taken at
+  std::vector<uint64_t> tile_hashes_;
+  int tiled_width_ = 0;
+  int tiled_height_ = 0;
+  int tile_columns_ = 0;
+  int tile_rows_ = 0;
+  int tile_size_ = 0;
+  std::vector<uint8_t> atlas_pixels_;  // Packed BGRX tiles
+};
+
+#endif  // RUNNER_SCREEN_CAPTURE_H_
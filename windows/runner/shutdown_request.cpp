@@ -0,0 +1,14 @@
+#include "shutdown_request.h"
+
+#include <windows.h>
+
+bool IsShutdownRequested() {
+  // Created rather than opened so a helper that starts later still reaches
+  // this instance. The helper resets it once the app is gone.
+  static HANDLE event = ::CreateEventW(nullptr, TRUE, FALSE,
+                                       RUNNER_SHUTDOWN_EVENT_NAME);
+  if (event == nullptr) {
+    return false;
+  }
+  return ::WaitForSingleObject(event, 0) == WAIT_OBJECT_0;
+}
@@ -0,0 +1,15 @@
+#ifndef RUNNER_SHUTDOWN_REQUEST_H_
+#define RUNNER_SHUTDOWN_REQUEST_H_
+
+// Lets the service helper ask the app to exit cleanly, e.g. to restart an
+// instance that has leaked past its memory or handle budget. The helper sets
+// the named event; the runner polls it from its heartbeat timer.
+//
+// Must match SHUTDOWN_EVENT_NAME in service_helper/supervisor_win.cpp.
+#define RUNNER_SHUTDOWN_EVENT_NAME L"A1ToolsShutdownRequestEvent"
+
+// Returns true if the service helper has requested a shutdown. Cheap enough
+// to call on every timer tick.
+bool IsShutdownRequested();
+
+#endif  // RUNNER_SHUTDOWN_REQUEST_H_
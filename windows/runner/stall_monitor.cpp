@@ -0,0 +1,297 @@
+#include "stall_monitor.h"
+
+#include <stdio.h>
+#include <wchar.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+
+// Only while the window is visible; probing stops while it is hidden.
+static const int64_t kProbeIntervalMs = 100;
+
+// While a stall goes on, how often to check for the monitor being stopped.
+static const int64_t kStalledPollMs = 1000;
+
+// Milliseconds excluding time the system was asleep.
+static int64_t NowMs() {
+  ULONGLONG interrupt_time = 0;
+  ::QueryUnbiasedInterruptTime(&interrupt_time);
+  return static_cast<int64_t>(interrupt_time / 10000);
+}
+
+static int64_t UnixNowMs() {
+  FILETIME file_time;
+  ::GetSystemTimeAsFileTime(&file_time);
+  ULARGE_INTEGER value;
+  value.LowPart = file_time.dwLowDateTime;
+  value.HighPart = file_time.dwHighDateTime;
+  // 100 ns intervals since 1601-01-01
+  return static_cast<int64_t>((value.QuadPart - 116444736000000000ull) / 10000);
+}
+
+// "module+0xoffset" for code in a loaded module, the raw address otherwise.
+static std::string DescribeAddress(DWORD64 pc) {
+  char offset[32];
+  HMODULE module = nullptr;
+  if (::GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                               GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           reinterpret_cast<LPCWSTR>(pc), &module)) {
+    wchar_t path[MAX_PATH];
+    DWORD length = ::GetModuleFileNameW(module, path, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH) {
+      path[0] = L'\0';
+    }
+    const wchar_t* name = wcsrchr(path, L'\\');
+    name = name != nullptr ? name + 1 : path;
+    char utf8_name[MAX_PATH * 3];
+    if (name[0] != L'\0' &&
+        ::WideCharToMultiByte(CP_UTF8, 0, name, -1, utf8_name,
+                              sizeof(utf8_name), nullptr, nullptr) > 0) {
+      snprintf(offset, sizeof(offset), "+0x%llx",
+               static_cast<unsigned long long>(
+                   pc - reinterpret_cast<DWORD64>(module)));
+      return std::string(utf8_name) + offset;
+    }
+  }
+  snprintf(offset, sizeof(offset), "0x%llx",
+           static_cast<unsigned long long>(pc));
+  return offset;
+}
+
+#if defined(_M_X64)
+// Moves |*value| from the captured stack, which starts at |original|, to
+// the same place in its copy at |copy|.
+static void Relocate(DWORD64* value, DWORD64 original, DWORD64 copy,
+                     size_t size) {
+  if (*value >= original && *value - original < size) {
+    *value = *value - original + copy;
+  }
+}
+
+// Callee-saved registers may point into the stack (the frame pointer most
+// of all); unwinding restores them from it.
+static void RelocateRegisters(CONTEXT* context, DWORD64 original,
+                              DWORD64 copy, size_t size) {
+  DWORD64* registers[] = {&context->Rbx, &context->Rbp, &context->Rsi,
+                          &context->Rdi, &context->R12, &context->R13,
+                          &context->R14, &context->R15};
+  for (DWORD64* value : registers) {
+    Relocate(value, original, copy, size);
+  }
+}
+
+// Walks the stack captured in |context| using |size| bytes of it copied to
+// |copy|, storing up to |max_frames| return addresses in |pcs|. Runs with
+// the thread resumed, so the function table lookups may take locks. Frames
+// that reach past the end of a cut-off copy end the walk.
+static size_t UnwindStackCopy(CONTEXT* context, uint8_t* copy_data,
+                              size_t size, DWORD64* pcs, size_t max_frames) {
+  const DWORD64 original = context->Rsp;
+  const DWORD64 copy = reinterpret_cast<DWORD64>(copy_data);
+  const DWORD64 copy_end = copy + size;
+  context->Rsp = copy;
+  RelocateRegisters(context, original, copy, size);
+
+  size_t count = 0;
+  __try {
+    while (count < max_frames && context->Rip != 0 &&
+           context->Rsp >= copy && context->Rsp < copy_end) {
+      pcs[count++] = context->Rip;
+      DWORD64 image_base = 0;
+      PRUNTIME_FUNCTION function =
+          ::RtlLookupFunctionEntry(context->Rip, &image_base, nullptr);
+      if (function != nullptr) {
+        void* handler_data = nullptr;
+        DWORD64 establisher_frame = 0;
+        ::RtlVirtualUnwind(UNW_FLAG_NHANDLER, image_base, context->Rip,
+                           function, context, &handler_data,
+                           &establisher_frame, nullptr);
+        RelocateRegisters(context, original, copy, size);
+      } else if (count == 1 && context->Rsp + sizeof(DWORD64) <= copy_end) {
+        // Leaf function: the return address is on top of the stack
+        context->Rip = *reinterpret_cast<const DWORD64*>(context->Rsp);
+        context->Rsp += sizeof(DWORD64);
+      } else {
+        // Code without unwind data (JIT, Dart AOT) ends the walk
+        break;
+      }
+    }
+  } __except (EXCEPTION_EXECUTE_HANDLER) {
+    // A frame read past the copy; keep what was walked
+  }
+  return count;
+}
+#endif
+
+StallMonitor& StallMonitor::GetInstance() {
+  static StallMonitor instance;
+  return instance;
+}
+
+StallMonitor::StallMonitor() {}
+
+StallMonitor::~StallMonitor() {
+  Stop();
+}
+
+void StallMonitor::Start(HWND window) {
+  if (monitor_.joinable()) {
+    return;
+  }
+  thread_ = ::OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT, FALSE,
+                         ::GetCurrentThreadId());
+  if (thread_ == nullptr) {
+    return;
+  }
+  ::GetCurrentThreadStackLimits(&stack_low_, &stack_high_);
+  stack_copy_.resize(kMaxStackCopy);
+  window_ = window;
+  stopping_ = false;
+  monitor_ = std::thread(&StallMonitor::MonitorLoop, this);
+}
+
+void StallMonitor::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  if (monitor_.joinable()) {
+    monitor_.join();
+  }
+  if (thread_ != nullptr) {
+    ::CloseHandle(thread_);
+    thread_ = nullptr;
+  }
+  window_ = nullptr;
+}
+
+void StallMonitor::OnProbe(WPARAM sequence) {
+  int64_t now = NowMs();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dispatched_sequence_ = sequence;
+    dispatched_at_ = now;
+  }
+  wake_.notify_all();
+}
+
+void StallMonitor::SetVisible(bool visible) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    visible_ = visible;
+  }
+  wake_.notify_all();
+}
+
+std::vector<StallMonitor::Stall> StallMonitor::TakeStalls(uint64_t* dropped) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<Stall> stalls(std::make_move_iterator(stalls_.begin()),
+                            std::make_move_iterator(stalls_.end()));
+  stalls_.clear();
+  *dropped = dropped_;
+  dropped_ = 0;
+  return stalls;
+}
+
+void StallMonitor::MonitorLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    if (!visible_) {
+      wake_.wait(lock, [this]() { return stopping_ || visible_; });
+      continue;
+    }
+    uint64_t sequence = ++sequence_;
+    int64_t posted_at = NowMs();
+    int64_t started_ms = UnixNowMs();
+    lock.unlock();
+    bool posted = ::PostMessageW(window_, RUNNER_STALL_PROBE_MESSAGE,
+                                 static_cast<WPARAM>(sequence), 0) != FALSE;
+    lock.lock();
+    if (!posted) {
+      wake_.wait_for(lock, std::chrono::milliseconds(kProbeIntervalMs));
+      continue;
+    }
+
+    // Wait for the probe, sampling the stack once it is late
+    UINT message = 0;
+    size_t frame_count = 0;
+    bool sampled = false;
+    while (!stopping_ && dispatched_sequence_ != sequence) {
+      int64_t waited = NowMs() - posted_at;
+      if (!sampled && waited >= kStallThresholdMs) {
+        sampled = true;
+        lock.unlock();
+        message = dispatching_.load(std::memory_order_relaxed);
+        frame_count = CaptureStack();
+        lock.lock();
+        continue;
+      }
+      wake_.wait_for(lock, std::chrono::milliseconds(
+                               sampled ? kStalledPollMs
+                                       : kStallThresholdMs - waited));
+    }
+    if (stopping_) {
+      break;
+    }
+
+    int64_t duration_ms = dispatched_at_ - posted_at;
+    if (duration_ms >= kStallThresholdMs) {
+      lock.unlock();
+      Record(started_ms, duration_ms, message, frame_count);
+      lock.lock();
+    }
+    wake_.wait_for(lock, std::chrono::milliseconds(kProbeIntervalMs),
+                   [this]() { return stopping_; });
+  }
+}
+
+size_t StallMonitor::CaptureStack() {
+#if defined(_M_X64)
+  if (stack_copy_.empty() ||
+      ::SuspendThread(thread_) == static_cast<DWORD>(-1)) {
+    return 0;
+  }
+  CONTEXT context = {};
+  context.ContextFlags = CONTEXT_FULL;
+  size_t copied = 0;
+  // Also waits for the suspension to take effect. Everything from the
+  // stack pointer up is committed, so the copy cannot fault.
+  if (::GetThreadContext(thread_, &context) && context.Rsp >= stack_low_ &&
+      context.Rsp < stack_high_) {
+    copied = std::min(static_cast<size_t>(stack_high_ - context.Rsp),
+                      stack_copy_.size());
+    memcpy(stack_copy_.data(), reinterpret_cast<const void*>(context.Rsp),
+           copied);
+  }
+  ::ResumeThread(thread_);
+  if (copied == 0) {
+    return 0;
+  }
+  return UnwindStackCopy(&context, stack_copy_.data(), copied, pcs_,
+                         kMaxFrames);
+#else
+  // Only x64 unwinding is implemented; the duration is still recorded
+  return 0;
+#endif
+}
+
+void StallMonitor::Record(int64_t started_ms, int64_t duration_ms,
+                          UINT message, size_t frame_count) {
+  Stall stall;
+  stall.started_ms = started_ms;
+  stall.duration_ms = duration_ms;
+  stall.message = message;
+  for (size_t i = 0; i < frame_count; i++) {
+    stall.frames.push_back(DescribeAddress(pcs_[i]));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stalls_.size() >= kMaxStalls) {
+    stalls_.pop_front();
+    dropped_++;
+  }
+  stalls_.push_back(std::move(stall));
+}
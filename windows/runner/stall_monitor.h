@@ -0,0 +1,118 @@
+#ifndef RUNNER_STALL_MONITOR_H_
+#define RUNNER_STALL_MONITOR_H_
+
+#include <windows.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Probe posted to the platform window by the stall monitor; wparam is the
+// probe's sequence number, passed back to StallMonitor::OnProbe.
+#define RUNNER_STALL_PROBE_MESSAGE (WM_APP + 0x44)
+
+// Watchdog for the platform thread's message loop. A monitor thread posts a
+// probe message every 100 ms while the window is visible (none while it is
+// hidden, minimized or in the tray, so an idle app stays idle) and measures
+// how long the loop takes to dispatch it. When a probe is still waiting
+// after the stall threshold, the platform thread is suspended just long
+// enough to copy its registers and the live part of its stack, which is
+// unwound once it runs again. Once the probe finally arrives the stall
+// (duration, stack, the message being dispatched) goes into a ring buffer
+// that Dart drains and uploads
+// (lib/core/services/crash_reporting_service.dart).
+//
+// Times exclude system sleep, so a suspended laptop is not a stall.
+class StallMonitor {
+ public:
+  // Probes waiting at least this long are stalls.
+  static const int64_t kStallThresholdMs = 250;
+  // Stalls kept until Dart takes them; older ones are dropped first.
+  static const size_t kMaxStalls = 32;
+  static const size_t kMaxFrames = 48;
+  // Most of the platform thread's stack copied for unwinding, from the
+  // stack pointer up; deeper frames are cut off.
+  static const size_t kMaxStackCopy = 256 * 1024;
+
+  struct Stall {
+    int64_t started_ms = 0;   // Unix time the probe was posted
+    int64_t duration_ms = 0;  // Until the probe was dispatched
+    UINT message = 0;  // Message being dispatched when sampled, 0 if none
+    // Innermost first, "module+0xoffset" (symbolized offline with the PDBs)
+    std::vector<std::string> frames;
+  };
+
+  static StallMonitor& GetInstance();
+
+  // Starts watching the calling thread's message loop through probes
+  // posted to |window|, which must pass them to OnProbe.
+  void Start(HWND window);
+
+  // Stops and joins the monitor thread.
+  void Stop();
+
+  // Called by the message loop with the message it is about to dispatch,
+  // and with 0 once it returns, so a stall can be attributed to a message.
+  void OnDispatch(UINT message) {
+    dispatching_.store(message, std::memory_order_relaxed);
+  }
+
+  // Called by |window| for RUNNER_STALL_PROBE_MESSAGE.
+  void OnProbe(WPARAM sequence);
+
+  // Pauses probing while the window is not visible and resumes it once it
+  // is again.
+  void SetVisible(bool visible);
+
+  // Removes and returns the recorded stalls, oldest first, and the number
+  // dropped since the last call because the buffer was full.
+  std::vector<Stall> TakeStalls(uint64_t* dropped);
+
+ private:
+  StallMonitor();
+  ~StallMonitor();
+
+  // Disable copy
+  StallMonitor(const StallMonitor&) = delete;
+  StallMonitor& operator=(const StallMonitor&) = delete;
+
+  void MonitorLoop();
+
+  // Suspends the platform thread, copies its context and stack into
+  // stack_copy_, resumes it, then unwinds the copy into pcs_. Nothing that
+  // may take a lock runs while it is suspended: it may hold that lock (the
+  // loader's, the heap's, or the function table lock that
+  // RtlLookupFunctionEntry needs).
+  size_t CaptureStack();
+
+  void Record(int64_t started_ms, int64_t duration_ms, UINT message,
+              size_t frame_count);
+
+  HWND window_ = nullptr;
+  HANDLE thread_ = nullptr;  // The platform thread
+  ULONG_PTR stack_low_ = 0;
+  ULONG_PTR stack_high_ = 0;
+  std::thread monitor_;
+  std::atomic<UINT> dispatching_{0};
+
+  std::mutex mutex_;  // Guards everything below
+  std::condition_variable wake_;
+  bool stopping_ = false;
+  bool visible_ = true;
+  uint64_t sequence_ = 0;
+  uint64_t dispatched_sequence_ = 0;
+  int64_t dispatched_at_ = 0;
+  std::deque<Stall> stalls_;
+  uint64_t dropped_ = 0;
+
+  // Written only by the monitor thread
+  DWORD64 pcs_[kMaxFrames];
+  std::vector<uint8_t> stack_copy_;  // kMaxStackCopy, allocated by Start
+};
+
+#endif  // RUNNER_STALL_MONITOR_H_
@@ -0,0 +1,146 @@
+#include "startup_trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// FILETIME ticks (100 ns) per microsecond.
+static const int64_t kFileTimeTicksPerUs = 10;
+
+static int64_t FileTimeToTicks(const FILETIME& time) {
+  ULARGE_INTEGER value;
+  value.LowPart = time.dwLowDateTime;
+  value.HighPart = time.dwHighDateTime;
+  return static_cast<int64_t>(value.QuadPart);
+}
+
+static void AppendJsonString(std::string* out, const char* text) {
+  out->push_back('"');
+  for (const char* c = text; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      out->push_back('\\');
+      out->push_back(*c);
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      out->push_back(' ');
+    } else {
+      out->push_back(*c);
+    }
+  }
+  out->push_back('"');
+}
+
+StartupTrace& StartupTrace::GetInstance() {
+  static StartupTrace instance;
+  return instance;
+}
+
+StartupTrace::StartupTrace() : origin_offset_us_(0), count_(0) {
+  ::QueryPerformanceFrequency(&frequency_);
+  ::QueryPerformanceCounter(&origin_);
+
+  // Anchor the trace at process creation; the wall clock is only used for
+  // this one offset.
+  FILETIME creation, exit, kernel, user, now;
+  ::GetSystemTimePreciseAsFileTime(&now);
+  if (::GetProcessTimes(::GetCurrentProcess(), &creation, &exit, &kernel,
+                        &user)) {
+    int64_t offset =
+        (FileTimeToTicks(now) - FileTimeToTicks(creation)) / kFileTimeTicksPerUs;
+    origin_offset_us_ = offset > 0 ? offset : 0;
+  }
+
+  for (size_t i = 0; i < kMaxEvents; i++) {
+    events_[i].ready.store(false, std::memory_order_relaxed);
+  }
+}
+
+int64_t StartupTrace::NowUs() const {
+  LARGE_INTEGER now;
+  ::QueryPerformanceCounter(&now);
+  int64_t ticks = now.QuadPart - origin_.QuadPart;
+  // Split to avoid overflowing ticks * 1000000
+  int64_t seconds = ticks / frequency_.QuadPart;
+  int64_t remainder = ticks % frequency_.QuadPart;
+  return origin_offset_us_ + seconds * 1000000 +
+         remainder * 1000000 / frequency_.QuadPart;
+}
+
+void StartupTrace::Record(const char* name, char phase) {
+  int64_t ts = NowUs();
+  size_t index = count_.fetch_add(1, std::memory_order_relaxed);
+  if (index >= kMaxEvents) {
+    return;
+  }
+  Event& event = events_[index];
+  strncpy_s(event.name, sizeof(event.name), name, _TRUNCATE);
+  event.phase = phase;
+  event.tid = ::GetCurrentThreadId();
+  event.ts_us = ts;
+  event.ready.store(true, std::memory_order_release);
+}
+
+size_t StartupTrace::size() const {
+  size_t count = count_.load(std::memory_order_acquire);
+  return count < kMaxEvents ? count : kMaxEvents;
+}
+
+const StartupTrace::Event* StartupTrace::At(size_t index) const {
+  if (index >= kMaxEvents ||
+      !events_[index].ready.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  return &events_[index];
+}
+
+std::string StartupTrace::ToChromeTraceJson() const {
+  unsigned long pid = ::GetCurrentProcessId();
+  std::string json = "{\"traceEvents\":[";
+  char buffer[96];
+  bool first = true;
+  for (size_t i = 0; i < size(); i++) {
+    const Event* event = At(i);
+    if (event == nullptr) {
+      continue;
+    }
+    json += first ? "\n" : ",\n";
+    first = false;
+    json += "{\"name\":";
+    AppendJsonString(&json, event->name);
+    snprintf(buffer, sizeof(buffer),
+             ",\"cat\":\"startup\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":%lu,"
+             "\"tid\":%lu",
+             event->phase, static_cast<long long>(event->ts_us), pid,
+             static_cast<unsigned long>(event->tid));
+    json += buffer;
+    // Instant events are process-wide markers
+    json += event->phase == 'i' ? ",\"s\":\"p\"}" : "}";
+  }
+  json += "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"platform\":\"windows\"}}\n";
+  return json;
+}
+
+bool StartupTrace::Dump(const std::wstring& path) const {
+  std::string json = ToChromeTraceJson();
+  FILE* file = nullptr;
+  if (_wfopen_s(&file, path.c_str(), L"wb") != 0 || file == nullptr) {
+    return false;
+  }
+  bool ok = fwrite(json.data(), 1, json.size(), file) == json.size();
+  return fclose(file) == 0 && ok;
+}
+
+std::wstring StartupTrace::RequestedDumpPath() {
+  wchar_t path[MAX_PATH];
+  DWORD length = ::GetEnvironmentVariableW(RUNNER_STARTUP_TRACE_ENV_VAR, path,
+                                           MAX_PATH);
+  if (length == 0 || length >= MAX_PATH) {
+    return std::wstring();
+  }
+  return std::wstring(path, length);
+}
+
+bool StartupTrace::ExitAfterDumpRequested() {
+  wchar_t value[8];
+  DWORD length = ::GetEnvironmentVariableW(RUNNER_STARTUP_TRACE_EXIT_ENV_VAR,
+                                           value, 8);
+  return length == 1 && value[0] == L'1';
+}
@@ -0,0 +1,96 @@
+#ifndef RUNNER_STARTUP_TRACE_H_
+#define RUNNER_STARTUP_TRACE_H_
+
+#include <windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Environment variable naming a file the trace is written to (Chrome trace
+// JSON) once the first frame is shown. Setting
+// RUNNER_STARTUP_TRACE_EXIT_ENV_VAR to 1 additionally quits the app right
+// after, which is how scripts/startup_benchmark.py drives repeated launches.
+#define RUNNER_STARTUP_TRACE_ENV_VAR L"A1_TOOLS_STARTUP_TRACE"
+#define RUNNER_STARTUP_TRACE_EXIT_ENV_VAR L"A1_TOOLS_STARTUP_TRACE_EXIT"
+
+// Records cold-start phases with monotonic timestamps into a fixed buffer.
+// Recording is a few stores and never allocates, so it can stay enabled in
+// release builds. Timestamps are microseconds since the process was
+// created, so time spent in the loader before wWinMain is included.
+//
+// The Dart side reads the events and adds its own phases over the
+// com.a1chimney.a1tools/startup_trace channel
+// (lib/core/services/startup_trace_service.dart).
+class StartupTrace {
+ public:
+  static const size_t kMaxEvents = 128;
+  static const size_t kMaxNameLength = 47;
+
+  struct Event {
+    char name[kMaxNameLength + 1];
+    char phase;    // 'B' begin, 'E' end, 'i' instant (Chrome trace phases)
+    uint32_t tid;
+    int64_t ts_us;
+    std::atomic<bool> ready;  // Set once the other fields are written
+  };
+
+  static StartupTrace& GetInstance();
+
+  void Begin(const char* name) { Record(name, 'B'); }
+  void End(const char* name) { Record(name, 'E'); }
+  void Instant(const char* name) { Record(name, 'i'); }
+
+  // Appends an event; longer names are truncated. Dropped once the buffer
+  // is full.
+  void Record(const char* name, char phase);
+
+  // Number of recorded events; events past it may still be in flight.
+  size_t size() const;
+
+  // The event at index, nullptr if it is not completely written yet.
+  const Event* At(size_t index) const;
+
+  // The whole trace in Chrome trace event format (chrome://tracing,
+  // ui.perfetto.dev).
+  std::string ToChromeTraceJson() const;
+
+  // Writes the Chrome trace JSON to path.
+  bool Dump(const std::wstring& path) const;
+
+  // Path from RUNNER_STARTUP_TRACE_ENV_VAR, empty when not requested.
+  static std::wstring RequestedDumpPath();
+  static bool ExitAfterDumpRequested();
+
+ private:
+  StartupTrace();
+
+  // Disable copy
+  StartupTrace(const StartupTrace&) = delete;
+  StartupTrace& operator=(const StartupTrace&) = delete;
+
+  int64_t NowUs() const;
+
+  LARGE_INTEGER frequency_;
+  LARGE_INTEGER origin_;       // QPC value at construction
+  int64_t origin_offset_us_;   // Process creation until construction
+  std::atomic<size_t> count_;
+  Event events_[kMaxEvents];
+};
+
+// Begins a phase on construction and ends it on destruction.
+class StartupTraceScope {
+ public:
+  explicit StartupTraceScope(const char* name) : name_(name) {
+    StartupTrace::GetInstance().Begin(name_);
+  }
+  ~StartupTraceScope() { StartupTrace::GetInstance().End(name_); }
+
+ private:
+  StartupTraceScope(const StartupTraceScope&) = delete;
+  StartupTraceScope& operator=(const StartupTraceScope&) = delete;
+
+  const char* name_;
+};
+
+#endif  // RUNNER_STARTUP_TRACE_H_
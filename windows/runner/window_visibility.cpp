@@ -0,0 +1,85 @@
+#include "window_visibility.h"
+
+#include <dwmapi.h>
+
+// Bounds the z-order walk; a desktop rarely has more top-level windows.
+static const int kMaxWindowsAbove = 512;
+
+static bool IsCloaked(HWND window) {
+  DWORD cloaked = 0;
+  return SUCCEEDED(::DwmGetWindowAttribute(window, DWMWA_CLOAKED, &cloaked,
+                                           sizeof(cloaked))) &&
+         cloaked != 0;
+}
+
+// Bounds without the invisible resize borders DWM adds around the frame.
+static bool GetVisibleBounds(HWND window, RECT* bounds) {
+  return SUCCEEDED(::DwmGetWindowAttribute(window, DWMWA_EXTENDED_FRAME_BOUNDS,
+                                           bounds, sizeof(*bounds))) ||
+         ::GetWindowRect(window, bounds);
+}
+
+// Whether |window| could hide what is below it. Click-through and
+// translucent windows (overlays, notifications, per-pixel alpha) cannot.
+static bool IsOpaqueCover(HWND window) {
+  if (!::IsWindowVisible(window) || ::IsIconic(window) || IsCloaked(window)) {
+    return false;
+  }
+  LONG ex_style = ::GetWindowLongW(window, GWL_EXSTYLE);
+  if (ex_style & WS_EX_TRANSPARENT) {
+    return false;
+  }
+  if (ex_style & WS_EX_LAYERED) {
+    BYTE alpha = 0;
+    DWORD flags = 0;
+    // Fails for UpdateLayeredWindow windows, which blend per pixel
+    if (!::GetLayeredWindowAttributes(window, nullptr, &alpha, &flags) ||
+        (flags & LWA_COLORKEY) || ((flags & LWA_ALPHA) && alpha != 255)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool IsOccluded(HWND window) {
+  RECT bounds;
+  if (!GetVisibleBounds(window, &bounds)) {
+    return false;
+  }
+  // Only the part on some monitor can be seen
+  HRGN uncovered = ::CreateRectRgnIndirect(&bounds);
+  HRGN screen = ::CreateRectRgn(
+      ::GetSystemMetrics(SM_XVIRTUALSCREEN), ::GetSystemMetrics(SM_YVIRTUALSCREEN),
+      ::GetSystemMetrics(SM_XVIRTUALSCREEN) + ::GetSystemMetrics(SM_CXVIRTUALSCREEN),
+      ::GetSystemMetrics(SM_YVIRTUALSCREEN) + ::GetSystemMetrics(SM_CYVIRTUALSCREEN));
+  int region = ::CombineRgn(uncovered, uncovered, screen, RGN_AND);
+  ::DeleteObject(screen);
+
+  HWND above = ::GetWindow(window, GW_HWNDPREV);
+  for (int i = 0; region != NULLREGION && region != ERROR && above != nullptr &&
+                  i < kMaxWindowsAbove;
+       i++, above = ::GetWindow(above, GW_HWNDPREV)) {
+    RECT cover_bounds;
+    if (!IsOpaqueCover(above) || !GetVisibleBounds(above, &cover_bounds)) {
+      continue;
+    }
+    HRGN cover = ::CreateRectRgnIndirect(&cover_bounds);
+    region = ::CombineRgn(uncovered, uncovered, cover, RGN_DIFF);
+    ::DeleteObject(cover);
+  }
+  ::DeleteObject(uncovered);
+  return region == NULLREGION;
+}
+
+WindowVisibility GetWindowVisibility(HWND window) {
+  if (window == nullptr || !::IsWindowVisible(window) || IsCloaked(window)) {
+    return WindowVisibility::kHidden;
+  }
+  if (::IsIconic(window)) {
+    return WindowVisibility::kMinimized;
+  }
+  if (IsOccluded(window)) {
+    return WindowVisibility::kOccluded;
+  }
+  return WindowVisibility::kVisible;
+}
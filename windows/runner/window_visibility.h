@@ -0,0 +1,20 @@
+#ifndef RUNNER_WINDOW_VISIBILITY_H_
+#define RUNNER_WINDOW_VISIBILITY_H_
+
+#include <windows.h>
+
+// How much of a top-level window the user can see. Anything but kVisible is
+// reported to Dart as AppLifecycleState.hidden, which stops the framework
+// from scheduling frames.
+enum class WindowVisibility {
+  kVisible,
+  kHidden,     // Not shown, or cloaked (other virtual desktop)
+  kMinimized,
+  kOccluded,   // Fully covered by opaque windows above it
+};
+
+// Classifies |window|. The occlusion test walks the windows above it in
+// z-order, so call it on state changes and from a slow timer, not per frame.
+WindowVisibility GetWindowVisibility(HWND window);
+
+#endif  // RUNNER_WINDOW_VISIBILITY_H_